@@ -16,6 +16,7 @@
 #include <limits.h>
 #include <search.h>
 #include <assert.h>
+#include <sys/resource.h>
 
 #include "uthash.h"
 
@@ -102,6 +103,196 @@ void darshan_iter_record_refs(void *hash_head, void (*iter_action)(void *, void
     return;
 }
 
+int darshan_fd_table_set(struct darshan_fd_table *table, int fd, void *rec_ref_p)
+{
+    int chunk = fd >> DARSHAN_FD_TABLE_CHUNK_BITS;
+    int new_nchunks;
+    void ***new_chunks;
+    struct rlimit rlim;
+
+    if(fd < 0)
+        return(0);
+
+    if(chunk >= table->nchunks)
+    {
+        /* size the first level to cover the descriptor limit up front, so
+         * that it normally only has to be allocated once
+         */
+        new_nchunks = 2 * table->nchunks;
+        if(!table->chunks && getrlimit(RLIMIT_NOFILE, &rlim) == 0 &&
+            rlim.rlim_cur != RLIM_INFINITY && rlim.rlim_cur <= INT_MAX)
+            new_nchunks = (rlim.rlim_cur + DARSHAN_FD_TABLE_CHUNK_SIZE - 1) >>
+                DARSHAN_FD_TABLE_CHUNK_BITS;
+        if(new_nchunks <= chunk)
+            new_nchunks = chunk + 1;
+
+        new_chunks = realloc(table->chunks, new_nchunks * sizeof(*new_chunks));
+        if(!new_chunks)
+            return(0);
+        memset(&new_chunks[table->nchunks], 0,
+            (new_nchunks - table->nchunks) * sizeof(*new_chunks));
+        table->chunks = new_chunks;
+        table->nchunks = new_nchunks;
+    }
+
+    if(!table->chunks[chunk])
+    {
+        table->chunks[chunk] = calloc(DARSHAN_FD_TABLE_CHUNK_SIZE,
+            sizeof(**table->chunks));
+        if(!table->chunks[chunk])
+            return(0);
+    }
+
+    table->chunks[chunk][fd & (DARSHAN_FD_TABLE_CHUNK_SIZE - 1)] = rec_ref_p;
+    return(1);
+}
+
+void *darshan_fd_table_remove(struct darshan_fd_table *table, int fd)
+{
+    void *rec_ref_p;
+
+    rec_ref_p = darshan_fd_table_lookup(table, fd);
+    if(rec_ref_p)
+        table->chunks[fd >> DARSHAN_FD_TABLE_CHUNK_BITS]
+            [fd & (DARSHAN_FD_TABLE_CHUNK_SIZE - 1)] = NULL;
+
+    return(rec_ref_p);
+}
+
+void darshan_fd_table_clear(struct darshan_fd_table *table)
+{
+    int i;
+
+    for(i = 0; i < table->nchunks; i++)
+        free(table->chunks[i]);
+    free(table->chunks);
+    table->chunks = NULL;
+    table->nchunks = 0;
+
+    return;
+}
+
+/* smallest handle table allocated, as a power of two */
+#define DARSHAN_HANDLE_TABLE_MIN_BITS 6
+
+/* resize a handle table to (1 << bits) slots, reinserting all entries */
+static int darshan_handle_table_rehash(struct darshan_handle_table *table,
+    int bits)
+{
+    struct darshan_handle_table_slot *old_slots = table->slots;
+    unsigned long old_size = old_slots ? (1UL << table->bits) : 0;
+    unsigned long mask = (1UL << bits) - 1;
+    unsigned long i, slot;
+
+    table->slots = calloc(1UL << bits, sizeof(*table->slots));
+    if(!table->slots)
+    {
+        table->slots = old_slots;
+        return(0);
+    }
+    table->bits = bits;
+
+    for(i = 0; i < old_size; i++)
+    {
+        if(!old_slots[i].rec_ref_p)
+            continue;
+        slot = DARSHAN_HANDLE_TABLE_SLOT(old_slots[i].handle, bits);
+        while(table->slots[slot].rec_ref_p)
+            slot = (slot + 1) & mask;
+        table->slots[slot] = old_slots[i];
+    }
+    free(old_slots);
+
+    return(1);
+}
+
+int darshan_handle_table_set(struct darshan_handle_table *table,
+    const void *handle, size_t handle_sz, void *rec_ref_p)
+{
+    uint64_t key = darshan_handle_table_key(handle, handle_sz);
+    unsigned long mask;
+    unsigned long slot;
+
+    if(!rec_ref_p)
+        return(0);
+
+    /* keep the load factor at or below 1/2 */
+    if(!table->slots || 2 * (table->count + 1) > (1 << table->bits))
+    {
+        if(!darshan_handle_table_rehash(table, table->slots ?
+            table->bits + 1 : DARSHAN_HANDLE_TABLE_MIN_BITS))
+            return(0);
+    }
+
+    mask = (1UL << table->bits) - 1;
+    slot = DARSHAN_HANDLE_TABLE_SLOT(key, table->bits);
+    while(table->slots[slot].rec_ref_p && table->slots[slot].handle != key)
+        slot = (slot + 1) & mask;
+    if(!table->slots[slot].rec_ref_p)
+        table->count++;
+    table->slots[slot].handle = key;
+    table->slots[slot].rec_ref_p = rec_ref_p;
+
+    return(1);
+}
+
+void *darshan_handle_table_remove(struct darshan_handle_table *table,
+    const void *handle, size_t handle_sz)
+{
+    uint64_t key = darshan_handle_table_key(handle, handle_sz);
+    void *rec_ref_p;
+    unsigned long mask;
+    unsigned long slot, next, home;
+
+    if(!table->slots)
+        return(NULL);
+
+    mask = (1UL << table->bits) - 1;
+    slot = DARSHAN_HANDLE_TABLE_SLOT(key, table->bits);
+    while(table->slots[slot].rec_ref_p && table->slots[slot].handle != key)
+        slot = (slot + 1) & mask;
+    rec_ref_p = table->slots[slot].rec_ref_p;
+    if(!rec_ref_p)
+        return(NULL);
+    table->slots[slot].rec_ref_p = NULL;
+    table->count--;
+
+    /* shift later entries of the probe sequence back, so that they can
+     * still be found without tombstones
+     */
+    next = slot;
+    while(1)
+    {
+        next = (next + 1) & mask;
+        if(!table->slots[next].rec_ref_p)
+            break;
+
+        /* leave this entry if its home slot is (cyclically) in the range
+         * (slot, next]; it is still reachable from there
+         */
+        home = DARSHAN_HANDLE_TABLE_SLOT(table->slots[next].handle, table->bits);
+        if((slot <= next) ? (slot < home && home <= next) :
+            (slot < home || home <= next))
+            continue;
+
+        table->slots[slot] = table->slots[next];
+        table->slots[next].rec_ref_p = NULL;
+        slot = next;
+    }
+
+    return(rec_ref_p);
+}
+
+void darshan_handle_table_clear(struct darshan_handle_table *table)
+{
+    free(table->slots);
+    table->slots = NULL;
+    table->bits = 0;
+    table->count = 0;
+
+    return;
+}
+
 char* darshan_clean_file_path(const char* path)
 {
     char* newpath = NULL;
@@ -248,6 +439,233 @@ struct darshan_common_val_counter *darshan_track_common_val_counters(
     return(found);
 }
 
+/* Fibonacci hashing, so that values which differ only in their upper bits
+ * (e.g., multiples of a common block size) still spread out
+ */
+#define DARSHAN_COMMON_VAL_HASH(__val) \
+    ((unsigned int)(((uint64_t)(__val) * 0x9E3779B97F4A7C15ULL) >> \
+        (64 - DARSHAN_COMMON_VAL_TABLE_BITS)))
+#define DARSHAN_COMMON_VAL_NEXT_SLOT(__slot) \
+    (((__slot) + 1) & (DARSHAN_COMMON_VAL_TABLE_SIZE - 1))
+
+/* find the slot holding 'val', or the empty slot where it belongs */
+static unsigned int darshan_common_val_slot(
+    struct darshan_common_val_table *table, int64_t val)
+{
+    unsigned int slot = DARSHAN_COMMON_VAL_HASH(val);
+
+    /* linear probing; the table is never full, so this terminates */
+    while(table->freqs[slot] && table->vals[slot] != val)
+        slot = DARSHAN_COMMON_VAL_NEXT_SLOT(slot);
+
+    return(slot);
+}
+
+/* remove the value at 'slot', shifting later entries of its probe sequence
+ * back so that they can still be found
+ */
+static void darshan_common_val_remove(
+    struct darshan_common_val_table *table, unsigned int slot)
+{
+    unsigned int next = slot;
+    unsigned int home;
+
+    table->freqs[slot] = 0;
+    table->count--;
+
+    while(1)
+    {
+        next = DARSHAN_COMMON_VAL_NEXT_SLOT(next);
+        if(!table->freqs[next])
+            break;
+
+        /* leave this entry if its home slot is (cyclically) in the range
+         * (slot, next]; it is still reachable from there
+         */
+        home = DARSHAN_COMMON_VAL_HASH(table->vals[next]);
+        if((slot <= next) ? (slot < home && home <= next) :
+            (slot < home || home <= next))
+            continue;
+
+        table->vals[slot] = table->vals[next];
+        table->freqs[slot] = table->freqs[next];
+        table->freqs[next] = 0;
+        slot = next;
+    }
+
+    return;
+}
+
+int64_t darshan_track_common_val(struct darshan_common_val_table *table,
+    int64_t val)
+{
+    unsigned int slot;
+    unsigned int min_slot = 0;
+    int64_t min_freq = 0;
+    int i;
+
+    slot = darshan_common_val_slot(table, val);
+    if(table->freqs[slot])
+        return(++table->freqs[slot]);
+
+    if(table->count >= DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT)
+    {
+        /* replace the least frequent value, which the new value inherits
+         * the frequency of (its true frequency can be no larger)
+         */
+        for(i = 0; i < DARSHAN_COMMON_VAL_TABLE_SIZE; i++)
+        {
+            if(table->freqs[i] && (!min_freq || table->freqs[i] < min_freq))
+            {
+                min_freq = table->freqs[i];
+                min_slot = i;
+            }
+        }
+        darshan_common_val_remove(table, min_slot);
+        slot = darshan_common_val_slot(table, val);
+    }
+
+    table->vals[slot] = val;
+    table->freqs[slot] = min_freq + 1;
+    table->count++;
+
+    return(table->freqs[slot]);
+}
+
+struct darshan_common_val_entry
+{
+    int64_t val;
+    int64_t freq;
+};
+
+/* sort common values by decreasing frequency, then decreasing value */
+static int darshan_common_val_entry_compare(const void *a_p, const void *b_p)
+{
+    const struct darshan_common_val_entry *a = a_p;
+    const struct darshan_common_val_entry *b = b_p;
+
+    if(a->freq != b->freq)
+        return((a->freq > b->freq) ? -1 : 1);
+    if(a->val != b->val)
+        return((a->val > b->val) ? -1 : 1);
+
+    return(0);
+}
+
+/* copy the contents of 'table' into 'entries', sorted by frequency */
+static int darshan_common_val_sorted(struct darshan_common_val_table *table,
+    struct darshan_common_val_entry *entries)
+{
+    int i;
+    int n = 0;
+
+    for(i = 0; i < DARSHAN_COMMON_VAL_TABLE_SIZE; i++)
+    {
+        if(table->freqs[i])
+        {
+            entries[n].val = table->vals[i];
+            entries[n].freq = table->freqs[i];
+            n++;
+        }
+    }
+    qsort(entries, n, sizeof(*entries), darshan_common_val_entry_compare);
+
+    return(n);
+}
+
+/* smallest frequency in 'table' if it is full, 0 otherwise (a value missing
+ * from a full table may have occurred up to that many times)
+ */
+static int64_t darshan_common_val_floor(struct darshan_common_val_table *table)
+{
+    int64_t min_freq = 0;
+    int i;
+
+    if(table->count < DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT)
+        return(0);
+
+    for(i = 0; i < DARSHAN_COMMON_VAL_TABLE_SIZE; i++)
+        if(table->freqs[i] && (!min_freq || table->freqs[i] < min_freq))
+            min_freq = table->freqs[i];
+
+    return(min_freq);
+}
+
+void darshan_merge_common_vals(struct darshan_common_val_table *in,
+    struct darshan_common_val_table *inout)
+{
+    struct darshan_common_val_entry entries[2*DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT];
+    int64_t in_floor, inout_floor;
+    unsigned int slot;
+    int n = 0;
+    int i;
+
+    in_floor = darshan_common_val_floor(in);
+    inout_floor = darshan_common_val_floor(inout);
+
+    /* the merged frequency of each value is the sum of its frequencies in
+     * both tables, using the other table's floor if it is missing there
+     */
+    for(i = 0; i < DARSHAN_COMMON_VAL_TABLE_SIZE; i++)
+    {
+        if(!inout->freqs[i])
+            continue;
+        entries[n].val = inout->vals[i];
+        slot = darshan_common_val_slot(in, inout->vals[i]);
+        entries[n].freq = inout->freqs[i] +
+            (in->freqs[slot] ? in->freqs[slot] : in_floor);
+        n++;
+    }
+    for(i = 0; i < DARSHAN_COMMON_VAL_TABLE_SIZE; i++)
+    {
+        if(!in->freqs[i])
+            continue;
+        slot = darshan_common_val_slot(inout, in->vals[i]);
+        if(inout->freqs[slot])
+            continue;
+        entries[n].val = in->vals[i];
+        entries[n].freq = in->freqs[i] + inout_floor;
+        n++;
+    }
+    qsort(entries, n, sizeof(*entries), darshan_common_val_entry_compare);
+
+    /* keep the most frequent values */
+    memset(inout, 0, sizeof(*inout));
+    if(n > DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT)
+        n = DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT;
+    for(i = 0; i < n; i++)
+    {
+        slot = darshan_common_val_slot(inout, entries[i].val);
+        inout->vals[slot] = entries[i].val;
+        inout->freqs[slot] = entries[i].freq;
+        inout->count++;
+    }
+
+    return;
+}
+
+void darshan_set_common_val_counters(struct darshan_common_val_table *table,
+    int64_t *val_p, int64_t *cnt_p)
+{
+    struct darshan_common_val_entry entries[DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT];
+    int n;
+    int i, j;
+
+    n = darshan_common_val_sorted(table, entries);
+
+    /* like DARSHAN_UPDATE_COMMON_VAL_COUNTERS(), never report a value of 0 */
+    for(i = 0, j = 0; j < 4; i++)
+    {
+        if(i < n && entries[i].val == 0)
+            continue;
+        val_p[j] = (i < n) ? entries[i].val : 0;
+        cnt_p[j] = (i < n) ? entries[i].freq : 0;
+        j++;
+    }
+
+    return;
+}
+
 #ifdef HAVE_MPI
 void darshan_variance_reduce(void *invec, void *inoutvec, int *len,
     MPI_Datatype *dt)
@@ -269,6 +687,19 @@ void darshan_variance_reduce(void *invec, void *inoutvec, int *len,
 
     return;
 }
+
+void darshan_common_val_reduce(void *invec, void *inoutvec, int *len,
+    MPI_Datatype *dt)
+{
+    struct darshan_common_val_table *in = invec;
+    struct darshan_common_val_table *inout = inoutvec;
+    int i;
+
+    for(i=0; i<*len; i++)
+        darshan_merge_common_vals(&in[i], &inout[i]);
+
+    return;
+}
 #endif
 
 /*
@@ -71,6 +71,11 @@
 #define DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT 32
 /* maximum number of counters in each common value */
 #define DARSHAN_COMMON_VAL_MAX_NCOUNTERS 12
+/* number of slots in a common value table (must be a power of 2 greater
+ * than DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT, so that probing terminates)
+ */
+#define DARSHAN_COMMON_VAL_TABLE_BITS 6
+#define DARSHAN_COMMON_VAL_TABLE_SIZE (1 << DARSHAN_COMMON_VAL_TABLE_BITS)
 
 /* potentially set or add common value counters, depending on the __val_count
  * for the given __vals. This macro ensures common values are stored first in
@@ -142,6 +147,23 @@ struct darshan_common_val_counter
     int freq;
 };
 
+/* Space-Saving sketch of the most frequent single values (e.g., access
+ * sizes or strides), stored in an open-addressed hash table.  Frequencies
+ * are upper bounds on the true frequency of each value.  It is meant to be
+ * embedded in a module's record reference so that tracking common values
+ * never allocates memory, and sketches from different processes can be
+ * merged to find the most common values job-wide.  Each table takes about
+ * 1 KiB (value and frequency for DARSHAN_COMMON_VAL_TABLE_SIZE slots), so
+ * a POSIX record reference, which tracks access sizes and strides, carries
+ * about 2 KiB of sketch state and an MPI-IO one about 1 KiB.
+ */
+struct darshan_common_val_table
+{
+    int64_t vals[DARSHAN_COMMON_VAL_TABLE_SIZE];
+    int64_t freqs[DARSHAN_COMMON_VAL_TABLE_SIZE]; /* 0 if the slot is unused */
+    int count;
+};
+
 /* i/o type (read or write) */
 enum darshan_io_type
 {
@@ -242,6 +264,151 @@ void darshan_iter_record_refs(
     void (*iter_action)(void *, void *),
     void *user_ptr);
 
+/* number of handles covered by each second-level chunk of a fd table */
+#define DARSHAN_FD_TABLE_CHUNK_BITS 10
+#define DARSHAN_FD_TABLE_CHUNK_SIZE (1 << DARSHAN_FD_TABLE_CHUNK_BITS)
+
+/* two-level table mapping small, dense, non-negative integer handles
+ * (e.g., file descriptors) directly to record reference pointers; the
+ * first level is sized from RLIMIT_NOFILE and grown if needed, second
+ * level chunks are allocated on first use
+ */
+struct darshan_fd_table
+{
+    void ***chunks;
+    int nchunks;
+};
+
+/* darshan_fd_table_lookup()
+ *
+ * Lookup the record reference pointer stored for handle 'fd' in the
+ * given fd table. Returns NULL if no reference is stored for 'fd'.
+ */
+static inline void *darshan_fd_table_lookup(struct darshan_fd_table *table, int fd)
+{
+    int chunk = fd >> DARSHAN_FD_TABLE_CHUNK_BITS;
+
+    if(fd < 0 || chunk >= table->nchunks || !table->chunks[chunk])
+        return(NULL);
+    return(table->chunks[chunk][fd & (DARSHAN_FD_TABLE_CHUNK_SIZE - 1)]);
+}
+
+/* darshan_fd_table_set()
+ *
+ * Store the record reference pointer 'rec_ref_p' for handle 'fd' in the
+ * given fd table, replacing any reference already stored for 'fd'.
+ * Returns 1 on success, 0 otherwise.
+ */
+int darshan_fd_table_set(
+    struct darshan_fd_table *table,
+    int fd,
+    void *rec_ref_p);
+
+/* darshan_fd_table_remove()
+ *
+ * Remove the record reference stored for handle 'fd' from the given fd
+ * table. Returns the removed reference pointer, or NULL if none was stored.
+ */
+void *darshan_fd_table_remove(
+    struct darshan_fd_table *table,
+    int fd);
+
+/* darshan_fd_table_clear()
+ *
+ * Remove all record references from the given fd table and free its
+ * memory. Record reference pointers themselves are not freed.
+ */
+void darshan_fd_table_clear(
+    struct darshan_fd_table *table);
+
+/* open-addressed hash table mapping opaque handles of up to 8 bytes (e.g.,
+ * MPI_File values) to record reference pointers, for handles that are not
+ * small dense integers and so can't index a fd table
+ */
+struct darshan_handle_table_slot
+{
+    uint64_t handle;
+    void *rec_ref_p; /* NULL if the slot is unused */
+};
+
+struct darshan_handle_table
+{
+    struct darshan_handle_table_slot *slots;
+    int bits; /* the table holds (1 << bits) slots */
+    int count;
+};
+
+static inline uint64_t darshan_handle_table_key(const void *handle,
+    size_t handle_sz)
+{
+    uint64_t key = 0;
+
+    memcpy(&key, handle, handle_sz < sizeof(key) ? handle_sz : sizeof(key));
+    return(key);
+}
+
+#define DARSHAN_HANDLE_TABLE_SLOT(__key, __bits) \
+    ((unsigned long)(((__key) * 0x9E3779B97F4A7C15ULL) >> (64 - (__bits))))
+
+/* darshan_handle_table_lookup()
+ *
+ * Lookup the record reference pointer stored for the handle at 'handle',
+ * of size 'handle_sz', in the given handle table. Returns NULL if no
+ * reference is stored for the handle.
+ */
+static inline void *darshan_handle_table_lookup(
+    struct darshan_handle_table *table, const void *handle, size_t handle_sz)
+{
+    uint64_t key = darshan_handle_table_key(handle, handle_sz);
+    unsigned long mask;
+    unsigned long slot;
+
+    if(!table->slots)
+        return(NULL);
+
+    mask = (1UL << table->bits) - 1;
+    slot = DARSHAN_HANDLE_TABLE_SLOT(key, table->bits);
+    while(table->slots[slot].rec_ref_p)
+    {
+        if(table->slots[slot].handle == key)
+            return(table->slots[slot].rec_ref_p);
+        slot = (slot + 1) & mask;
+    }
+
+    return(NULL);
+}
+
+/* darshan_handle_table_set()
+ *
+ * Store the record reference pointer 'rec_ref_p' for the handle at
+ * 'handle', of size 'handle_sz', in the given handle table, replacing any
+ * reference already stored for it. Returns 1 on success, 0 otherwise.
+ */
+int darshan_handle_table_set(
+    struct darshan_handle_table *table,
+    const void *handle,
+    size_t handle_sz,
+    void *rec_ref_p);
+
+/* darshan_handle_table_remove()
+ *
+ * Remove the record reference stored for the handle at 'handle', of size
+ * 'handle_sz', from the given handle table. Returns the removed reference
+ * pointer, or NULL if none was stored.
+ */
+void *darshan_handle_table_remove(
+    struct darshan_handle_table *table,
+    const void *handle,
+    size_t handle_sz);
+
+/* darshan_handle_table_clear()
+ *
+ * Remove all record references from the given handle table and free its
+ * memory. Record reference pointers themselves are not freed.
+ */
+void darshan_handle_table_clear(
+    struct darshan_handle_table *table);
+
 /* darshan_clean_file_path()
  *
  * Allocate a new string that contains a new cleaned-up version of
@@ -277,6 +444,9 @@ void darshan_record_sort(
  * tree (i.e., the number of allocated common value counters), 'vals'
  * is the set of new values to attempt to add, and 'nvals' is the
  * total number of values in the 'vals' pointer.
+ *
+ * NOTE: modules tracking single values should use the cheaper
+ * darshan_track_common_val() instead.
  */
 struct darshan_common_val_counter *darshan_track_common_val_counters(
     void **common_val_root,
@@ -284,6 +454,40 @@ struct darshan_common_val_counter *darshan_track_common_val_counters(
     int nvals,
     int *common_val_count);
 
+/* darshan_track_common_val()
+ *
+ * Increment the frequency of the single value 'val' in the common value
+ * table 'table'.  If 'val' is not present and the table already tracks
+ * DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT values, the least frequent value is
+ * evicted to make room for it (i.e., the Space-Saving algorithm), so the
+ * table is not biased towards the values that happen to occur first.
+ * 'table' must be zeroed before first use.  Returns the updated (estimated)
+ * frequency of 'val'.
+ */
+int64_t darshan_track_common_val(
+    struct darshan_common_val_table *table,
+    int64_t val);
+
+/* darshan_merge_common_vals()
+ *
+ * Merge the common value table 'in' into 'inout', such that 'inout'
+ * approximates the most frequent values of the combined input streams.
+ */
+void darshan_merge_common_vals(
+    struct darshan_common_val_table *in,
+    struct darshan_common_val_table *inout);
+
+/* darshan_set_common_val_counters()
+ *
+ * Overwrite the 4 common value counters at '__val_p' and their count
+ * counters at '__cnt_p' with the 4 most frequent values in 'table', in
+ * the same order as DARSHAN_UPDATE_COMMON_VAL_COUNTERS() maintains them.
+ */
+void darshan_set_common_val_counters(
+    struct darshan_common_val_table *table,
+    int64_t *val_p,
+    int64_t *cnt_p);
+
 #ifdef HAVE_MPI
 /* darshan_variance_reduce()
  *
@@ -301,6 +505,19 @@ void darshan_variance_reduce(
     void *inoutvec,
     int *len,
     MPI_Datatype *dt);
+
+/* darshan_common_val_reduce()
+ *
+ * MPI reduction operation to merge arrays of common value tables (see
+ * darshan_merge_common_vals()), e.g., to find the most common access sizes
+ * of records which are shared across all processes.  The datatype should
+ * be a contiguous type spanning one struct darshan_common_val_table.
+ */
+void darshan_common_val_reduce(
+    void *invec,
+    void *inoutvec,
+    int *len,
+    MPI_Datatype *dt);
 #endif
 
 #endif /* __DARSHAN_COMMON_H */
@@ -14,6 +14,7 @@
 #include "utlist.h"
 #include "darshan.h"
 #include "darshan-config.h"
+#include "darshan-heatmap.h"
 
 /* paths prefixed with the following directories are not tracked by darshan */
 char* darshan_path_exclusions[] = {
@@ -115,6 +116,8 @@ void darshan_init_config(struct darshan_config *cfg)
 #endif
     cfg->exclude_dirs = darshan_path_exclusions;
     cfg->include_dirs = darshan_path_inclusions;
+    cfg->heatmap_nbins = DARSHAN_DEF_HEATMAP_NBINS;
+    cfg->heatmap_bin_width = DARSHAN_DEF_HEATMAP_BIN_WIDTH;
 
     return;
 }
@@ -437,6 +440,26 @@ void darshan_parse_config_env(struct darshan_config *cfg)
             }
         }
     }
+    envstr = getenv("DARSHAN_HEATMAP_NBINS");
+    if(envstr)
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, int, cfg->heatmap_nbins, success);
+    envstr = getenv("DARSHAN_HEATMAP_BIN_WIDTH");
+    if(envstr)
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, double, cfg->heatmap_bin_width, success);
+    envstr = getenv("DARSHAN_HEATMAP_RECENT_NBINS");
+    if(envstr)
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, int, cfg->heatmap_recent_nbins, success);
+    if(getenv("DARSHAN_HEATMAP_RANK_MATRIX"))
+        cfg->heatmap_rank_matrix_flag = 1;
+    envstr = getenv("DARSHAN_CHECKPOINT_INTERVAL");
+    if(envstr)
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, int, cfg->checkpoint_interval, success);
+    envstr = getenv("DARSHAN_CHECKPOINT_PATH");
+    if(envstr)
+    {
+        free(cfg->checkpoint_path);
+        cfg->checkpoint_path = strdup(envstr);
+    }
     if(getenv("DARSHAN_DUMP_CONFIG"))
         cfg->dump_config_flag = 1;
     if(getenv("DARSHAN_INTERNAL_TIMING"))
@@ -810,6 +833,37 @@ void darshan_parse_config_file(struct darshan_config *cfg)
                     }
                 }
             }
+            else if(strcmp(key, "HEATMAP_NBINS") == 0)
+            {
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, int, cfg->heatmap_nbins, success);
+            }
+            else if(strcmp(key, "HEATMAP_BIN_WIDTH") == 0)
+            {
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, double, cfg->heatmap_bin_width, success);
+            }
+            else if(strcmp(key, "HEATMAP_RECENT_NBINS") == 0)
+            {
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, int, cfg->heatmap_recent_nbins, success);
+            }
+            else if(strcmp(key, "HEATMAP_RANK_MATRIX") == 0)
+                cfg->heatmap_rank_matrix_flag = 1;
+            else if(strcmp(key, "CHECKPOINT_INTERVAL") == 0)
+            {
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, int, cfg->checkpoint_interval, success);
+            }
+            else if(strcmp(key, "CHECKPOINT_PATH") == 0)
+            {
+                val = strtok(NULL, " \t");
+                if(val)
+                {
+                    free(cfg->checkpoint_path);
+                    cfg->checkpoint_path = strdup(val);
+                }
+            }
             else if(strcmp(key, "DUMP_CONFIG") == 0)
                 cfg->dump_config_flag = 1;
             else if(strcmp(key, "INTERNAL_TIMING") == 0)
@@ -912,6 +966,19 @@ void darshan_dump_config(struct darshan_config *cfg)
         fprintf(stderr, "# DXT_UNALIGNED_IO_TRIGGER = %.2lf\n",
             cfg->unaligned_io_trigger->u.unaligned_io.thresh_pct);
     }
+    fprintf(stderr, "# HEATMAP_NBINS = %d\n", cfg->heatmap_nbins);
+    fprintf(stderr, "# HEATMAP_BIN_WIDTH = %.3lf seconds\n", cfg->heatmap_bin_width);
+    fprintf(stderr, "# HEATMAP_RECENT_NBINS = %d\n", cfg->heatmap_recent_nbins);
+    fprintf(stderr, "# HEATMAP_RANK_MATRIX = %s\n",
+        (cfg->heatmap_rank_matrix_flag) ? "ENABLED" : "DISABLED");
+    if(cfg->checkpoint_interval > 0)
+    {
+        fprintf(stderr, "# CHECKPOINT_INTERVAL = %d seconds\n", cfg->checkpoint_interval);
+        fprintf(stderr, "# CHECKPOINT_PATH = %s\n",
+            (cfg->checkpoint_path) ? cfg->checkpoint_path : "CWD");
+    }
+    else
+        fprintf(stderr, "# CHECKPOINT_INTERVAL = DISABLED\n");
     for(i = 1; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
     {
         fprintf(stderr, "# %s MODULE CONFIG:\n", darshan_module_names[i]);
@@ -978,6 +1045,7 @@ void darshan_free_config(
 #ifdef __DARSHAN_ENABLE_MMAP_LOGS
     free(cfg->mmap_log_path);
 #endif
+    free(cfg->checkpoint_path);
     if(cfg->user_exclude_dirs)
     {   while((path = cfg->user_exclude_dirs[tmp_index++]))
             free(path);
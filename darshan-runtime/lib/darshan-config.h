@@ -37,6 +37,12 @@ struct darshan_config
     char *rank_inclusions;
     struct dxt_trigger *small_io_trigger;
     struct dxt_trigger *unaligned_io_trigger;
+    int heatmap_nbins;
+    double heatmap_bin_width;
+    int heatmap_recent_nbins;
+    int heatmap_rank_matrix_flag;
+    int checkpoint_interval;
+    char *checkpoint_path;
     int internal_timing_flag;
     int disable_shared_redux_flag;
     int dump_config_flag;
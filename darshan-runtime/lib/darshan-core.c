@@ -35,6 +35,9 @@
 #include <zlib.h>
 #include <errno.h>
 #include <assert.h>
+#ifdef HAVE_CPUID_H
+#include <cpuid.h>
+#endif
 
 #ifdef HAVE_MPI
 #include <mpi.h>
@@ -46,6 +49,7 @@
 #include "darshan-config.h"
 #include "darshan-dynamic.h"
 #include "darshan-dxt.h"
+#include "darshan-heatmap.h"
 
 #ifdef DARSHAN_LUSTRE
 #include <lustre/lustre_user.h>
@@ -55,6 +59,9 @@ extern char* __progname;
 extern char* __progname_full;
 struct darshan_core_runtime *__darshan_core = NULL;
 double __darshan_core_wtime_offset = 0;
+double __darshan_core_tsc_scale = 0;
+unsigned long long __darshan_core_tsc_base = 0;
+double __darshan_core_tsc_base_time = 0;
 #ifdef HAVE_STDATOMIC_H
 atomic_flag __darshan_core_mutex = ATOMIC_FLAG_INIT;
 #else
@@ -66,6 +73,29 @@ static int using_mpi = 0;
 static int my_rank = 0;
 static int nprocs = 1;
 static int orig_parent_pid = 0;
+static int tsc_calibrated = 0;
+
+/* state for periodically checkpointing this process's records to a
+ * standalone log file, if enabled
+ */
+struct darshan_core_checkpoint
+{
+    char log_prefix[__DARSHAN_PATH_MAX];
+    int interval;
+    int seq;
+    size_t name_mem_done;
+    char *shadow; /* module records as of the last checkpoint */
+    char *delta; /* job data, new name records, and changed module records */
+    size_t delta_sz;
+    char *comp_buf;
+    pid_t pid;
+    uint64_t proc_id; /* distinguishes processes that share a rank */
+    int stop;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
+static struct darshan_core_checkpoint *ckpt = NULL;
 static int parent_pid;
 
 static struct darshan_core_mnt_data mnt_data_array[DARSHAN_MAX_MNTS];
@@ -151,6 +181,13 @@ static int darshan_deflate_buffer(
 static void darshan_core_cleanup(
     struct darshan_core_runtime* core);
 static void darshan_core_fork_child_cb(void);
+static void darshan_core_calibrate_tsc(void);
+static void darshan_core_start_checkpoints(
+    struct darshan_core_runtime *core);
+static void darshan_core_stop_checkpoints(void);
+static void darshan_core_remove_checkpoints(void);
+static void darshan_core_track_record_size(
+    struct darshan_core_module *mod, size_t rec_size);
 #ifdef HAVE_MPI
 static void darshan_core_reduce_min_time(
     void* in_time_v, void* inout_time_v,
@@ -160,6 +197,25 @@ static void darshan_core_reduce_max_time(
     int *len, MPI_Datatype *datatype);
 #endif
 
+#ifdef __DARSHAN_ENABLE_MMAP_LOGS
+/* bracket updates to the mmap log header, name records, and module maps
+ * with increments of the sequence counter stored at the end of the mmap
+ * log, so that tools sampling the log mid-job get consistent snapshots
+ */
+#define DARSHAN_MMAP_LOG_UPDATE_BEGIN(__core) do { \
+    __atomic_store_n((__core)->mmap_seq_p, *(__core)->mmap_seq_p + 1, \
+        __ATOMIC_RELAXED); \
+    __atomic_thread_fence(__ATOMIC_RELEASE); \
+} while(0)
+#define DARSHAN_MMAP_LOG_UPDATE_END(__core) do { \
+    __atomic_store_n((__core)->mmap_seq_p, *(__core)->mmap_seq_p + 1, \
+        __ATOMIC_RELEASE); \
+} while(0)
+#else
+#define DARSHAN_MMAP_LOG_UPDATE_BEGIN(__core)
+#define DARSHAN_MMAP_LOG_UPDATE_END(__core)
+#endif
+
 #define DARSHAN_WARN(__err_str, ...) do { \
     darshan_core_fprintf(stderr, "darshan_library_warning: " \
         __err_str ".\n", ## __VA_ARGS__); \
@@ -211,6 +267,13 @@ void darshan_core_initialize(int argc, char **argv)
     if (__darshan_core != NULL || getenv("DARSHAN_DISABLE"))
         return;
 
+    /* switch to TSC-based timing if possible, before taking any timestamps */
+    if(!tsc_calibrated)
+    {
+        darshan_core_calibrate_tsc();
+        tsc_calibrated = 1;
+    }
+
     init_start = darshan_core_wtime_absolute();
 
     /* allocate structure to track darshan core runtime information */
@@ -352,6 +415,10 @@ void darshan_core_initialize(int argc, char **argv)
             pthread_atfork(NULL, NULL, &darshan_core_fork_child_cb);
         }
 
+        /* start checkpointing before any module can register records */
+        if(init_core->config.checkpoint_interval > 0)
+            darshan_core_start_checkpoints(init_core);
+
         /* if darshan was successfully initialized, set the global pointer
          * and record absolute start time so that we can later generate
          * relative times with this as a reference point.
@@ -438,6 +505,9 @@ void darshan_core_shutdown(int write_log)
     __darshan_core = NULL;
     __DARSHAN_CORE_UNLOCK();
 
+    /* make sure no checkpoint is in progress while we write the log */
+    darshan_core_stop_checkpoints();
+
     /* skip to cleanup if not writing a log */
     if(!write_log)
         goto cleanup;
@@ -470,6 +540,11 @@ void darshan_core_shutdown(int write_log)
      * there will be no mmap files and no final log file.
      */
     unlink(final_core->mmap_log_name);
+
+    /* the header is rewritten below to describe the final log, so leave
+     * the sequence counter odd to keep live readers from using it
+     */
+    DARSHAN_MMAP_LOG_UPDATE_BEGIN(final_core);
 #endif
 
     final_core->comp_buf = malloc(final_core->config.mod_mem);
@@ -677,6 +752,9 @@ void darshan_core_shutdown(int write_log)
     /* finalize log file name and permissions */
     darshan_log_finalize(logfile_name, start_log_time);
 
+    /* the final log supersedes any checkpoints written by this process */
+    darshan_core_remove_checkpoints();
+
     if(internal_timing_flag)
     {
         double open_tm;
@@ -756,6 +834,14 @@ cleanup:
         if(final_core->mod_array[i])
             final_core->mod_array[i]->mod_funcs.mod_cleanup_func();
     darshan_core_cleanup(final_core);
+    if(ckpt)
+    {
+        free(ckpt->shadow);
+        free(ckpt->delta);
+        free(ckpt->comp_buf);
+        free(ckpt);
+        ckpt = NULL;
+    }
 #ifdef HAVE_MPI
     if(using_mpi)
     {
@@ -787,7 +873,8 @@ static void *darshan_init_mmap_log(struct darshan_core_runtime* core, int jobid)
     assert(sys_page_size > 0);
 
     mmap_size = sizeof(struct darshan_header) + DARSHAN_JOB_RECORD_SIZE +
-        + core->config.name_mem + core->config.mod_mem;
+        + core->config.name_mem + core->config.mod_mem +
+        DARSHAN_MMAP_LOG_SEQ_SIZE;
     if(mmap_size % sys_page_size)
         mmap_size = ((mmap_size / sys_page_size) + 1) * sys_page_size;
 
@@ -853,6 +940,10 @@ static void *darshan_init_mmap_log(struct darshan_core_runtime* core, int jobid)
     /* close darshan log file (this does *not* unmap the log file) */
     close(mmap_fd);
 
+    /* the sequence counter occupies the last bytes of the log file */
+    core->mmap_seq_p = (uint64_t *)((char *)mmap_p + mmap_size -
+        DARSHAN_MMAP_LOG_SEQ_SIZE);
+
     return(mmap_p);
 }
 #endif
@@ -2164,6 +2255,7 @@ static void darshan_core_cleanup(struct darshan_core_runtime* core)
     {
         if(core->mod_array[i])
         {
+            free(core->mod_array[i]->rec_sizes);
             free(core->mod_array[i]);
             core->mod_array[i] = NULL;
         }
@@ -2210,6 +2302,425 @@ static void darshan_core_fork_child_cb(void)
     return;
 }
 
+/* length of the busy-wait used to measure the TSC frequency */
+#define DARSHAN_TSC_CALIBRATION_NSEC (5*1000*1000)
+
+/* enable TSC-based timing in darshan_core_wtime_absolute() if the CPU
+ * has an invariant TSC, using a frequency measured against CLOCK_MONOTONIC;
+ * leaves the clock_gettime() path in place otherwise, or if the user set
+ * DARSHAN_DISABLE_TSC_TIMER
+ */
+static void darshan_core_calibrate_tsc(void)
+{
+#if defined(HAVE_RDTSCP_INTRINSIC) && defined(HAVE_CPUID_H) && \
+    !defined(__DARSHAN_RDTSCP_FREQUENCY)
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int flag;
+    unsigned long long tsc1, tsc2;
+    struct timespec mono1, mono2, real;
+    double elapsed, freq;
+
+    if(getenv("DARSHAN_DISABLE_TSC_TIMER"))
+        return;
+
+    /* CPUID.80000007H:EDX[8] indicates the TSC runs at a constant rate
+     * regardless of frequency scaling and sleep states
+     */
+    if(!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1 << 8)))
+        return;
+
+    clock_gettime(CLOCK_REALTIME, &real);
+    clock_gettime(CLOCK_MONOTONIC, &mono1);
+    tsc1 = __rdtscp(&flag);
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &mono2);
+        elapsed = (double)(mono2.tv_sec - mono1.tv_sec) +
+            1.0e-9 * (double)(mono2.tv_nsec - mono1.tv_nsec);
+    } while(elapsed < 1.0e-9 * DARSHAN_TSC_CALIBRATION_NSEC);
+    tsc2 = __rdtscp(&flag);
+
+    /* sanity check the measured frequency; fall back to clock_gettime()
+     * if it is implausible (e.g., because the process was descheduled)
+     */
+    freq = (double)(tsc2 - tsc1) / elapsed;
+    if(tsc2 <= tsc1 || freq < 1.0e8 || freq > 1.0e11)
+        return;
+
+    __darshan_core_tsc_base = tsc1;
+    __darshan_core_tsc_base_time = ((double)real.tv_sec) +
+        1.0e-9 * ((double)real.tv_nsec);
+    __darshan_core_tsc_scale = 1.0 / freq;
+#endif
+
+    return;
+}
+
+/* darshan_core_track_record_size()
+ *
+ * Remember the size of each record a module registers, so that checkpoints
+ * can compare and copy individual records. Must be called with the core
+ * lock held.
+ */
+static void darshan_core_track_record_size(struct darshan_core_module *mod,
+    size_t rec_size)
+{
+    size_t *tmp_sizes;
+    int new_len;
+
+    /* a negative count means tracking failed and the module is skipped */
+    if(mod->rec_count < 0)
+        return;
+
+    if(mod->rec_count == mod->rec_sizes_len)
+    {
+        new_len = (mod->rec_sizes_len) ? (2 * mod->rec_sizes_len) : 64;
+        tmp_sizes = realloc(mod->rec_sizes, new_len * sizeof(*tmp_sizes));
+        if(!tmp_sizes)
+        {
+            mod->rec_count = -1;
+            return;
+        }
+        mod->rec_sizes = tmp_sizes;
+        mod->rec_sizes_len = new_len;
+    }
+    mod->rec_sizes[mod->rec_count++] = rec_size;
+
+    return;
+}
+
+/* darshan_core_write_checkpoint()
+ *
+ * Write the records that changed since the previous checkpoint, along
+ * with any new name records, to a standalone (uncollective) log file.
+ * Module memory is only compared and copied while holding the core lock;
+ * compression and I/O happen after releasing it.
+ */
+static void darshan_core_write_checkpoint(void)
+{
+    struct darshan_header hdr;
+    struct darshan_job *job;
+    struct darshan_core_module *mod;
+    struct darshan_base_record *base_rec;
+    struct timespec now;
+    char *exemnt, *names, *mod_p, *rec_p, *shadow_p;
+    char *mod_start[DARSHAN_KNOWN_MODULE_COUNT] = {0};
+    int mod_len[DARSHAN_KNOWN_MODULE_COUNT] = {0};
+    int name_len;
+    int changed = 0;
+    char ckpt_name[__DARSHAN_PATH_MAX];
+    char tmp_name[__DARSHAN_PATH_MAX];
+    void *pointers[2];
+    int lengths[2];
+    int comp_sz;
+    uint64_t off;
+    int meta_remain;
+    int fd;
+    int ret = 0;
+    int i, j;
+
+    job = (struct darshan_job *)ckpt->delta;
+    exemnt = ckpt->delta + sizeof(*job);
+    names = exemnt + DARSHAN_EXE_LEN + 1;
+
+    __DARSHAN_CORE_LOCK();
+    if(!__darshan_core)
+    {
+        __DARSHAN_CORE_UNLOCK();
+        return;
+    }
+
+    memcpy(&hdr, __darshan_core->log_hdr_p, sizeof(hdr));
+    memcpy(job, __darshan_core->log_job_p, sizeof(*job));
+    memcpy(exemnt, __darshan_core->log_exemnt_p, DARSHAN_EXE_LEN + 1);
+
+    /* name records are only ever appended, so just copy the new ones */
+    name_len = __darshan_core->name_mem_used - ckpt->name_mem_done;
+    memcpy(names, (char *)__darshan_core->log_name_p + ckpt->name_mem_done,
+        name_len);
+    ckpt->name_mem_done = __darshan_core->name_mem_used;
+    if(name_len > 0)
+        changed = 1;
+
+    mod_p = names + name_len;
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        mod = __darshan_core->mod_array[i];
+        /* DXT modules manage their own memory and are not checkpointed */
+        if(!mod || !mod->rec_buf_start || mod->rec_count < 0)
+            continue;
+
+        mod_start[i] = mod_p;
+        rec_p = mod->rec_buf_start;
+        shadow_p = ckpt->shadow + (rec_p - (char *)__darshan_core->log_mod_p);
+        for(j = 0; j < mod->rec_count; j++)
+        {
+            base_rec = (struct darshan_base_record *)rec_p;
+            /* skip records the module has not initialized yet */
+            if(base_rec->id != 0 && memcmp(rec_p, shadow_p, mod->rec_sizes[j]))
+            {
+                memcpy(shadow_p, rec_p, mod->rec_sizes[j]);
+                memcpy(mod_p, rec_p, mod->rec_sizes[j]);
+                mod_p += mod->rec_sizes[j];
+                mod_len[i] += mod->rec_sizes[j];
+                changed = 1;
+            }
+            rec_p += mod->rec_sizes[j];
+            shadow_p += mod->rec_sizes[j];
+        }
+    }
+    __DARSHAN_CORE_UNLOCK();
+
+    if(!changed)
+        return;
+
+    ckpt->seq++;
+    ret = snprintf(ckpt_name, __DARSHAN_PATH_MAX, "%s_ckpt%06d.darshan",
+        ckpt->log_prefix, ckpt->seq);
+    if(ret >= 0 && ret < __DARSHAN_PATH_MAX)
+        ret = snprintf(tmp_name, __DARSHAN_PATH_MAX, "%s.tmp", ckpt_name);
+    if(ret < 0 || ret >= __DARSHAN_PATH_MAX)
+    {
+        DARSHAN_WARN("checkpoint file name too long, skipping checkpoint");
+        ckpt->seq--;
+        return;
+    }
+    ret = 0;
+
+    /* the job record describes the job up to this checkpoint */
+    clock_gettime(CLOCK_REALTIME, &now);
+    job->end_time_sec = (int64_t)now.tv_sec;
+    job->end_time_nsec = (int64_t)now.tv_nsec;
+    meta_remain = DARSHAN_JOB_METADATA_LEN - strlen(job->metadata) - 1;
+    if(meta_remain >= 64)
+        sprintf(job->metadata + strlen(job->metadata),
+            "checkpoint=%d\ncheckpoint_proc=%" PRIu64 "\n",
+            ckpt->seq, ckpt->proc_id);
+
+    fd = open(tmp_name, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR);
+    if(fd < 0)
+    {
+        DARSHAN_WARN("unable to create checkpoint file %s", tmp_name);
+        return;
+    }
+
+    /* job record and exe/mount string */
+    off = sizeof(hdr);
+    pointers[0] = job;
+    pointers[1] = exemnt;
+    lengths[0] = sizeof(*job);
+    lengths[1] = strlen(exemnt);
+    comp_sz = ckpt->delta_sz;
+    ret = darshan_deflate_buffer(pointers, lengths, 2, ckpt->comp_buf, &comp_sz);
+    if(ret == 0 && pwrite(fd, ckpt->comp_buf, comp_sz, off) != comp_sz)
+        ret = -1;
+    off += comp_sz;
+
+    /* new name records */
+    hdr.name_map.off = off;
+    comp_sz = ckpt->delta_sz;
+    if(ret == 0)
+        ret = darshan_deflate_buffer((void **)&names, &name_len, 1,
+            ckpt->comp_buf, &comp_sz);
+    if(ret == 0 && pwrite(fd, ckpt->comp_buf, comp_sz, off) != comp_sz)
+        ret = -1;
+    off += comp_sz;
+    hdr.name_map.len = off - hdr.name_map.off;
+
+    /* changed records of each module */
+    for(i = 0; i < DARSHAN_MAX_MODS; i++)
+    {
+        hdr.mod_map[i].off = hdr.mod_map[i].len = 0;
+        if(ret != 0 || i >= DARSHAN_KNOWN_MODULE_COUNT || mod_len[i] == 0)
+            continue;
+
+        comp_sz = ckpt->delta_sz;
+        ret = darshan_deflate_buffer((void **)&mod_start[i], &mod_len[i], 1,
+            ckpt->comp_buf, &comp_sz);
+        if(ret == 0 && pwrite(fd, ckpt->comp_buf, comp_sz, off) != comp_sz)
+            ret = -1;
+        hdr.mod_map[i].off = off;
+        hdr.mod_map[i].len = comp_sz;
+        off += comp_sz;
+    }
+
+    hdr.comp_type = DARSHAN_ZLIB_COMP;
+    if(ret == 0 && pwrite(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr))
+        ret = -1;
+    close(fd);
+
+    /* only expose complete checkpoints under their final name */
+    if(ret == 0)
+        ret = rename(tmp_name, ckpt_name);
+    if(ret != 0)
+    {
+        DARSHAN_WARN("unable to write checkpoint file %s", ckpt_name);
+        unlink(tmp_name);
+        ckpt->seq--;
+    }
+
+    return;
+}
+
+static void *darshan_core_checkpoint_thread(void *arg)
+{
+    struct timespec deadline;
+
+    pthread_mutex_lock(&ckpt->mutex);
+    while(!ckpt->stop)
+    {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += ckpt->interval;
+        while(!ckpt->stop &&
+            pthread_cond_timedwait(&ckpt->cond, &ckpt->mutex, &deadline) != ETIMEDOUT);
+        if(ckpt->stop)
+            break;
+
+        pthread_mutex_unlock(&ckpt->mutex);
+        darshan_core_write_checkpoint();
+        pthread_mutex_lock(&ckpt->mutex);
+    }
+    pthread_mutex_unlock(&ckpt->mutex);
+
+    return(NULL);
+}
+
+/* darshan_core_start_checkpoints()
+ *
+ * Allocate checkpoint state and start a thread that checkpoints this
+ * process's records every 'checkpoint_interval' seconds. Checkpoint files
+ * are named <user>_<exe>_id<jobid>_<start time>_<rank>-<pid>_ckpt<seq>.darshan,
+ * so that all checkpoints of a job share a common prefix and sort by
+ * sequence number. Collective when using MPI.
+ */
+static void darshan_core_start_checkpoints(struct darshan_core_runtime *core)
+{
+    char ckpt_dir[__DARSHAN_PATH_MAX];
+    char cuser[L_cuserid] = {0};
+    char hname[HOST_NAME_MAX] = {0};
+    int64_t prefix_ids[2];
+    char *exe;
+    int ret;
+
+    /* agree on a job id and start time so the checkpoints of all ranks
+     * share a prefix
+     */
+    prefix_ids[0] = core->log_job_p->jobid;
+    prefix_ids[1] = core->log_job_p->start_time_sec;
+#ifdef HAVE_MPI
+    if(using_mpi)
+        PMPI_Bcast(prefix_ids, 2, MPI_INT64_T, 0, core->mpi_comm);
+#endif
+
+    if(!realpath(core->config.checkpoint_path ? core->config.checkpoint_path : ".",
+        ckpt_dir))
+    {
+        DARSHAN_WARN("unable to resolve checkpoint path, disabling checkpoints");
+        return;
+    }
+
+    ckpt = malloc(sizeof(*ckpt));
+    if(!ckpt)
+        return;
+    memset(ckpt, 0, sizeof(*ckpt));
+
+    darshan_get_user_name(cuser);
+    exe = strrchr(__progname, '/');
+    exe = exe ? exe + 1 : __progname;
+    /* leave room for the "_ckpt<seq>.darshan.tmp" suffix */
+    ret = snprintf(ckpt->log_prefix, __DARSHAN_PATH_MAX, "%s/%s_%s_id%" PRId64 "_%" PRId64 "_%d-%d",
+        ckpt_dir, cuser, exe, prefix_ids[0], prefix_ids[1], my_rank,
+        (int)getpid());
+    if(ret < 0 || ret >= __DARSHAN_PATH_MAX - 32)
+    {
+        DARSHAN_WARN("checkpoint path too long, disabling checkpoints");
+        free(ckpt);
+        ckpt = NULL;
+        return;
+    }
+    ckpt->interval = core->config.checkpoint_interval;
+    ckpt->pid = getpid();
+
+    /* ranks are not unique without MPI (every process is rank 0), so
+     * checkpoints also record a host and pid based process identity for
+     * darshan-merge to tell processes apart
+     */
+    (void)gethostname(hname, sizeof(hname));
+    hname[sizeof(hname) - 1] = '\0';
+    ckpt->proc_id = darshan_hash((void *)hname, strlen(hname), (uint64_t)ckpt->pid);
+
+    ckpt->delta_sz = sizeof(struct darshan_job) + DARSHAN_EXE_LEN + 1 +
+        core->config.name_mem + core->config.mod_mem;
+    ckpt->shadow = calloc(1, core->config.mod_mem);
+    ckpt->delta = malloc(ckpt->delta_sz);
+    ckpt->comp_buf = malloc(ckpt->delta_sz);
+    if(!ckpt->shadow || !ckpt->delta || !ckpt->comp_buf)
+        goto fail;
+
+    pthread_mutex_init(&ckpt->mutex, NULL);
+    pthread_cond_init(&ckpt->cond, NULL);
+    ret = pthread_create(&ckpt->thread, NULL, darshan_core_checkpoint_thread, NULL);
+    if(ret != 0)
+        goto fail;
+
+    return;
+
+fail:
+    DARSHAN_WARN("unable to start checkpoint thread, disabling checkpoints");
+    free(ckpt->shadow);
+    free(ckpt->delta);
+    free(ckpt->comp_buf);
+    free(ckpt);
+    ckpt = NULL;
+    return;
+}
+
+/* darshan_core_stop_checkpoints()
+ *
+ * Stop the checkpoint thread of this process, waiting for any checkpoint
+ * in progress to complete.
+ */
+static void darshan_core_stop_checkpoints(void)
+{
+    /* the checkpoint thread does not survive fork(), so there is nothing
+     * to stop (or lock) in a child process
+     */
+    if(!ckpt || ckpt->pid != getpid())
+        return;
+
+    pthread_mutex_lock(&ckpt->mutex);
+    ckpt->stop = 1;
+    pthread_cond_signal(&ckpt->cond);
+    pthread_mutex_unlock(&ckpt->mutex);
+    pthread_join(ckpt->thread, NULL);
+
+    return;
+}
+
+/* darshan_core_remove_checkpoints()
+ *
+ * Remove all checkpoint files written by this process.
+ */
+static void darshan_core_remove_checkpoints(void)
+{
+    char ckpt_name[__DARSHAN_PATH_MAX];
+    int ret;
+    int i;
+
+    if(!ckpt || ckpt->pid != getpid())
+        return;
+
+    for(i = 1; i <= ckpt->seq; i++)
+    {
+        ret = snprintf(ckpt_name, __DARSHAN_PATH_MAX, "%s_ckpt%06d.darshan",
+            ckpt->log_prefix, i);
+        if(ret < 0 || ret >= __DARSHAN_PATH_MAX)
+            continue;
+        unlink(ckpt_name);
+    }
+
+    return;
+}
+
 static int darshan_core_name_is_excluded(const char *name, darshan_module_id mod_id)
 {
     int name_is_path;
@@ -2224,6 +2735,11 @@ static int darshan_core_name_is_excluded(const char *name, darshan_module_id mod
        (mod_id == DARSHAN_HEATMAP_MOD) || (mod_id == DARSHAN_MDHIM_MOD))
         name_is_path = 0;
 
+    /* never instrument our own checkpoint files */
+    if(name_is_path && ckpt &&
+       !strncmp(ckpt->log_prefix, name, strlen(ckpt->log_prefix)))
+        return(1);
+
     if(name_is_path)
     {
         /* if record name is a path, check against either default or
@@ -2558,7 +3074,9 @@ int darshan_core_register_module(
 
     /* register module with darshan */
     __darshan_core->mod_array[mod_id] = mod;
+    DARSHAN_MMAP_LOG_UPDATE_BEGIN(__darshan_core);
     __darshan_core->log_hdr_p->mod_ver[mod_id] = darshan_module_versions[mod_id];
+    DARSHAN_MMAP_LOG_UPDATE_END(__darshan_core);
 
     /* set the memory alignment and calling process's rank, if desired */
     if(sys_mem_alignment)
@@ -2592,12 +3110,15 @@ void darshan_core_unregister_module(
     /* NOTE: save pointer to free module after lock is released */
     mod = __darshan_core->mod_array[mod_id];
     __darshan_core->mod_array[mod_id] = NULL;
+    DARSHAN_MMAP_LOG_UPDATE_BEGIN(__darshan_core);
     __darshan_core->log_hdr_p->mod_ver[mod_id] = 0;
 #ifdef __DARSHAN_ENABLE_MMAP_LOGS
     __darshan_core->log_hdr_p->mod_map[mod_id].off =
         __darshan_core->log_hdr_p->mod_map[mod_id].len = 0;
 #endif
+    DARSHAN_MMAP_LOG_UPDATE_END(__darshan_core);
     __DARSHAN_CORE_UNLOCK();
+    free(mod->rec_sizes);
     free(mod);
 
     return;
@@ -2636,12 +3157,15 @@ void *darshan_core_register_record(
         return(NULL);
     }
 
+    DARSHAN_MMAP_LOG_UPDATE_BEGIN(__darshan_core);
+
     /* register a name record if a name is given for this record */
     if(name)
     {
         if(darshan_core_name_is_excluded(name, mod_id))
         {
             /* do not register record if name matches any exclusion rules */
+            DARSHAN_MMAP_LOG_UPDATE_END(__darshan_core);
             __DARSHAN_CORE_UNLOCK();
             return(NULL);
         }
@@ -2657,6 +3181,7 @@ void *darshan_core_register_record(
             if(ret == 0)
             {
                 DARSHAN_MOD_FLAG_SET(__darshan_core->log_hdr_p->partial_flag, mod_id);
+                DARSHAN_MMAP_LOG_UPDATE_END(__darshan_core);
                 __DARSHAN_CORE_UNLOCK();
                 return(NULL);
             }
@@ -2675,6 +3200,9 @@ void *darshan_core_register_record(
          */
         rec_buf = __darshan_core->mod_array[mod_id]->rec_buf_p;
         __darshan_core->mod_array[mod_id]->rec_buf_p += rec_size;
+        if(ckpt)
+            darshan_core_track_record_size(__darshan_core->mod_array[mod_id],
+                rec_size);
 #ifdef __DARSHAN_ENABLE_MMAP_LOGS
         __darshan_core->log_hdr_p->mod_map[mod_id].len += rec_size;
 #endif
@@ -2689,6 +3217,8 @@ void *darshan_core_register_record(
         rec_buf = (void *)1;
     }
 
+    DARSHAN_MMAP_LOG_UPDATE_END(__darshan_core);
+
     __DARSHAN_CORE_UNLOCK();
 
     if(fs_info)
@@ -2712,6 +3242,27 @@ char *darshan_core_lookup_record_name(darshan_record_id rec_id)
     return(name);
 }
 
+void darshan_core_heatmap_config(int *nbins, double *bin_width,
+    int *recent_nbins, int *rank_matrix)
+{
+    *nbins = DARSHAN_DEF_HEATMAP_NBINS;
+    *bin_width = DARSHAN_DEF_HEATMAP_BIN_WIDTH;
+    *recent_nbins = 0;
+    *rank_matrix = 0;
+
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core)
+    {
+        *nbins = __darshan_core->config.heatmap_nbins;
+        *bin_width = __darshan_core->config.heatmap_bin_width;
+        *recent_nbins = __darshan_core->config.heatmap_recent_nbins;
+        *rank_matrix = __darshan_core->config.heatmap_rank_matrix_flag;
+    }
+    __DARSHAN_CORE_UNLOCK();
+
+    return;
+}
+
 void darshan_instrument_fs_data(int fs_type, const char *path, int fd)
 {
 #ifdef DARSHAN_LUSTRE
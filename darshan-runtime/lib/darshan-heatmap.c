@@ -29,18 +29,6 @@
  */
 double g_end_timestamp = 0;
 
-/* maximum number of bins per record */
-/* TODO: make this tunable at runtime */
-/* TODO: safety check that total record size plus trailing bins doesn't
- * exceed DEF_MOD_BUF_SIZE.  If it does, the log will still be technically
- * valid but the default darshan-parser will not be able to display it.
- */
-#define DARSHAN_MAX_HEATMAP_BINS 200
-
-/* initial width of each bin, as floating point seconds */
-/* TODO: make this tunable at runtime */
-#define DARSHAN_INITIAL_BIN_WIDTH_SECONDS 0.1
-
 /* maximum number of distinct heatmaps that we will track (there is a
  * heatmap per module that interacts with it, not per file, so we should not
  * need many).  If this limit is exceeded then the darshan core will mark
@@ -50,10 +38,39 @@ double g_end_timestamp = 0;
 /* TODO: make this tunable at runtime */
 #define DARSHAN_MAX_HEATMAPS 8
 
+/* upper limit (in bytes) on the size of each rank x time matrix gathered to
+ * rank 0 when HEATMAP_RANK_MATRIX is enabled.  Heatmaps are collapsed to
+ * coarser bins as needed to stay within this limit at large scale.
+ */
+#define DARSHAN_MAX_HEATMAP_RANK_MATRIX_SIZE (16*1024*1024)
+
+/* size of a heatmap record including its trailing read and write bins */
+#define HEATMAP_REC_SIZE(__nbins) \
+    (sizeof(struct darshan_heatmap_record) + 2*(__nbins)*sizeof(int64_t))
+
 /* structure to track heatmaps at runtime */
 struct heatmap_record_ref
 {
     struct darshan_heatmap_record* heatmap_rec;
+    /* if enabled, a ring of fixed-width bins tracking only the most recent
+     * activity; it is stored immediately after heatmap_rec's bins
+     */
+    struct darshan_heatmap_record* recent_rec;
+    int64_t recent_last_bin; /* absolute index of the newest bin in the ring */
+    int gathered; /* heatmap_rec was gathered into a rank matrix */
+};
+
+/* a heatmap gathered from all ranks at shutdown; each of the nprocs rows
+ * holds a rank's quantized write bins followed by its read bins
+ */
+struct heatmap_rank_matrix
+{
+    darshan_record_id rec_id;
+    double bin_width_seconds;
+    int64_t nbins;
+    int64_t write_quantum;
+    int64_t read_quantum;
+    uint8_t *bins;
 };
 
 /* The heatmap_runtime structure maintains necessary state for storing
@@ -64,6 +81,20 @@ struct heatmap_runtime
     void *rec_id_hash;
     int rec_count;
     int frozen; /* flag to indicate that the counters should no longer be modified */
+    int nbins; /* number of bins in each whole-execution heatmap */
+    double bin_width; /* initial bin width, in seconds */
+    int recent_nbins; /* number of bins in each recent activity ring (0 if disabled) */
+    int rank_matrix; /* gather heatmaps into a rank x time matrix at shutdown */
+    /* rank matrices gathered during reduction (only on rank 0) */
+    struct heatmap_rank_matrix rank_matrices[DARSHAN_MAX_HEATMAPS];
+    int rank_matrix_count;
+    int nprocs;
+    /* output buffer for the module's records followed by the rank
+     * matrices; reserved on rank 0 while gathering, so that running out of
+     * memory is detected before any rank hands its heatmaps over
+     */
+    void *output_buf;
+    size_t output_buf_size;
 };
 
 static struct heatmap_runtime *heatmap_runtime = NULL;
@@ -72,7 +103,17 @@ static int my_rank = -1;
 static struct heatmap_record_ref *heatmap_track_new_record(
     darshan_record_id rec_id, const char *name);
 static void collapse_heatmap(struct darshan_heatmap_record *rec);
+static void heatmap_update_recent(struct heatmap_record_ref *rec_ref,
+    int rw_flag, int64_t size, double start_time, double end_time);
+static void finalize_recent_heatmap(struct darshan_heatmap_record *rec,
+    int64_t last_bin, double end_timestamp);
 #ifdef HAVE_MPI
+static void heatmap_gather_rank_matrices(
+    darshan_record_id *shared_recs, int shared_rec_count,
+    double end_timestamp, MPI_Comm mod_comm);
+static void heatmap_output_rank_matrices(
+    void **heatmap_buf, int *heatmap_buf_sz);
+static size_t heatmap_rank_matrix_out_size(int64_t nbins, int nprocs);
 static void heatmap_mpi_redux(
     void *stdio_buf, MPI_Comm mod_comm,
     darshan_record_id *shared_recs, int shared_rec_count);
@@ -125,8 +166,10 @@ static void heatmap_output(
     int *heatmap_buf_sz)
 {
     struct darshan_heatmap_record* rec;
-    struct darshan_heatmap_record* next_rec;
+    struct heatmap_record_ref *rec_ref;
+    void* slot_ptr;
     void* contig_buf_ptr;
+    size_t slot_size;
     int i,j;
     double end_timestamp;
     unsigned long this_size;
@@ -147,91 +190,98 @@ static void heatmap_output(
     else
         end_timestamp = darshan_core_wtime();
 
-
-    /* iterate through records (heatmap histograms) to drop any that contain
-     * no data
+    /* each heatmap occupies a fixed size slot in the module buffer: the
+     * whole-execution heatmap, followed by the recent activity heatmap if
+     * that is enabled
      */
-    for(i=0; i<heatmap_runtime->rec_count; i++)
-    {
-        do {
-            rec = (struct darshan_heatmap_record*)((uintptr_t)*heatmap_buf + i*(sizeof(*rec) + DARSHAN_MAX_HEATMAP_BINS*2*sizeof(int64_t)));
-            next_rec = (struct darshan_heatmap_record*)((uintptr_t)*heatmap_buf + (i+1)*(sizeof(*rec) + DARSHAN_MAX_HEATMAP_BINS*2*sizeof(int64_t)));
-
-            empty = 1;
-            for(j=0; j<DARSHAN_MAX_HEATMAP_BINS; j++)
-            {
-                if(rec->write_bins[j] > 0 || rec->read_bins[j] > 0) {
-                    empty = 0;
-                    break;
-                }
-            }
-            /* reduce record count if this heatmap is empty */
-            if(empty) {
-                heatmap_runtime->rec_count--;
-                /* if there are more heatmaps after this one, shift them all down */
-                if (i < heatmap_runtime->rec_count) {
-                    memmove(rec, next_rec,
-                            (heatmap_runtime->rec_count - i) *
-                            (sizeof(*rec) + DARSHAN_MAX_HEATMAP_BINS * 2 * sizeof(int64_t)));
-                    /* fix pointers in any heatmaps that were compacted */
-                    for (j = 0; j < heatmap_runtime->rec_count - i; j++) {
-                        rec->write_bins
-                            = (int64_t*)((uintptr_t)rec + sizeof(*rec));
-                        rec->read_bins
-                            = (int64_t*)((uintptr_t)rec + sizeof(*rec)
-                              + DARSHAN_MAX_HEATMAP_BINS * sizeof(int64_t));
-                        rec = (struct
-                              darshan_heatmap_record*)((uintptr_t)rec
-                              + (sizeof(*rec) + DARSHAN_MAX_HEATMAP_BINS
-                              * 2 * sizeof(int64_t)));
-                    }
-                }
-            }
-            /* repeat in this i position as long as we find empty heatmaps */
-        } while(empty && i<heatmap_runtime->rec_count);
-    }
+    slot_size = HEATMAP_REC_SIZE(heatmap_runtime->nbins);
+    if(heatmap_runtime->recent_nbins)
+        slot_size += HEATMAP_REC_SIZE(heatmap_runtime->recent_nbins);
 
-    /* iterate through records (heatmap histograms) to normalize bin widths
-     * and compact memory
+    /* iterate through records (heatmap histograms) to drop any that contain
+     * no data, normalize bin widths, and compact memory
      */
     contig_buf_ptr = *heatmap_buf;
     for(i=0; i<heatmap_runtime->rec_count; i++)
     {
-        rec = (struct darshan_heatmap_record*)((uintptr_t)*heatmap_buf + i*(sizeof(*rec) + DARSHAN_MAX_HEATMAP_BINS*2*sizeof(int64_t)));
+        slot_ptr = (void*)((uintptr_t)*heatmap_buf + i*slot_size);
+        rec = (struct darshan_heatmap_record*)slot_ptr;
 
-        /* Collapse records if needed until the total histogram time range
-         * extends to end of execution time.  This will ensure that all of
-         * the heatmap records have a consistent size
-         */
-        while(end_timestamp > rec->bin_width_seconds * DARSHAN_MAX_HEATMAP_BINS)
-            collapse_heatmap(rec);
+        empty = 1;
+        for(j=0; j<rec->nbins; j++)
+        {
+            if(rec->write_bins[j] > 0 || rec->read_bins[j] > 0) {
+                empty = 0;
+                break;
+            }
+        }
+        /* skip this heatmap (and its recent activity ring) if it is empty */
+        if(empty)
+            continue;
 
-        tmp_nbins= ceil(end_timestamp/rec->bin_width_seconds);
+        /* look up runtime state now, before any data in this slot moves */
+        rec_ref = darshan_lookup_record_ref(heatmap_runtime->rec_id_hash,
+            &rec->base_rec.id, sizeof(darshan_record_id));
+        assert(rec_ref);
 
-        /* are there bins beyond the execution time of the program? */
-        if(tmp_nbins < rec->nbins)
+        /* heatmaps gathered into a rank matrix are written by rank 0 below */
+        if(!rec_ref->gathered)
         {
-            /* truncate bins so that we don't report any beyond the time when
-             * instrumentation stopped
+            /* Collapse records if needed until the total histogram time range
+             * extends to end of execution time.  This will ensure that all of
+             * the heatmap records have a consistent size
              */
-            rec->nbins = tmp_nbins;
-            /* shift read_bins down so that memory remains contiguous even
-             * if nbins has been reduced
+            while(end_timestamp > rec->bin_width_seconds * rec->nbins)
+                collapse_heatmap(rec);
+
+            tmp_nbins= ceil(end_timestamp/rec->bin_width_seconds);
+
+            /* are there bins beyond the execution time of the program? */
+            if(tmp_nbins < rec->nbins)
+            {
+                /* truncate bins so that we don't report any beyond the time when
+                 * instrumentation stopped
+                 */
+                rec->nbins = tmp_nbins;
+                /* shift read_bins down so that memory remains contiguous even
+                 * if nbins has been reduced
+                 */
+                memmove(&rec->write_bins[rec->nbins], rec->read_bins,
+                    rec->nbins*sizeof(int64_t));
+                rec->read_bins = &rec->write_bins[rec->nbins];
+            }
+
+            /* now shift the entire record + bins as a contiguous block down in
+             * the buffer so that the entire buffer is contiguous
              */
-            memmove(&rec->write_bins[rec->nbins], rec->read_bins,
-                rec->nbins*sizeof(int64_t));
-            rec->read_bins = &rec->write_bins[rec->nbins];
+            this_size = HEATMAP_REC_SIZE(rec->nbins);
+            memmove(contig_buf_ptr, rec, this_size);
+            contig_buf_ptr += this_size;
+            *heatmap_buf_sz += this_size;
         }
 
-        /* now shift the entire record + bins as a contiguous block down in
-         * the buffer so that the entire buffer is contiguous
-         */
-        this_size = sizeof(*rec) + rec->nbins * 2 * sizeof(uint64_t);
-        memmove(contig_buf_ptr, rec, this_size);
-        contig_buf_ptr += this_size;
-        *heatmap_buf_sz += this_size;
+        if(rec_ref->recent_rec)
+        {
+            /* the recent activity ring trails the (original) whole-execution
+             * heatmap, which is past anything compacted so far
+             */
+            rec = (struct darshan_heatmap_record*)((uintptr_t)slot_ptr +
+                HEATMAP_REC_SIZE(heatmap_runtime->nbins));
+            finalize_recent_heatmap(rec, rec_ref->recent_last_bin,
+                end_timestamp);
+
+            this_size = HEATMAP_REC_SIZE(rec->nbins);
+            memmove(contig_buf_ptr, rec, this_size);
+            contig_buf_ptr += this_size;
+            *heatmap_buf_sz += this_size;
+        }
     }
 
+#ifdef HAVE_MPI
+    if(heatmap_runtime->rank_matrix_count > 0)
+        heatmap_output_rank_matrices(heatmap_buf, heatmap_buf_sz);
+#endif
+
     HEATMAP_UNLOCK();
 
     return;
@@ -239,12 +289,18 @@ static void heatmap_output(
 
 static void heatmap_cleanup()
 {
+    int i;
+
     HEATMAP_LOCK();
     assert(heatmap_runtime);
 
     /* cleanup internal structures used for instrumenting */
     darshan_clear_record_refs(&(heatmap_runtime->rec_id_hash), 1);
 
+    for(i=0; i<heatmap_runtime->rank_matrix_count; i++)
+        free(heatmap_runtime->rank_matrices[i].bins);
+    free(heatmap_runtime->output_buf);
+
     free(heatmap_runtime);
     heatmap_runtime = NULL;
 
@@ -256,12 +312,38 @@ struct heatmap_runtime* heatmap_runtime_initialize(void)
 {
     struct heatmap_runtime* tmp_runtime;
     int ret;
-    /* NOTE: this module generates one record per module that uses it, so
-     * the memory requirements should be modest
-     */
-    size_t heatmap_buf_size = sizeof(struct darshan_heatmap_record) + 2*DARSHAN_MAX_HEATMAP_BINS*sizeof(int64_t);
+    int nbins;
+    double bin_width;
+    int recent_nbins;
+    int rank_matrix;
+    size_t heatmap_buf_size;
     size_t heatmap_rec_count = DARSHAN_MAX_HEATMAPS;
 
+    /* sanity check the heatmap resolution requested by the user */
+    darshan_core_heatmap_config(&nbins, &bin_width, &recent_nbins,
+        &rank_matrix);
+    if(nbins < 2)
+        nbins = DARSHAN_DEF_HEATMAP_NBINS;
+    if(nbins > DARSHAN_MAX_HEATMAP_NBINS)
+        nbins = DARSHAN_MAX_HEATMAP_NBINS;
+    /* collapsing a heatmap merges pairs of bins, so nbins must be even */
+    if(nbins % 2)
+        nbins++;
+    if(bin_width <= 0)
+        bin_width = DARSHAN_DEF_HEATMAP_BIN_WIDTH;
+    if(recent_nbins < 0)
+        recent_nbins = 0;
+    if(recent_nbins > DARSHAN_MAX_HEATMAP_NBINS)
+        recent_nbins = DARSHAN_MAX_HEATMAP_NBINS;
+
+    /* NOTE: this module generates one record (or two, if recent activity
+     * is tracked) per module that uses it, so the memory requirements
+     * should be modest
+     */
+    heatmap_buf_size = HEATMAP_REC_SIZE(nbins);
+    if(recent_nbins)
+        heatmap_buf_size += HEATMAP_REC_SIZE(recent_nbins);
+
     darshan_module_funcs mod_funcs = {
 #ifdef HAVE_MPI
         .mod_redux_func = heatmap_mpi_redux,
@@ -291,6 +373,10 @@ struct heatmap_runtime* heatmap_runtime_initialize(void)
         return(NULL);
     }
     memset(tmp_runtime, 0, sizeof(*tmp_runtime));
+    tmp_runtime->nbins = nbins;
+    tmp_runtime->bin_width = bin_width;
+    tmp_runtime->recent_nbins = recent_nbins;
+    tmp_runtime->rank_matrix = rank_matrix;
 
     return(tmp_runtime);
 }
@@ -344,22 +430,22 @@ static void collapse_heatmap(struct darshan_heatmap_record *rec)
     int i;
 
     /* collapse write bins */
-    for(i=0; i<DARSHAN_MAX_HEATMAP_BINS; i+=2)
+    for(i=0; i<rec->nbins; i+=2)
     {
         rec->write_bins[i] += rec->write_bins[i+1]; /* accumulate adjacent bins */
         rec->write_bins[i/2] = rec->write_bins[i];  /* shift down */
     }
     /* zero out second half of heatmap */
-    memset(&rec->write_bins[DARSHAN_MAX_HEATMAP_BINS/2], 0, (DARSHAN_MAX_HEATMAP_BINS/2)*sizeof(int64_t));
+    memset(&rec->write_bins[rec->nbins/2], 0, (rec->nbins/2)*sizeof(int64_t));
 
     /* collapse read bins */
-    for(i=0; i<DARSHAN_MAX_HEATMAP_BINS; i+=2)
+    for(i=0; i<rec->nbins; i+=2)
     {
         rec->read_bins[i] += rec->read_bins[i+1]; /* accumulate adjacent bins */
         rec->read_bins[i/2] = rec->read_bins[i];  /* shift down */
     }
     /* zero out second half of heatmap */
-    memset(&rec->read_bins[DARSHAN_MAX_HEATMAP_BINS/2], 0, (DARSHAN_MAX_HEATMAP_BINS/2)*sizeof(int64_t));
+    memset(&rec->read_bins[rec->nbins/2], 0, (rec->nbins/2)*sizeof(int64_t));
 
     /* double bin width */
     rec->bin_width_seconds *= 2.0;
@@ -386,8 +472,12 @@ void heatmap_update(darshan_record_id heatmap_id, int rw_flag,
      */
     if(!rec_ref) { HEATMAP_POST_RECORD(); return; }
 
+    /* the recent activity ring (if any) keeps its original resolution */
+    if(rec_ref->recent_rec)
+        heatmap_update_recent(rec_ref, rw_flag, size, start_time, end_time);
+
     /* is current update out of bounds with histogram size?  if so, collapse */
-    while(end_time > rec_ref->heatmap_rec->bin_width_seconds * DARSHAN_MAX_HEATMAP_BINS)
+    while(end_time > rec_ref->heatmap_rec->bin_width_seconds * rec_ref->heatmap_rec->nbins)
         collapse_heatmap(rec_ref->heatmap_rec);
 
     /* once we fall through to this point, we know that the current heatmap
@@ -442,11 +532,143 @@ void heatmap_update(darshan_record_id heatmap_id, int rw_flag,
     return;
 }
 
+static void heatmap_update_recent(struct heatmap_record_ref *rec_ref,
+    int rw_flag, int64_t size, double start_time, double end_time)
+{
+    struct darshan_heatmap_record *rec = rec_ref->recent_rec;
+    int64_t bin_index;
+    int64_t first_bin = start_time/rec->bin_width_seconds;
+    int64_t last_bin = end_time/rec->bin_width_seconds;
+    double top_boundary, bottom_boundary, seconds_in_bin;
+    int64_t intermediate_bytes;
+
+    /* advance the ring if this update extends past its newest bin, zeroing
+     * slots that are reused for the new bins
+     */
+    if(last_bin > rec_ref->recent_last_bin)
+    {
+        bin_index = rec_ref->recent_last_bin + 1;
+        if(bin_index < last_bin - rec->nbins + 1)
+            bin_index = last_bin - rec->nbins + 1;
+        for(; bin_index <= last_bin; bin_index++)
+        {
+            rec->write_bins[bin_index % rec->nbins] = 0;
+            rec->read_bins[bin_index % rec->nbins] = 0;
+        }
+        rec_ref->recent_last_bin = last_bin;
+    }
+
+    /* ignore any portion of the update that is older than the ring */
+    if(first_bin < rec_ref->recent_last_bin - rec->nbins + 1)
+        first_bin = rec_ref->recent_last_bin - rec->nbins + 1;
+
+    for(bin_index = first_bin; bin_index <= last_bin; bin_index++)
+    {
+        /* same proportional assignment as in heatmap_update() */
+        seconds_in_bin = rec->bin_width_seconds;
+        bottom_boundary = bin_index * rec->bin_width_seconds;
+        top_boundary = bottom_boundary + rec->bin_width_seconds;
+        if(start_time > bottom_boundary)
+            seconds_in_bin -= start_time-bottom_boundary;
+        if(end_time < top_boundary)
+            seconds_in_bin -= top_boundary-end_time;
+
+        if(seconds_in_bin < 0)
+            return;
+
+        if(end_time > start_time)
+            intermediate_bytes = round(size * (seconds_in_bin/(end_time-start_time)));
+        else
+            intermediate_bytes = size;
+
+        if(rw_flag == HEATMAP_WRITE)
+            rec->write_bins[bin_index % rec->nbins] += intermediate_bytes;
+        else
+            rec->read_bins[bin_index % rec->nbins] += intermediate_bytes;
+    }
+
+    return;
+}
+
+static void reverse_bins(int64_t *bins, int64_t nbins)
+{
+    int64_t i;
+    int64_t tmp;
+
+    for(i=0; i<nbins/2; i++)
+    {
+        tmp = bins[i];
+        bins[i] = bins[nbins-1-i];
+        bins[nbins-1-i] = tmp;
+    }
+
+    return;
+}
+
+/* rotate bins in place so that bins[first] becomes bins[0] */
+static void rotate_bins(int64_t *bins, int64_t nbins, int64_t first)
+{
+    if(first == 0)
+        return;
+
+    reverse_bins(bins, first);
+    reverse_bins(&bins[first], nbins-first);
+    reverse_bins(bins, nbins);
+
+    return;
+}
+
+/* convert a recent activity ring into a conventional heatmap record that
+ * covers the window of bins leading up to 'end_timestamp'
+ */
+static void finalize_recent_heatmap(struct darshan_heatmap_record *rec,
+    int64_t last_bin, double end_timestamp)
+{
+    int64_t end_bin = end_timestamp/rec->bin_width_seconds;
+    int64_t first_bin;
+    int64_t bin_index;
+
+    /* advance the ring to the end of execution, zeroing reused slots */
+    if(end_bin > last_bin)
+    {
+        bin_index = last_bin + 1;
+        if(bin_index < end_bin - rec->nbins + 1)
+            bin_index = end_bin - rec->nbins + 1;
+        for(; bin_index <= end_bin; bin_index++)
+        {
+            rec->write_bins[bin_index % rec->nbins] = 0;
+            rec->read_bins[bin_index % rec->nbins] = 0;
+        }
+    }
+    else
+        end_bin = last_bin;
+
+    first_bin = end_bin - rec->nbins + 1;
+    if(first_bin < 0)
+        first_bin = 0;
+
+    /* unroll the ring so that the oldest bin in the window comes first */
+    rotate_bins(rec->write_bins, rec->nbins, first_bin % rec->nbins);
+    rotate_bins(rec->read_bins, rec->nbins, first_bin % rec->nbins);
+
+    rec->nbins = end_bin - first_bin + 1;
+    rec->start_time_seconds = first_bin * rec->bin_width_seconds;
+    /* shift read_bins down so that memory remains contiguous */
+    memmove(&rec->write_bins[rec->nbins], rec->read_bins,
+        rec->nbins*sizeof(int64_t));
+    rec->read_bins = &rec->write_bins[rec->nbins];
+
+    return;
+}
+
 static struct heatmap_record_ref *heatmap_track_new_record(
     darshan_record_id rec_id, const char *name)
 {
     struct darshan_heatmap_record *heatmap_rec = NULL;
+    struct darshan_heatmap_record *recent_rec = NULL;
     struct heatmap_record_ref *rec_ref = NULL;
+    char recent_name[128];
+    size_t rec_size;
     int ret;
 
     rec_ref = malloc(sizeof(*rec_ref));
@@ -464,12 +686,17 @@ static struct heatmap_record_ref *heatmap_track_new_record(
     }
 
     /* register with darshan-core so it is persisted in the log file */
-    /* include enough space for 2x number of heatmap bins (read and write) */
+    /* include enough space for 2x number of heatmap bins (read and write),
+     * plus the recent activity ring if enabled
+     */
+    rec_size = HEATMAP_REC_SIZE(heatmap_runtime->nbins);
+    if(heatmap_runtime->recent_nbins)
+        rec_size += HEATMAP_REC_SIZE(heatmap_runtime->recent_nbins);
     heatmap_rec = darshan_core_register_record(
         rec_id,
         name,
         DARSHAN_HEATMAP_MOD,
-        sizeof(struct darshan_heatmap_record)+(2*DARSHAN_MAX_HEATMAP_BINS*sizeof(int64_t)),
+        rec_size,
         NULL);
 
     if(!heatmap_rec)
@@ -483,13 +710,42 @@ static struct heatmap_record_ref *heatmap_track_new_record(
     /* registering this file record was successful, so initialize some fields */
     heatmap_rec->base_rec.id = rec_id;
     heatmap_rec->base_rec.rank = my_rank;
-    heatmap_rec->bin_width_seconds = DARSHAN_INITIAL_BIN_WIDTH_SECONDS;
-    heatmap_rec->nbins = DARSHAN_MAX_HEATMAP_BINS;
+    heatmap_rec->bin_width_seconds = heatmap_runtime->bin_width;
+    heatmap_rec->nbins = heatmap_runtime->nbins;
+    heatmap_rec->start_time_seconds = 0;
+    heatmap_rec->nranks = 0;
+    heatmap_rec->write_quantum = 0;
+    heatmap_rec->read_quantum = 0;
     heatmap_rec->write_bins = (int64_t*)((uintptr_t)heatmap_rec + sizeof(*heatmap_rec));
     heatmap_rec->read_bins = (int64_t*)((uintptr_t)heatmap_rec + sizeof(*heatmap_rec) + heatmap_rec->nbins*sizeof(int64_t));
     rec_ref->heatmap_rec = heatmap_rec;
     heatmap_runtime->rec_count++;
 
+    if(heatmap_runtime->recent_nbins)
+    {
+        /* the recent activity ring is a separate record in the log, named
+         * after its parent heatmap.  Its memory was already reserved above,
+         * so we register a zero-size record just to store its name.
+         */
+        snprintf(recent_name, sizeof(recent_name), "%s:recent", name);
+        recent_rec = (struct darshan_heatmap_record*)((uintptr_t)heatmap_rec +
+            HEATMAP_REC_SIZE(heatmap_runtime->nbins));
+        recent_rec->base_rec.id = darshan_core_gen_record_id(recent_name);
+        recent_rec->base_rec.rank = my_rank;
+        (void)darshan_core_register_record(recent_rec->base_rec.id,
+            recent_name, DARSHAN_HEATMAP_MOD, 0, NULL);
+        recent_rec->bin_width_seconds = heatmap_runtime->bin_width;
+        recent_rec->nbins = heatmap_runtime->recent_nbins;
+        recent_rec->start_time_seconds = 0;
+        recent_rec->nranks = 0;
+        recent_rec->write_quantum = 0;
+        recent_rec->read_quantum = 0;
+        recent_rec->write_bins = (int64_t*)((uintptr_t)recent_rec + sizeof(*recent_rec));
+        recent_rec->read_bins = (int64_t*)((uintptr_t)recent_rec + sizeof(*recent_rec) + recent_rec->nbins*sizeof(int64_t));
+        rec_ref->recent_rec = recent_rec;
+        rec_ref->recent_last_bin = -1;
+    }
+
     return(rec_ref);
 }
 
@@ -499,14 +755,17 @@ static void heatmap_mpi_redux(
     darshan_record_id *shared_recs, int shared_rec_count)
 {
     double end_timestamp;
+    int rank_matrix;
 
     /* NOTE: no actual record reduction here.  We are just using this as an
-     * opportunity to agree on shutdown times.
+     * opportunity to agree on shutdown times and, if requested, to gather
+     * each heatmap into a rank x time matrix.
      */
 
     HEATMAP_LOCK();
     assert(heatmap_runtime);
     heatmap_runtime->frozen = 1;
+    rank_matrix = heatmap_runtime->rank_matrix;
     HEATMAP_UNLOCK();
 
     /* check time locally */
@@ -517,6 +776,286 @@ static void heatmap_mpi_redux(
      */
     PMPI_Allreduce(&end_timestamp, &g_end_timestamp, 1, MPI_DOUBLE,
         MPI_MAX, mod_comm);
+
+    if(rank_matrix)
+        heatmap_gather_rank_matrices(shared_recs, shared_rec_count,
+            g_end_timestamp, mod_comm);
+
+    return;
+}
+
+/* quantize 'nbins' bins to a single byte each, counting multiples of
+ * 'quantum' bytes.  Nonzero bins never quantize to zero, so the rank matrix
+ * still shows every bin in which a rank was active.
+ */
+static void quantize_bins(int64_t *bins, int64_t nbins, int64_t quantum,
+    uint8_t *qbins)
+{
+    int64_t i;
+    int64_t q;
+
+    for(i=0; i<nbins; i++)
+    {
+        q = (bins[i] + quantum/2) / quantum;
+        if(q == 0 && bins[i] > 0)
+            q = 1;
+        if(q > UINT8_MAX)
+            q = UINT8_MAX;
+        qbins[i] = q;
+    }
+
+    return;
+}
+
+/* gather each heatmap shared by all ranks into a quantized rank x time
+ * matrix on rank 0.  Every rank collapses its heatmap to the same bin width
+ * first, so rows line up without any further communication.
+ */
+static void heatmap_gather_rank_matrices(
+    darshan_record_id *shared_recs, int shared_rec_count,
+    double end_timestamp, MPI_Comm mod_comm)
+{
+    struct heatmap_record_ref *rec_ref;
+    struct darshan_heatmap_record *rec;
+    struct heatmap_rank_matrix *matrix;
+    int64_t local_max[3], global_max[3];
+    int64_t nbins;
+    int64_t write_quantum, read_quantum;
+    uint8_t *row = NULL;
+    uint8_t *matrix_bins = NULL;
+    void *out_buf;
+    size_t out_size;
+    size_t slot_size;
+    int nprocs;
+    int i, j;
+
+    PMPI_Comm_size(mod_comm, &nprocs);
+
+    HEATMAP_LOCK();
+    heatmap_runtime->nprocs = nprocs;
+
+    /* the output buffer starts with this rank's own records, which never
+     * take more room than their slots in the module buffer
+     */
+    slot_size = HEATMAP_REC_SIZE(heatmap_runtime->nbins);
+    if(heatmap_runtime->recent_nbins)
+        slot_size += HEATMAP_REC_SIZE(heatmap_runtime->recent_nbins);
+    out_size = heatmap_runtime->rec_count * slot_size;
+
+    /* shared_recs is in the same order on every rank, and every rank has a
+     * heatmap for each shared record id, so the collectives below match up
+     */
+    for(i=0; i<shared_rec_count; i++)
+    {
+        /* skip ids that do not refer to a whole-execution heatmap (i.e.,
+         * the names of recent activity heatmaps)
+         */
+        rec_ref = darshan_lookup_record_ref(heatmap_runtime->rec_id_hash,
+            &shared_recs[i], sizeof(darshan_record_id));
+        if(!rec_ref)
+            continue;
+        rec = rec_ref->heatmap_rec;
+
+        /* collapse to cover the entire execution, then keep collapsing until
+         * the gathered matrix fits within our memory bound.  All ranks make
+         * the same decisions, since they start from the same initial bin
+         * width and agree on the end timestamp.
+         */
+        while(end_timestamp > rec->bin_width_seconds * rec->nbins)
+            collapse_heatmap(rec);
+        nbins = ceil(end_timestamp/rec->bin_width_seconds);
+        if(nbins < 1)
+            nbins = 1;
+        while((int64_t)nprocs*2*nbins > DARSHAN_MAX_HEATMAP_RANK_MATRIX_SIZE &&
+            nbins > 1)
+        {
+            collapse_heatmap(rec);
+            nbins = ceil(end_timestamp/rec->bin_width_seconds);
+            if(nbins < 1)
+                nbins = 1;
+        }
+
+        /* allocate the gather buffers (and on rank 0, grow the reserved
+         * output buffer to hold this matrix) up front, so that an
+         * allocation failure on any rank can be agreed on in the same
+         * reduction
+         */
+        row = malloc(2*nbins);
+        out_buf = NULL;
+        if(my_rank == 0)
+        {
+            matrix_bins = malloc((size_t)nprocs*2*nbins);
+            out_buf = realloc(heatmap_runtime->output_buf,
+                out_size + heatmap_rank_matrix_out_size(nbins, nprocs));
+            if(out_buf)
+                heatmap_runtime->output_buf = out_buf;
+        }
+
+        /* agree on a quantum that lets the busiest bin of any rank fit in
+         * a single byte
+         */
+        local_max[0] = local_max[1] = 0;
+        local_max[2] = (!row || (my_rank == 0 && (!matrix_bins || !out_buf)));
+        for(j=0; j<nbins; j++)
+        {
+            if(rec->write_bins[j] > local_max[0])
+                local_max[0] = rec->write_bins[j];
+            if(rec->read_bins[j] > local_max[1])
+                local_max[1] = rec->read_bins[j];
+        }
+        HEATMAP_UNLOCK();
+        PMPI_Allreduce(local_max, global_max, 3, MPI_INT64_T, MPI_MAX,
+            mod_comm);
+        HEATMAP_LOCK();
+
+        /* nothing to gather if no rank has any data for this heatmap, and
+         * if any rank is out of memory every rank keeps its own record
+         */
+        if(global_max[2] || (global_max[0] == 0 && global_max[1] == 0))
+        {
+            if(global_max[2] && my_rank == 0)
+                darshan_core_fprintf(stderr, "darshan library warning: "
+                    "unable to allocate heatmap rank matrix, writing "
+                    "per-process heatmaps instead\n");
+            if(!global_max[2])
+                rec_ref->gathered = 1;
+            free(row);
+            free(matrix_bins);
+            row = matrix_bins = NULL;
+            continue;
+        }
+
+        /* this heatmap is now the responsibility of rank 0 */
+        rec_ref->gathered = 1;
+        write_quantum = (global_max[0] + UINT8_MAX - 1) / UINT8_MAX;
+        read_quantum = (global_max[1] + UINT8_MAX - 1) / UINT8_MAX;
+        if(write_quantum < 1)
+            write_quantum = 1;
+        if(read_quantum < 1)
+            read_quantum = 1;
+
+        quantize_bins(rec->write_bins, nbins, write_quantum, row);
+        quantize_bins(rec->read_bins, nbins, read_quantum, &row[nbins]);
+
+        HEATMAP_UNLOCK();
+        PMPI_Gather(row, 2*nbins, MPI_BYTE, matrix_bins, 2*nbins, MPI_BYTE,
+            0, mod_comm);
+        HEATMAP_LOCK();
+        free(row);
+
+        if(my_rank == 0)
+        {
+            out_size += heatmap_rank_matrix_out_size(nbins, nprocs);
+            heatmap_runtime->output_buf_size = out_size;
+            matrix = &heatmap_runtime->rank_matrices[
+                heatmap_runtime->rank_matrix_count++];
+            matrix->rec_id = shared_recs[i];
+            matrix->bin_width_seconds = rec->bin_width_seconds;
+            matrix->nbins = nbins;
+            matrix->write_quantum = write_quantum;
+            matrix->read_quantum = read_quantum;
+            matrix->bins = matrix_bins;
+            matrix_bins = NULL;
+        }
+    }
+
+    HEATMAP_UNLOCK();
+
+    return;
+}
+
+/* upper bound on the output size of a rank matrix of 'nbins' bins per rank:
+ * a record header for each block of ranks, plus every rank's quantized bins
+ */
+static size_t heatmap_rank_matrix_out_size(int64_t nbins, int nprocs)
+{
+    int64_t rows_per_rec;
+
+    rows_per_rec = DARSHAN_MAX_HEATMAP_NBINS / nbins;
+    if(rows_per_rec < 1)
+        rows_per_rec = 1;
+
+    return(((nprocs + rows_per_rec - 1) / rows_per_rec) *
+        sizeof(struct darshan_heatmap_record) + (size_t)nprocs * 2 * nbins);
+}
+
+/* append rank matrices gathered by heatmap_gather_rank_matrices() to the
+ * output buffer reserved while gathering them.  Each matrix is split into
+ * records covering blocks of consecutive ranks, small enough for
+ * darshan-util to expand into int64_t bins; blocks in which no rank has any
+ * data are omitted.
+ */
+static void heatmap_output_rank_matrices(
+    void **heatmap_buf, int *heatmap_buf_sz)
+{
+    struct heatmap_rank_matrix *matrix;
+    struct darshan_heatmap_record *rec;
+    void *out_buf = heatmap_runtime->output_buf;
+    void *out_ptr;
+    int64_t rows_per_rec;
+    int64_t first_rank;
+    int64_t nrows;
+    int64_t row_size;
+    int64_t j;
+    int i;
+
+    assert(out_buf && heatmap_runtime->output_buf_size >= (size_t)*heatmap_buf_sz);
+    memcpy(out_buf, *heatmap_buf, *heatmap_buf_sz);
+    out_ptr = (void*)((uintptr_t)out_buf + *heatmap_buf_sz);
+
+    for(i=0; i<heatmap_runtime->rank_matrix_count; i++)
+    {
+        matrix = &heatmap_runtime->rank_matrices[i];
+        row_size = 2 * matrix->nbins;
+        rows_per_rec = DARSHAN_MAX_HEATMAP_NBINS / matrix->nbins;
+        if(rows_per_rec < 1)
+            rows_per_rec = 1;
+
+        for(first_rank = 0; first_rank < heatmap_runtime->nprocs;
+            first_rank += rows_per_rec)
+        {
+            nrows = heatmap_runtime->nprocs - first_rank;
+            if(nrows > rows_per_rec)
+                nrows = rows_per_rec;
+
+            /* skip blocks of ranks that did not perform any I/O */
+            for(j=0; j<nrows*row_size; j++)
+                if(matrix->bins[first_rank*row_size + j])
+                    break;
+            if(j == nrows*row_size)
+                continue;
+
+            rec = out_ptr;
+            memset(rec, 0, sizeof(*rec));
+            rec->base_rec.id = matrix->rec_id;
+            rec->base_rec.rank = first_rank;
+            rec->bin_width_seconds = matrix->bin_width_seconds;
+            rec->nbins = matrix->nbins;
+            rec->nranks = nrows;
+            rec->write_quantum = matrix->write_quantum;
+            rec->read_quantum = matrix->read_quantum;
+            out_ptr = (void*)((uintptr_t)out_ptr + sizeof(*rec));
+
+            /* rows of write bins, followed by rows of read bins */
+            for(j=0; j<nrows; j++)
+            {
+                memcpy(out_ptr, &matrix->bins[(first_rank+j)*row_size],
+                    matrix->nbins);
+                out_ptr = (void*)((uintptr_t)out_ptr + matrix->nbins);
+            }
+            for(j=0; j<nrows; j++)
+            {
+                memcpy(out_ptr, &matrix->bins[(first_rank+j)*row_size +
+                    matrix->nbins], matrix->nbins);
+                out_ptr = (void*)((uintptr_t)out_ptr + matrix->nbins);
+            }
+        }
+    }
+
+    *heatmap_buf = out_buf;
+    *heatmap_buf_sz = (uintptr_t)out_ptr - (uintptr_t)out_buf;
+
+    return;
 }
 #endif
 /*
@@ -12,6 +12,19 @@
 #define HEATMAP_READ 1
 #define HEATMAP_WRITE 2
 
+/* default number of bins per heatmap, and default initial width of each
+ * bin as floating point seconds.  Both can be overridden at runtime using
+ * the HEATMAP_NBINS and HEATMAP_BIN_WIDTH config settings.
+ */
+#define DARSHAN_DEF_HEATMAP_NBINS 200
+#define DARSHAN_DEF_HEATMAP_BIN_WIDTH 0.1
+
+/* upper limit on the number of bins per heatmap.  This keeps each record
+ * (plus trailing bins) within the DEF_MOD_BUF_SIZE buffers that
+ * darshan-util uses to parse records.
+ */
+#define DARSHAN_MAX_HEATMAP_NBINS 5000
+
 #ifdef DARSHAN_HEATMAP
 
 /* heatmap_register()
@@ -21,7 +21,6 @@
 #include <time.h>
 #include <stdlib.h>
 #include <errno.h>
-#include <search.h>
 #include <assert.h>
 #include <pthread.h>
 
@@ -144,8 +143,7 @@ struct mpiio_file_record_ref
     double last_meta_end;
     double last_read_end;
     double last_write_end;
-    void *access_root;
-    int access_count;
+    struct darshan_common_val_table access_vals;
 };
 
 /* The mpiio_runtime structure maintains necessary state for storing
@@ -155,7 +153,7 @@ struct mpiio_file_record_ref
 struct mpiio_runtime
 {
     void *rec_id_hash;
-    void *fh_hash;
+    struct darshan_handle_table fh_table; /* keyed on the MPI_File value */
     int file_rec_count;
     darshan_record_id heatmap_id;
     int frozen; /* flag to indicate that the counters should no longer be modified */
@@ -165,14 +163,15 @@ static void mpiio_runtime_initialize(
     void);
 static struct mpiio_file_record_ref *mpiio_track_new_file_record(
     darshan_record_id rec_id, const char *path);
-static void mpiio_finalize_file_records(
-    void *rec_ref_p, void *user_ptr);
 #ifdef HAVE_MPI
 static void mpiio_record_reduction_op(
     void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
 static void mpiio_shared_record_variance(
     MPI_Comm mod_comm, struct darshan_mpiio_file *inrec_array,
     struct darshan_mpiio_file *outrec_array, int shared_rec_count);
+static void mpiio_shared_record_common_vals(
+    MPI_Comm mod_comm, struct darshan_mpiio_file *inrec_array,
+    struct darshan_mpiio_file *outrec_array, int shared_rec_count);
 static void mpiio_mpi_redux(
     void *mpiio_buf, MPI_Comm mod_comm,
     darshan_record_id *shared_recs, int shared_rec_count);
@@ -242,7 +241,7 @@ static int my_rank = -1;
     rec_ref->file_rec->fcounters[MPIIO_F_OPEN_END_TIMESTAMP] = __tm2; \
     DARSHAN_TIMER_INC_NO_OVERLAP(rec_ref->file_rec->fcounters[MPIIO_F_META_TIME], \
         __tm1, __tm2, rec_ref->last_meta_end); \
-    darshan_add_record_ref(&(mpiio_runtime->fh_hash), &__fh, sizeof(MPI_File), rec_ref); \
+    darshan_handle_table_set(&(mpiio_runtime->fh_table), &(__fh), sizeof(MPI_File), rec_ref); \
     if(newpath != __path) free(newpath); \
 } while(0)
 
@@ -261,10 +260,10 @@ static int get_byte_offset = 0;
     int size = 0; \
     MPI_Offset displacement=-1;\
     int64_t size_ll; \
-    struct darshan_common_val_counter *cvc; \
+    int cv_freq; \
     double __elapsed = __tm2-__tm1; \
     if(__ret != MPI_SUCCESS) break; \
-    rec_ref = darshan_lookup_record_ref(mpiio_runtime->fh_hash, &(__fh), sizeof(MPI_File)); \
+    rec_ref = darshan_handle_table_lookup(&(mpiio_runtime->fh_table), &(__fh), sizeof(MPI_File)); \
     if(!rec_ref) break; \
     if((__count > 0) && (__datatype != MPI_DATATYPE_NULL)) { \
         PMPI_Type_size(__datatype, &size);  \
@@ -277,12 +276,11 @@ static int get_byte_offset = 0;
     heatmap_update(mpiio_runtime->heatmap_id, HEATMAP_READ, size, __tm1, __tm2); \
     DARSHAN_BUCKET_INC(&(rec_ref->file_rec->counters[MPIIO_SIZE_READ_AGG_0_100]), size); \
     size_ll = size; \
-    cvc = darshan_track_common_val_counters(&rec_ref->access_root, &size_ll, 1, \
-        &rec_ref->access_count); \
-    if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
+    cv_freq = darshan_track_common_val(&rec_ref->access_vals, size_ll); \
+    if(cv_freq) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[MPIIO_ACCESS1_ACCESS]), \
         &(rec_ref->file_rec->counters[MPIIO_ACCESS1_COUNT]), \
-        cvc->vals, 1, cvc->freq, 0); \
+        &size_ll, 1, cv_freq, 0); \
     rec_ref->file_rec->counters[MPIIO_BYTES_READ] += size; \
     rec_ref->file_rec->counters[__counter] += 1; \
     if(rec_ref->last_io_type == DARSHAN_IO_WRITE) \
@@ -304,10 +302,10 @@ static int get_byte_offset = 0;
     int size = 0; \
     MPI_Offset displacement=-1; \
     int64_t size_ll; \
-    struct darshan_common_val_counter *cvc; \
+    int cv_freq; \
     double __elapsed = __tm2-__tm1; \
     if(__ret != MPI_SUCCESS) break; \
-    rec_ref = darshan_lookup_record_ref(mpiio_runtime->fh_hash, &(__fh), sizeof(MPI_File)); \
+    rec_ref = darshan_handle_table_lookup(&(mpiio_runtime->fh_table), &(__fh), sizeof(MPI_File)); \
     if(!rec_ref) break; \
     if((__count > 0) && (__datatype != MPI_DATATYPE_NULL)) { \
         PMPI_Type_size(__datatype, &size);  \
@@ -320,12 +318,11 @@ static int get_byte_offset = 0;
     heatmap_update(mpiio_runtime->heatmap_id, HEATMAP_WRITE, size, __tm1, __tm2); \
     DARSHAN_BUCKET_INC(&(rec_ref->file_rec->counters[MPIIO_SIZE_WRITE_AGG_0_100]), size); \
     size_ll = size; \
-    cvc = darshan_track_common_val_counters(&rec_ref->access_root, &size_ll, 1, \
-        &rec_ref->access_count); \
-    if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
+    cv_freq = darshan_track_common_val(&rec_ref->access_vals, size_ll); \
+    if(cv_freq) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[MPIIO_ACCESS1_ACCESS]), \
         &(rec_ref->file_rec->counters[MPIIO_ACCESS1_COUNT]), \
-        cvc->vals, 1, cvc->freq, 0); \
+        &size_ll, 1, cv_freq, 0); \
     rec_ref->file_rec->counters[MPIIO_BYTES_WRITTEN] += size; \
     rec_ref->file_rec->counters[__counter] += 1; \
     if(rec_ref->last_io_type == DARSHAN_IO_READ) \
@@ -1078,7 +1075,7 @@ int DARSHAN_DECL(MPI_File_sync)(MPI_File fh)
     if(ret == MPI_SUCCESS)
     {
         MPIIO_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(mpiio_runtime->fh_hash,
+        rec_ref = darshan_handle_table_lookup(&(mpiio_runtime->fh_table),
             &fh, sizeof(MPI_File));
         if(rec_ref)
         {
@@ -1116,7 +1113,7 @@ int DARSHAN_DECL(MPI_File_set_view)(MPI_File fh, MPI_Offset disp, MPI_Datatype e
     if(ret == MPI_SUCCESS)
     {
         MPIIO_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(mpiio_runtime->fh_hash,
+        rec_ref = darshan_handle_table_lookup(&(mpiio_runtime->fh_table),
             &fh, sizeof(MPI_File));
         if(rec_ref)
         {
@@ -1156,7 +1153,7 @@ int DARSHAN_DECL(MPI_File_close)(MPI_File *fh)
     tm2 = MPIIO_WTIME();
 
     MPIIO_PRE_RECORD();
-    rec_ref = darshan_lookup_record_ref(mpiio_runtime->fh_hash,
+    rec_ref = darshan_handle_table_lookup(&(mpiio_runtime->fh_table),
         &tmp_fh, sizeof(MPI_File));
     if(rec_ref)
     {
@@ -1167,7 +1164,7 @@ int DARSHAN_DECL(MPI_File_close)(MPI_File *fh)
         DARSHAN_TIMER_INC_NO_OVERLAP(
             rec_ref->file_rec->fcounters[MPIIO_F_META_TIME],
             tm1, tm2, rec_ref->last_meta_end);
-        darshan_delete_record_ref(&(mpiio_runtime->fh_hash),
+        darshan_handle_table_remove(&(mpiio_runtime->fh_table),
             &tmp_fh, sizeof(MPI_File));
     }
     MPIIO_POST_RECORD();
@@ -1275,15 +1272,6 @@ static struct mpiio_file_record_ref *mpiio_track_new_file_record(
     return(rec_ref);
 }
 
-static void mpiio_finalize_file_records(void *rec_ref_p, void *user_ptr)
-{
-    struct mpiio_file_record_ref *rec_ref =
-        (struct mpiio_file_record_ref *)rec_ref_p;
-
-    tdestroy(rec_ref->access_root, free);
-    return;
-}
-
 #ifdef HAVE_MPI
 static void mpiio_record_reduction_op(void* infile_v, void* inoutfile_v,
     int *len, MPI_Datatype *datatype)
@@ -1542,6 +1530,72 @@ static void mpiio_shared_record_variance(MPI_Comm mod_comm,
 
     return;
 }
+
+/* merge the access size sketches of shared records across all processes,
+ * so that the most common values are correct job-wide
+ */
+static void mpiio_shared_record_common_vals(MPI_Comm mod_comm,
+    struct darshan_mpiio_file *inrec_array, struct darshan_mpiio_file *outrec_array,
+    int shared_rec_count)
+{
+    MPI_Datatype cv_type;
+    MPI_Op cv_op;
+    struct mpiio_file_record_ref *rec_ref;
+    struct darshan_common_val_table *cv_send_buf = NULL;
+    struct darshan_common_val_table *cv_recv_buf = NULL;
+    int alloc_failed, any_alloc_failed;
+    int i;
+
+    cv_send_buf = malloc(shared_rec_count *
+        sizeof(struct darshan_common_val_table));
+    if(my_rank == 0)
+        cv_recv_buf = malloc(shared_rec_count *
+            sizeof(struct darshan_common_val_table));
+
+    /* all ranks must agree to skip the reduction if any of them is out of
+     * memory, rather than leave the others waiting in it
+     */
+    alloc_failed = (!cv_send_buf || (my_rank == 0 && !cv_recv_buf));
+    PMPI_Allreduce(&alloc_failed, &any_alloc_failed, 1, MPI_INT, MPI_MAX,
+        mod_comm);
+    if(any_alloc_failed)
+    {
+        free(cv_send_buf);
+        free(cv_recv_buf);
+        return;
+    }
+
+    for(i=0; i<shared_rec_count; i++)
+    {
+        rec_ref = darshan_lookup_record_ref(mpiio_runtime->rec_id_hash,
+            &inrec_array[i].base_rec.id, sizeof(darshan_record_id));
+        assert(rec_ref);
+        cv_send_buf[i] = rec_ref->access_vals;
+    }
+
+    PMPI_Type_contiguous(sizeof(struct darshan_common_val_table),
+        MPI_BYTE, &cv_type);
+    PMPI_Type_commit(&cv_type);
+    PMPI_Op_create(darshan_common_val_reduce, 1, &cv_op);
+
+    PMPI_Reduce(cv_send_buf, cv_recv_buf, shared_rec_count,
+        cv_type, cv_op, 0, mod_comm);
+
+    if(my_rank == 0)
+    {
+        for(i=0; i<shared_rec_count; i++)
+            darshan_set_common_val_counters(&cv_recv_buf[i],
+                &(outrec_array[i].counters[MPIIO_ACCESS1_ACCESS]),
+                &(outrec_array[i].counters[MPIIO_ACCESS1_COUNT]));
+        free(cv_recv_buf);
+    }
+
+    PMPI_Type_free(&cv_type);
+    PMPI_Op_free(&cv_op);
+    free(cv_send_buf);
+
+    return;
+}
 #endif
 
 /* mpiio module shutdown benchmark routine */
@@ -1731,6 +1785,10 @@ static void mpiio_mpi_redux(
     mpiio_shared_record_variance(mod_comm, red_send_buf, red_recv_buf,
         shared_rec_count);
 
+    /* merge common access size sketches for shared files */
+    mpiio_shared_record_common_vals(mod_comm, red_send_buf, red_recv_buf,
+        shared_rec_count);
+
     /* update module state to account for shared file reduction */
     if(my_rank == 0)
     {
@@ -1779,9 +1837,7 @@ static void mpiio_cleanup()
     assert(mpiio_runtime);
 
     /* cleanup internal structures used for instrumenting */
-    darshan_iter_record_refs(mpiio_runtime->rec_id_hash,
-        &mpiio_finalize_file_records, NULL);
-    darshan_clear_record_refs(&(mpiio_runtime->fh_hash), 0);
+    darshan_handle_table_clear(&(mpiio_runtime->fh_table));
     darshan_clear_record_refs(&(mpiio_runtime->rec_id_hash), 1);
 
     free(mpiio_runtime);
@@ -23,7 +23,6 @@
 #include <errno.h>
 #include <sys/uio.h>
 #include <sys/mman.h>
-#include <search.h>
 #include <assert.h>
 #include <libgen.h>
 #include <aio.h>
@@ -140,10 +139,8 @@ struct posix_file_record_ref
     double last_meta_end;
     double last_read_end;
     double last_write_end;
-    void *access_root;
-    int access_count;
-    void *stride_root;
-    int stride_count;
+    struct darshan_common_val_table access_vals;
+    struct darshan_common_val_table stride_vals;
     struct posix_aio_tracker* aio_list;
     int fs_type; /* same as darshan_fs_info->fs_type */
 };
@@ -155,7 +152,7 @@ struct posix_file_record_ref
 struct posix_runtime
 {
     void *rec_id_hash;
-    void *fd_hash;
+    struct darshan_fd_table fd_table;
     int file_rec_count;
     darshan_record_id heatmap_id;
     int frozen; /* flag to indicate that the counters should no longer be modified */
@@ -177,14 +174,15 @@ static void posix_aio_tracker_add(
     int fd, void *aiocbp);
 static struct posix_aio_tracker* posix_aio_tracker_del(
     int fd, void *aiocbp);
-static void posix_finalize_file_records(
-    void *rec_ref_p, void *user_ptr);
 #ifdef HAVE_MPI
 static void posix_record_reduction_op(
     void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
 static void posix_shared_record_variance(
     MPI_Comm mod_comm, struct darshan_posix_file *inrec_array,
     struct darshan_posix_file *outrec_array, int shared_rec_count);
+static void posix_shared_record_common_vals(
+    MPI_Comm mod_comm, struct darshan_posix_file *inrec_array,
+    struct darshan_posix_file *outrec_array, int shared_rec_count);
 static void posix_mpi_redux(
     void *posix_buf, MPI_Comm mod_comm,
     darshan_record_id *shared_recs, int shared_rec_count);
@@ -268,7 +266,7 @@ static int darshan_mem_alignment = 1;
     __rec_ref->file_rec->fcounters[POSIX_F_OPEN_END_TIMESTAMP] = __tm2; \
     DARSHAN_TIMER_INC_NO_OVERLAP(__rec_ref->file_rec->fcounters[POSIX_F_META_TIME], \
         __tm1, __tm2, __rec_ref->last_meta_end); \
-    darshan_add_record_ref(&(posix_runtime->fd_hash), &__ret, sizeof(int), __rec_ref); \
+    darshan_fd_table_set(&(posix_runtime->fd_table), __ret, __rec_ref); \
 } while(0)
 
 #define POSIX_RECORD_READ(__ret, __fd, __pread_flag, __pread_offset, __aligned, __tm1, __tm2) do { \
@@ -276,10 +274,10 @@ static int darshan_mem_alignment = 1;
     int64_t stride; \
     int64_t this_offset; \
     int64_t file_alignment; \
-    struct darshan_common_val_counter *cvc; \
+    int cv_freq; \
     double __elapsed = __tm2-__tm1; \
     if(__ret < 0) break; \
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &(__fd), sizeof(int)); \
+    rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), __fd); \
     if(!rec_ref) break; \
     if(__pread_flag) \
         this_offset = __pread_offset; \
@@ -305,18 +303,16 @@ static int darshan_mem_alignment = 1;
     rec_ref->file_rec->counters[POSIX_BYTES_READ] += __ret; \
     rec_ref->file_rec->counters[POSIX_READS] += 1; \
     DARSHAN_BUCKET_INC(&(rec_ref->file_rec->counters[POSIX_SIZE_READ_0_100]), __ret); \
-    cvc = darshan_track_common_val_counters(&rec_ref->access_root, &__ret, 1, \
-        &rec_ref->access_count); \
-    if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
+    cv_freq = darshan_track_common_val(&rec_ref->access_vals, __ret); \
+    if(cv_freq) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[POSIX_ACCESS1_ACCESS]), \
         &(rec_ref->file_rec->counters[POSIX_ACCESS1_COUNT]), \
-        cvc->vals, 1, cvc->freq, 0); \
-    cvc = darshan_track_common_val_counters(&rec_ref->stride_root, &stride, 1, \
-        &rec_ref->stride_count); \
-    if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
+        &__ret, 1, cv_freq, 0); \
+    cv_freq = darshan_track_common_val(&rec_ref->stride_vals, stride); \
+    if(cv_freq) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[POSIX_STRIDE1_STRIDE]), \
         &(rec_ref->file_rec->counters[POSIX_STRIDE1_COUNT]), \
-        cvc->vals, 1, cvc->freq, 0); \
+        &stride, 1, cv_freq, 0); \
     if(!__aligned) \
         rec_ref->file_rec->counters[POSIX_MEM_NOT_ALIGNED] += 1; \
     file_alignment = rec_ref->file_rec->counters[POSIX_FILE_ALIGNMENT]; \
@@ -341,10 +337,10 @@ static int darshan_mem_alignment = 1;
     int64_t stride; \
     int64_t this_offset; \
     int64_t file_alignment; \
-    struct darshan_common_val_counter *cvc; \
+    int cv_freq; \
     double __elapsed = __tm2-__tm1; \
     if(__ret < 0) break; \
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &__fd, sizeof(int)); \
+    rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), __fd); \
     if(!rec_ref) break; \
     if(__pwrite_flag) \
         this_offset = __pwrite_offset; \
@@ -370,18 +366,16 @@ static int darshan_mem_alignment = 1;
     rec_ref->file_rec->counters[POSIX_BYTES_WRITTEN] += __ret; \
     rec_ref->file_rec->counters[POSIX_WRITES] += 1; \
     DARSHAN_BUCKET_INC(&(rec_ref->file_rec->counters[POSIX_SIZE_WRITE_0_100]), __ret); \
-    cvc = darshan_track_common_val_counters(&rec_ref->access_root, &__ret, 1, \
-        &rec_ref->access_count); \
-    if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
+    cv_freq = darshan_track_common_val(&rec_ref->access_vals, __ret); \
+    if(cv_freq) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[POSIX_ACCESS1_ACCESS]), \
         &(rec_ref->file_rec->counters[POSIX_ACCESS1_COUNT]), \
-        cvc->vals, 1, cvc->freq, 0); \
-    cvc = darshan_track_common_val_counters(&rec_ref->stride_root, &stride, 1, \
-        &rec_ref->stride_count); \
-    if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
+        &__ret, 1, cv_freq, 0); \
+    cv_freq = darshan_track_common_val(&rec_ref->stride_vals, stride); \
+    if(cv_freq) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[POSIX_STRIDE1_STRIDE]), \
         &(rec_ref->file_rec->counters[POSIX_STRIDE1_COUNT]), \
-        cvc->vals, 1, cvc->freq, 0); \
+        &stride, 1, cv_freq, 0); \
     if(!__aligned) \
         rec_ref->file_rec->counters[POSIX_MEM_NOT_ALIGNED] += 1; \
     file_alignment = rec_ref->file_rec->counters[POSIX_FILE_ALIGNMENT]; \
@@ -551,8 +545,7 @@ int DARSHAN_DECL(openat)(int dirfd, const char *pathname, int flags, ...)
     else
     {
         /* construct path relative to dirfd */
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash,
-            &dirfd, sizeof(dirfd));
+        rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), dirfd);
         if(rec_ref)
         {
             dirpath = darshan_core_lookup_record_name(rec_ref->file_rec->base_rec.id);
@@ -628,8 +621,7 @@ int DARSHAN_DECL(openat64)(int dirfd, const char *pathname, int flags, ...)
     else
     {
         /* construct path relative to dirfd */
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash,
-            &dirfd, sizeof(dirfd));
+        rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), dirfd);
         if(rec_ref)
         {
             dirpath = darshan_core_lookup_record_name(rec_ref->file_rec->base_rec.id);
@@ -715,8 +707,7 @@ int DARSHAN_DECL(dup)(int oldfd)
     if(ret >= 0)
     {
         POSIX_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash,
-            &oldfd, sizeof(oldfd));
+        rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), oldfd);
         POSIX_RECORD_REFOPEN(ret, rec_ref, tm1, tm2, POSIX_DUPS);
         POSIX_POST_RECORD();
     }
@@ -739,8 +730,7 @@ int DARSHAN_DECL(dup2)(int oldfd, int newfd)
     if(ret >=0)
     {
         POSIX_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash,
-            &oldfd, sizeof(oldfd));
+        rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), oldfd);
         POSIX_RECORD_REFOPEN(ret, rec_ref, tm1, tm2, POSIX_DUPS);
         POSIX_POST_RECORD();
     }
@@ -763,8 +753,7 @@ int DARSHAN_DECL(dup3)(int oldfd, int newfd, int flags)
     if(ret >=0)
     {
         POSIX_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash,
-            &oldfd, sizeof(oldfd));
+        rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), oldfd);
         POSIX_RECORD_REFOPEN(ret, rec_ref, tm1, tm2, POSIX_DUPS);
         POSIX_POST_RECORD();
     }
@@ -1288,7 +1277,7 @@ off_t DARSHAN_DECL(lseek)(int fd, off_t offset, int whence)
     if(ret >= 0)
     {
         POSIX_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+        rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), fd);
         if(rec_ref)
         {
             rec_ref->offset = ret;
@@ -1318,7 +1307,7 @@ off64_t DARSHAN_DECL(lseek64)(int fd, off64_t offset, int whence)
     if(ret >= 0)
     {
         POSIX_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+        rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), fd);
         if(rec_ref)
         {
             rec_ref->offset = ret;
@@ -1433,7 +1422,7 @@ int DARSHAN_DECL(__fxstat)(int vers, int fd, struct stat *buf)
         return(ret);
 
     POSIX_PRE_RECORD();
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), fd);
     if(rec_ref)
     {
         POSIX_RECORD_STAT(rec_ref, buf, tm1, tm2);
@@ -1459,7 +1448,7 @@ int DARSHAN_DECL(__fxstat64)(int vers, int fd, struct stat64 *buf)
         return(ret);
 
     POSIX_PRE_RECORD();
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), fd);
     if(rec_ref)
     {
         POSIX_RECORD_STAT(rec_ref, buf, tm1, tm2);
@@ -1492,7 +1481,7 @@ void* DARSHAN_DECL(mmap)(void *addr, size_t length, int prot, int flags,
         return(ret);
 
     POSIX_PRE_RECORD();
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), fd);
     if(rec_ref)
     {
         rec_ref->file_rec->counters[POSIX_MMAPS] += 1;
@@ -1525,7 +1514,7 @@ void* DARSHAN_DECL(mmap64)(void *addr, size_t length, int prot, int flags,
         return(ret);
 
     POSIX_PRE_RECORD();
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), fd);
     if(rec_ref)
     {
         rec_ref->file_rec->counters[POSIX_MMAPS] += 1;
@@ -1552,7 +1541,7 @@ int DARSHAN_DECL(fsync)(int fd)
         return(ret);
 
     POSIX_PRE_RECORD();
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), fd);
     if(rec_ref)
     {
         DARSHAN_TIMER_INC_NO_OVERLAP(
@@ -1581,7 +1570,7 @@ int DARSHAN_DECL(fdatasync)(int fd)
         return(ret);
 
     POSIX_PRE_RECORD();
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), fd);
     if(rec_ref)
     {
         DARSHAN_TIMER_INC_NO_OVERLAP(
@@ -1607,7 +1596,7 @@ int DARSHAN_DECL(close)(int fd)
     tm2 = POSIX_WTIME();
 
     POSIX_PRE_RECORD();
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), fd);
     if(rec_ref)
     {
         rec_ref->last_byte_written = 0;
@@ -1619,7 +1608,7 @@ int DARSHAN_DECL(close)(int fd)
         DARSHAN_TIMER_INC_NO_OVERLAP(
             rec_ref->file_rec->fcounters[POSIX_F_META_TIME],
             tm1, tm2, rec_ref->last_meta_end);
-        darshan_delete_record_ref(&(posix_runtime->fd_hash), &fd, sizeof(int));
+        darshan_fd_table_remove(&(posix_runtime->fd_table), fd);
     }
     POSIX_POST_RECORD();
 
@@ -1996,7 +1985,7 @@ static struct posix_aio_tracker* posix_aio_tracker_del(int fd, void *aiocbp)
     struct posix_aio_tracker *tracker = NULL, *iter, *tmp;
     struct posix_file_record_ref *rec_ref;
 
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), fd);
     if(rec_ref)
     {
         LL_FOREACH_SAFE(rec_ref->aio_list, iter, tmp)
@@ -2019,7 +2008,7 @@ static void posix_aio_tracker_add(int fd, void *aiocbp)
     struct posix_aio_tracker* tracker;
     struct posix_file_record_ref *rec_ref;
 
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), fd);
     if(rec_ref)
     {
         tracker = malloc(sizeof(*tracker));
@@ -2034,16 +2023,6 @@ static void posix_aio_tracker_add(int fd, void *aiocbp)
     return;
 }
 
-static void posix_finalize_file_records(void *rec_ref_p, void *user_ptr)
-{
-    struct posix_file_record_ref *rec_ref =
-        (struct posix_file_record_ref *)rec_ref_p;
-
-    tdestroy(rec_ref->access_root, free);
-    tdestroy(rec_ref->stride_root, free);
-    return;
-}
-
 #ifdef HAVE_MPI
 static void posix_record_reduction_op(void* infile_v, void* inoutfile_v,
     int *len, MPI_Datatype *datatype)
@@ -2362,6 +2341,82 @@ static void posix_shared_record_variance(MPI_Comm mod_comm,
 
     return;
 }
+
+/* merge the access size and stride sketches of shared records across all
+ * processes, so that the most common values are correct job-wide rather
+ * than just the most common values of whichever ranks saw them
+ */
+static void posix_shared_record_common_vals(MPI_Comm mod_comm,
+    struct darshan_posix_file *inrec_array, struct darshan_posix_file *outrec_array,
+    int shared_rec_count)
+{
+    MPI_Datatype cv_type;
+    MPI_Op cv_op;
+    struct posix_file_record_ref *rec_ref;
+    struct darshan_common_val_table *cv_send_buf = NULL;
+    struct darshan_common_val_table *cv_recv_buf = NULL;
+    int alloc_failed, any_alloc_failed;
+    int i;
+
+    cv_send_buf = malloc(shared_rec_count * 2 *
+        sizeof(struct darshan_common_val_table));
+    if(my_rank == 0)
+        cv_recv_buf = malloc(shared_rec_count * 2 *
+            sizeof(struct darshan_common_val_table));
+
+    /* all ranks must agree to skip the reduction if any of them is out of
+     * memory, rather than leave the others waiting in it
+     */
+    alloc_failed = (!cv_send_buf || (my_rank == 0 && !cv_recv_buf));
+    PMPI_Allreduce(&alloc_failed, &any_alloc_failed, 1, MPI_INT, MPI_MAX,
+        mod_comm);
+    if(any_alloc_failed)
+    {
+        free(cv_send_buf);
+        free(cv_recv_buf);
+        return;
+    }
+
+    /* access size and stride sketches for each shared record, in the same
+     * order as the shared records themselves
+     */
+    for(i=0; i<shared_rec_count; i++)
+    {
+        rec_ref = darshan_lookup_record_ref(posix_runtime->rec_id_hash,
+            &inrec_array[i].base_rec.id, sizeof(darshan_record_id));
+        assert(rec_ref);
+        cv_send_buf[2*i] = rec_ref->access_vals;
+        cv_send_buf[2*i+1] = rec_ref->stride_vals;
+    }
+
+    PMPI_Type_contiguous(sizeof(struct darshan_common_val_table),
+        MPI_BYTE, &cv_type);
+    PMPI_Type_commit(&cv_type);
+    PMPI_Op_create(darshan_common_val_reduce, 1, &cv_op);
+
+    PMPI_Reduce(cv_send_buf, cv_recv_buf, shared_rec_count * 2,
+        cv_type, cv_op, 0, mod_comm);
+
+    if(my_rank == 0)
+    {
+        for(i=0; i<shared_rec_count; i++)
+        {
+            darshan_set_common_val_counters(&cv_recv_buf[2*i],
+                &(outrec_array[i].counters[POSIX_ACCESS1_ACCESS]),
+                &(outrec_array[i].counters[POSIX_ACCESS1_COUNT]));
+            darshan_set_common_val_counters(&cv_recv_buf[2*i+1],
+                &(outrec_array[i].counters[POSIX_STRIDE1_STRIDE]),
+                &(outrec_array[i].counters[POSIX_STRIDE1_COUNT]));
+        }
+        free(cv_recv_buf);
+    }
+
+    PMPI_Type_free(&cv_type);
+    PMPI_Op_free(&cv_op);
+    free(cv_send_buf);
+
+    return;
+}
 #endif
 
 char *darshan_posix_lookup_record_name(int fd)
@@ -2372,8 +2427,7 @@ char *darshan_posix_lookup_record_name(int fd)
     POSIX_LOCK();
     if(posix_runtime)
     {
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash,
-            &fd, sizeof(fd));
+        rec_ref = darshan_fd_table_lookup(&(posix_runtime->fd_table), fd);
         if(rec_ref)
             rec_name = darshan_core_lookup_record_name(rec_ref->file_rec->base_rec.id);
     }
@@ -2565,6 +2619,10 @@ static void posix_mpi_redux(
     posix_shared_record_variance(mod_comm, red_send_buf, red_recv_buf,
         shared_rec_count);
 
+    /* merge common access size and stride sketches for shared files */
+    posix_shared_record_common_vals(mod_comm, red_send_buf, red_recv_buf,
+        shared_rec_count);
+
     /* update module state to account for shared file reduction */
     if(my_rank == 0)
     {
@@ -2613,9 +2671,7 @@ static void posix_cleanup()
     assert(posix_runtime);
 
     /* cleanup internal structures used for instrumenting */
-    darshan_iter_record_refs(posix_runtime->rec_id_hash,
-        &posix_finalize_file_records, NULL);
-    darshan_clear_record_refs(&(posix_runtime->fd_hash), 0);
+    darshan_fd_table_clear(&(posix_runtime->fd_table));
     darshan_clear_record_refs(&(posix_runtime->rec_id_hash), 1);
 
     free(posix_runtime);
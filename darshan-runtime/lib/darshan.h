@@ -146,6 +146,7 @@ struct darshan_core_runtime
     char *comp_buf;
 #ifdef __DARSHAN_ENABLE_MMAP_LOGS
     char mmap_log_name[__DARSHAN_PATH_MAX];
+    uint64_t *mmap_seq_p;
 #endif
 #ifdef HAVE_MPI
     MPI_Comm mpi_comm;
@@ -159,6 +160,9 @@ struct darshan_core_runtime
  */
 extern struct darshan_core_runtime *__darshan_core;
 extern double __darshan_core_wtime_offset;
+extern double __darshan_core_tsc_scale;
+extern unsigned long long __darshan_core_tsc_base;
+extern double __darshan_core_tsc_base_time;
 #ifdef HAVE_STDATOMIC_H
 extern atomic_flag __darshan_core_mutex;
 #define __DARSHAN_CORE_LOCK() \
@@ -279,6 +283,12 @@ struct darshan_core_module
     void *rec_buf_p;
     size_t rec_mem_avail;
     darshan_module_funcs mod_funcs;
+    /* sizes of the records registered so far, only tracked when periodic
+     * checkpoints are enabled
+     */
+    size_t *rec_sizes;
+    int rec_count;
+    int rec_sizes_len;
 };
 
 /* darshan_core_register_module()
@@ -365,6 +375,21 @@ void *darshan_core_register_record(
 char *darshan_core_lookup_record_name(
     darshan_record_id rec_id);
 
+/* darshan_core_heatmap_config()
+ *
+ * Retrieves the heatmap settings from the Darshan runtime configuration:
+ * the number of bins in each whole-execution heatmap ('nbins'), the
+ * initial width of each bin in seconds ('bin_width'), and the number of
+ * fixed-width bins to retain for recent activity ('recent_nbins', 0 if
+ * disabled), and whether heatmaps should be gathered into a rank x time
+ * matrix at shutdown ('rank_matrix').
+ */
+void darshan_core_heatmap_config(
+    int *nbins,
+    double *bin_width,
+    int *recent_nbins,
+    int *rank_matrix);
+
 /* darshan_core_disabled_instrumentation
  *
  * Returns true (1) if Darshan has currently disabled instrumentation,
@@ -399,6 +424,20 @@ static inline double darshan_core_wtime_absolute(void)
 #else
     /* normal path */
     struct timespec tp;
+#ifdef HAVE_RDTSCP_INTRINSIC
+    /* use the TSC if it was found to be invariant and calibrated against
+     * the system clock when Darshan initialized
+     */
+    if(__darshan_core_tsc_scale > 0)
+    {
+        unsigned flag;
+        unsigned long long ts;
+
+        ts = __rdtscp(&flag);
+        return(__darshan_core_tsc_base_time +
+            (double)(ts - __darshan_core_tsc_base) * __darshan_core_tsc_scale);
+    }
+#endif
     /* some notes on what function to use to retrieve time as of 2021-05:
      * - clock_gettime() is faster than MPI_Wtime() across platforms
      * - clock_gettime() is at least competitive with gettimeofday()
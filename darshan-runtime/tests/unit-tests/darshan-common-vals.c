@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2022 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <darshan-runtime-config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "munit/munit.h"
+
+#include "darshan.h"
+
+static MunitResult track_exact_values(const MunitParameter params[], void* data);
+static MunitResult track_skewed_values(const MunitParameter params[], void* data);
+static MunitResult track_late_values(const MunitParameter params[], void* data);
+static MunitResult merge_skewed_values(const MunitParameter params[], void* data);
+static MunitResult reduce_value_tables(const MunitParameter params[], void* data);
+
+/* test definition */
+static MunitTest tests[]
+    = {{"/track-exact-values", track_exact_values,
+        NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+       {"/track-skewed-values", track_skewed_values,
+        NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+       {"/track-late-values", track_late_values,
+        NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+       {"/merge-skewed-values", merge_skewed_values,
+        NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+       {"/reduce-value-tables", reduce_value_tables,
+        NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+       {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+static const MunitSuite test_suite = {
+    "/darshan-common-vals", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE
+};
+
+/* number of simulated processes and accesses per process */
+#define TEST_NPROCS 8
+#define TEST_NOPS 20000
+/* distinct values in the long tail of the skewed streams */
+#define TEST_NTAIL 2000
+
+/* the heavy hitters of the skewed streams, most frequent first, and the
+ * share of accesses (in percent) that each of them gets
+ */
+static const int64_t heavy_vals[4] = {4096, 65536, 1048576, 512};
+static const int heavy_pcts[4] = {30, 20, 12, 8};
+
+/* exact frequencies of the values of a stream, indexed by value id (the
+ * heavy hitters first, then the tail values)
+ */
+struct exact_counts
+{
+    int64_t freqs[4 + TEST_NTAIL];
+    int64_t total;
+};
+
+static int64_t value_of(int id)
+{
+    return((id < 4) ? heavy_vals[id] : 100000000 + id);
+}
+
+/* generate a deterministic skewed stream of value ids, with the heavy
+ * hitters interleaved with the tail rather than front-loaded
+ */
+static void skewed_stream(uint64_t seed, int *ids, int nops)
+{
+    uint64_t state = seed * 2654435761ULL + 1;
+    int r, i, j;
+
+    for(i = 0; i < nops; i++)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        r = (state >> 33) % 100;
+        for(j = 0; j < 4; j++)
+        {
+            if(r < heavy_pcts[j])
+                break;
+            r -= heavy_pcts[j];
+        }
+        if(j == 4)
+            j = 4 + (state >> 13) % TEST_NTAIL;
+        ids[i] = j;
+    }
+}
+
+static void track_stream(struct darshan_common_val_table *table,
+    struct exact_counts *exact, const int *ids, int nops)
+{
+    int i;
+
+    for(i = 0; i < nops; i++)
+    {
+        darshan_track_common_val(table, value_of(ids[i]));
+        exact->freqs[ids[i]]++;
+        exact->total++;
+    }
+}
+
+/* returns the estimated frequency of 'val' in 'table', or 0 */
+static int64_t table_freq(struct darshan_common_val_table *table, int64_t val)
+{
+    int i;
+
+    for(i = 0; i < DARSHAN_COMMON_VAL_TABLE_SIZE; i++)
+        if(table->freqs[i] && table->vals[i] == val)
+            return(table->freqs[i]);
+
+    return(0);
+}
+
+/* check the Space-Saving guarantees against exact counts: every tracked
+ * frequency is an upper bound within total/k of the true frequency, and
+ * the 4 reported counters are exactly the 4 heavy hitters, in order
+ */
+static void check_against_exact(struct darshan_common_val_table *table,
+    struct exact_counts *exact)
+{
+    int64_t max_err = exact->total / DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT;
+    int64_t vals[4], cnts[4];
+    int64_t freq;
+    int count = 0;
+    int i;
+
+    for(i = 0; i < 4 + TEST_NTAIL; i++)
+    {
+        freq = table_freq(table, value_of(i));
+        if(!freq)
+        {
+            /* only values rarer than the error bound may be missing */
+            munit_assert_int64(exact->freqs[i], <=, max_err);
+            continue;
+        }
+        munit_assert_int64(freq, >=, exact->freqs[i]);
+        munit_assert_int64(freq, <=, exact->freqs[i] + max_err);
+        count++;
+    }
+    munit_assert_int(count, ==, table->count);
+    munit_assert_int(count, <=, DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT);
+
+    darshan_set_common_val_counters(table, vals, cnts);
+    for(i = 0; i < 4; i++)
+    {
+        munit_assert_int64(vals[i], ==, heavy_vals[i]);
+        munit_assert_int64(cnts[i], ==, table_freq(table, heavy_vals[i]));
+    }
+}
+
+/* below capacity, frequencies are exact and zero is never reported */
+static MunitResult track_exact_values(const MunitParameter params[], void* data)
+{
+    struct darshan_common_val_table table;
+    int64_t vals[4], cnts[4];
+    int64_t i;
+
+    memset(&table, 0, sizeof(table));
+    for(i = 0; i < DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT; i++)
+        munit_assert_int64(darshan_track_common_val(&table, i * 4096), ==, 1);
+    for(i = 0; i < 10; i++)
+        darshan_track_common_val(&table, 0);
+    for(i = 0; i < 5; i++)
+        darshan_track_common_val(&table, 8192);
+    for(i = 0; i < 3; i++)
+        darshan_track_common_val(&table, 4096);
+    munit_assert_int(table.count, ==, DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT);
+    munit_assert_int64(table_freq(&table, 0), ==, 11);
+    munit_assert_int64(table_freq(&table, 8192), ==, 6);
+    munit_assert_int64(table_freq(&table, 4096), ==, 4);
+
+    /* ties are broken by larger value first */
+    darshan_set_common_val_counters(&table, vals, cnts);
+    munit_assert_int64(vals[0], ==, 8192);
+    munit_assert_int64(cnts[0], ==, 6);
+    munit_assert_int64(vals[1], ==, 4096);
+    munit_assert_int64(cnts[1], ==, 4);
+    munit_assert_int64(vals[2], ==, (DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT - 1) * 4096);
+    munit_assert_int64(cnts[2], ==, 1);
+
+    return MUNIT_OK;
+}
+
+/* with many more distinct values than slots, evictions keep the heavy
+ * hitters within the error bound of their exact counts
+ */
+static MunitResult track_skewed_values(const MunitParameter params[], void* data)
+{
+    struct darshan_common_val_table table;
+    struct exact_counts exact;
+    int *ids;
+
+    ids = malloc(TEST_NOPS * sizeof(*ids));
+    munit_assert_not_null(ids);
+    memset(&table, 0, sizeof(table));
+    memset(&exact, 0, sizeof(exact));
+    skewed_stream(1, ids, TEST_NOPS);
+    track_stream(&table, &exact, ids, TEST_NOPS);
+    check_against_exact(&table, &exact);
+    free(ids);
+
+    return MUNIT_OK;
+}
+
+/* a value that only becomes frequent after the table filled up with other
+ * values must still displace them
+ */
+static MunitResult track_late_values(const MunitParameter params[], void* data)
+{
+    struct darshan_common_val_table table;
+    int64_t vals[4], cnts[4];
+    int64_t i;
+
+    memset(&table, 0, sizeof(table));
+    for(i = 0; i < 10 * DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT; i++)
+        darshan_track_common_val(&table, 1 + i % (4 * DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT));
+    for(i = 0; i < 1000; i++)
+        darshan_track_common_val(&table, 1048576);
+
+    darshan_set_common_val_counters(&table, vals, cnts);
+    munit_assert_int64(vals[0], ==, 1048576);
+    munit_assert_int64(cnts[0], >=, 1000);
+    munit_assert_int64(cnts[0], <=, 1000 + 10);
+
+    return MUNIT_OK;
+}
+
+/* merging the sketches of several processes, in the order an MPI reduction
+ * would, approximates the exact counts of the combined streams
+ */
+static MunitResult merge_skewed_values(const MunitParameter params[], void* data)
+{
+    struct darshan_common_val_table tables[TEST_NPROCS];
+    struct exact_counts exact, local_exact;
+    int *ids;
+    int stride;
+    int i, j;
+
+    ids = malloc(TEST_NOPS * sizeof(*ids));
+    munit_assert_not_null(ids);
+    memset(&exact, 0, sizeof(exact));
+    for(i = 0; i < TEST_NPROCS; i++)
+    {
+        /* each process sees a stream of a different length */
+        memset(&tables[i], 0, sizeof(tables[i]));
+        memset(&local_exact, 0, sizeof(local_exact));
+        skewed_stream(i + 2, ids, TEST_NOPS / (i + 1));
+        track_stream(&tables[i], &local_exact, ids, TEST_NOPS / (i + 1));
+        check_against_exact(&tables[i], &local_exact);
+        for(j = 0; j < 4 + TEST_NTAIL; j++)
+            exact.freqs[j] += local_exact.freqs[j];
+        exact.total += local_exact.total;
+    }
+
+    /* a binary reduction tree */
+    for(stride = 1; stride < TEST_NPROCS; stride *= 2)
+        for(i = 0; i + stride < TEST_NPROCS; i += 2 * stride)
+            darshan_merge_common_vals(&tables[i + stride], &tables[i]);
+    check_against_exact(&tables[0], &exact);
+
+    /* merging tables that are below capacity is exact */
+    memset(&tables[0], 0, sizeof(tables[0]));
+    memset(&tables[1], 0, sizeof(tables[1]));
+    for(i = 0; i < 10; i++)
+    {
+        darshan_track_common_val(&tables[0], 512 * (i % 3));
+        darshan_track_common_val(&tables[1], 512 * (i % 5));
+    }
+    darshan_merge_common_vals(&tables[1], &tables[0]);
+    munit_assert_int(tables[0].count, ==, 5);
+    munit_assert_int64(table_freq(&tables[0], 0), ==, 4 + 2);
+    munit_assert_int64(table_freq(&tables[0], 512), ==, 3 + 2);
+    munit_assert_int64(table_freq(&tables[0], 1024), ==, 3 + 2);
+    munit_assert_int64(table_freq(&tables[0], 1536), ==, 2);
+    munit_assert_int64(table_freq(&tables[0], 2048), ==, 2);
+
+    free(ids);
+
+    return MUNIT_OK;
+}
+
+/* the MPI reduction operation merges arrays of tables element-wise */
+static MunitResult reduce_value_tables(const MunitParameter params[], void* data)
+{
+#ifdef HAVE_MPI
+    struct darshan_common_val_table in[2], inout[2], expected[2];
+    struct exact_counts exact;
+    int *ids;
+    int len = 2;
+    int i;
+
+    ids = malloc(TEST_NOPS * sizeof(*ids));
+    munit_assert_not_null(ids);
+    memset(in, 0, sizeof(in));
+    memset(inout, 0, sizeof(inout));
+    for(i = 0; i < 2; i++)
+    {
+        memset(&exact, 0, sizeof(exact));
+        skewed_stream(10 + i, ids, TEST_NOPS);
+        track_stream(&in[i], &exact, ids, TEST_NOPS);
+        skewed_stream(20 + i, ids, TEST_NOPS / 2);
+        track_stream(&inout[i], &exact, ids, TEST_NOPS / 2);
+    }
+    memcpy(expected, inout, sizeof(expected));
+    for(i = 0; i < 2; i++)
+        darshan_merge_common_vals(&in[i], &expected[i]);
+
+    darshan_common_val_reduce(in, inout, &len, NULL);
+    munit_assert_memory_equal(sizeof(expected), inout, expected);
+    free(ids);
+
+    return MUNIT_OK;
+#else
+    return MUNIT_SKIP;
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    return munit_suite_main(&test_suite, NULL, argc, argv);
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2022 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <darshan-runtime-config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "munit/munit.h"
+
+#include "darshan.h"
+
+static MunitResult open_close_handles(const MunitParameter params[], void* data);
+
+/* test definition */
+static MunitTest tests[]
+    = {{"/open-close-handles", open_close_handles,
+        NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+       {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+static const MunitSuite test_suite = {
+    "/darshan-handle-table", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE
+};
+
+#define TEST_NHANDLES 5000
+#define TEST_NROUNDS 20
+
+/* simulate many rounds of opening and closing pointer-like handles, as
+ * MPI_File handles would be: every open handle must be found, closed
+ * handles must not be, and the table must not grow beyond what the
+ * handles open at any one time need
+ */
+static MunitResult open_close_handles(const MunitParameter params[], void* data)
+{
+    struct darshan_handle_table table;
+    void **handles;
+    uintptr_t ref;
+    int round;
+    int i, r;
+
+    handles = malloc(TEST_NHANDLES * sizeof(*handles));
+    munit_assert_not_null(handles);
+    memset(&table, 0, sizeof(table));
+
+    for(round = 0; round < TEST_NROUNDS; round++)
+    {
+        for(i = 0; i < TEST_NHANDLES; i++)
+        {
+            handles[i] = (void*)(uintptr_t)(0x10000 + 64 * (i + round * TEST_NHANDLES));
+            ref = i + 1;
+            munit_assert_int(darshan_handle_table_set(&table, &handles[i],
+                sizeof(void*), (void*)ref), ==, 1);
+        }
+        munit_assert_int(table.count, ==, TEST_NHANDLES);
+
+        /* close handles in a random order */
+        for(i = 0; i < TEST_NHANDLES / 2; i++)
+        {
+            r = munit_rand_int_range(0, TEST_NHANDLES - 1);
+            if(!handles[r])
+                continue;
+            ref = r + 1;
+            munit_assert_ptr_equal(darshan_handle_table_remove(&table,
+                &handles[r], sizeof(void*)), (void*)ref);
+            munit_assert_null(darshan_handle_table_lookup(&table,
+                &handles[r], sizeof(void*)));
+            handles[r] = NULL;
+        }
+        for(i = 0; i < TEST_NHANDLES; i++)
+        {
+            if(!handles[i])
+                continue;
+            ref = i + 1;
+            munit_assert_ptr_equal(darshan_handle_table_lookup(&table,
+                &handles[i], sizeof(void*)), (void*)ref);
+            munit_assert_ptr_equal(darshan_handle_table_remove(&table,
+                &handles[i], sizeof(void*)), (void*)ref);
+        }
+        munit_assert_int(table.count, ==, 0);
+    }
+
+    /* the load factor is kept at or below 1/2 of the peak open handles */
+    munit_assert_int(1 << table.bits, <=, 4 * TEST_NHANDLES);
+    darshan_handle_table_clear(&table);
+    free(handles);
+
+    return MUNIT_OK;
+}
+
+int main(int argc, char **argv)
+{
+    return munit_suite_main(&test_suite, NULL, argc, argv);
+}
@@ -0,0 +1,110 @@
+/*
+ *  (C) 2023 by Argonne National Laboratory.
+ *      See COPYRIGHT in top-level directory.
+ */
+
+/* Microbenchmark to measure the per-operation cost of POSIX read/write
+ * instrumentation.  Each phase issues tiny pwrite() and pread() calls to a
+ * single file, cycling through a configurable number of distinct access
+ * sizes and strides so that the common access size and stride counters
+ * are exercised.  Run it once with and once without Darshan preloaded;
+ * the difference in time per operation is the instrumentation cost.
+ */
+
+/* Arguments: a file name (which will be created), the number of
+ * operations to perform in each phase, and the number of distinct access
+ * sizes to cycle through
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <assert.h>
+
+#include <mpi.h>
+
+int main(int argc, char **argv)
+{
+    int nprocs;
+    int ret;
+    int fd;
+    long unsigned iters;
+    long unsigned i;
+    int nsizes;
+    char *buffer;
+    off_t offset;
+    size_t size;
+    double write1, write2, read1, read2;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+    /* we only want one proc */
+    if(nprocs > 1)
+    {
+        fprintf(stderr, "Error: this benchmark should be run with exactly one process.\n");
+        MPI_Finalize();
+        return(-1);
+    }
+
+    if(argc != 4 || sscanf(argv[2], "%lu", &iters) != 1 ||
+        sscanf(argv[3], "%d", &nsizes) != 1 || nsizes < 1)
+    {
+        fprintf(stderr, "Usage: %s <filename> <iters> <number of access sizes>\n", argv[0]);
+        fprintf(stderr, "       (note: filename will be created at runtime)\n");
+        MPI_Finalize();
+        return(-1);
+    }
+
+    fd = open(argv[1], O_CREAT|O_TRUNC|O_RDWR, 0644);
+    if(fd < 0)
+    {
+        perror("open");
+        MPI_Finalize();
+        return(-1);
+    }
+
+    buffer = calloc(nsizes, 1);
+    assert(buffer);
+
+    /* accesses of 1..nsizes bytes, each followed by a gap of the same
+     * size, so that both the access sizes and the strides vary
+     */
+    write1 = MPI_Wtime();
+    for(i=0, offset=0; i<iters; i++)
+    {
+        size = i % nsizes + 1;
+        ret = pwrite(fd, buffer, size, offset);
+        assert(ret == size);
+        offset += 2*size;
+        if(offset > 1024*1024)
+            offset = 0;
+    }
+    write2 = MPI_Wtime();
+
+    read1 = MPI_Wtime();
+    for(i=0, offset=0; i<iters; i++)
+    {
+        size = i % nsizes + 1;
+        ret = pread(fd, buffer, size, offset);
+        assert(ret == size);
+        offset += 2*size;
+        if(offset > 1024*1024)
+            offset = 0;
+    }
+    read2 = MPI_Wtime();
+
+    close(fd);
+    unlink(argv[1]);
+    free(buffer);
+
+    printf("# <op> <iters> <access sizes> <total time (s)> <time per op (ns)>\n");
+    printf("pwrite\t%lu\t%d\t%f\t%f\n", iters, nsizes, write2-write1,
+        (write2-write1)*1e9/iters);
+    printf("pread\t%lu\t%d\t%f\t%f\n", iters, nsizes, read2-read1,
+        (read2-read1)*1e9/iters);
+
+    MPI_Finalize();
+    return(0);
+}
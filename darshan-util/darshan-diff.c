@@ -9,6 +9,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <getopt.h>
 #include <inttypes.h>
 #include <sys/types.h>
 #include <assert.h>
@@ -31,8 +35,60 @@ struct darshan_file_record_ref
     UT_hash_handle hlink;
 };
 
+/* maximum number of records of a module to hold in memory when streaming
+ * a log in record id order; additional records are spilled to temporary
+ * sorted runs
+ */
+#define DARSHAN_DIFF_RUN_RECORDS (1 << 16)
+
+struct darshan_sorted_rec
+{
+    darshan_record_id id;
+    int64_t rank;
+    void *rec;
+};
+
+/* a sorted run of records, either spilled to a temporary log or in memory */
+struct darshan_sorted_run
+{
+    darshan_fd fd;
+    struct darshan_sorted_rec *recs;
+    int nrecs;
+    int pos;
+    struct darshan_sorted_rec cur;
+};
+
+/* a module's records in (record id, rank) order, merged from sorted runs */
+struct darshan_sorted_stream
+{
+    darshan_module_id mod_id;
+    char (*run_paths)[PATH_MAX];
+    int *run_nrecs;
+    int nruns;
+    struct darshan_sorted_rec *buf;
+    int count;
+    int len;
+    struct darshan_sorted_run *srcs;
+    struct darshan_sorted_run **heap;
+    int nheap;
+};
+
+/* a pair of records to diff when streaming, either of which may be NULL */
+struct darshan_diff_pair
+{
+    void *rec1;
+    void *rec2;
+};
+
+/* relative tolerance for counter comparisons */
+static double diff_tolerance = 0.0;
+/* ignore floating point (timing) counters and job timing differences */
+static int diff_counters_only = 0;
+
 static int darshan_build_global_record_hash(
     darshan_fd fd, struct darshan_file_record_ref **rec_hash);
+static int darshan_diff_streams(darshan_fd file1, darshan_fd file2);
+static char *lookup_name(darshan_name_table name_table, darshan_record_id id);
 
 static void print_str_diff(char *prefix, char *arg1, char *arg2)
 {
@@ -48,31 +104,176 @@ static void print_int64_diff(char *prefix, int64_t arg1, int64_t arg2)
     return;
 }
 
+static void usage(char *exename)
+{
+    fprintf(stderr, "Usage: %s [options] <logfile1> <logfile2>\n", exename);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "\t--stream\tCompare records in record id order using bounded memory.\n");
+    fprintf(stderr, "\t--tolerance <val>\tIgnore counter differences within the given relative tolerance (e.g., 0.05).\n");
+    fprintf(stderr, "\t--counters-only\tCompare integer counters only, ignoring timers and timestamps.\n");
+
+    exit(1);
+}
+
+static int counter_within_tolerance(double val1, double val2)
+{
+    double diff, mag1, mag2;
+
+    if(val1 == val2)
+        return(1);
+    if(diff_tolerance <= 0.0)
+        return(0);
+
+    diff = (val1 > val2) ? (val1 - val2) : (val2 - val1);
+    mag1 = (val1 < 0) ? -val1 : val1;
+    mag2 = (val2 < 0) ? -val2 : val2;
+
+    return(diff <= diff_tolerance * ((mag1 > mag2) ? mag1 : mag2));
+}
+
+static void print_counter(const struct darshan_counter_layout *layout, char *prefix,
+    void *rec, char *name, int i, int fcounter)
+{
+    struct darshan_base_record *base_rec = (struct darshan_base_record *)rec;
+    const char *mod_name = darshan_module_names[layout->mod_id];
+    int64_t *counters = (int64_t *)((char *)rec + layout->counters_off);
+    double *fcounters = (double *)((char *)rec + layout->fcounters_off);
+
+    printf("%s", prefix);
+    if(fcounter)
+        DARSHAN_F_COUNTER_PRINT(mod_name, base_rec->rank, base_rec->id,
+            layout->fcounter_names[i], fcounters[i], name, "", "");
+    else if(i == layout->unsigned_counter)
+        DARSHAN_U_COUNTER_PRINT(mod_name, base_rec->rank, base_rec->id,
+            layout->counter_names[i], counters[i], name, "", "");
+    else
+        DARSHAN_D_COUNTER_PRINT(mod_name, base_rec->rank, base_rec->id,
+            layout->counter_names[i], counters[i], name, "", "");
+
+    return;
+}
+
+/* print the diff of two module records (either of which may be NULL),
+ * honoring the tolerance and counters-only settings for modules with a
+ * known counter layout
+ */
+static void print_record_diff(darshan_module_id mod_id, void *rec1, char *name1,
+    void *rec2, char *name2)
+{
+    const struct darshan_counter_layout *layout = NULL;
+    int64_t *counters1 = NULL, *counters2 = NULL;
+    double *fcounters1 = NULL, *fcounters2 = NULL;
+    int i;
+
+    if(diff_tolerance > 0.0 || diff_counters_only)
+        layout = darshan_log_get_counter_layout(mod_id);
+    if(!layout)
+    {
+        /* not every module knows how to diff its records */
+        if(mod_logutils[mod_id]->log_print_diff)
+            mod_logutils[mod_id]->log_print_diff(rec1, name1, rec2, name2);
+        return;
+    }
+
+    if(rec1)
+    {
+        counters1 = (int64_t *)((char *)rec1 + layout->counters_off);
+        fcounters1 = (double *)((char *)rec1 + layout->fcounters_off);
+    }
+    if(rec2)
+    {
+        counters2 = (int64_t *)((char *)rec2 + layout->counters_off);
+        fcounters2 = (double *)((char *)rec2 + layout->fcounters_off);
+    }
+
+    for(i = 0; i < layout->ncounters; i++)
+    {
+        if(rec1 && rec2 && (i == layout->unsigned_counter ?
+            counters1[i] == counters2[i] :
+            counter_within_tolerance(counters1[i], counters2[i])))
+            continue;
+        if(rec1)
+            print_counter(layout, "- ", rec1, name1, i, 0);
+        if(rec2)
+            print_counter(layout, "+ ", rec2, name2, i, 0);
+    }
+
+    if(diff_counters_only)
+        return;
+
+    for(i = 0; i < layout->nfcounters; i++)
+    {
+        if(rec1 && rec2 && counter_within_tolerance(fcounters1[i], fcounters2[i]))
+            continue;
+        if(rec1)
+            print_counter(layout, "- ", rec1, name1, i, 1);
+        if(rec2)
+            print_counter(layout, "+ ", rec2, name2, i, 1);
+    }
+
+    return;
+}
+
 int main(int argc, char *argv[])
 {
     char *logfile1, *logfile2;
     darshan_fd file1, file2;
     struct darshan_job job1, job2;
     char exe1[4096], exe2[4096];
-    struct darshan_name_record_ref *name_hash1 = NULL, *name_hash2 = NULL;
-    struct darshan_name_record_ref *name_ref1, *name_ref2;
+    darshan_name_table name_table1 = NULL, name_table2 = NULL;
     struct darshan_file_record_ref *rec_hash1 = NULL, *rec_hash2 = NULL;
     struct darshan_file_record_ref *rec_ref1, *rec_ref2, *rec_tmp;
     struct darshan_mod_record_ref *mod_rec1, *mod_rec2;
     void *mod_buf1, *mod_buf2;
     struct darshan_base_record *base_rec1, *base_rec2;
-    char *file_name1, *file_name2;
+    char *file_name1 = NULL, *file_name2 = NULL;
+    int stream = 0;
+    char *check;
+    int index;
     int i;
     int ret;
+    static struct option long_opts[] =
+    {
+        {"stream", no_argument, NULL, 's'},
+        {"tolerance", required_argument, NULL, 't'},
+        {"counters-only", no_argument, NULL, 'c'},
+        {0, 0, 0, 0}
+    };
 
-    if(argc != 3)
+    while(1)
     {
-        fprintf(stderr, "Usage: darshan-diff <logfile1> <logfile2>\n");
-        return(-1);
+        int c = getopt_long(argc, argv, "", long_opts, &index);
+
+        if(c == -1) break;
+
+        switch(c)
+        {
+            case 's':
+                stream = 1;
+                break;
+            case 't':
+                diff_tolerance = strtod(optarg, &check);
+                if(optarg == check || diff_tolerance < 0.0)
+                {
+                    fprintf(stderr, "Error: invalid tolerance value.\n");
+                    return(-1);
+                }
+                break;
+            case 'c':
+                diff_counters_only = 1;
+                break;
+            case '?':
+            default:
+                usage(argv[0]);
+                break;
+        }
     }
 
-    logfile1 = argv[1];
-    logfile2 = argv[2];
+    if(argc - optind != 2)
+        usage(argv[0]);
+
+    logfile1 = argv[optind];
+    logfile2 = argv[optind + 1];
 
     file1 = darshan_log_open(logfile1);
     if(!file1)
@@ -133,36 +334,60 @@ int main(int argc, char *argv[])
 
     if (job1.uid != job2.uid)
         print_int64_diff("# uid:", job1.uid, job2.uid);
-    if (job1.start_time_sec != job2.start_time_sec)
+    if (!diff_counters_only && job1.start_time_sec != job2.start_time_sec)
         print_int64_diff("# start_time:", job1.start_time_sec, job2.start_time_sec);
-    if (job1.end_time_sec != job2.end_time_sec)
+    if (!diff_counters_only && job1.end_time_sec != job2.end_time_sec)
         print_int64_diff("# end_time:", job1.end_time_sec, job2.end_time_sec);
     if (job1.nprocs != job2.nprocs)
         print_int64_diff("# nprocs:", job1.nprocs, job2.nprocs);
-    if ((job1.end_time_sec-job1.start_time_sec) != (job2.end_time_sec-job2.start_time_sec))
+    if (!diff_counters_only &&
+        (job1.end_time_sec-job1.start_time_sec) != (job2.end_time_sec-job2.start_time_sec))
         print_int64_diff("# run time:",
                 (int64_t)(job1.end_time_sec - job1.start_time_sec + 1),
                 (int64_t)(job2.end_time_sec - job2.start_time_sec + 1));
 
-    /* get hash of record ids to file names for each log */
-    ret = darshan_log_get_namehash(file1, &name_hash1);
+    if(stream)
+    {
+        /* compare the logs module by module, in record id order, reading
+         * only the names of the records being compared
+         */
+        ret = darshan_diff_streams(file1, file2);
+        if(ret < 0)
+        {
+            darshan_log_close(file1);
+            darshan_log_close(file2);
+            return(-1);
+        }
+        goto cleanup;
+    }
+
+    /* get table of record ids to file names for each log */
+    ret = darshan_name_table_create(&name_table1);
+    if(ret == 0)
+        ret = darshan_log_get_name_table(file1, name_table1, NULL, 0);
     if(ret < 0)
     {
+        darshan_name_table_destroy(name_table1);
         darshan_log_close(file1);
         darshan_log_close(file2);
         fprintf(stderr, "Error: unable to read record hash for darshan log file %s.\n", logfile1);
         return(-1);
     }
 
-    ret = darshan_log_get_namehash(file2, &name_hash2);
+    ret = darshan_name_table_create(&name_table2);
+    if(ret == 0)
+        ret = darshan_log_get_name_table(file2, name_table2, NULL, 0);
     if(ret < 0)
     {
+        darshan_name_table_destroy(name_table1);
+        darshan_name_table_destroy(name_table2);
         darshan_log_close(file1);
         darshan_log_close(file2);
         fprintf(stderr, "Error: unable to read record hash for darshan log file %s.\n", logfile2);
         return(-1);
     }
 
+
     /* build hash tables of all records opened by all modules for each darshan log file */
     ret = darshan_build_global_record_hash(file1, &rec_hash1);
     if(ret < 0)
@@ -247,21 +472,11 @@ int main(int argc, char *argv[])
 
                 /* get corresponding file name for each record */
                 if(mod_buf1)
-                {
-                    HASH_FIND(hlink, name_hash1, &(base_rec1->id),
-                        sizeof(darshan_record_id), name_ref1);
-                    assert(name_ref1);
-                    file_name1 = name_ref1->name_record->name;
-                }
+                    file_name1 = lookup_name(name_table1, base_rec1->id);
                 if(mod_buf2)
-                {
-                    HASH_FIND(hlink, name_hash2, &(base_rec2->id),
-                        sizeof(darshan_record_id), name_ref2);
-                    assert(name_ref2);
-                    file_name2 = name_ref2->name_record->name;
-                }
+                    file_name2 = lookup_name(name_table2, base_rec2->id);
 
-                mod_logutils[i]->log_print_diff(mod_buf1, file_name1, mod_buf2, file_name2);
+                print_record_diff(i, mod_buf1, file_name1, mod_buf2, file_name2);
 
                 /* remove records which we have diffed already */
                 if(mod_buf1)
@@ -318,12 +533,9 @@ int main(int argc, char *argv[])
                 mod_rec2 = rec_ref2->mod_recs[i];
                 base_rec2 = (struct darshan_base_record *)mod_rec2->mod_dat;
 
-                HASH_FIND(hlink, name_hash2, &(base_rec2->id),
-                    sizeof(darshan_record_id), name_ref2);
-                assert(name_ref2);
-                file_name2 = name_ref2->name_record->name;
+                file_name2 = lookup_name(name_table2, base_rec2->id);
 
-                mod_logutils[i]->log_print_diff(NULL, NULL, mod_rec2->mod_dat, file_name2);
+                print_record_diff(i, NULL, NULL, mod_rec2->mod_dat, file_name2);
                 
                 /* remove the record we just diffed */
                 if(mod_rec2->next == mod_rec2)
@@ -345,18 +557,9 @@ int main(int argc, char *argv[])
         free(rec_ref2);
     }
 
-    HASH_ITER(hlink, name_hash1, name_ref1, name_ref2)
-    {
-        HASH_DELETE(hlink, name_hash1, name_ref1);
-        free(name_ref1->name_record);
-        free(name_ref1);
-    }
-    HASH_ITER(hlink, name_hash2, name_ref2, name_ref1)
-    {
-        HASH_DELETE(hlink, name_hash2, name_ref2);
-        free(name_ref2->name_record);
-        free(name_ref2);
-    }
+cleanup:
+    darshan_name_table_destroy(name_table1);
+    darshan_name_table_destroy(name_table2);
 
     darshan_log_close(file1);
     darshan_log_close(file2);
@@ -472,6 +675,501 @@ static int darshan_build_global_record_hash(
     return(0);
 }
 
+static int sorted_rec_cmp(const void *a, const void *b)
+{
+    const struct darshan_sorted_rec *rec_a = a;
+    const struct darshan_sorted_rec *rec_b = b;
+
+    if(rec_a->id != rec_b->id)
+        return((rec_a->id < rec_b->id) ? -1 : 1);
+    if(rec_a->rank != rec_b->rank)
+        return((rec_a->rank < rec_b->rank) ? -1 : 1);
+    return(0);
+}
+
+static int sorted_run_less(struct darshan_sorted_run *a, struct darshan_sorted_run *b)
+{
+    int cmp = sorted_rec_cmp(&a->cur, &b->cur);
+
+    if(cmp != 0)
+        return(cmp < 0);
+    return(a < b);
+}
+
+static void sorted_heap_sift_down(struct darshan_sorted_run **heap, int nheap, int i)
+{
+    struct darshan_sorted_run *tmp;
+    int child;
+
+    while((child = 2 * i + 1) < nheap)
+    {
+        if(child + 1 < nheap && sorted_run_less(heap[child + 1], heap[child]))
+            child++;
+        if(!sorted_run_less(heap[child], heap[i]))
+            break;
+        tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+        i = child;
+    }
+
+    return;
+}
+
+/* sort the buffered records of a stream and spill them to a temporary log */
+static int sorted_stream_spill(struct darshan_sorted_stream *stream)
+{
+    char (*tmp_paths)[PATH_MAX];
+    int *tmp_nrecs;
+    darshan_fd run_fd;
+    char *tmpdir;
+    int fd;
+    int ret = 0;
+    int i;
+
+    tmp_paths = realloc(stream->run_paths, (stream->nruns + 1) * sizeof(*tmp_paths));
+    if(!tmp_paths)
+        return(-1);
+    stream->run_paths = tmp_paths;
+    tmp_nrecs = realloc(stream->run_nrecs, (stream->nruns + 1) * sizeof(*tmp_nrecs));
+    if(!tmp_nrecs)
+        return(-1);
+    stream->run_nrecs = tmp_nrecs;
+
+    tmpdir = getenv("TMPDIR");
+    if(!tmpdir)
+        tmpdir = "/tmp";
+    snprintf(stream->run_paths[stream->nruns], PATH_MAX, "%s/darshan-diff-XXXXXX", tmpdir);
+    fd = mkstemp(stream->run_paths[stream->nruns]);
+    if(fd < 0)
+    {
+        fprintf(stderr, "Error: unable to create temporary file in %s.\n", tmpdir);
+        return(-1);
+    }
+    close(fd);
+    stream->run_nrecs[stream->nruns] = stream->count;
+    stream->nruns++;
+
+    run_fd = darshan_log_create(stream->run_paths[stream->nruns - 1], DARSHAN_ZLIB_COMP, 0);
+    if(run_fd == NULL)
+        return(-1);
+
+    qsort(stream->buf, stream->count, sizeof(*stream->buf), sorted_rec_cmp);
+    for(i = 0; i < stream->count; i++)
+    {
+        ret = mod_logutils[stream->mod_id]->log_put_record(run_fd, stream->buf[i].rec);
+        if(ret < 0)
+            break;
+    }
+    darshan_log_close(run_fd);
+    if(ret < 0)
+        return(-1);
+
+    for(i = 0; i < stream->count; i++)
+        free(stream->buf[i].rec);
+    stream->count = 0;
+
+    return(0);
+}
+
+/* advance a sorted run to its next record, returning 1 if a record was
+ * read, 0 if the run is exhausted, and -1 on error
+ */
+static int sorted_run_next(struct darshan_sorted_run *run, darshan_module_id mod_id)
+{
+    struct darshan_base_record *base_rec;
+    void *rec = NULL;
+
+    if(run->pos == run->nrecs)
+        return(0);
+
+    if(run->fd)
+    {
+        if(mod_logutils[mod_id]->log_get_record(run->fd, &rec) != 1)
+        {
+            fprintf(stderr, "Error: unable to read module %s data from temporary file.\n",
+                darshan_module_names[mod_id]);
+            return(-1);
+        }
+        base_rec = (struct darshan_base_record *)rec;
+        run->cur.id = base_rec->id;
+        run->cur.rank = base_rec->rank;
+        run->cur.rec = rec;
+    }
+    else
+    {
+        run->cur = run->recs[run->pos];
+        run->recs[run->pos].rec = NULL;
+    }
+    run->pos++;
+
+    return(1);
+}
+
+static void sorted_stream_close(struct darshan_sorted_stream *stream)
+{
+    int i;
+
+    for(i = 0; i < stream->nheap; i++)
+        free(stream->heap[i]->cur.rec);
+    for(i = 0; i <= stream->nruns && stream->srcs; i++)
+        if(stream->srcs[i].fd)
+            darshan_log_close(stream->srcs[i].fd);
+    for(i = 0; i < stream->nruns; i++)
+        unlink(stream->run_paths[i]);
+    for(i = 0; i < stream->count; i++)
+        free(stream->buf[i].rec);
+    free(stream->buf);
+    free(stream->run_paths);
+    free(stream->run_nrecs);
+    free(stream->srcs);
+    free(stream->heap);
+    memset(stream, 0, sizeof(*stream));
+
+    return;
+}
+
+/* read all of a module's records from a log, sorting them into runs that
+ * can be merged into a single stream in record id order
+ */
+static int sorted_stream_open(darshan_fd fd, darshan_module_id mod_id,
+    struct darshan_sorted_stream *stream)
+{
+    struct darshan_sorted_rec *tmp_buf;
+    struct darshan_base_record *base_rec;
+    int nsrcs = 0;
+    void *rec = NULL;
+    int ret;
+    int i;
+
+    memset(stream, 0, sizeof(*stream));
+    stream->mod_id = mod_id;
+
+    while((ret = mod_logutils[mod_id]->log_get_record(fd, &rec)) == 1)
+    {
+        if(stream->count == stream->len)
+        {
+            stream->len = stream->len ? (2 * stream->len) : 1024;
+            tmp_buf = realloc(stream->buf, stream->len * sizeof(*tmp_buf));
+            if(!tmp_buf)
+            {
+                free(rec);
+                ret = -1;
+                break;
+            }
+            stream->buf = tmp_buf;
+        }
+        base_rec = (struct darshan_base_record *)rec;
+        stream->buf[stream->count].id = base_rec->id;
+        stream->buf[stream->count].rank = base_rec->rank;
+        stream->buf[stream->count].rec = rec;
+        stream->count++;
+        rec = NULL;
+
+        if(stream->count == DARSHAN_DIFF_RUN_RECORDS)
+        {
+            ret = sorted_stream_spill(stream);
+            if(ret < 0)
+                break;
+        }
+    }
+    if(ret < 0)
+    {
+        fprintf(stderr, "Error: unable to read module %s data from log file.\n",
+            darshan_module_names[mod_id]);
+        sorted_stream_close(stream);
+        return(-1);
+    }
+
+    qsort(stream->buf, stream->count, sizeof(*stream->buf), sorted_rec_cmp);
+
+    /* set up a k-way merge of the spilled runs and the buffered records */
+    stream->srcs = calloc(stream->nruns + 1, sizeof(*stream->srcs));
+    stream->heap = calloc(stream->nruns + 1, sizeof(*stream->heap));
+    if(!stream->srcs || !stream->heap)
+    {
+        sorted_stream_close(stream);
+        return(-1);
+    }
+    for(i = 0; i < stream->nruns; i++)
+    {
+        stream->srcs[nsrcs].fd = darshan_log_open(stream->run_paths[i]);
+        if(!stream->srcs[nsrcs].fd)
+        {
+            sorted_stream_close(stream);
+            return(-1);
+        }
+        stream->srcs[nsrcs].nrecs = stream->run_nrecs[i];
+        nsrcs++;
+    }
+    stream->srcs[nsrcs].recs = stream->buf;
+    stream->srcs[nsrcs].nrecs = stream->count;
+    nsrcs++;
+
+    for(i = 0; i < nsrcs; i++)
+    {
+        ret = sorted_run_next(&stream->srcs[i], mod_id);
+        if(ret < 0)
+        {
+            sorted_stream_close(stream);
+            return(-1);
+        }
+        if(ret == 1)
+            stream->heap[stream->nheap++] = &stream->srcs[i];
+    }
+    for(i = stream->nheap / 2 - 1; i >= 0; i--)
+        sorted_heap_sift_down(stream->heap, stream->nheap, i);
+
+    return(0);
+}
+
+/* take the next record of a stream, in (record id, rank) order; the caller
+ * is responsible for freeing the record
+ */
+static int sorted_stream_next(struct darshan_sorted_stream *stream,
+    struct darshan_sorted_rec *rec)
+{
+    struct darshan_sorted_run *run;
+    int ret;
+
+    if(stream->nheap == 0)
+        return(0);
+
+    run = stream->heap[0];
+    *rec = run->cur;
+    ret = sorted_run_next(run, stream->mod_id);
+    if(ret < 0)
+    {
+        run->cur.rec = NULL;
+        return(-1);
+    }
+    if(ret == 0)
+        stream->heap[0] = stream->heap[--stream->nheap];
+    sorted_heap_sift_down(stream->heap, stream->nheap, 0);
+
+    return(1);
+}
+
+static char *lookup_name(darshan_name_table name_table, darshan_record_id id)
+{
+    const char *name;
+
+    name = darshan_name_table_lookup(name_table, id);
+    assert(name);
+
+    return((char *)name);
+}
+
+/* print the diffs of a batch of record pairs, reading only the names of the
+ * records in the batch from each log
+ */
+static int diff_print_batch(darshan_module_id mod_id, darshan_fd file1,
+    darshan_fd file2, struct darshan_diff_pair *pairs, int npairs,
+    int *first, darshan_record_id *last_id)
+{
+    darshan_name_table name_table1 = NULL, name_table2 = NULL;
+    darshan_record_id *ids1, *ids2;
+    darshan_record_id id;
+    int nids1 = 0, nids2 = 0;
+    int ret = 0;
+    int i;
+
+    ids1 = malloc(npairs * sizeof(*ids1));
+    ids2 = malloc(npairs * sizeof(*ids2));
+    if(!ids1 || !ids2)
+    {
+        free(ids1);
+        free(ids2);
+        return(-1);
+    }
+    for(i = 0; i < npairs; i++)
+    {
+        if(pairs[i].rec1)
+            ids1[nids1++] = ((struct darshan_base_record *)pairs[i].rec1)->id;
+        if(pairs[i].rec2)
+            ids2[nids2++] = ((struct darshan_base_record *)pairs[i].rec2)->id;
+    }
+
+    /* an empty whitelist would read every name, so skip those lookups */
+    if(darshan_name_table_create(&name_table1) < 0 ||
+       darshan_name_table_create(&name_table2) < 0 ||
+       (nids1 && darshan_log_get_name_table(file1, name_table1, ids1, nids1) < 0) ||
+       (nids2 && darshan_log_get_name_table(file2, name_table2, ids2, nids2) < 0))
+    {
+        fprintf(stderr, "Error: unable to read record names from darshan log files.\n");
+        ret = -1;
+    }
+    free(ids1);
+    free(ids2);
+
+    for(i = 0; i < npairs; i++)
+    {
+        if(ret == 0)
+        {
+            id = pairs[i].rec1 ?
+                ((struct darshan_base_record *)pairs[i].rec1)->id :
+                ((struct darshan_base_record *)pairs[i].rec2)->id;
+
+            /* separate the output for each record id */
+            if(*first || *last_id != id)
+            {
+                printf("\n");
+                *last_id = id;
+                *first = 0;
+            }
+
+            print_record_diff(mod_id,
+                pairs[i].rec1, pairs[i].rec1 ? lookup_name(name_table1, id) : NULL,
+                pairs[i].rec2, pairs[i].rec2 ? lookup_name(name_table2, id) : NULL);
+        }
+        free(pairs[i].rec1);
+        free(pairs[i].rec2);
+    }
+
+    darshan_name_table_destroy(name_table1);
+    darshan_name_table_destroy(name_table2);
+
+    return(ret);
+}
+
+/* diff two logs module by module, reading each module's records in record
+ * id order and matching them up rank-by-rank in a single merge pass.  Names
+ * are read for a batch of matched records at a time, so memory use does
+ * not grow with the number of records in either log.
+ */
+static int darshan_diff_streams(darshan_fd file1, darshan_fd file2)
+{
+    struct darshan_sorted_stream stream1, stream2;
+    struct darshan_sorted_rec rec1, rec2;
+    struct darshan_diff_pair *pairs;
+    darshan_record_id last_id = 0;
+    darshan_record_id skip_id;
+    int skip_shared;
+    int npairs = 0;
+    int first = 1;
+    int have1, have2;
+    int cmp;
+    int ret = 0;
+    int i;
+
+    pairs = malloc(DARSHAN_DIFF_RUN_RECORDS * sizeof(*pairs));
+    if(!pairs)
+        return(-1);
+
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(!mod_logutils[i] || !mod_logutils[i]->log_print_diff) continue;
+
+        /* skip the DXT modules -- we won't be diff'ing traces */
+        if(i == DXT_POSIX_MOD || i == DXT_MPIIO_MOD)
+            continue;
+
+        if(file1->mod_map[i].len == 0 && file2->mod_map[i].len == 0)
+            continue;
+
+        /* TODO: skip records found in both logs for modules that don't
+         * have the same format version, for now
+         */
+        skip_shared = (file1->mod_map[i].len && file2->mod_map[i].len &&
+            (file1->mod_ver[i] != file2->mod_ver[i]));
+
+        first = 1;
+        if(sorted_stream_open(file1, i, &stream1) < 0)
+        {
+            free(pairs);
+            return(-1);
+        }
+        if(sorted_stream_open(file2, i, &stream2) < 0)
+        {
+            sorted_stream_close(&stream1);
+            free(pairs);
+            return(-1);
+        }
+
+        have1 = sorted_stream_next(&stream1, &rec1);
+        have2 = sorted_stream_next(&stream2, &rec2);
+        /* stop at the first read error on either stream */
+        while(have1 >= 0 && have2 >= 0 && (have1 > 0 || have2 > 0))
+        {
+            if(skip_shared && have1 > 0 && have2 > 0 && rec1.id == rec2.id)
+            {
+                /* drop every rank's record of this id from both logs */
+                if(skip_shared == 1)
+                {
+                    fprintf(stderr, "Warning: skipping %s module data due to incompatible"
+                        "version numbers (file1=%d, file2=%d).\n",
+                        darshan_module_names[i], file1->mod_ver[i], file2->mod_ver[i]);
+                    skip_shared = 2; /* warn once per module */
+                }
+                skip_id = rec1.id;
+                while(have1 > 0 && rec1.id == skip_id)
+                {
+                    free(rec1.rec);
+                    have1 = sorted_stream_next(&stream1, &rec1);
+                }
+                while(have2 > 0 && rec2.id == skip_id)
+                {
+                    free(rec2.rec);
+                    have2 = sorted_stream_next(&stream2, &rec2);
+                }
+                continue;
+            }
+
+            if(have1 > 0 && have2 > 0)
+                cmp = sorted_rec_cmp(&rec1, &rec2);
+            else
+                cmp = (have1 > 0) ? -1 : 1;
+
+            pairs[npairs].rec1 = (cmp <= 0) ? rec1.rec : NULL;
+            pairs[npairs].rec2 = (cmp >= 0) ? rec2.rec : NULL;
+            npairs++;
+            if(cmp <= 0)
+                have1 = sorted_stream_next(&stream1, &rec1);
+            if(cmp >= 0)
+                have2 = sorted_stream_next(&stream2, &rec2);
+
+            if(npairs == DARSHAN_DIFF_RUN_RECORDS)
+            {
+                ret = diff_print_batch(i, file1, file2, pairs, npairs,
+                    &first, &last_id);
+                npairs = 0;
+                if(ret < 0)
+                    break;
+            }
+        }
+        if(ret == 0 && npairs > 0)
+            ret = diff_print_batch(i, file1, file2, pairs, npairs,
+                &first, &last_id);
+        else
+        {
+            /* free any pairs left over after a read error */
+            while(npairs > 0)
+            {
+                npairs--;
+                free(pairs[npairs].rec1);
+                free(pairs[npairs].rec2);
+            }
+        }
+        npairs = 0;
+
+        if(have1 > 0)
+            free(rec1.rec);
+        if(have2 > 0)
+            free(rec2.rec);
+        sorted_stream_close(&stream1);
+        sorted_stream_close(&stream2);
+        if(ret < 0 || have1 < 0 || have2 < 0)
+        {
+            free(pairs);
+            return(-1);
+        }
+    }
+
+    free(pairs);
+
+    return(0);
+}
+
 /*
  * Local variables:
  *  c-indent-level: 4
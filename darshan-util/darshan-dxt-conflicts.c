@@ -0,0 +1,430 @@
+/*
+ * Copyright (C) 2015 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+/* This file implements the DXT conflict analysis (dxt_conflicts_*)
+ * functions in darshan-dxt-logutils.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "darshan-logutils.h"
+#include "uthash-1.9.2/src/uthash.h"
+
+/* a DXT segment with a valid byte range, as [start, end) */
+struct dxt_conflict_seg
+{
+    int64_t start;
+    int64_t end;
+    double start_time;
+    double end_time;
+    int32_t rank;
+};
+
+/* all segments of a single file, gathered across ranks */
+struct dxt_conflict_rec_ref
+{
+    darshan_record_id id;
+    struct dxt_conflict_seg *writes;
+    int64_t nwrites;
+    int64_t writes_len;
+    struct dxt_conflict_seg *reads;
+    int64_t nreads;
+    int64_t reads_len;
+    UT_hash_handle hlink;
+};
+
+static int dxt_conflict_seg_cmp(const void *a, const void *b)
+{
+    const struct dxt_conflict_seg *s_a = a;
+    const struct dxt_conflict_seg *s_b = b;
+
+    if(s_a->start != s_b->start)
+        return((s_a->start < s_b->start) ? -1 : 1);
+    return((s_a->end > s_b->end) - (s_a->end < s_b->end));
+}
+
+static int dxt_conflict_add_segs(struct dxt_conflict_seg **segs, int64_t *nsegs,
+    int64_t *len, segment_info *io_trace, int64_t count, int64_t rank)
+{
+    struct dxt_conflict_seg *tmp_segs;
+    int64_t new_len;
+    int64_t i;
+
+    for(i = 0; i < count; i++)
+    {
+        /* MPI-IO offsets are not available in older logs */
+        if(io_trace[i].offset < 0 || io_trace[i].length <= 0)
+            continue;
+
+        if(*nsegs == *len)
+        {
+            /* grow by half to limit the slack on very large traces */
+            new_len = *len ? (*len + *len / 2) : 16;
+            tmp_segs = realloc(*segs, new_len * sizeof(**segs));
+            if(!tmp_segs)
+                return(-1);
+            *segs = tmp_segs;
+            *len = new_len;
+        }
+        (*segs)[*nsegs].start = io_trace[i].offset;
+        (*segs)[*nsegs].end = io_trace[i].offset + io_trace[i].length;
+        (*segs)[*nsegs].start_time = io_trace[i].start_time;
+        (*segs)[*nsegs].end_time = io_trace[i].end_time;
+        (*segs)[*nsegs].rank = rank;
+        (*nsegs)++;
+    }
+
+    return(0);
+}
+
+/* Build an implicit interval tree over segments sorted by start offset:
+ * the tree is the in-order layout of the array itself, with node i at
+ * level k if its k lowest bits are set, and max_end[i] holding the largest
+ * end offset in node i's subtree.  Returns the root level.
+ */
+static int dxt_itree_index(struct dxt_conflict_seg *segs, int64_t *max_end,
+    int64_t n)
+{
+    int64_t i, last_i = 0, last = 0;
+    int64_t x, i0, step, e, el, er;
+    int k;
+
+    for(i = 0; i < n; i += 2)
+    {
+        last_i = i;
+        last = max_end[i] = segs[i].end;
+    }
+    for(k = 1; ((int64_t)1 << k) <= n; k++)
+    {
+        x = (int64_t)1 << (k - 1);
+        i0 = (x << 1) - 1;
+        step = x << 2;
+        for(i = i0; i < n; i += step)
+        {
+            el = max_end[i - x];
+            er = (i + x < n) ? max_end[i + x] : last;
+            e = segs[i].end;
+            if(el > e)
+                e = el;
+            if(er > e)
+                e = er;
+            max_end[i] = e;
+        }
+        last_i = ((last_i >> k) & 1) ? (last_i - x) : (last_i + x);
+        if(last_i < n && max_end[last_i] > last)
+            last = max_end[last_i];
+    }
+
+    return(k - 1);
+}
+
+/* visit the writes overlapping a read from another rank, to see whether the
+ * read may observe data written by that rank (a read after write) and
+ * whether the two were concurrent (a race).  Returns a bitwise or of 1 for
+ * a read after write and 2 for a race.
+ */
+static int dxt_itree_check_read(struct dxt_conflict_seg *writes,
+    int64_t *max_end, int64_t n, int root_level, struct dxt_conflict_seg *read)
+{
+    struct { int64_t x; int k; int w; } stack[130], z;
+    int64_t i, i0, i1, y;
+    int t = 0;
+    int ret = 0;
+
+#define DXT_CHECK_WRITE(__w) do { \
+    if((__w)->rank != read->rank && (__w)->start_time < read->end_time) \
+    { \
+        ret |= 1; \
+        if((__w)->end_time > read->start_time) \
+            return(3); \
+    } \
+} while(0)
+
+    stack[t].x = ((int64_t)1 << root_level) - 1;
+    stack[t].k = root_level;
+    stack[t++].w = 0;
+    while(t > 0)
+    {
+        z = stack[--t];
+        if(z.k <= 3)
+        {
+            /* scan small subtrees directly */
+            i0 = z.x >> z.k << z.k;
+            i1 = i0 + ((int64_t)1 << (z.k + 1)) - 1;
+            if(i1 > n)
+                i1 = n;
+            for(i = i0; i < i1 && writes[i].start < read->end; i++)
+            {
+                if(read->start < writes[i].end)
+                    DXT_CHECK_WRITE(&writes[i]);
+            }
+        }
+        else if(z.w == 0)
+        {
+            /* revisit this node after its left subtree, if that can overlap */
+            y = z.x - ((int64_t)1 << (z.k - 1));
+            stack[t].x = z.x;
+            stack[t].k = z.k;
+            stack[t++].w = 1;
+            if(y >= n || max_end[y] > read->start)
+            {
+                stack[t].x = y;
+                stack[t].k = z.k - 1;
+                stack[t++].w = 0;
+            }
+        }
+        else if(z.x < n && writes[z.x].start < read->end)
+        {
+            if(read->start < writes[z.x].end)
+                DXT_CHECK_WRITE(&writes[z.x]);
+            stack[t].x = z.x + ((int64_t)1 << (z.k - 1));
+            stack[t].k = z.k - 1;
+            stack[t++].w = 0;
+        }
+    }
+#undef DXT_CHECK_WRITE
+
+    return(ret);
+}
+
+static int dxt_conflicts_analyze_file(struct dxt_conflict_rec_ref *ref,
+    struct dxt_conflict_file *file)
+{
+    struct dxt_conflict_seg *writes = ref->writes;
+    int64_t n = ref->nwrites;
+    int64_t best1, best2, rank1;
+    int64_t union_end, overlap_end, e;
+    int64_t *max_end;
+    char *flags;
+    int root_level;
+    int64_t i;
+    int ret;
+
+    file->write_count = ref->nwrites;
+    file->read_count = ref->nreads;
+    if(n == 0)
+        return(0);
+
+    flags = calloc(n, 1);
+    if(!flags)
+        return(-1);
+    qsort(writes, n, sizeof(*writes), dxt_conflict_seg_cmp);
+
+    /* sweep writes by start offset, tracking the furthest end offset
+     * reached by any rank (best1, by rank1) and by any other rank (best2),
+     * to find writes overlapping an earlier-starting write of another rank
+     * and the union of bytes written and written by more than one rank
+     */
+    best1 = best2 = INT64_MIN;
+    rank1 = -1;
+    union_end = overlap_end = INT64_MIN;
+    for(i = 0; i < n; i++)
+    {
+        file->write_bytes += writes[i].end - writes[i].start;
+        if(writes[i].end > union_end)
+        {
+            file->unique_write_bytes += writes[i].end -
+                ((union_end > writes[i].start) ? union_end : writes[i].start);
+            union_end = writes[i].end;
+        }
+
+        e = (writes[i].rank != rank1) ? best1 : best2;
+        if(e > writes[i].start)
+        {
+            flags[i] = 1;
+            if(e > writes[i].end)
+                e = writes[i].end;
+            if(e > overlap_end)
+            {
+                file->overlap_write_bytes += e -
+                    ((overlap_end > writes[i].start) ? overlap_end : writes[i].start);
+                overlap_end = e;
+            }
+        }
+
+        if(writes[i].rank == rank1)
+        {
+            if(writes[i].end > best1)
+                best1 = writes[i].end;
+        }
+        else if(writes[i].end > best1)
+        {
+            best2 = best1;
+            best1 = writes[i].end;
+            rank1 = writes[i].rank;
+        }
+        else if(writes[i].end > best2)
+            best2 = writes[i].end;
+    }
+    file->max_write_offset = union_end;
+    file->coverage = (double)file->unique_write_bytes / union_end;
+
+    /* sweep in reverse, tracking the lowest start offsets in the same way,
+     * to also flag writes overlapping a later-starting write of another rank
+     */
+    best1 = best2 = INT64_MAX;
+    rank1 = -1;
+    for(i = n - 1; i >= 0; i--)
+    {
+        e = (writes[i].rank != rank1) ? best1 : best2;
+        if(e < writes[i].end)
+            flags[i] = 1;
+        if(flags[i])
+            file->overlapping_writes++;
+
+        if(writes[i].rank == rank1)
+        {
+            if(writes[i].start < best1)
+                best1 = writes[i].start;
+        }
+        else if(writes[i].start < best1)
+        {
+            best2 = best1;
+            best1 = writes[i].start;
+            rank1 = writes[i].rank;
+        }
+        else if(writes[i].start < best2)
+            best2 = writes[i].start;
+    }
+    free(flags);
+
+    if(ref->nreads == 0)
+        return(0);
+
+    /* look up the writes overlapping each read in an interval tree */
+    max_end = malloc(n * sizeof(*max_end));
+    if(!max_end)
+        return(-1);
+    root_level = dxt_itree_index(writes, max_end, n);
+    for(i = 0; i < ref->nreads; i++)
+    {
+        ret = dxt_itree_check_read(writes, max_end, n, root_level,
+            &ref->reads[i]);
+        if(ret & 1)
+            file->raw_reads++;
+        if(ret & 2)
+            file->raw_races++;
+    }
+    free(max_end);
+
+    return(0);
+}
+
+static int dxt_conflict_file_cmp(const void *a, const void *b)
+{
+    const struct dxt_conflict_file *f_a = a;
+    const struct dxt_conflict_file *f_b = b;
+
+    if(f_a->mod_id != f_b->mod_id)
+        return((f_a->mod_id < f_b->mod_id) ? -1 : 1);
+    return((f_a->rec_id > f_b->rec_id) - (f_a->rec_id < f_b->rec_id));
+}
+
+int dxt_conflicts_analyze(darshan_fd fd, struct dxt_conflict_file **files,
+    int *count)
+{
+    int mods[2] = {DXT_POSIX_MOD, DXT_MPIIO_MOD};
+    struct dxt_conflict_rec_ref *rec_hash = NULL;
+    struct dxt_conflict_rec_ref *ref, *tmp_ref;
+    struct dxt_conflict_file *tmp_files;
+    struct dxt_file_record *rec;
+    segment_info *io_trace;
+    void *buf = NULL;
+    int files_len = 0;
+    int ret = 0;
+    int m;
+
+    *files = NULL;
+    *count = 0;
+
+    /* analyze one module at a time, so only its segments are in memory */
+    for(m = 0; m < 2 && ret == 0; m++)
+    {
+        while((ret = mod_logutils[mods[m]]->log_get_record(fd, &buf)) > 0)
+        {
+            rec = buf;
+            io_trace = (segment_info *)((char *)rec + sizeof(*rec));
+
+            HASH_FIND(hlink, rec_hash, &rec->base_rec.id,
+                sizeof(darshan_record_id), ref);
+            if(!ref)
+            {
+                ref = calloc(1, sizeof(*ref));
+                if(!ref)
+                {
+                    ret = -1;
+                    break;
+                }
+                ref->id = rec->base_rec.id;
+                HASH_ADD(hlink, rec_hash, id, sizeof(darshan_record_id), ref);
+            }
+
+            ret = dxt_conflict_add_segs(&ref->writes, &ref->nwrites,
+                &ref->writes_len, io_trace, rec->write_count,
+                rec->base_rec.rank);
+            if(ret == 0)
+                ret = dxt_conflict_add_segs(&ref->reads, &ref->nreads,
+                    &ref->reads_len, io_trace + rec->write_count,
+                    rec->read_count, rec->base_rec.rank);
+            free(buf);
+            buf = NULL;
+            if(ret < 0)
+                break;
+        }
+
+        HASH_ITER(hlink, rec_hash, ref, tmp_ref)
+        {
+            if(ret == 0 && (ref->nwrites > 0 || ref->nreads > 0))
+            {
+                if(*count == files_len)
+                {
+                    files_len = files_len ? (2 * files_len) : 16;
+                    tmp_files = realloc(*files, files_len * sizeof(**files));
+                    if(!tmp_files)
+                        ret = -1;
+                    else
+                        *files = tmp_files;
+                }
+                if(ret == 0)
+                {
+                    memset(&(*files)[*count], 0, sizeof(**files));
+                    (*files)[*count].rec_id = ref->id;
+                    (*files)[*count].mod_id = mods[m];
+                    ret = dxt_conflicts_analyze_file(ref, &(*files)[*count]);
+                    (*count)++;
+                }
+            }
+
+            HASH_DELETE(hlink, rec_hash, ref);
+            free(ref->writes);
+            free(ref->reads);
+            free(ref);
+        }
+    }
+
+    if(ret < 0)
+    {
+        free(*files);
+        *files = NULL;
+        *count = 0;
+        return(-1);
+    }
+
+    qsort(*files, *count, sizeof(**files), dxt_conflict_file_cmp);
+
+    return(0);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
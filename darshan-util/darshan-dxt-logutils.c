@@ -19,6 +19,8 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <limits.h>
+#include <sys/mman.h>
 
 #include "darshan-logutils.h"
 
@@ -459,6 +461,629 @@ void dxt_log_print_mpiio_file(void *mpiio_file_rec, char *file_name,
     return;
 }
 
+static int dxt_segment_arrays_grow(struct dxt_segment_arrays *arrays,
+    int64_t *len, int64_t needed)
+{
+    int64_t new_len;
+    void *tmp;
+
+    if(needed <= *len)
+        return(0);
+    new_len = *len ? *len : 1024;
+    while(new_len < needed)
+        new_len *= 2;
+
+#define DXT_GROW_ARRAY(__array) do { \
+    tmp = realloc(__array, new_len * sizeof(*(__array))); \
+    if(!tmp) \
+        return(-1); \
+    __array = tmp; \
+} while(0)
+    DXT_GROW_ARRAY(arrays->rec_index);
+    DXT_GROW_ARRAY(arrays->rank);
+    DXT_GROW_ARRAY(arrays->offset);
+    DXT_GROW_ARRAY(arrays->length);
+    DXT_GROW_ARRAY(arrays->start_time);
+    DXT_GROW_ARRAY(arrays->end_time);
+    DXT_GROW_ARRAY(arrays->op);
+#undef DXT_GROW_ARRAY
+    *len = new_len;
+
+    return(0);
+}
+
+int dxt_log_get_segment_arrays(darshan_fd fd, darshan_module_id mod_id,
+    struct dxt_segment_arrays *arrays)
+{
+    struct dxt_file_record *rec;
+    segment_info *io_trace;
+    darshan_record_id *tmp_ids;
+    int64_t recs_len = 0;
+    int64_t segs_len = 0;
+    int64_t nsegs, i, j;
+    void *buf = NULL;
+    int ret;
+
+    memset(arrays, 0, sizeof(*arrays));
+    if(mod_id != DXT_POSIX_MOD && mod_id != DXT_MPIIO_MOD)
+        return(-1);
+
+    while((ret = mod_logutils[mod_id]->log_get_record(fd, &buf)) > 0)
+    {
+        rec = buf;
+        io_trace = (segment_info *)((char *)rec + sizeof(*rec));
+        nsegs = rec->write_count + rec->read_count;
+
+        if(arrays->nrecs == recs_len)
+        {
+            recs_len = recs_len ? (2 * recs_len) : 64;
+            tmp_ids = realloc(arrays->rec_ids, recs_len * sizeof(*tmp_ids));
+            if(!tmp_ids)
+            {
+                ret = -1;
+                break;
+            }
+            arrays->rec_ids = tmp_ids;
+        }
+        if(dxt_segment_arrays_grow(arrays, &segs_len, arrays->count + nsegs) < 0)
+        {
+            ret = -1;
+            break;
+        }
+
+        arrays->rec_ids[arrays->nrecs] = rec->base_rec.id;
+        for(i = 0, j = arrays->count; i < nsegs; i++, j++)
+        {
+            arrays->rec_index[j] = arrays->nrecs;
+            arrays->rank[j] = rec->base_rec.rank;
+            arrays->offset[j] = io_trace[i].offset;
+            arrays->length[j] = io_trace[i].length;
+            arrays->start_time[j] = io_trace[i].start_time;
+            arrays->end_time[j] = io_trace[i].end_time;
+            arrays->op[j] = (i < rec->write_count) ? DXT_QUERY_WRITE : DXT_QUERY_READ;
+        }
+        arrays->nrecs++;
+        arrays->count += nsegs;
+
+        free(buf);
+        buf = NULL;
+    }
+    free(buf);
+
+    if(ret < 0)
+    {
+        dxt_free_segment_arrays(arrays);
+        return(-1);
+    }
+
+    return(0);
+}
+
+void dxt_free_segment_arrays(struct dxt_segment_arrays *arrays)
+{
+    free(arrays->rec_ids);
+    free(arrays->rec_index);
+    free(arrays->rank);
+    free(arrays->offset);
+    free(arrays->length);
+    free(arrays->start_time);
+    free(arrays->end_time);
+    free(arrays->op);
+    memset(arrays, 0, sizeof(*arrays));
+
+    return;
+}
+
+/* a single (record, rank, operation) trace in a DXT index, whose
+ * segments are stored contiguously, sorted by start time
+ *
+ * each trace's segments form an implicit interval tree: the root of the
+ * segments [lo, hi) is the middle segment, with the segments before and
+ * after it as its left and right subtrees, and max_end[] holds the latest
+ * end time within each node's subtree.  A query descends only into
+ * subtrees that can still overlap its window, so it costs O(log n + k) per
+ * trace even if a single long segment overlaps most of the others.
+ */
+struct dxt_index_trace
+{
+    darshan_record_id id;
+    int64_t rank;
+    int32_t mod_id;
+    int32_t op;
+    int64_t first_seg;
+    int64_t nsegs;
+};
+
+/* on-disk index cache header, followed by the traces, segments, subtree
+ * maximum end times and original segment numbers
+ */
+#define DXT_INDEX_MAGIC "DXTINDEX"
+#define DXT_INDEX_VERSION 2
+struct dxt_index_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t pad;
+    int64_t log_size;
+    int64_t log_mtime;
+    int64_t log_mtime_nsec;
+    int64_t ntraces;
+    int64_t nsegs;
+};
+
+struct dxt_index
+{
+    int64_t ntraces;
+    struct dxt_index_trace *traces;
+    int64_t nsegs;
+    segment_info *segs;
+    /* max_end[i] is the latest end time in the interval tree subtree
+     * rooted at segment i of its trace
+     */
+    double *max_end;
+    int32_t *seg_nums;
+    /* set when the index is mapped from a cache file */
+    void *map;
+    size_t map_len;
+};
+
+struct dxt_index_seg
+{
+    segment_info info;
+    int32_t num;
+};
+
+static int dxt_index_trace_cmp(const void *a, const void *b)
+{
+    const struct dxt_index_trace *t_a = a;
+    const struct dxt_index_trace *t_b = b;
+
+    if(t_a->mod_id != t_b->mod_id)
+        return((t_a->mod_id < t_b->mod_id) ? -1 : 1);
+    if(t_a->id != t_b->id)
+        return((t_a->id < t_b->id) ? -1 : 1);
+    if(t_a->rank != t_b->rank)
+        return((t_a->rank < t_b->rank) ? -1 : 1);
+    return((t_a->op > t_b->op) - (t_a->op < t_b->op));
+}
+
+static int dxt_index_seg_cmp(const void *a, const void *b)
+{
+    const struct dxt_index_seg *s_a = a;
+    const struct dxt_index_seg *s_b = b;
+
+    if(s_a->info.start_time != s_b->info.start_time)
+        return((s_a->info.start_time < s_b->info.start_time) ? -1 : 1);
+    return((s_a->num > s_b->num) - (s_a->num < s_b->num));
+}
+
+/* fill in the subtree maximum end times of the interval tree over the
+ * segments [lo, hi), returning the maximum of the whole range
+ */
+static double dxt_index_build_tree(segment_info *segs, double *max_end,
+    int64_t lo, int64_t hi)
+{
+    int64_t mid;
+    double max, sub_max;
+
+    if(lo >= hi)
+        return(-1.0);
+
+    mid = lo + (hi - lo) / 2;
+    max = segs[mid].end_time;
+    sub_max = dxt_index_build_tree(segs, max_end, lo, mid);
+    if(sub_max > max)
+        max = sub_max;
+    sub_max = dxt_index_build_tree(segs, max_end, mid + 1, hi);
+    if(sub_max > max)
+        max = sub_max;
+    max_end[mid] = max;
+
+    return(max);
+}
+
+/* append one operation's segments from a DXT record to the index */
+static int dxt_index_add_trace(struct dxt_index *index, int64_t *traces_len,
+    int64_t *segs_len, struct dxt_file_record *rec, int mod_id, int op,
+    segment_info *io_trace, int64_t count)
+{
+    struct dxt_index_trace *trace;
+    struct dxt_index_seg *tmp_segs;
+    void *tmp;
+    int64_t new_len;
+    int64_t i;
+
+    if(count == 0)
+        return(0);
+
+    if(index->ntraces == *traces_len)
+    {
+        new_len = *traces_len ? (2 * *traces_len) : 64;
+        tmp = realloc(index->traces, new_len * sizeof(*index->traces));
+        if(!tmp)
+            return(-1);
+        index->traces = tmp;
+        *traces_len = new_len;
+    }
+    if(index->nsegs + count > *segs_len)
+    {
+        new_len = *segs_len ? *segs_len : 1024;
+        while(new_len < index->nsegs + count)
+            new_len *= 2;
+        tmp = realloc(index->segs, new_len * sizeof(*index->segs));
+        if(!tmp)
+            return(-1);
+        index->segs = tmp;
+        tmp = realloc(index->max_end, new_len * sizeof(*index->max_end));
+        if(!tmp)
+            return(-1);
+        index->max_end = tmp;
+        tmp = realloc(index->seg_nums, new_len * sizeof(*index->seg_nums));
+        if(!tmp)
+            return(-1);
+        index->seg_nums = tmp;
+        *segs_len = new_len;
+    }
+
+    tmp_segs = malloc(count * sizeof(*tmp_segs));
+    if(!tmp_segs)
+        return(-1);
+    for(i = 0; i < count; i++)
+    {
+        tmp_segs[i].info = io_trace[i];
+        tmp_segs[i].num = i;
+    }
+    qsort(tmp_segs, count, sizeof(*tmp_segs), dxt_index_seg_cmp);
+
+    trace = &index->traces[index->ntraces++];
+    trace->id = rec->base_rec.id;
+    trace->rank = rec->base_rec.rank;
+    trace->mod_id = mod_id;
+    trace->op = op;
+    trace->first_seg = index->nsegs;
+    trace->nsegs = count;
+    for(i = 0; i < count; i++)
+    {
+        index->segs[index->nsegs + i] = tmp_segs[i].info;
+        index->seg_nums[index->nsegs + i] = tmp_segs[i].num;
+    }
+    dxt_index_build_tree(&index->segs[index->nsegs],
+        &index->max_end[index->nsegs], 0, count);
+    index->nsegs += count;
+    free(tmp_segs);
+
+    return(0);
+}
+
+static int dxt_index_build(const char *logname, struct dxt_index *index)
+{
+    int mods[2] = {DXT_POSIX_MOD, DXT_MPIIO_MOD};
+    struct dxt_file_record *rec;
+    segment_info *io_trace;
+    int64_t traces_len = 0;
+    int64_t segs_len = 0;
+    darshan_fd fd;
+    void *buf = NULL;
+    int ret = 0;
+    int m;
+
+    fd = darshan_log_open(logname);
+    if(!fd)
+        return(-1);
+
+    for(m = 0; m < 2 && ret == 0; m++)
+    {
+        while((ret = mod_logutils[mods[m]]->log_get_record(fd, &buf)) > 0)
+        {
+            rec = buf;
+            io_trace = (segment_info *)((char *)rec + sizeof(*rec));
+            ret = dxt_index_add_trace(index, &traces_len, &segs_len, rec,
+                mods[m], DXT_QUERY_WRITE, io_trace, rec->write_count);
+            if(ret == 0)
+                ret = dxt_index_add_trace(index, &traces_len, &segs_len, rec,
+                    mods[m], DXT_QUERY_READ, io_trace + rec->write_count,
+                    rec->read_count);
+            free(buf);
+            buf = NULL;
+            if(ret < 0)
+                break;
+        }
+    }
+    darshan_log_close(fd);
+    if(ret < 0)
+        return(-1);
+
+    qsort(index->traces, index->ntraces, sizeof(*index->traces),
+        dxt_index_trace_cmp);
+
+    return(0);
+}
+
+static int dxt_index_load_cache(const char *path, struct stat *log_st,
+    struct dxt_index *index)
+{
+    struct dxt_index_header *hdr;
+    struct stat st;
+    size_t expected;
+    char *p;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return(-1);
+    if(fstat(fd, &st) < 0 || st.st_size < sizeof(*hdr))
+    {
+        close(fd);
+        return(-1);
+    }
+    p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED)
+        return(-1);
+
+    hdr = (struct dxt_index_header *)p;
+    expected = sizeof(*hdr) + hdr->ntraces * sizeof(struct dxt_index_trace) +
+        hdr->nsegs * (sizeof(segment_info) + sizeof(double) + sizeof(int32_t));
+    if(memcmp(hdr->magic, DXT_INDEX_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version != DXT_INDEX_VERSION || hdr->log_size != log_st->st_size ||
+        hdr->log_mtime != log_st->st_mtim.tv_sec ||
+        hdr->log_mtime_nsec != log_st->st_mtim.tv_nsec || hdr->ntraces < 0 ||
+        hdr->nsegs < 0 || expected != st.st_size)
+    {
+        munmap(p, st.st_size);
+        return(-1);
+    }
+
+    index->map = p;
+    index->map_len = st.st_size;
+    index->ntraces = hdr->ntraces;
+    index->nsegs = hdr->nsegs;
+    p += sizeof(*hdr);
+    index->traces = (struct dxt_index_trace *)p;
+    p += index->ntraces * sizeof(*index->traces);
+    index->segs = (segment_info *)p;
+    p += index->nsegs * sizeof(*index->segs);
+    index->max_end = (double *)p;
+    p += index->nsegs * sizeof(*index->max_end);
+    index->seg_nums = (int32_t *)p;
+
+    return(0);
+}
+
+/* write the index to a temporary file and rename it into place, so
+ * concurrent readers never see a partial cache
+ */
+static void dxt_index_save_cache(const char *path, struct stat *log_st,
+    struct dxt_index *index)
+{
+    struct dxt_index_header hdr;
+    char tmp_path[PATH_MAX];
+    FILE *fp;
+    int fd;
+    int ok;
+    int ret;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, DXT_INDEX_MAGIC, sizeof(hdr.magic));
+    hdr.version = DXT_INDEX_VERSION;
+    hdr.log_size = log_st->st_size;
+    hdr.log_mtime = log_st->st_mtim.tv_sec;
+    hdr.log_mtime_nsec = log_st->st_mtim.tv_nsec;
+    hdr.ntraces = index->ntraces;
+    hdr.nsegs = index->nsegs;
+
+    ret = snprintf(tmp_path, sizeof(tmp_path), "%s.XXXXXX", path);
+    if(ret < 0 || ret >= sizeof(tmp_path))
+        return;
+    fd = mkstemp(tmp_path);
+    if(fd < 0)
+        return; /* the cache is optional, e.g. for logs in read-only directories */
+    fp = fdopen(fd, "w");
+    if(!fp)
+    {
+        close(fd);
+        unlink(tmp_path);
+        return;
+    }
+
+    ok = (fwrite(&hdr, sizeof(hdr), 1, fp) == 1);
+    ok = ok && (fwrite(index->traces, sizeof(*index->traces), index->ntraces, fp) == index->ntraces);
+    ok = ok && (fwrite(index->segs, sizeof(*index->segs), index->nsegs, fp) == index->nsegs);
+    ok = ok && (fwrite(index->max_end, sizeof(*index->max_end), index->nsegs, fp) == index->nsegs);
+    ok = ok && (fwrite(index->seg_nums, sizeof(*index->seg_nums), index->nsegs, fp) == index->nsegs);
+    if(fclose(fp) != 0)
+        ok = 0;
+    if(!ok || rename(tmp_path, path) < 0)
+        unlink(tmp_path);
+
+    return;
+}
+
+int dxt_index_open(const char *logname, int cache, struct dxt_index **index)
+{
+    char cache_path[PATH_MAX];
+    struct stat log_st;
+    int ret;
+
+    *index = calloc(1, sizeof(**index));
+    if(!*index)
+        return(-1);
+
+    if(cache)
+    {
+        if(stat(logname, &log_st) < 0)
+        {
+            fprintf(stderr, "Error: unable to stat log file %s.\n", logname);
+            free(*index);
+            *index = NULL;
+            return(-1);
+        }
+        /* skip the cache if its name would not fit */
+        ret = snprintf(cache_path, sizeof(cache_path), "%s.dxtidx", logname);
+        if(ret < 0 || ret >= sizeof(cache_path))
+            cache = 0;
+        else if(dxt_index_load_cache(cache_path, &log_st, *index) == 0)
+            return(0);
+    }
+
+    ret = dxt_index_build(logname, *index);
+    if(ret < 0)
+    {
+        dxt_index_close(*index);
+        *index = NULL;
+        return(-1);
+    }
+
+    if(cache)
+        dxt_index_save_cache(cache_path, &log_st, *index);
+
+    return(0);
+}
+
+static int dxt_index_add_result(struct dxt_query_segment **segs,
+    int64_t *count, int64_t *len, struct dxt_index_trace *trace,
+    segment_info *info, int32_t seg_num)
+{
+    struct dxt_query_segment *tmp_segs;
+
+    if(*count == *len)
+    {
+        *len = *len ? (2 * *len) : 64;
+        tmp_segs = realloc(*segs, *len * sizeof(**segs));
+        if(!tmp_segs)
+            return(-1);
+        *segs = tmp_segs;
+    }
+    (*segs)[*count].rec_id = trace->id;
+    (*segs)[*count].rank = trace->rank;
+    (*segs)[*count].op = trace->op;
+    (*segs)[*count].segment = seg_num;
+    (*segs)[*count].info = *info;
+    (*count)++;
+
+    return(0);
+}
+
+/* in-order walk of the interval tree over the segments [lo, hi) of a
+ * trace (offsets relative to its first segment), appending the segments
+ * that overlap the query window in start time order
+ */
+static int dxt_index_query_tree(struct dxt_index *index,
+    struct dxt_index_trace *trace, struct dxt_query *query,
+    int64_t lo, int64_t hi, struct dxt_query_segment **segs, int64_t *count,
+    int64_t *len)
+{
+    segment_info *trace_segs = &index->segs[trace->first_seg];
+    int64_t mid;
+    int ret;
+
+    while(lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        /* nothing in this subtree ends within the window */
+        if(index->max_end[trace->first_seg + mid] < query->start_time)
+            return(0);
+
+        ret = dxt_index_query_tree(index, trace, query, lo, mid, segs,
+            count, len);
+        if(ret < 0)
+            return(ret);
+
+        /* this segment and everything after it starts after the window */
+        if(trace_segs[mid].start_time > query->end_time)
+            return(0);
+        if(trace_segs[mid].end_time >= query->start_time)
+        {
+            ret = dxt_index_add_result(segs, count, len, trace,
+                &trace_segs[mid], index->seg_nums[trace->first_seg + mid]);
+            if(ret < 0)
+                return(ret);
+        }
+
+        /* continue with the right subtree */
+        lo = mid + 1;
+    }
+
+    return(0);
+}
+
+int dxt_index_query(struct dxt_index *index, struct dxt_query *query,
+    struct dxt_query_segment **segs, int64_t *count)
+{
+    struct dxt_index_trace key;
+    struct dxt_index_trace *trace;
+    int64_t len = 0;
+    int64_t lo, hi, mid;
+    int64_t i;
+    int ret;
+
+    *segs = NULL;
+    *count = 0;
+
+    /* find the first trace that can match the module, record and ranks */
+    memset(&key, 0, sizeof(key));
+    key.mod_id = query->mod_id;
+    key.id = query->rec_id;
+    key.rank = query->rec_id ? query->rank_min : INT64_MIN;
+    key.op = 0;
+    lo = 0;
+    hi = index->ntraces;
+    while(lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if(dxt_index_trace_cmp(&index->traces[mid], &key) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for(i = lo; i < index->ntraces; i++)
+    {
+        trace = &index->traces[i];
+        if(trace->mod_id != query->mod_id)
+            break;
+        if(query->rec_id)
+        {
+            if(trace->id != query->rec_id || trace->rank > query->rank_max)
+                break;
+        }
+        if(trace->rank < query->rank_min || trace->rank > query->rank_max ||
+            !(trace->op & query->ops))
+            continue;
+
+        ret = dxt_index_query_tree(index, trace, query, 0, trace->nsegs,
+            segs, count, &len);
+        if(ret < 0)
+        {
+            free(*segs);
+            *segs = NULL;
+            *count = 0;
+            return(-1);
+        }
+    }
+
+    return(0);
+}
+
+void dxt_index_close(struct dxt_index *index)
+{
+    if(!index)
+        return;
+
+    if(index->map)
+        munmap(index->map, index->map_len);
+    else
+    {
+        free(index->traces);
+        free(index->segs);
+        free(index->max_end);
+        free(index->seg_nums);
+    }
+    free(index);
+
+    return;
+}
+
 /*
  * Local variables:
  *  c-indent-level: 4
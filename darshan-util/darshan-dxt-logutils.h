@@ -16,4 +16,95 @@ void dxt_log_print_posix_file(void *file_rec, char *file_name,
 void dxt_log_print_mpiio_file(void *file_rec,
         char *file_name, char *mnt_pt, char *fs_type);
 
+/* the segments of all of a DXT module's records, decoded into one array
+ * per field; each array is allocated separately, so that callers can take
+ * ownership of them individually (freeing them with darshan_free())
+ */
+struct dxt_segment_arrays
+{
+    int64_t nrecs;
+    darshan_record_id *rec_ids;  /* record id of each record */
+    int64_t count;
+    int64_t *rec_index;          /* record (index into rec_ids) of each segment */
+    int64_t *rank;
+    int64_t *offset;
+    int64_t *length;
+    double *start_time;
+    double *end_time;
+    int8_t *op;                  /* DXT_QUERY_WRITE or DXT_QUERY_READ */
+};
+
+int dxt_log_get_segment_arrays(darshan_fd fd, darshan_module_id mod_id,
+        struct dxt_segment_arrays *arrays);
+void dxt_free_segment_arrays(struct dxt_segment_arrays *arrays);
+
+/* DXT trace queries
+ *
+ * dxt_index_open() indexes the DXT segments of a log by module, record,
+ * rank, operation and time.  If cache is nonzero, the index is also saved
+ * next to the log (as <logname>.dxtidx) and reused by later opens as long
+ * as the log's size and modification time have not changed.
+ */
+#define DXT_QUERY_WRITE (1 << 0)
+#define DXT_QUERY_READ  (1 << 1)
+
+struct dxt_index;
+
+struct dxt_query
+{
+    int mod_id;                 /* DXT_POSIX_MOD or DXT_MPIIO_MOD */
+    darshan_record_id rec_id;   /* record to match, or 0 for all records */
+    int64_t rank_min;           /* inclusive range of ranks to match */
+    int64_t rank_max;
+    double start_time;          /* match segments overlapping this */
+    double end_time;            /* (inclusive) time window */
+    int ops;                    /* DXT_QUERY_WRITE and/or DXT_QUERY_READ */
+};
+
+struct dxt_query_segment
+{
+    darshan_record_id rec_id;
+    int64_t rank;
+    int op;                     /* DXT_QUERY_WRITE or DXT_QUERY_READ */
+    int segment;                /* segment number within the record's op */
+    segment_info info;
+};
+
+int dxt_index_open(const char *logname, int cache, struct dxt_index **index);
+/* matching segments are returned ordered by record, rank and operation,
+ * then start time; the caller frees *segs
+ */
+int dxt_index_query(struct dxt_index *index, struct dxt_query *query,
+        struct dxt_query_segment **segs, int64_t *count);
+void dxt_index_close(struct dxt_index *index);
+
+/* DXT conflict analysis
+ *
+ * dxt_conflicts_analyze() reads the DXT POSIX and MPI-IO records of a log
+ * (which must not have been read yet) and reports, for each traced file,
+ * how the byte ranges accessed by different ranks overlap.  Segments
+ * without a valid offset are ignored.
+ */
+struct dxt_conflict_file
+{
+    darshan_record_id rec_id;
+    int mod_id;
+    int64_t write_count;
+    int64_t read_count;
+    int64_t write_bytes;         /* bytes written, counting rewrites */
+    int64_t unique_write_bytes;  /* bytes covered by at least one write */
+    int64_t overlap_write_bytes; /* bytes written by more than one rank */
+    int64_t max_write_offset;    /* end of the furthest write */
+    double coverage;             /* unique_write_bytes / max_write_offset */
+    int64_t overlapping_writes;  /* writes overlapping another rank's write */
+    int64_t raw_reads;           /* reads overlapping another rank's write
+                                  * that started before the read ended
+                                  */
+    int64_t raw_races;           /* such reads concurrent with the write */
+};
+
+/* the caller frees *files */
+int dxt_conflicts_analyze(darshan_fd fd, struct dxt_conflict_file **files,
+        int *count);
+
 #endif
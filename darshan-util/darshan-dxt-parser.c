@@ -8,6 +8,7 @@
 #endif
 
 #include <stdio.h>
+#include <limits.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -23,10 +24,54 @@
 
 #include "darshan-logutils.h"
 
+#define OPTION_TIME_ORDER (1 << 0)  /* print a single time-ordered trace */
+#define OPTION_BINARY     (1 << 1)  /* write the time-ordered trace in binary */
 #define OPTION_SHOW_INCOMPLETE  (1 << 7)  /* show what we have, even if log is incomplete */
 
+/* number of trace events buffered in memory before they are sorted and
+ * spilled to a temporary file when building a time-ordered trace
+ */
+#define DXT_TRACE_RUN_EVENTS (1 << 20)
+
+#define DXT_TRACE_MAGIC "DXTTRACE"
+#define DXT_TRACE_VERSION 1
+#define DXT_TRACE_WRITE 0
+#define DXT_TRACE_READ  1
+
+/* a single DXT segment in a time-ordered trace; binary traces consist of
+ * a struct dxt_trace_header followed by these events in native byte order
+ */
+struct dxt_trace_event
+{
+    double start_time;
+    double end_time;
+    int64_t offset;
+    int64_t length;
+    darshan_record_id id;
+    int64_t rank;
+    int32_t segment;
+    uint16_t mod_id;
+    uint16_t op;
+};
+
+struct dxt_trace_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t event_size;
+};
+
+/* a sorted run of trace events spilled to a temporary file */
+struct dxt_trace_run
+{
+    FILE *fp;
+    struct dxt_trace_event cur;
+};
+
 static int usage (char *exename);
 static int parse_args (int argc, char **argv, char **filename);
+static int dxt_print_time_ordered(darshan_fd fd, int mask,
+    struct darshan_name_record_ref *name_hash);
 
 int main(int argc, char **argv)
 {
@@ -92,6 +137,13 @@ int main(int argc, char **argv)
     /* print any warnings related to this log file version */
     darshan_log_print_version_warnings(fd->version);
 
+    /* binary traces are written without the text preamble */
+    if (mask & OPTION_BINARY)
+    {
+        ret = dxt_print_time_ordered(fd, mask, name_hash);
+        goto cleanup;
+    }
+
     if (fd->comp_type == DARSHAN_ZLIB_COMP)
         comp_str = "ZLIB";
     else if (fd->comp_type == DARSHAN_BZIP2_COMP)
@@ -177,6 +229,12 @@ int main(int argc, char **argv)
         goto cleanup;
     }
 
+    if (mask & OPTION_TIME_ORDER)
+    {
+        ret = dxt_print_time_ordered(fd, mask, name_hash);
+        goto cleanup;
+    }
+
     for (i = 0; i < DARSHAN_MAX_MODS; i++)
     {
         struct darshan_base_record *base_rec;
@@ -357,6 +415,280 @@ cleanup:
     return(ret);
 }
 
+static int dxt_event_cmp(const void *a, const void *b)
+{
+    const struct dxt_trace_event *ev_a = a;
+    const struct dxt_trace_event *ev_b = b;
+
+    if(ev_a->start_time != ev_b->start_time)
+        return((ev_a->start_time < ev_b->start_time) ? -1 : 1);
+    if(ev_a->end_time != ev_b->end_time)
+        return((ev_a->end_time < ev_b->end_time) ? -1 : 1);
+    if(ev_a->rank != ev_b->rank)
+        return((ev_a->rank < ev_b->rank) ? -1 : 1);
+    if(ev_a->id != ev_b->id)
+        return((ev_a->id < ev_b->id) ? -1 : 1);
+    if(ev_a->mod_id != ev_b->mod_id)
+        return((ev_a->mod_id < ev_b->mod_id) ? -1 : 1);
+    if(ev_a->op != ev_b->op)
+        return((ev_a->op < ev_b->op) ? -1 : 1);
+    return((ev_a->segment > ev_b->segment) - (ev_a->segment < ev_b->segment));
+}
+
+static void dxt_heap_sift_down(struct dxt_trace_run **heap, int nheap, int i)
+{
+    struct dxt_trace_run *tmp;
+    int child;
+
+    while((child = 2 * i + 1) < nheap)
+    {
+        if(child + 1 < nheap &&
+            dxt_event_cmp(&heap[child + 1]->cur, &heap[child]->cur) < 0)
+            child++;
+        if(dxt_event_cmp(&heap[child]->cur, &heap[i]->cur) >= 0)
+            break;
+        tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+        i = child;
+    }
+
+    return;
+}
+
+/* sort buffered events and write them to an (already unlinked) temporary file */
+static int dxt_spill_run(struct dxt_trace_event *events, int count,
+    struct dxt_trace_run **runs, int *nruns)
+{
+    struct dxt_trace_run *tmp_runs;
+    char path[PATH_MAX];
+    char *tmpdir;
+    FILE *fp;
+    int fd;
+
+    tmp_runs = realloc(*runs, (*nruns + 1) * sizeof(**runs));
+    if(!tmp_runs)
+        return(-1);
+    *runs = tmp_runs;
+
+    tmpdir = getenv("TMPDIR");
+    if(!tmpdir)
+        tmpdir = "/tmp";
+    snprintf(path, PATH_MAX, "%s/darshan-dxt-parser-XXXXXX", tmpdir);
+    fd = mkstemp(path);
+    if(fd < 0)
+    {
+        fprintf(stderr, "Error: unable to create temporary file in %s.\n", tmpdir);
+        return(-1);
+    }
+    unlink(path);
+    fp = fdopen(fd, "w+");
+    if(!fp)
+    {
+        close(fd);
+        return(-1);
+    }
+
+    qsort(events, count, sizeof(*events), dxt_event_cmp);
+    if(fwrite(events, sizeof(*events), count, fp) != count ||
+        fflush(fp) != 0 || fseek(fp, 0, SEEK_SET) != 0)
+    {
+        fprintf(stderr, "Error: unable to write temporary file in %s.\n", tmpdir);
+        fclose(fp);
+        return(-1);
+    }
+
+    (*runs)[*nruns].fp = fp;
+    (*nruns)++;
+    return(0);
+}
+
+static void dxt_print_event(struct dxt_trace_event *ev, int mask,
+    struct darshan_name_record_ref *name_hash)
+{
+    struct darshan_name_record_ref *ref;
+    char *rec_name = "UNKNOWN";
+
+    if(mask & OPTION_BINARY)
+    {
+        fwrite(ev, sizeof(*ev), 1, stdout);
+        return;
+    }
+
+    HASH_FIND(hlink, name_hash, &(ev->id), sizeof(darshan_record_id), ref);
+    if(ref)
+        rec_name = ref->name_record->name;
+
+    printf("%8s%8" PRId64 "%7s%9d%16" PRId64 "%16" PRId64 "%12.4f%12.4f%22" PRIu64 "  %s\n",
+        (ev->mod_id == DXT_POSIX_MOD) ? "X_POSIX" : "X_MPIIO", ev->rank,
+        (ev->op == DXT_TRACE_WRITE) ? "write" : "read", ev->segment,
+        ev->offset, ev->length, ev->start_time, ev->end_time, ev->id, rec_name);
+    return;
+}
+
+/* print the segments of every DXT record as a single trace ordered by
+ * start time.  Segments are buffered, sorted and spilled to temporary
+ * files in bounded-size runs, which are then merged through a heap.
+ */
+static int dxt_print_time_ordered(darshan_fd fd, int mask,
+    struct darshan_name_record_ref *name_hash)
+{
+    int mods[2] = {DXT_POSIX_MOD, DXT_MPIIO_MOD};
+    struct dxt_trace_header hdr;
+    struct dxt_trace_event *events;
+    struct dxt_trace_run *runs = NULL;
+    struct dxt_trace_run **heap = NULL;
+    struct dxt_file_record *rec;
+    segment_info *io_trace;
+    char *mod_buf = NULL;
+    int count = 0;
+    int nruns = 0;
+    int nheap = 0;
+    int ret = 0;
+    int i, m;
+    int64_t j;
+
+    events = malloc(DXT_TRACE_RUN_EVENTS * sizeof(*events));
+    if(!events)
+        return(-1);
+
+    for(m = 0; m < 2 && ret == 0; m++)
+    {
+        if(fd->mod_map[mods[m]].len == 0 || !mod_logutils[mods[m]])
+            continue;
+
+        if(DARSHAN_MOD_FLAG_ISSET(fd->partial_flag, mods[m]))
+        {
+            if(!(mask & OPTION_SHOW_INCOMPLETE))
+            {
+                fprintf(stderr, "\n# *ERROR*: "
+                       "The %s module contains incomplete data!\n"
+                       "# You can display the (incomplete) data that is\n"
+                       "# present in this log using the --show-incomplete\n"
+                       "# option to darshan-dxt-parser.\n",
+                       darshan_module_names[mods[m]]);
+                ret = -1;
+                break;
+            }
+            fprintf(stderr, "# *WARNING*: The %s module contains incomplete data!\n",
+                darshan_module_names[mods[m]]);
+        }
+
+        while((ret = mod_logutils[mods[m]]->log_get_record(fd, (void **)&mod_buf)) > 0)
+        {
+            rec = (struct dxt_file_record *)mod_buf;
+            io_trace = (segment_info *)(mod_buf + sizeof(struct dxt_file_record));
+
+            for(j = 0; j < rec->write_count + rec->read_count; j++)
+            {
+                if(count == DXT_TRACE_RUN_EVENTS)
+                {
+                    ret = dxt_spill_run(events, count, &runs, &nruns);
+                    if(ret < 0)
+                        break;
+                    count = 0;
+                }
+                events[count].start_time = io_trace[j].start_time;
+                events[count].end_time = io_trace[j].end_time;
+                events[count].offset = io_trace[j].offset;
+                events[count].length = io_trace[j].length;
+                events[count].id = rec->base_rec.id;
+                events[count].rank = rec->base_rec.rank;
+                events[count].mod_id = mods[m];
+                if(j < rec->write_count)
+                {
+                    events[count].op = DXT_TRACE_WRITE;
+                    events[count].segment = j;
+                }
+                else
+                {
+                    events[count].op = DXT_TRACE_READ;
+                    events[count].segment = j - rec->write_count;
+                }
+                count++;
+            }
+
+            free(mod_buf);
+            mod_buf = NULL;
+            if(ret < 0)
+                break;
+        }
+        if(ret < 0)
+        {
+            fprintf(stderr, "Error: failed to parse %s module record.\n",
+                darshan_module_names[mods[m]]);
+        }
+    }
+    if(ret < 0)
+        goto cleanup;
+
+    if(mask & OPTION_BINARY)
+    {
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, DXT_TRACE_MAGIC, sizeof(hdr.magic));
+        hdr.version = DXT_TRACE_VERSION;
+        hdr.event_size = sizeof(struct dxt_trace_event);
+        fwrite(&hdr, sizeof(hdr), 1, stdout);
+    }
+    else
+    {
+        printf("\n# ***************************************************\n");
+        printf("# DXT time-ordered trace\n");
+        printf("# ***************************************************\n");
+        printf("# Module    Rank  Wt/Rd  Segment          Offset       Length    Start(s)      End(s)               File id  File name\n");
+    }
+
+    if(nruns == 0)
+    {
+        /* everything fit in memory */
+        qsort(events, count, sizeof(*events), dxt_event_cmp);
+        for(i = 0; i < count; i++)
+            dxt_print_event(&events[i], mask, name_hash);
+        goto cleanup;
+    }
+
+    if(count > 0)
+    {
+        ret = dxt_spill_run(events, count, &runs, &nruns);
+        if(ret < 0)
+            goto cleanup;
+    }
+    free(events);
+    events = NULL;
+
+    heap = malloc(nruns * sizeof(*heap));
+    if(!heap)
+    {
+        ret = -1;
+        goto cleanup;
+    }
+    for(i = 0; i < nruns; i++)
+    {
+        if(fread(&runs[i].cur, sizeof(runs[i].cur), 1, runs[i].fp) == 1)
+            heap[nheap++] = &runs[i];
+    }
+    for(i = nheap / 2 - 1; i >= 0; i--)
+        dxt_heap_sift_down(heap, nheap, i);
+
+    while(nheap > 0)
+    {
+        dxt_print_event(&heap[0]->cur, mask, name_hash);
+        if(fread(&heap[0]->cur, sizeof(heap[0]->cur), 1, heap[0]->fp) != 1)
+            heap[0] = heap[--nheap];
+        dxt_heap_sift_down(heap, nheap, 0);
+    }
+
+cleanup:
+    for(i = 0; i < nruns; i++)
+        fclose(runs[i].fp);
+    free(runs);
+    free(heap);
+    free(events);
+    free(mod_buf);
+
+    return(ret < 0 ? -1 : 0);
+}
+
 static int parse_args (int argc, char **argv, char **filename)
 {
     int index;
@@ -364,6 +696,8 @@ static int parse_args (int argc, char **argv, char **filename)
     static struct option long_opts[] =
     {
         {"show-incomplete", 0, NULL, OPTION_SHOW_INCOMPLETE},
+        {"time-order", 0, NULL, OPTION_TIME_ORDER},
+        {"binary", 0, NULL, OPTION_BINARY},
         {"help",  0, NULL, 0},
         {0, 0, 0, 0}
     };
@@ -379,8 +713,12 @@ static int parse_args (int argc, char **argv, char **filename)
         switch(c)
         {
             case OPTION_SHOW_INCOMPLETE:
+            case OPTION_TIME_ORDER:
                 mask |= c;
                 break;
+            case OPTION_BINARY:
+                mask |= (c | OPTION_TIME_ORDER);
+                break;
             case 0:
             case '?':
             default:
@@ -405,6 +743,9 @@ static int usage (char *exename)
 {
     fprintf(stderr, "Usage: %s [options] <filename>\n", exename);
     fprintf(stderr, "    --show-incomplete : display results even if log is incomplete\n");
+    fprintf(stderr, "    --time-order : print all segments of all records as a single\n"
+                    "                   trace ordered by start time\n");
+    fprintf(stderr, "    --binary : write the time-ordered trace to stdout in binary form\n");
 
     exit(1);
 }
@@ -22,6 +22,10 @@
 
 #include "darshan-logutils.h"
 
+/* size (in bytes) of heatmap records for different versions of the log format */
+#define DARSHAN_HEATMAP_RECORD_SIZE_1 48
+#define DARSHAN_HEATMAP_RECORD_SIZE_2 56
+
 /* prototypes for each of the heatmap module's logutil functions */
 static int darshan_log_get_heatmap_record(darshan_fd fd, void** heatmap_buf_p);
 static int darshan_log_put_heatmap_record(darshan_fd fd, void* heatmap_buf);
@@ -58,9 +62,13 @@ static int darshan_log_get_heatmap_record(darshan_fd fd, void** heatmap_buf_p)
     struct darshan_heatmap_record *rec = *((struct darshan_heatmap_record **)heatmap_buf_p);
     struct darshan_heatmap_record static_rec = {0};
     void* trailing;
+    uint8_t *qbins;
     int ret;
     int i;
+    int rec_len;
     int total_rec_size;
+    int64_t nvals;
+    int64_t trailing_size;
 
     if(fd->mod_map[DARSHAN_HEATMAP_MOD].len == 0)
         return(0);
@@ -76,12 +84,17 @@ static int darshan_log_get_heatmap_record(darshan_fd fd, void** heatmap_buf_p)
     if(*heatmap_buf_p == NULL)
         rec = &static_rec;
 
-    /* read base record; it is a fixed size */
-    ret = darshan_log_get_mod(fd, DARSHAN_HEATMAP_MOD, rec,
-        sizeof(struct darshan_heatmap_record));
+    /* read base record; it is a fixed size for a given format version */
+    if(fd->mod_ver[DARSHAN_HEATMAP_MOD] == 1)
+        rec_len = DARSHAN_HEATMAP_RECORD_SIZE_1;
+    else if(fd->mod_ver[DARSHAN_HEATMAP_MOD] == 2)
+        rec_len = DARSHAN_HEATMAP_RECORD_SIZE_2;
+    else
+        rec_len = sizeof(struct darshan_heatmap_record);
+    ret = darshan_log_get_mod(fd, DARSHAN_HEATMAP_MOD, rec, rec_len);
     if(ret < 0)
         return(-1);
-    else if(ret < sizeof(struct darshan_heatmap_record))
+    else if(ret < rec_len)
         return(0);
 
     /* do byte swapping if necessary */
@@ -91,12 +104,45 @@ static int darshan_log_get_heatmap_record(darshan_fd fd, void** heatmap_buf_p)
         DARSHAN_BSWAP64(&rec->base_rec.rank);
         DARSHAN_BSWAP64(&rec->bin_width_seconds);
         DARSHAN_BSWAP64(&rec->nbins);
+        if(fd->mod_ver[DARSHAN_HEATMAP_MOD] > 1)
+            DARSHAN_BSWAP64(&rec->start_time_seconds);
+        if(fd->mod_ver[DARSHAN_HEATMAP_MOD] > 2)
+        {
+            DARSHAN_BSWAP64(&rec->nranks);
+            DARSHAN_BSWAP64(&rec->write_quantum);
+            DARSHAN_BSWAP64(&rec->read_quantum);
+        }
+    }
+
+    /* version 1 heatmaps always cover the entire execution */
+    if(fd->mod_ver[DARSHAN_HEATMAP_MOD] == 1)
+        rec->start_time_seconds = 0;
+    /* versions prior to 3 have no rank matrices */
+    if(fd->mod_ver[DARSHAN_HEATMAP_MOD] < 3)
+    {
+        rec->nranks = 0;
+        rec->write_quantum = 0;
+        rec->read_quantum = 0;
+    }
+
+    /* rank matrices are stored with one byte per bin, but are expanded to
+     * int64_t bins in memory just like other heatmaps
+     */
+    if(rec->nranks > 0)
+    {
+        nvals = rec->nranks*rec->nbins;
+        trailing_size = nvals*2;
+    }
+    else
+    {
+        nvals = rec->nbins;
+        trailing_size = nvals*2*sizeof(int64_t);
     }
 
     /* if buffer was provided by caller, then it is implied that it is
      * DEF_MOD_BUF_SIZE bytes in size.  Make sure it is big enough, or if we
      * are allocating the buffer malloc enough size */
-    total_rec_size = sizeof(struct darshan_heatmap_record) + rec->nbins*2*sizeof(int64_t);
+    total_rec_size = sizeof(struct darshan_heatmap_record) + nvals*2*sizeof(int64_t);
     if(*heatmap_buf_p)
     {
         if(total_rec_size > DEF_MOD_BUF_SIZE)
@@ -117,14 +163,25 @@ static int darshan_log_get_heatmap_record(darshan_fd fd, void** heatmap_buf_p)
     /* set pointer for trailing data */
     trailing = (void*)((intptr_t)(*heatmap_buf_p) + sizeof(*rec));
     ret = darshan_log_get_mod(fd, DARSHAN_HEATMAP_MOD, trailing,
-        rec->nbins*2*sizeof(int64_t));
-    if(ret < rec->nbins*2*sizeof(int64_t))
+        trailing_size);
+    if(ret < trailing_size)
         return(-1);
 
     /* set pointers and byteswap trailing data */
     rec->write_bins = (int64_t*)((uintptr_t)rec + sizeof(*rec));
-    rec->read_bins = (int64_t*)((uintptr_t)rec + sizeof(*rec) + rec->nbins*sizeof(uint64_t));
-    if(fd->swap_flag)
+    rec->read_bins = (int64_t*)((uintptr_t)rec + sizeof(*rec) + nvals*sizeof(uint64_t));
+    if(rec->nranks > 0)
+    {
+        /* expand quantized bins in place, working backwards so that bytes
+         * are not overwritten before they have been expanded
+         */
+        qbins = (uint8_t*)trailing;
+        for(i=nvals-1; i>=0; i--)
+            rec->read_bins[i] = qbins[nvals+i] * rec->read_quantum;
+        for(i=nvals-1; i>=0; i--)
+            rec->write_bins[i] = qbins[i] * rec->write_quantum;
+    }
+    else if(fd->swap_flag)
     {
         for(i=0; i<rec->nbins; i++)
         {
@@ -142,8 +199,38 @@ static int darshan_log_get_heatmap_record(darshan_fd fd, void** heatmap_buf_p)
 static int darshan_log_put_heatmap_record(darshan_fd fd, void* heatmap_buf)
 {
     struct darshan_heatmap_record *rec = (struct darshan_heatmap_record *)heatmap_buf;
+    struct darshan_heatmap_record *qrec;
+    uint8_t *qbins;
+    int64_t nvals;
+    int64_t i;
     int ret;
 
+    if(rec->nranks > 0)
+    {
+        /* re-quantize rank matrices to one byte per bin */
+        nvals = rec->nranks*rec->nbins;
+        qrec = malloc(sizeof(*rec) + nvals*2);
+        if(!qrec)
+            return(-1);
+        memcpy(qrec, rec, sizeof(*rec));
+        qbins = (uint8_t*)((uintptr_t)qrec + sizeof(*rec));
+        for(i=0; i<nvals; i++)
+        {
+            qbins[i] = rec->write_quantum ?
+                rec->write_bins[i] / rec->write_quantum : 0;
+            qbins[nvals+i] = rec->read_quantum ?
+                rec->read_bins[i] / rec->read_quantum : 0;
+        }
+
+        ret = darshan_log_put_mod(fd, DARSHAN_HEATMAP_MOD, qrec,
+            sizeof(*rec) + nvals*2, DARSHAN_HEATMAP_VER);
+        free(qrec);
+        if(ret < 0)
+            return(-1);
+
+        return(0);
+    }
+
     /* append heatmap record to darshan log file */
     ret = darshan_log_put_mod(fd, DARSHAN_HEATMAP_MOD, rec,
         sizeof(struct darshan_heatmap_record) + rec->nbins*2*sizeof(int64_t), DARSHAN_HEATMAP_VER);
@@ -160,29 +247,62 @@ static void darshan_log_print_heatmap_record(void *file_rec, char *file_name,
     struct darshan_heatmap_record *heatmap_rec =
         (struct darshan_heatmap_record *)file_rec;
     char counter_name_buffer[256];
+    int64_t rank;
+    int64_t *read_bins, *write_bins;
+    int64_t nrows;
+    int64_t r;
     int i;
 
-    DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_HEATMAP_MOD],
-        heatmap_rec->base_rec.rank, heatmap_rec->base_rec.id,
-        "HEATMAP_F_BIN_WIDTH_SECONDS",
-        heatmap_rec->bin_width_seconds, file_name, mnt_pt, fs_type);
-
-    for(i=0; i<heatmap_rec->nbins; i++)
+    /* rank matrices are printed as a separate set of counters for each
+     * rank they cover
+     */
+    nrows = heatmap_rec->nranks > 0 ? heatmap_rec->nranks : 1;
+    for(r=0; r<nrows; r++)
     {
-        snprintf(counter_name_buffer, 256, "HEATMAP_READ_BIN_%d", i);
-        DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_HEATMAP_MOD],
-            heatmap_rec->base_rec.rank, heatmap_rec->base_rec.id,
-            counter_name_buffer,
-            heatmap_rec->read_bins[i], file_name, mnt_pt, fs_type);
-    }
+        rank = heatmap_rec->base_rec.rank + r;
+        read_bins = &heatmap_rec->read_bins[r*heatmap_rec->nbins];
+        write_bins = &heatmap_rec->write_bins[r*heatmap_rec->nbins];
 
-    for(i=0; i<heatmap_rec->nbins; i++)
-    {
-        snprintf(counter_name_buffer, 256, "HEATMAP_WRITE_BIN_%d", i);
-        DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_HEATMAP_MOD],
-            heatmap_rec->base_rec.rank, heatmap_rec->base_rec.id,
-            counter_name_buffer,
-            heatmap_rec->write_bins[i], file_name, mnt_pt, fs_type);
+        DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_HEATMAP_MOD],
+            rank, heatmap_rec->base_rec.id,
+            "HEATMAP_F_BIN_WIDTH_SECONDS",
+            heatmap_rec->bin_width_seconds, file_name, mnt_pt, fs_type);
+
+        DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_HEATMAP_MOD],
+            rank, heatmap_rec->base_rec.id,
+            "HEATMAP_F_START_TIME_SECONDS",
+            heatmap_rec->start_time_seconds, file_name, mnt_pt, fs_type);
+
+        if(heatmap_rec->nranks > 0)
+        {
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_HEATMAP_MOD],
+                rank, heatmap_rec->base_rec.id,
+                "HEATMAP_READ_QUANTUM",
+                heatmap_rec->read_quantum, file_name, mnt_pt, fs_type);
+
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_HEATMAP_MOD],
+                rank, heatmap_rec->base_rec.id,
+                "HEATMAP_WRITE_QUANTUM",
+                heatmap_rec->write_quantum, file_name, mnt_pt, fs_type);
+        }
+
+        for(i=0; i<heatmap_rec->nbins; i++)
+        {
+            snprintf(counter_name_buffer, 256, "HEATMAP_READ_BIN_%d", i);
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_HEATMAP_MOD],
+                rank, heatmap_rec->base_rec.id,
+                counter_name_buffer,
+                read_bins[i], file_name, mnt_pt, fs_type);
+        }
+
+        for(i=0; i<heatmap_rec->nbins; i++)
+        {
+            snprintf(counter_name_buffer, 256, "HEATMAP_WRITE_BIN_%d", i);
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_HEATMAP_MOD],
+                rank, heatmap_rec->base_rec.id,
+                counter_name_buffer,
+                write_bins[i], file_name, mnt_pt, fs_type);
+        }
     }
 
     return;
@@ -193,6 +313,8 @@ static void darshan_log_print_heatmap_description(int ver)
 {
     printf("\n# description of heatmap counters:\n");
     printf("#   HEATMAP_F_BIN_WIDTH_SECONDS: time duration of each heatmap bin\n");
+    printf("#   HEATMAP_F_START_TIME_SECONDS: start time of the first heatmap bin (nonzero only for heatmaps of recent activity)\n");
+    printf("#   HEATMAP_{READ|WRITE}_QUANTUM: granularity (in bytes) of bins in heatmaps gathered into a rank matrix\n");
     printf("#   HEATMAP_{READ|WRITE}_BIN_{*}: number of bytes read or written within specified heatmap bin\n");
 
     return;
@@ -9,23 +9,34 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include "darshan-logutils.h"
-#include "uthash-1.9.2/src/uthash.h"
+#include "darshan-logutils-idhash.h"
 
 #define max(a,b) (((a) > (b)) ? (a) : (b))
 
-/* struct to track per-file metrics */
-typedef struct file_hash_entry_s
+/* smallest number of records handed to each thread by a parallel inject;
+ * smaller batches are not worth the cost of a private accumulator
+ */
+#define DARSHAN_ACCUMULATOR_MIN_THREAD_RECORDS 4096
+
+/* which parts of the accumulator state an inject updates */
+#define ACCUMULATOR_AGG_RECORD (1 << 0) /* the aggregate record */
+#define ACCUMULATOR_TIMES      (1 << 1) /* per-rank and shared I/O time sums */
+#define ACCUMULATOR_FILES      (1 << 2) /* per-file metrics and total bytes */
+
+/* per-file metrics, one entry of the accumulator's dense files array */
+typedef struct file_metrics_s
 {
-    UT_hash_handle hlink;
     darshan_record_id rec_id;
     int64_t r_bytes;     /* bytes read */
     int64_t w_bytes;     /* bytes written */
     int64_t max_offset;  /* maximum offset accessed */
     int64_t nprocs;      /* nprocs that accessed it */
-} file_hash_entry_t;
+} file_metrics_t;
 
 /* accumulator state */
 struct darshan_accumulator_st {
@@ -33,7 +44,14 @@ struct darshan_accumulator_st {
     int64_t job_nprocs;
     void* agg_record;
     int num_records;
-    file_hash_entry_t *file_hash_table;
+    int nthreads;
+    /* per-file metrics, indexed by record id; entries are kept in one
+     * array, in the order files were first seen
+     */
+    struct darshan_idhash file_index;
+    file_metrics_t *files;
+    int64_t num_files;
+    int64_t files_size;
 
     /* amount of time consumed by slowest rank in shared files, across all
      * shared files observed
@@ -47,6 +65,9 @@ struct darshan_accumulator_st {
     double *rank_cumul_md_only_time;
 };
 
+static int accumulator_merge_metrics(darshan_accumulator dst,
+                                     darshan_accumulator src);
+
 int darshan_accumulator_create(darshan_module_id id,
                                int64_t job_nprocs,
                                darshan_accumulator*   new_accumulator)
@@ -69,6 +90,8 @@ int darshan_accumulator_create(darshan_module_id id,
 
     (*new_accumulator)->module_id = id;
     (*new_accumulator)->job_nprocs = job_nprocs;
+    (*new_accumulator)->nthreads = 1;
+    darshan_idhash_init(&(*new_accumulator)->file_index);
     (*new_accumulator)->agg_record = calloc(1, DEF_MOD_BUF_SIZE);
     if(!(*new_accumulator)->agg_record) {
         free(*new_accumulator);
@@ -89,9 +112,55 @@ int darshan_accumulator_create(darshan_module_id id,
     return(0);
 }
 
-int darshan_accumulator_inject(darshan_accumulator acc,
-                               void*               record_array,
-                               int                 record_count)
+/* returns the per-file entry for rec_id, adding a zeroed one if this
+ * accumulator hasn't seen the file yet; NULL on allocation failure
+ */
+static file_metrics_t *accumulator_get_file(darshan_accumulator acc,
+                                            darshan_record_id   rec_id)
+{
+    file_metrics_t *tmp_files;
+    int64_t ndx;
+
+    /* make sure there is room for a new entry before indexing it */
+    if(acc->num_files == acc->files_size)
+    {
+        tmp_files = realloc(acc->files,
+            (acc->files_size ? acc->files_size * 2 : 64) * sizeof(*tmp_files));
+        if(!tmp_files)
+            return(NULL);
+        acc->files = tmp_files;
+        acc->files_size = acc->files_size ? acc->files_size * 2 : 64;
+    }
+
+    ndx = darshan_idhash_find_or_add(&acc->file_index, rec_id, acc->num_files);
+    if(ndx < 0)
+        return(NULL);
+    if(ndx < acc->num_files)
+        return(&acc->files[ndx]);
+
+    /* first time we've seen this file in this accumulator */
+    memset(&acc->files[ndx], 0, sizeof(*acc->files));
+    acc->files[ndx].rec_id = rec_id;
+    acc->num_files++;
+
+    return(&acc->files[ndx]);
+}
+
+int darshan_accumulator_set_threads(darshan_accumulator acc,
+                                    int                 nthreads)
+{
+    if(nthreads < 1)
+        return(-1);
+
+    acc->nthreads = nthreads;
+
+    return(0);
+}
+
+static int accumulator_inject_serial(darshan_accumulator acc,
+                                     void*               record_array,
+                                     int                 record_count,
+                                     int                 parts)
 {
     int i;
     void* new_record = record_array;
@@ -105,22 +174,20 @@ int darshan_accumulator_inject(darshan_accumulator acc,
     double md_only_time;
     double rw_only_time;
     int ret;
-    file_hash_entry_t *hfile = NULL;
+    file_metrics_t *file = NULL;
 
-    if(!mod_logutils[acc->module_id]->log_agg_records ||
-       !mod_logutils[acc->module_id]->log_sizeof_record ||
-       !mod_logutils[acc->module_id]->log_record_metrics) {
-        /* this module doesn't support this operation */
-        return(-1);
-    }
-
-    for(i=0; i<record_count; i++) {
+    for(i=0; i<record_count; i++, new_record +=
+        mod_logutils[acc->module_id]->log_sizeof_record(new_record)) {
         /* accumulate aggregate record */
-        if(acc->num_records == 0)
-            mod_logutils[acc->module_id]->log_agg_records(new_record, acc->agg_record, 1);
-        else
-            mod_logutils[acc->module_id]->log_agg_records(new_record, acc->agg_record, 0);
-        acc->num_records++;
+        if(parts & ACCUMULATOR_AGG_RECORD) {
+            if(acc->num_records == 0)
+                mod_logutils[acc->module_id]->log_agg_records(new_record, acc->agg_record, 1);
+            else
+                mod_logutils[acc->module_id]->log_agg_records(new_record, acc->agg_record, 0);
+            acc->num_records++;
+        }
+        if(!(parts & (ACCUMULATOR_TIMES | ACCUMULATOR_FILES)))
+            continue;
 
         /* retrieve generic metrics from record */
         ret = mod_logutils[acc->module_id]->log_record_metrics( new_record,
@@ -131,56 +198,266 @@ int darshan_accumulator_inject(darshan_accumulator acc,
 
         /* accumulate performance metrics */
 
-        /* total bytes moved */
-        acc->total_bytes += (r_bytes + w_bytes);
-
-        if(rank < 0) {
-            /* sum the slowest I/O time across all shared files */
-            acc->shared_io_total_time_by_slowest += io_total_time;
-        }
-        else {
-            /* sum per-rank I/O times (including meta and rw breakdown) for
-             * each rank separately
-             */
-            assert(rank < acc->job_nprocs);
-            acc->rank_cumul_io_total_time[rank] += io_total_time;
-            acc->rank_cumul_rw_only_time[rank] += rw_only_time;
-            acc->rank_cumul_md_only_time[rank] += md_only_time;
+        if(parts & ACCUMULATOR_TIMES) {
+            if(rank < 0) {
+                /* sum the slowest I/O time across all shared files */
+                acc->shared_io_total_time_by_slowest += io_total_time;
+            }
+            else {
+                /* sum per-rank I/O times (including meta and rw breakdown)
+                 * for each rank separately
+                 */
+                assert(rank < acc->job_nprocs);
+                acc->rank_cumul_io_total_time[rank] += io_total_time;
+                acc->rank_cumul_rw_only_time[rank] += rw_only_time;
+                acc->rank_cumul_md_only_time[rank] += md_only_time;
+            }
         }
+        if(!(parts & ACCUMULATOR_FILES))
+            continue;
 
-        /* track in hash table for per-file metrics; there may be multiple
-         * records that refer to the same file */
-        HASH_FIND(hlink, acc->file_hash_table, &rec_id, sizeof(rec_id), hfile);
-        if(!hfile) {
-            /* first time we've seen this file in this accumulator */
-            hfile = calloc(1, sizeof(*hfile));
-            if(!hfile) {
-                return(-1);
-            }
+        /* total bytes moved */
+        acc->total_bytes += (r_bytes + w_bytes);
 
-            /* add to hash table */
-            hfile->rec_id = rec_id;
-            HASH_ADD(hlink, acc->file_hash_table, rec_id, sizeof(rec_id), hfile);
-        }
+        /* track per-file metrics; there may be multiple records that
+         * refer to the same file */
+        file = accumulator_get_file(acc, rec_id);
+        if(!file)
+            return(-1);
 
-        /* we have hfile at this point (either existing or newly created);
+        /* we have the file at this point (either existing or newly created);
          * increment metrics
          */
-        hfile->r_bytes += r_bytes;
-        hfile->w_bytes += w_bytes;
+        file->r_bytes += r_bytes;
+        file->w_bytes += w_bytes;
         if(max_offset == -1)
-            hfile->max_offset = -1; /* this module doesn't support this */
+            file->max_offset = -1; /* this module doesn't support this */
         else
-            hfile->max_offset = max(hfile->max_offset, max_offset);
+            file->max_offset = max(file->max_offset, max_offset);
         if (nprocs == -1)
-            hfile->nprocs = -1; /* globally shared */
+            file->nprocs = -1; /* globally shared */
         else
-            hfile->nprocs += nprocs; /* partially shared or unique, as far as we
+            file->nprocs += nprocs; /* partially shared or unique, as far as we
                                         know so far */
+    }
+
+    return(0);
+}
+
+/* state for one thread of a parallel inject */
+struct accumulator_inject_worker
+{
+    darshan_accumulator acc;
+    void* record_array;
+    int record_count;
+    int ret;
+};
+
+static void *accumulator_inject_thread(void *arg)
+{
+    struct accumulator_inject_worker *w = arg;
+
+    w->ret = accumulator_inject_serial(w->acc, w->record_array, w->record_count,
+        ACCUMULATOR_FILES);
+
+    return(NULL);
+}
+
+/* split the records into one contiguous range per thread, accumulate the
+ * per-file metrics of each range into a private accumulator, then merge the
+ * partial metrics into acc in record order.  Aggregate records can not be
+ * merged exactly (e.g., the common access sizes or the fastest and slowest
+ * ranks of the combined records are not determined by those of each
+ * range), and partial sums of I/O times would round differently, so the
+ * calling thread folds every record into acc's aggregate record and time
+ * sums, in record order, while the other threads run.
+ */
+static int accumulator_inject_parallel(darshan_accumulator acc,
+                                       void*               record_array,
+                                       int                 record_count,
+                                       int                 nthreads)
+{
+    struct accumulator_inject_worker *workers;
+    pthread_t *threads;
+    void* rec = record_array;
+    int i, j;
+    int ret = 0;
+
+    workers = calloc(nthreads, sizeof(*workers));
+    threads = calloc(nthreads, sizeof(*threads));
+    if(!workers || !threads)
+    {
+        free(workers);
+        free(threads);
+        return(-1);
+    }
+
+    /* records may vary in size, so walk them once to find where each
+     * thread's range starts
+     */
+    for(i = 0, j = 0; i < nthreads; i++)
+    {
+        workers[i].record_count =
+            (int)(((int64_t)record_count * (i + 1)) / nthreads) -
+            (int)(((int64_t)record_count * i) / nthreads);
+        workers[i].record_array = rec;
+        for(j = 0; j < workers[i].record_count; j++)
+            rec += mod_logutils[acc->module_id]->log_sizeof_record(rec);
+
+        ret = darshan_accumulator_create(acc->module_id, acc->job_nprocs,
+            &workers[i].acc);
+        if(ret < 0)
+            goto cleanup;
+    }
 
-        /* advance to next record */
-        new_record += mod_logutils[acc->module_id]->log_sizeof_record(new_record);
+    for(i = 0; i < nthreads; i++)
+    {
+        if(pthread_create(&threads[i], NULL, accumulator_inject_thread,
+            &workers[i]) != 0)
+        {
+            /* handle this range in the calling thread instead */
+            threads[i] = pthread_self();
+            accumulator_inject_thread(&workers[i]);
+        }
+    }
+    ret = accumulator_inject_serial(acc, record_array, record_count,
+        ACCUMULATOR_AGG_RECORD | ACCUMULATOR_TIMES);
+    for(i = 0; i < nthreads; i++)
+    {
+        if(!pthread_equal(threads[i], pthread_self()))
+            pthread_join(threads[i], NULL);
     }
+    if(ret < 0)
+        goto cleanup;
+
+    for(i = 0; i < nthreads; i++)
+    {
+        if(workers[i].ret < 0)
+        {
+            ret = -1;
+            goto cleanup;
+        }
+    }
+    for(i = 0; i < nthreads; i++)
+    {
+        ret = accumulator_merge_metrics(acc, workers[i].acc);
+        if(ret < 0)
+            goto cleanup;
+    }
+
+cleanup:
+    for(i = 0; i < nthreads; i++)
+        darshan_accumulator_destroy(workers[i].acc);
+    free(workers);
+    free(threads);
+
+    return(ret);
+}
+
+int darshan_accumulator_inject(darshan_accumulator acc,
+                               void*               record_array,
+                               int                 record_count)
+{
+    int nthreads;
+
+    if(!mod_logutils[acc->module_id]->log_agg_records ||
+       !mod_logutils[acc->module_id]->log_sizeof_record ||
+       !mod_logutils[acc->module_id]->log_record_metrics) {
+        /* this module doesn't support this operation */
+        return(-1);
+    }
+
+    nthreads = record_count / DARSHAN_ACCUMULATOR_MIN_THREAD_RECORDS;
+    if(nthreads > acc->nthreads)
+        nthreads = acc->nthreads;
+    if(nthreads > 1)
+        return(accumulator_inject_parallel(acc, record_array, record_count,
+            nthreads));
+
+    return(accumulator_inject_serial(acc, record_array, record_count,
+        ACCUMULATOR_AGG_RECORD | ACCUMULATOR_TIMES | ACCUMULATOR_FILES));
+}
+
+/* combine the derived metrics state (but not the aggregate record) of src
+ * into dst, leaving the metrics of src empty
+ */
+static int accumulator_merge_metrics(darshan_accumulator dst,
+                                     darshan_accumulator src)
+{
+    file_metrics_t *curr = NULL;
+    file_metrics_t *file = NULL;
+    int64_t i;
+
+    dst->total_bytes += src->total_bytes;
+    dst->shared_io_total_time_by_slowest += src->shared_io_total_time_by_slowest;
+    /* three arrays, but handled by one malloc (see _create()) */
+    for(i = 0; i < dst->job_nprocs * 3; i++)
+        dst->rank_cumul_io_total_time[i] += src->rank_cumul_io_total_time[i];
+
+    /* combine per-file metrics, adding files that dst hasn't seen */
+    if(darshan_idhash_reserve(&dst->file_index,
+        dst->num_files + src->num_files) < 0)
+        return(-1);
+    for(i = 0; i < src->num_files; i++)
+    {
+        curr = &src->files[i];
+        file = accumulator_get_file(dst, curr->rec_id);
+        if(!file)
+            return(-1);
+
+        file->r_bytes += curr->r_bytes;
+        file->w_bytes += curr->w_bytes;
+        if(file->max_offset == -1 || curr->max_offset == -1)
+            file->max_offset = -1;
+        else
+            file->max_offset = max(file->max_offset, curr->max_offset);
+        if(file->nprocs == -1 || curr->nprocs == -1)
+            file->nprocs = -1;
+        else
+            file->nprocs += curr->nprocs;
+    }
+
+    darshan_idhash_destroy(&src->file_index);
+    src->num_files = 0;
+    src->total_bytes = 0;
+    src->shared_io_total_time_by_slowest = 0;
+    memset(src->rank_cumul_io_total_time, 0,
+        src->job_nprocs * 3 * sizeof(double));
+
+    return(0);
+}
+
+int darshan_accumulator_merge(darshan_accumulator dst,
+                              darshan_accumulator src)
+{
+    int ret;
+
+    if(dst == src)
+        return(-1);
+    if(dst->module_id != src->module_id || dst->job_nprocs != src->job_nprocs)
+        return(-1);
+
+    if(src->num_records == 0)
+        return(0);
+
+    /* fold the aggregate record of src into that of dst, as if it were one
+     * more record injected into dst
+     */
+    if(dst->num_records == 0)
+        memcpy(dst->agg_record, src->agg_record,
+            mod_logutils[dst->module_id]->log_sizeof_record(src->agg_record));
+    else
+        mod_logutils[dst->module_id]->log_agg_records(src->agg_record,
+            dst->agg_record, 0);
+    dst->num_records += src->num_records;
+
+    ret = accumulator_merge_metrics(dst, src);
+    if(ret < 0)
+        return(ret);
+
+    /* leave src empty, so that it can be reused or destroyed */
+    src->num_records = 0;
+    memset(src->agg_record, 0, DEF_MOD_BUF_SIZE);
 
     return(0);
 }
@@ -190,29 +467,29 @@ int darshan_accumulator_inject(darshan_accumulator acc,
  * was globally shared or if the proc value gets incremented to cover all
  * processes in the job.
  */
-#define CATEGORY_INC(__cat_counters_p, __fhe_p, __job_nprocs) \
+#define CATEGORY_INC(__cat_counters_p, __file_p, __job_nprocs) \
 do{\
     if(!(__cat_counters_p)) \
         break; \
     __cat_counters_p->count++; \
-    __cat_counters_p->total_read_volume_bytes += __fhe_p->r_bytes; \
-    __cat_counters_p->total_write_volume_bytes += __fhe_p->w_bytes; \
+    __cat_counters_p->total_read_volume_bytes += __file_p->r_bytes; \
+    __cat_counters_p->total_write_volume_bytes += __file_p->w_bytes; \
     __cat_counters_p->max_read_volume_bytes = \
-        max(__cat_counters_p->max_read_volume_bytes, __fhe_p->r_bytes); \
+        max(__cat_counters_p->max_read_volume_bytes, __file_p->r_bytes); \
     __cat_counters_p->max_write_volume_bytes = \
-        max(__cat_counters_p->max_write_volume_bytes, __fhe_p->w_bytes); \
-    if(__fhe_p->max_offset == -1) {\
+        max(__cat_counters_p->max_write_volume_bytes, __file_p->w_bytes); \
+    if(__file_p->max_offset == -1) {\
         __cat_counters_p->total_max_offset_bytes = -1; \
         __cat_counters_p->max_offset_bytes = -1; \
     }\
     else {\
-        __cat_counters_p->total_max_offset_bytes += __fhe_p->max_offset; \
+        __cat_counters_p->total_max_offset_bytes += __file_p->max_offset; \
         __cat_counters_p->max_offset_bytes = \
-            max(__cat_counters_p->max_offset_bytes, __fhe_p->max_offset); \
+            max(__cat_counters_p->max_offset_bytes, __file_p->max_offset); \
     }\
-    if(__fhe_p->nprocs > 0 && __cat_counters_p->nprocs > -1) \
-        __cat_counters_p->nprocs += __fhe_p->nprocs; \
-    if(__fhe_p->nprocs < 0 || __cat_counters_p->nprocs >= __job_nprocs) \
+    if(__file_p->nprocs > 0 && __cat_counters_p->nprocs > -1) \
+        __cat_counters_p->nprocs += __file_p->nprocs; \
+    if(__file_p->nprocs < 0 || __cat_counters_p->nprocs >= __job_nprocs) \
         __cat_counters_p->nprocs = -1; \
 }while(0)
 
@@ -220,16 +497,17 @@ int darshan_accumulator_emit(darshan_accumulator             acc,
                              struct darshan_derived_metrics* metrics,
                              void*                           summation_record)
 {
-    file_hash_entry_t *curr = NULL;
-    file_hash_entry_t *tmp_file = NULL;
+    file_metrics_t *curr = NULL;
     struct darshan_file_category_counters* cat_counters;
     int64_t i;
 
     memset(metrics, 0, sizeof(*metrics));
 
-    /* walk hash table to construct metrics by file category */
-    HASH_ITER(hlink, acc->file_hash_table, curr, tmp_file)
+    /* walk per-file metrics to construct metrics by file category */
+    for(i = 0; i < acc->num_files; i++)
     {
+        curr = &acc->files[i];
+
         /* all files */
         cat_counters = &metrics->category_counters[DARSHAN_ALL_FILES];
         CATEGORY_INC(cat_counters, curr, acc->job_nprocs);
@@ -295,9 +573,6 @@ int darshan_accumulator_emit(darshan_accumulator             acc,
 
 int darshan_accumulator_destroy(darshan_accumulator acc)
 {
-    file_hash_entry_t *curr = NULL;
-    file_hash_entry_t *tmp_file = NULL;
-
     if(!acc)
         return(0);
 
@@ -308,12 +583,8 @@ int darshan_accumulator_destroy(darshan_accumulator acc)
     if(acc->agg_record)
         free(acc->agg_record);
 
-    /* walk file hash table, freeing memory as we go */
-    HASH_ITER(hlink, acc->file_hash_table, curr, tmp_file)
-    {
-        HASH_DELETE(hlink, acc->file_hash_table, curr);
-        free(curr);
-    }
+    darshan_idhash_destroy(&acc->file_index);
+    free(acc->files);
 
     free(acc);
 
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2022 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+/* Internal open-addressing hash table mapping darshan record ids to
+ * non-negative values (typically indices into an array owned by the
+ * caller).  Slots are stored in a single array and probed linearly, so a
+ * lookup touches one or two cache lines and adding an entry never
+ * allocates, apart from occasionally doubling the table.
+ */
+
+#ifndef __DARSHAN_LOGUTILS_IDHASH_H
+#define __DARSHAN_LOGUTILS_IDHASH_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "darshan-log-format.h"
+
+/* smallest table allocated, as a power of two */
+#define DARSHAN_IDHASH_MIN_BITS 6
+
+struct darshan_idhash_slot
+{
+    darshan_record_id id;
+    int64_t value; /* -1 marks an empty slot */
+};
+
+struct darshan_idhash
+{
+    struct darshan_idhash_slot *slots;
+    int bits;      /* table holds (1 << bits) slots */
+    int64_t count; /* number of occupied slots */
+};
+
+static inline void darshan_idhash_init(struct darshan_idhash *h)
+{
+    h->slots = NULL;
+    h->bits = 0;
+    h->count = 0;
+}
+
+static inline void darshan_idhash_destroy(struct darshan_idhash *h)
+{
+    free(h->slots);
+    darshan_idhash_init(h);
+}
+
+/* record ids are already hash values, but multiply them by a large odd
+ * constant (fibonacci hashing) so that the top bits are well mixed even
+ * for ids that are not
+ */
+static inline uint64_t darshan_idhash_slot_index(
+    const struct darshan_idhash *h, darshan_record_id id)
+{
+    return((id * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - h->bits));
+}
+
+/* resize the table to (1 << bits) slots, reinserting all entries */
+static inline int darshan_idhash_rehash(struct darshan_idhash *h, int bits)
+{
+    struct darshan_idhash_slot *old_slots = h->slots;
+    uint64_t old_size = h->slots ? ((uint64_t)1 << h->bits) : 0;
+    uint64_t size = (uint64_t)1 << bits;
+    uint64_t mask = size - 1;
+    uint64_t i, j;
+
+    h->slots = malloc(size * sizeof(*h->slots));
+    if(!h->slots)
+    {
+        h->slots = old_slots;
+        return(-1);
+    }
+    for(i = 0; i < size; i++)
+        h->slots[i].value = -1;
+    h->bits = bits;
+
+    for(i = 0; i < old_size; i++)
+    {
+        if(old_slots[i].value < 0)
+            continue;
+        j = darshan_idhash_slot_index(h, old_slots[i].id);
+        while(h->slots[j].value >= 0)
+            j = (j + 1) & mask;
+        h->slots[j] = old_slots[i];
+    }
+    free(old_slots);
+
+    return(0);
+}
+
+/* make room for at least count entries without further resizing */
+static inline int darshan_idhash_reserve(struct darshan_idhash *h,
+    int64_t count)
+{
+    int bits = h->slots ? h->bits : DARSHAN_IDHASH_MIN_BITS;
+
+    /* keep the load factor at or below 1/2 */
+    while(((int64_t)1 << (bits - 1)) < count)
+        bits++;
+    if(h->slots && bits == h->bits)
+        return(0);
+
+    return(darshan_idhash_rehash(h, bits));
+}
+
+/* returns the value stored for id, or -1 if id is not in the table */
+static inline int64_t darshan_idhash_find(const struct darshan_idhash *h,
+    darshan_record_id id)
+{
+    uint64_t mask, j;
+
+    if(!h->slots)
+        return(-1);
+
+    mask = ((uint64_t)1 << h->bits) - 1;
+    j = darshan_idhash_slot_index(h, id);
+    while(h->slots[j].value >= 0)
+    {
+        if(h->slots[j].id == id)
+            return(h->slots[j].value);
+        j = (j + 1) & mask;
+    }
+
+    return(-1);
+}
+
+/* returns the value already stored for id or, if id is not in the table
+ * yet, stores and returns the given (non-negative) value; callers can tell
+ * the two cases apart by passing a value that is not yet in use, such as
+ * the next free index of their entry array.  Returns -1 on allocation
+ * failure.
+ */
+static inline int64_t darshan_idhash_find_or_add(struct darshan_idhash *h,
+    darshan_record_id id, int64_t value)
+{
+    uint64_t mask, j;
+
+    if(darshan_idhash_reserve(h, h->count + 1) < 0)
+        return(-1);
+
+    mask = ((uint64_t)1 << h->bits) - 1;
+    j = darshan_idhash_slot_index(h, id);
+    while(h->slots[j].value >= 0)
+    {
+        if(h->slots[j].id == id)
+            return(h->slots[j].value);
+        j = (j + 1) & mask;
+    }
+    h->slots[j].id = id;
+    h->slots[j].value = value;
+    h->count++;
+
+    return(value);
+}
+
+#endif /* __DARSHAN_LOGUTILS_IDHASH_H */
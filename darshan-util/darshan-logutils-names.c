@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2022 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+/* This file implements the name table API (darshan_name_table*) functions
+ * in darshan-logutils.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "darshan-logutils.h"
+#include "darshan-logutils-idhash.h"
+
+#define max(a,b) (((a) > (b)) ? (a) : (b))
+
+/* names are copied into blocks of at least this many bytes */
+#define DARSHAN_NAME_ARENA_BLOCK_SIZE (1024*1024)
+
+/* a block of the name arena; blocks are never moved or resized, so name
+ * pointers stay valid until the table is destroyed
+ */
+struct darshan_name_arena_block
+{
+    struct darshan_name_arena_block *next;
+    size_t len;
+    size_t size;
+    char data[];
+};
+
+struct darshan_name_table_entry
+{
+    darshan_record_id id;
+    const char *name;
+};
+
+struct darshan_name_table_st
+{
+    /* record id -> index into entries */
+    struct darshan_idhash index;
+    /* entries, in the order they were added */
+    struct darshan_name_table_entry *entries;
+    int64_t count;
+    int64_t size;
+    /* most recently allocated arena block first */
+    struct darshan_name_arena_block *arena;
+};
+
+int darshan_name_table_create(darshan_name_table *new_table)
+{
+    *new_table = calloc(1, sizeof(struct darshan_name_table_st));
+    if(!(*new_table))
+        return(-1);
+
+    darshan_idhash_init(&(*new_table)->index);
+
+    return(0);
+}
+
+int darshan_name_table_reserve(darshan_name_table table, int64_t count)
+{
+    struct darshan_name_table_entry *tmp_entries;
+
+    if(count > table->size)
+    {
+        tmp_entries = realloc(table->entries, count * sizeof(*tmp_entries));
+        if(!tmp_entries)
+            return(-1);
+        table->entries = tmp_entries;
+        table->size = count;
+    }
+
+    return(darshan_idhash_reserve(&table->index, count));
+}
+
+/* copy a name into the arena, starting a new block if needed */
+static const char *name_table_copy_name(darshan_name_table table,
+                                        const char *name, size_t len)
+{
+    struct darshan_name_arena_block *block = table->arena;
+    char *copy;
+
+    if(!block || block->size - block->len < len + 1)
+    {
+        block = malloc(sizeof(*block) +
+            max(DARSHAN_NAME_ARENA_BLOCK_SIZE, len + 1));
+        if(!block)
+            return(NULL);
+        block->len = 0;
+        block->size = max(DARSHAN_NAME_ARENA_BLOCK_SIZE, len + 1);
+        block->next = table->arena;
+        table->arena = block;
+    }
+
+    copy = &block->data[block->len];
+    memcpy(copy, name, len);
+    copy[len] = '\0';
+    block->len += len + 1;
+
+    return(copy);
+}
+
+int darshan_name_table_add_len(darshan_name_table table,
+                               darshan_record_id  id,
+                               const char*        name,
+                               size_t             name_len)
+{
+    struct darshan_name_table_entry *entry;
+
+    /* grow the entries and the index together, so that adding the entry
+     * below can't fail
+     */
+    if(table->count == table->size &&
+       darshan_name_table_reserve(table, table->size ? table->size * 2 : 1024) < 0)
+        return(-1);
+
+    if(darshan_idhash_find(&table->index, id) >= 0)
+        return(0); /* already present; keep the existing name */
+
+    entry = &table->entries[table->count];
+    entry->id = id;
+    entry->name = name_table_copy_name(table, name, name_len);
+    if(!entry->name)
+        return(-1);
+    darshan_idhash_find_or_add(&table->index, id, table->count);
+    table->count++;
+
+    return(1);
+}
+
+int darshan_name_table_add(darshan_name_table table,
+                           darshan_record_id  id,
+                           const char*        name)
+{
+    return(darshan_name_table_add_len(table, id, name, strlen(name)));
+}
+
+const char *darshan_name_table_lookup(darshan_name_table table,
+                                      darshan_record_id  id)
+{
+    int64_t ndx;
+
+    ndx = darshan_idhash_find(&table->index, id);
+    if(ndx < 0)
+        return(NULL);
+
+    return(table->entries[ndx].name);
+}
+
+int64_t darshan_name_table_count(darshan_name_table table)
+{
+    return(table->count);
+}
+
+int darshan_name_table_get(darshan_name_table table,
+                           int64_t            index,
+                           darshan_record_id* id,
+                           const char**       name)
+{
+    if(index < 0 || index >= table->count)
+        return(-1);
+
+    *id = table->entries[index].id;
+    *name = table->entries[index].name;
+
+    return(0);
+}
+
+void darshan_name_table_destroy(darshan_name_table table)
+{
+    struct darshan_name_arena_block *block, *next;
+
+    if(!table)
+        return;
+
+    for(block = table->arena; block; block = next)
+    {
+        next = block->next;
+        free(block);
+    }
+    darshan_idhash_destroy(&table->index);
+    free(table->entries);
+    free(table);
+
+    return;
+}
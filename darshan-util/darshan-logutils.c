@@ -13,6 +13,7 @@
 #include <string.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <inttypes.h>
 #include <sys/types.h>
@@ -24,9 +25,12 @@
 #endif
 
 #include "darshan-logutils.h"
+#include "darshan-logutils-idhash.h"
 
 /* default input buffer size for decompression algorithm */
 #define DARSHAN_DEF_COMP_BUF_SZ (1024*1024) /* 1 MiB */
+/* size of the batches of records injected into an accumulator at once */
+#define DARSHAN_ACCUMULATE_BATCH_SZ (16*1024*1024) /* 16 MiB */
 #define __DARSHAN_PATH_MAX 4096
 
 /* special identifers for referring to header, job, and
@@ -53,6 +57,12 @@ struct darshan_dz_state
     int prev_reg_id;
 };
 
+/* adds a name (not necessarily null terminated) of the given length to a
+ * collection of name records; returns -1 on failure
+ */
+typedef int (*darshan_name_add_fn)(void *names, darshan_record_id id,
+    const char *name, size_t name_len);
+
 /* internal fd data structure */
 struct darshan_fd_int_state
 {
@@ -71,7 +81,7 @@ struct darshan_fd_int_state
     /* log format version-specific function calls for getting
      * data from the log file
      */
-    int (*get_namerecs)(void *, int, int, struct darshan_name_record_ref **,
+    int (*get_namerecs)(void *, int, int, darshan_name_add_fn, void *,
                         darshan_record_id *, int);
 
     /* compression/decompression stream read/write state */
@@ -89,8 +99,14 @@ struct darshan_mod_logutil_funcs *mod_logutils[DARSHAN_KNOWN_MODULE_COUNT] =
 /* internal helper functions */
 static int darshan_mnt_info_cmp(const void *a, const void *b);
 static int darshan_log_get_namerecs(void *name_rec_buf, int buf_len,
-    int swap_flag, struct darshan_name_record_ref **hash,
+    int swap_flag, darshan_name_add_fn add_fn, void *names,
     darshan_record_id *whitelist, int whitelist_count);
+static int darshan_log_read_names(darshan_fd fd, darshan_name_add_fn add_fn,
+    void *names, darshan_record_id *whitelist, int whitelist_count);
+static int darshan_namehash_add(void *names, darshan_record_id id,
+    const char *name, size_t name_len);
+static int darshan_name_table_add_fn(void *names, darshan_record_id id,
+    const char *name, size_t name_len);
 static int darshan_log_get_format_version(char *ver_str, int *maj_num, int *min_num);
 static int darshan_log_get_header(darshan_fd fd);
 static int darshan_log_put_header(darshan_fd fd);
@@ -120,8 +136,10 @@ static int darshan_log_noz_read(darshan_fd fd, struct darshan_log_map map,
 
 /* backwards compatibility functions */
 static int darshan_log_get_namerecs_3_00(void *name_rec_buf, int buf_len,
-    int swap_flag, struct darshan_name_record_ref **hash,
+    int swap_flag, darshan_name_add_fn add_fn, void *names,
     darshan_record_id *whitelist, int whitelist_count);
+static int64_t darshan_log_compact_namerecs_3_00(char *buf, int64_t buf_len,
+    int swap_flag);
 
 static char *darshan_util_lib_ver = PACKAGE_VERSION;
 
@@ -628,21 +646,11 @@ int darshan_log_get_filtered_namehash(darshan_fd fd,
         struct darshan_name_record_ref **hash,
         darshan_record_id *whitelist, int whitelist_count)
 {
-    struct darshan_fd_int_state *state;
-    char *name_rec_buf;
-    int name_rec_buf_sz;
-    int read;
-    int read_req_sz;
-    int buf_len = 0;
-    int buf_processed;
-
     if(!fd)
     {
         fprintf(stderr, "Error: invalid Darshan log file handle.\n");
         return(-1);
     }
-    state = fd->state;
-    assert(state);
 
     /* just return if there is no name record mapping data */
     if(fd->name_map.len == 0)
@@ -651,45 +659,28 @@ int darshan_log_get_filtered_namehash(darshan_fd fd,
         return(0);
     }
 
-    /* default to buffer twice as big as default compression buf */
-    name_rec_buf_sz = DARSHAN_DEF_COMP_BUF_SZ * 2;
-    name_rec_buf = malloc(name_rec_buf_sz);
-    if(!name_rec_buf)
-        return(-1);
-    memset(name_rec_buf, 0, name_rec_buf_sz);
+    return(darshan_log_read_names(fd, darshan_namehash_add, hash,
+        whitelist, whitelist_count));
+}
 
-    do
+/* darshan_log_get_name_table()
+ *
+ * read the set of name records from the darshan log file and add them to
+ * the given name table, optionally applying a whitelist
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_get_name_table(darshan_fd fd, darshan_name_table table,
+        darshan_record_id *whitelist, int whitelist_count)
+{
+    if(!fd)
     {
-        /* read chunks of the darshan record id -> name mapping from log file,
-         * constructing a hash table in the process
-         */
-        read_req_sz = name_rec_buf_sz - buf_len;
-        read = darshan_log_dzread(fd, DARSHAN_NAME_MAP_REGION_ID,
-            name_rec_buf + buf_len, read_req_sz);
-        if(read < 0)
-        {
-            fprintf(stderr, "Error: failed to read name hash from darshan log file.\n");
-            free(name_rec_buf);
-            return(-1);
-        }
-        buf_len += read;
-
-        /* extract any name records in the buffer */
-        buf_processed = state->get_namerecs(name_rec_buf, buf_len, fd->swap_flag, hash,
-            whitelist, whitelist_count);
-
-        /* copy any leftover data to beginning of buffer to parse next */
-        memcpy(name_rec_buf, name_rec_buf + buf_processed, buf_len - buf_processed);
-        buf_len -= buf_processed;
-
-        /* we keep reading until we get a short read informing us we have
-         * read all of the record hash
-         */
-    } while(read == read_req_sz);
-    assert(buf_len == 0);
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
+    }
 
-    free(name_rec_buf);
-    return(0);
+    return(darshan_log_read_names(fd, darshan_name_table_add_fn, table,
+        whitelist, whitelist_count));
 }
 
 /* darshan_log_put_namehash()
@@ -745,6 +736,261 @@ int darshan_log_put_namehash(darshan_fd fd, struct darshan_name_record_ref *hash
     return(0);
 }
 
+/* darshan_log_put_name_table()
+ *
+ * writes the names of a name table to the darshan log file, with the same
+ * constraints as darshan_log_put_namehash()
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_put_name_table(darshan_fd fd, darshan_name_table table)
+{
+    struct darshan_fd_int_state *state;
+    struct darshan_name_record *name_rec;
+    darshan_record_id id;
+    const char *name;
+    int name_len;
+    int64_t i;
+    int wrote;
+
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
+    }
+    state = fd->state;
+    assert(state);
+
+    /* allocate memory for largest possible hash record */
+    name_rec = malloc(sizeof(darshan_record_id) + __DARSHAN_PATH_MAX + 1);
+    if(!name_rec)
+        return(-1);
+    memset(name_rec, 0, sizeof(darshan_record_id) + __DARSHAN_PATH_MAX + 1);
+
+    /* individually serialize each name record and write to log file */
+    for(i = 0; i < darshan_name_table_count(table); i++)
+    {
+        darshan_name_table_get(table, i, &id, &name);
+        name_len = strnlen(name, __DARSHAN_PATH_MAX);
+        name_rec->id = id;
+        memcpy(name_rec->name, name, name_len);
+        name_rec->name[name_len] = '\0';
+
+        /* write this name record to log file */
+        wrote = darshan_log_dzwrite(fd, DARSHAN_NAME_MAP_REGION_ID,
+            name_rec, sizeof(darshan_record_id) + name_len + 1);
+        if(wrote != sizeof(darshan_record_id) + name_len + 1)
+        {
+            state->err = -1;
+            fprintf(stderr, "Error: failed to write name hash to darshan log file.\n");
+            free(name_rec);
+            return(-1);
+        }
+    }
+
+    free(name_rec);
+    return(0);
+}
+
+/* darshan_log_get_name_index()
+ *
+ * inflate the name record region of the darshan log file into a single
+ * buffer and index the names in place, optionally applying a whitelist
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_get_name_index(darshan_fd fd, struct darshan_name_index *index,
+        darshan_record_id *whitelist, int whitelist_count)
+{
+    struct darshan_fd_int_state *state;
+    struct darshan_idhash whitelist_hash;
+    darshan_record_id id;
+    char *tmp_buf;
+    int64_t buf_size;
+    int64_t pos;
+    int64_t name_len;
+    int64_t count;
+    int swap_flag;
+    int read;
+    int read_req_sz;
+    int i;
+    int ret = -1;
+
+    memset(index, 0, sizeof(*index));
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
+    }
+    state = fd->state;
+    assert(state);
+
+    /* just return if there is no name record mapping data */
+    if(fd->name_map.len == 0)
+        return(0);
+
+    darshan_idhash_init(&whitelist_hash);
+    if(whitelist)
+    {
+        if(darshan_idhash_reserve(&whitelist_hash, whitelist_count) < 0)
+            goto cleanup;
+        for(i = 0; i < whitelist_count; i++)
+            darshan_idhash_find_or_add(&whitelist_hash, whitelist[i], 0);
+    }
+
+    /* inflate the whole region, growing the buffer as needed; start from a
+     * guess of a few times the compressed size
+     */
+    buf_size = fd->name_map.len * 4;
+    if(buf_size < DARSHAN_DEF_COMP_BUF_SZ)
+        buf_size = DARSHAN_DEF_COMP_BUF_SZ;
+    index->buf = malloc(buf_size);
+    if(!index->buf)
+        goto cleanup;
+
+    /* force the region's stream to restart, in case it was read before */
+    state->dz.prev_reg_id = DARSHAN_HEADER_REGION_ID;
+    do
+    {
+        if(index->buf_len == buf_size)
+        {
+            tmp_buf = realloc(index->buf, buf_size * 2);
+            if(!tmp_buf)
+                goto cleanup;
+            index->buf = tmp_buf;
+            buf_size *= 2;
+        }
+
+        read_req_sz = (buf_size - index->buf_len > INT_MAX) ?
+            INT_MAX : (int)(buf_size - index->buf_len);
+        read = darshan_log_dzread(fd, DARSHAN_NAME_MAP_REGION_ID,
+            index->buf + index->buf_len, read_req_sz);
+        if(read < 0)
+        {
+            fprintf(stderr, "Error: failed to read name hash from darshan log file.\n");
+            goto cleanup;
+        }
+        index->buf_len += read;
+    } while(read == read_req_sz);
+
+    /* bring older name records into the current layout first */
+    swap_flag = fd->swap_flag;
+    if(state->get_namerecs == darshan_log_get_namerecs_3_00)
+    {
+        index->buf_len = darshan_log_compact_namerecs_3_00(index->buf,
+            index->buf_len, swap_flag);
+        if(index->buf_len < 0)
+        {
+            fprintf(stderr, "Error: failed to read name hash from darshan log file.\n");
+            goto cleanup;
+        }
+        swap_flag = 0;
+    }
+
+    /* count the names to index, fixing the endianness of ids in place */
+    count = 0;
+    for(pos = 0; pos < index->buf_len; pos += sizeof(id) + name_len + 1)
+    {
+        if(index->buf_len - pos <= (int64_t)sizeof(id))
+            break;
+        name_len = strnlen(index->buf + pos + sizeof(id),
+            index->buf_len - pos - sizeof(id));
+        if(name_len == index->buf_len - pos - (int64_t)sizeof(id))
+            break;
+
+        if(swap_flag)
+            DARSHAN_BSWAP64(index->buf + pos);
+        memcpy(&id, index->buf + pos, sizeof(id));
+        if(!whitelist || darshan_idhash_find(&whitelist_hash, id) >= 0)
+            count++;
+    }
+    if(pos != index->buf_len)
+    {
+        /* the last name record is incomplete */
+        fprintf(stderr, "Error: failed to read name hash from darshan log file.\n");
+        goto cleanup;
+    }
+
+    /* ids and offsets share one allocation */
+    if(count > 0)
+    {
+        index->ids = malloc(count * (sizeof(*index->ids) + sizeof(*index->offsets)));
+        if(!index->ids)
+            goto cleanup;
+        index->offsets = (int64_t *)(index->ids + count);
+    }
+    for(pos = 0; pos < index->buf_len; pos += sizeof(id) + name_len + 1)
+    {
+        memcpy(&id, index->buf + pos, sizeof(id));
+        name_len = strlen(index->buf + pos + sizeof(id));
+        if(!whitelist || darshan_idhash_find(&whitelist_hash, id) >= 0)
+        {
+            index->ids[index->count] = id;
+            index->offsets[index->count] = pos + sizeof(id);
+            index->count++;
+        }
+    }
+    ret = 0;
+
+cleanup:
+    darshan_idhash_destroy(&whitelist_hash);
+    if(ret < 0)
+        darshan_name_index_free(index);
+    /* later reads of the name region start over as well */
+    state->dz.prev_reg_id = DARSHAN_HEADER_REGION_ID;
+
+    return(ret);
+}
+
+const char *darshan_name_index_lookup(struct darshan_name_index *index,
+        darshan_record_id id)
+{
+    int64_t i;
+
+    if(!index->id_hash)
+    {
+        if(index->count == 0)
+            return(NULL);
+
+        index->id_hash = malloc(sizeof(*index->id_hash));
+        if(!index->id_hash)
+            return(NULL);
+        darshan_idhash_init(index->id_hash);
+        if(darshan_idhash_reserve(index->id_hash, index->count) < 0)
+        {
+            free(index->id_hash);
+            index->id_hash = NULL;
+            return(NULL);
+        }
+        /* ids appearing more than once resolve to their first name, as
+         * with the other name record interfaces
+         */
+        for(i = 0; i < index->count; i++)
+            darshan_idhash_find_or_add(index->id_hash, index->ids[i], i);
+    }
+
+    i = darshan_idhash_find(index->id_hash, id);
+    if(i < 0)
+        return(NULL);
+
+    return(index->buf + index->offsets[i]);
+}
+
+void darshan_name_index_free(struct darshan_name_index *index)
+{
+    free(index->buf);
+    /* offsets are part of the ids allocation */
+    free(index->ids);
+    if(index->id_hash)
+    {
+        darshan_idhash_destroy(index->id_hash);
+        free(index->id_hash);
+    }
+    memset(index, 0, sizeof(*index));
+
+    return;
+}
+
 /* darshan_log_get_mod()
  *
  * get a chunk of module data from the darshan log file
@@ -991,18 +1237,131 @@ int whitelist_filter(darshan_record_id val, darshan_record_id *whitelist, int wh
     return 0;
 }
 
+/* name collection callbacks for darshan_log_read_names() */
+static int darshan_namehash_add(void *names, darshan_record_id id,
+    const char *name, size_t name_len)
+{
+    struct darshan_name_record_ref **hash = names;
+    struct darshan_name_record_ref *ref;
+
+    HASH_FIND(hlink, *hash, &id, sizeof(darshan_record_id), ref);
+    if(ref)
+        return(0);
+
+    ref = malloc(sizeof(*ref));
+    if(!ref)
+        return(-1);
+
+    ref->name_record = malloc(sizeof(darshan_record_id) + name_len + 1);
+    if(!ref->name_record)
+    {
+        free(ref);
+        return(-1);
+    }
+
+    /* transform the name into the zero-length array structure darshan
+     * uses to track name records
+     */
+    ref->name_record->id = id;
+    memcpy(ref->name_record->name, name, name_len);
+    ref->name_record->name[name_len] = '\0';
+
+    /* add this record to the hash */
+    HASH_ADD(hlink, *hash, name_record->id, sizeof(darshan_record_id), ref);
+
+    return(0);
+}
+
+static int darshan_name_table_add_fn(void *names, darshan_record_id id,
+    const char *name, size_t name_len)
+{
+    return(darshan_name_table_add_len(names, id, name, name_len));
+}
+
+/* read the name record region of a log, passing each name record to add_fn
+ *
+ * returns 0 on success, -1 on failure
+ */
+static int darshan_log_read_names(darshan_fd fd, darshan_name_add_fn add_fn,
+    void *names, darshan_record_id *whitelist, int whitelist_count)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    char *name_rec_buf;
+    int name_rec_buf_sz;
+    int read;
+    int read_req_sz;
+    int buf_len = 0;
+    int buf_processed;
+
+    assert(state);
+
+    /* just return if there is no name record mapping data */
+    if(fd->name_map.len == 0)
+        return(0);
+
+    /* default to buffer twice as big as default compression buf */
+    name_rec_buf_sz = DARSHAN_DEF_COMP_BUF_SZ * 2;
+    name_rec_buf = malloc(name_rec_buf_sz);
+    if(!name_rec_buf)
+        return(-1);
+    memset(name_rec_buf, 0, name_rec_buf_sz);
+
+    /* force the region's stream to restart, in case it was read before */
+    state->dz.prev_reg_id = DARSHAN_HEADER_REGION_ID;
+    do
+    {
+        /* read chunks of the darshan record id -> name mapping from log file,
+         * collecting the names in the process
+         */
+        read_req_sz = name_rec_buf_sz - buf_len;
+        read = darshan_log_dzread(fd, DARSHAN_NAME_MAP_REGION_ID,
+            name_rec_buf + buf_len, read_req_sz);
+        if(read < 0)
+        {
+            fprintf(stderr, "Error: failed to read name hash from darshan log file.\n");
+            free(name_rec_buf);
+            state->dz.prev_reg_id = DARSHAN_HEADER_REGION_ID;
+            return(-1);
+        }
+        buf_len += read;
+
+        /* extract any name records in the buffer */
+        buf_processed = state->get_namerecs(name_rec_buf, buf_len, fd->swap_flag,
+            add_fn, names, whitelist, whitelist_count);
+        if(buf_processed < 0)
+        {
+            free(name_rec_buf);
+            state->dz.prev_reg_id = DARSHAN_HEADER_REGION_ID;
+            return(-1);
+        }
+
+        /* copy any leftover data to beginning of buffer to parse next */
+        memmove(name_rec_buf, name_rec_buf + buf_processed, buf_len - buf_processed);
+        buf_len -= buf_processed;
+
+        /* we keep reading until we get a short read informing us we have
+         * read all of the record hash
+         */
+    } while(read == read_req_sz);
+    assert(buf_len == 0);
+
+    free(name_rec_buf);
+    /* later reads of the name region start over as well */
+    state->dz.prev_reg_id = DARSHAN_HEADER_REGION_ID;
+    return(0);
+}
+
 static int darshan_log_get_namerecs(void *name_rec_buf, int buf_len,
-    int swap_flag, struct darshan_name_record_ref **hash,
+    int swap_flag, darshan_name_add_fn add_fn, void *names,
     darshan_record_id *whitelist, int whitelist_count)
 {
-    struct darshan_name_record_ref *ref;
     struct darshan_name_record *name_rec;
     char *tmp_p;
     int buf_processed = 0;
     int rec_len;
 
     /* work through the name record buffer -- deserialize the record data
-     * and add to the output hash table
+     * and add to the output names
      * NOTE: these mapping pairs are variable in length, so we have to be able
      * to handle incomplete mappings temporarily here
      */
@@ -1025,26 +1384,13 @@ static int darshan_log_get_namerecs(void *name_rec_buf, int buf_len,
             DARSHAN_BSWAP64(&(name_rec->id));
         }
 
-        HASH_FIND(hlink, *hash, &(name_rec->id), sizeof(darshan_record_id), ref);
-        if(!ref && (!whitelist ||
-            whitelist_filter(name_rec->id, whitelist, whitelist_count)))
+        if(!whitelist ||
+            whitelist_filter(name_rec->id, whitelist, whitelist_count))
         {
-            ref = malloc(sizeof(*ref));
-            if(!ref)
-                return(-1);
-
-            ref->name_record = malloc(rec_len);
-            if(!ref->name_record)
-            {
-                free(ref);
+            /* copy the name over from the hash buffer */
+            if(add_fn(names, name_rec->id, name_rec->name,
+                rec_len - sizeof(darshan_record_id) - 1) < 0)
                 return(-1);
-            }
-
-            /* copy the name record over from the hash buffer */
-            memcpy(ref->name_record, name_rec, rec_len);
-
-            /* add this record to the hash */
-            HASH_ADD(hlink, *hash, name_record->id, sizeof(darshan_record_id), ref);
         }
 
         tmp_p = (char *)name_rec + rec_len;
@@ -2072,10 +2418,9 @@ static int darshan_log_dzunload(darshan_fd fd, struct darshan_log_map *map_p)
  ********************************************************/
 
 static int darshan_log_get_namerecs_3_00(void *name_rec_buf, int buf_len,
-    int swap_flag, struct darshan_name_record_ref **hash,
+    int swap_flag, darshan_name_add_fn add_fn, void *names,
     darshan_record_id *whitelist, int whitelist_count)
 {
-    struct darshan_name_record_ref *ref;
     char *buf_ptr;
     darshan_record_id *rec_id_ptr;
     uint32_t *path_len_ptr;
@@ -2084,7 +2429,7 @@ static int darshan_log_get_namerecs_3_00(void *name_rec_buf, int buf_len,
     int buf_processed = 0;
 
     /* work through the name record buffer -- deserialize the mapping data and
-     * add to the output hash table
+     * add to the output names
      * NOTE: these mapping pairs are variable in length, so we have to be able
      * to handle incomplete mappings temporarily here
      */
@@ -2112,30 +2457,14 @@ static int darshan_log_get_namerecs_3_00(void *name_rec_buf, int buf_len,
             /* we need to sort out endianness issues before deserializing */
             DARSHAN_BSWAP64(rec_id_ptr);
 
-        HASH_FIND(hlink, *hash, rec_id_ptr, sizeof(darshan_record_id), ref);
-        if(!ref && (!whitelist ||
-            whitelist_filter(*rec_id_ptr, whitelist, whitelist_count)))
+        if(!whitelist ||
+            whitelist_filter(*rec_id_ptr, whitelist, whitelist_count))
         {
-            ref = malloc(sizeof(*ref));
-            if(!ref)
-                return(-1);
-
-            ref->name_record = malloc(rec_len - sizeof(uint32_t) + 1);
-            if(!ref->name_record)
-            {
-                free(ref);
-                return(-1);
-            }
-
-            /* transform the serialized name record into the zero-length
-             * array structure darshan uses to track name records
+            /* the serialized path isn't null terminated; add_fn adds the
+             * terminator when copying it
              */
-            ref->name_record->id = *rec_id_ptr;
-            memcpy(ref->name_record->name, path_ptr, *path_len_ptr);
-            ref->name_record->name[*path_len_ptr] = '\0';
-
-            /* add this record to the hash */
-            HASH_ADD(hlink, *hash, name_record->id, sizeof(darshan_record_id), ref);
+            if(add_fn(names, *rec_id_ptr, path_ptr, *path_len_ptr) < 0)
+                return(-1);
         }
 
         buf_ptr += rec_len;
@@ -2146,6 +2475,48 @@ static int darshan_log_get_namerecs_3_00(void *name_rec_buf, int buf_len,
     return(buf_processed);
 }
 
+/* rewrite a version 3.00 name record region
+ * (... darshan_record_id | (uint32_t) path_len | path ...) in place into
+ * the current layout (... darshan_record_id | null terminated path ...),
+ * fixing endianness along the way.  Records only get shorter, so this never
+ * overwrites data that has not been parsed yet.
+ *
+ * returns the new length of the region, or -1 if it is truncated
+ */
+static int64_t darshan_log_compact_namerecs_3_00(char *buf, int64_t buf_len,
+    int swap_flag)
+{
+    darshan_record_id rec_id;
+    uint32_t path_len;
+    int64_t read_pos = 0;
+    int64_t write_pos = 0;
+
+    while(read_pos < buf_len)
+    {
+        if(buf_len - read_pos < (int64_t)(sizeof(rec_id) + sizeof(path_len)))
+            return(-1);
+        memcpy(&rec_id, buf + read_pos, sizeof(rec_id));
+        memcpy(&path_len, buf + read_pos + sizeof(rec_id), sizeof(path_len));
+        if(swap_flag)
+        {
+            DARSHAN_BSWAP64(&rec_id);
+            DARSHAN_BSWAP32(&path_len);
+        }
+        read_pos += sizeof(rec_id) + sizeof(path_len);
+        if(buf_len - read_pos < path_len)
+            return(-1);
+
+        memcpy(buf + write_pos, &rec_id, sizeof(rec_id));
+        write_pos += sizeof(rec_id);
+        memmove(buf + write_pos, buf + read_pos, path_len);
+        write_pos += path_len;
+        buf[write_pos++] = '\0';
+        read_pos += path_len;
+    }
+
+    return(write_pos);
+}
+
 /*
  * Support functions for use with other languages
  */
@@ -2209,46 +2580,7 @@ void darshan_log_get_name_records(darshan_fd fd,
                               struct darshan_name_record_info **name_records,
                               int* count)
 {
-    int ret;
-    struct darshan_name_record_ref *name_hash = NULL;
-    struct darshan_name_record_ref *tmp = NULL;
-    struct darshan_name_record_ref *curr = NULL;
-
-    /* read hash of darshan records */
-    ret = darshan_log_get_namehash(fd, &name_hash);
-    if(ret < 0)
-    {
-        darshan_log_close(fd);
-        return;
-    }
-
-    int num = HASH_CNT(hlink, name_hash);
-    *name_records = malloc(sizeof(**name_records) * num);
-    assert(*name_records);
-
-    int i = 0;
-    HASH_ITER(hlink, name_hash, curr, tmp)
-    {
-        (*name_records)[i].id = curr->name_record->id;
-        /* NOTE: darshan_log_get_namehash() call above returns a
-         * hash table that has allocated name record memory for records
-         * in the log file. This hash table is not exposed to callers,
-         * though, so it's this function's responsibility to destroy the
-         * table and free corresponding memory before returning, as is
-         * done below. This also requires that we strdup() record names
-         * that are returned to callers, who are then responsible for
-         * freeing this memory, just as they are responsible for freeing
-         * the name_records array allocated above.
-         */
-        (*name_records)[i].name = strdup(curr->name_record->name);
-        HASH_DELETE(hlink, name_hash, curr);
-        free(curr->name_record);
-        free(curr);
-        i++;
-    }
- 
-    *count = num;
-
+    darshan_log_get_filtered_name_records(fd, name_records, count, NULL, 0);
 }
 
 /*
@@ -2263,43 +2595,43 @@ void darshan_log_get_filtered_name_records(darshan_fd fd,
 {
 
     int ret;
-    struct darshan_name_record_ref *name_hash = NULL;
-    struct darshan_name_record_ref *tmp = NULL;
-    struct darshan_name_record_ref *curr = NULL;
+    darshan_name_table name_table;
+    const char *name;
+    int64_t i;
 
-    /* read hash of darshan records */
-    ret = darshan_log_get_filtered_namehash(fd, &name_hash, whitelist, whitelist_count);
+    /* read table of darshan record names */
+    ret = darshan_name_table_create(&name_table);
+    if(ret < 0)
+    {
+        darshan_log_close(fd);
+        return;
+    }
+    ret = darshan_log_get_name_table(fd, name_table, whitelist, whitelist_count);
     if(ret < 0)
     {
+        darshan_name_table_destroy(name_table);
         darshan_log_close(fd);
         return;
     }
 
-    int num = HASH_CNT(hlink, name_hash);
+    int num = darshan_name_table_count(name_table);
     *name_records = malloc(sizeof(**name_records) * num);
     assert(*name_records);
 
-    int i = 0;
-    HASH_ITER(hlink, name_hash, curr, tmp)
-    {
-        (*name_records)[i].id = curr->name_record->id;
-        /* NOTE: darshan_log_get_filtered_namehash() call above returns a
-         * hash table that has allocated name record memory for records
-         * in the log file. This hash table is not exposed to callers,
-         * though, so it's this function's responsibility to destroy the
-         * table and free corresponding memory before returning, as is
-         * done below. This also requires that we strdup() record names
-         * that are returned to callers, who are then responsible for
-         * freeing this memory, just as they are responsible for freeing
-         * the name_records array allocated above.
+    for(i = 0; i < num; i++)
+    {
+        darshan_name_table_get(name_table, i, &((*name_records)[i].id), &name);
+        /* NOTE: the name table above owns the memory of all the names it
+         * holds, and is not exposed to callers, so it is destroyed before
+         * returning. This requires that we strdup() record names that are
+         * returned to callers, who are then responsible for freeing this
+         * memory, just as they are responsible for freeing the
+         * name_records array allocated above.
          */
-        (*name_records)[i].name = strdup(curr->name_record->name);
-        HASH_DELETE(hlink, name_hash, curr);
-        free(curr->name_record);
-        free(curr);
-        i++;
+        (*name_records)[i].name = strdup(name);
     }
- 
+    darshan_name_table_destroy(name_table);
+
     *count = num;
 
 }
@@ -2332,6 +2664,250 @@ void darshan_free(void *ptr)
     free(ptr);
 }
 
+#define COUNTER_LAYOUT(__mod_id, __type, __prefix, __names, __unsigned) \
+    {__mod_id, DARSHAN_##__prefix##_VER, __prefix##_NUM_INDICES, \
+     __names##_counter_names, \
+     offsetof(__type, counters), __prefix##_F_NUM_INDICES, \
+     __names##_f_counter_names, offsetof(__type, fcounters), __unsigned}
+
+static const struct darshan_counter_layout counter_layouts[] =
+{
+    COUNTER_LAYOUT(DARSHAN_POSIX_MOD, struct darshan_posix_file, POSIX, posix,
+        POSIX_RENAMED_FROM),
+    COUNTER_LAYOUT(DARSHAN_MPIIO_MOD, struct darshan_mpiio_file, MPIIO, mpiio, -1),
+    COUNTER_LAYOUT(DARSHAN_H5F_MOD, struct darshan_hdf5_file, H5F, h5f, -1),
+    COUNTER_LAYOUT(DARSHAN_H5D_MOD, struct darshan_hdf5_dataset, H5D, h5d, -1),
+    COUNTER_LAYOUT(DARSHAN_PNETCDF_FILE_MOD, struct darshan_pnetcdf_file,
+        PNETCDF_FILE, pnetcdf_file, -1),
+    COUNTER_LAYOUT(DARSHAN_PNETCDF_VAR_MOD, struct darshan_pnetcdf_var,
+        PNETCDF_VAR, pnetcdf_var, -1),
+    COUNTER_LAYOUT(DARSHAN_BGQ_MOD, struct darshan_bgq_record, BGQ, bgq, -1),
+    COUNTER_LAYOUT(DARSHAN_STDIO_MOD, struct darshan_stdio_file, STDIO, stdio, -1),
+    COUNTER_LAYOUT(DARSHAN_MDHIM_MOD, struct darshan_mdhim_record, MDHIM, mdhim, -1),
+};
+
+/*
+ * darshan_log_get_counter_layout
+ *
+ * Return the counter layout of a module's (current version) records, or
+ * NULL if the module's records are not simple counter arrays.
+ */
+const struct darshan_counter_layout *darshan_log_get_counter_layout(
+    darshan_module_id mod_id)
+{
+    int i;
+
+    for(i = 0; i < sizeof(counter_layouts) / sizeof(counter_layouts[0]); i++)
+    {
+        if(counter_layouts[i].mod_id == mod_id)
+            return(&counter_layouts[i]);
+    }
+
+    return(NULL);
+}
+
+static int darshan_record_matrix_grow(struct darshan_record_matrix *matrix,
+    int64_t *len)
+{
+    int64_t new_len = *len ? (2 * *len) : 1024;
+    void *tmp;
+
+#define MATRIX_GROW_ARRAY(__array, __width) do { \
+    tmp = realloc(__array, new_len * (__width) * sizeof(*(__array))); \
+    if(!tmp) \
+        return(-1); \
+    __array = tmp; \
+} while(0)
+    MATRIX_GROW_ARRAY(matrix->ids, 1);
+    MATRIX_GROW_ARRAY(matrix->ranks, 1);
+    MATRIX_GROW_ARRAY(matrix->counters, matrix->ncounters);
+    MATRIX_GROW_ARRAY(matrix->fcounters, matrix->nfcounters);
+    if(matrix->mod_id == DARSHAN_H5D_MOD ||
+       matrix->mod_id == DARSHAN_PNETCDF_VAR_MOD)
+        MATRIX_GROW_ARRAY(matrix->file_rec_ids, 1);
+#undef MATRIX_GROW_ARRAY
+    *len = new_len;
+
+    return(0);
+}
+
+/*
+ * darshan_log_get_record_matrix
+ *
+ * Read all remaining records of module 'mod_id' from 'fd' into
+ * 'matrix', with one row per record of the counter and floating point
+ * counter matrices. The arrays are allocated here and must be released
+ * with darshan_free_record_matrix() (or individually with
+ * darshan_free()). Returns 0 on success, -1 on failure or if the
+ * module's records are not simple counter arrays.
+ */
+int darshan_log_get_record_matrix(darshan_fd fd, darshan_module_id mod_id,
+    struct darshan_record_matrix *matrix)
+{
+    const struct darshan_counter_layout *layout;
+    struct darshan_base_record *base_rec;
+    size_t file_rec_id_off = 0;
+    int64_t len = 0;
+    char *mod_buf;
+    int ret;
+
+    memset(matrix, 0, sizeof(*matrix));
+    layout = darshan_log_get_counter_layout(mod_id);
+    if(!layout || !mod_logutils[mod_id])
+        return(-1);
+
+    if(mod_id == DARSHAN_H5D_MOD)
+        file_rec_id_off = offsetof(struct darshan_hdf5_dataset, file_rec_id);
+    else if(mod_id == DARSHAN_PNETCDF_VAR_MOD)
+        file_rec_id_off = offsetof(struct darshan_pnetcdf_var, file_rec_id);
+
+    mod_buf = malloc(DEF_MOD_BUF_SIZE);
+    if(!mod_buf)
+        return(-1);
+
+    matrix->mod_id = mod_id;
+    matrix->ncounters = layout->ncounters;
+    matrix->nfcounters = layout->nfcounters;
+
+    while((ret = mod_logutils[mod_id]->log_get_record(fd, (void **)&mod_buf)) > 0)
+    {
+        if(matrix->nrecs == len && darshan_record_matrix_grow(matrix, &len) < 0)
+        {
+            ret = -1;
+            break;
+        }
+
+        base_rec = (struct darshan_base_record *)mod_buf;
+        matrix->ids[matrix->nrecs] = base_rec->id;
+        matrix->ranks[matrix->nrecs] = base_rec->rank;
+        memcpy(&matrix->counters[matrix->nrecs * matrix->ncounters],
+            mod_buf + layout->counters_off,
+            matrix->ncounters * sizeof(int64_t));
+        memcpy(&matrix->fcounters[matrix->nrecs * matrix->nfcounters],
+            mod_buf + layout->fcounters_off,
+            matrix->nfcounters * sizeof(double));
+        if(file_rec_id_off)
+            memcpy(&matrix->file_rec_ids[matrix->nrecs],
+                mod_buf + file_rec_id_off, sizeof(darshan_record_id));
+        matrix->nrecs++;
+    }
+    free(mod_buf);
+
+    if(ret < 0)
+    {
+        darshan_free_record_matrix(matrix);
+        return(-1);
+    }
+
+    return(0);
+}
+
+/*
+ * darshan_free_record_matrix
+ *
+ * Release the arrays of a record matrix filled in by
+ * darshan_log_get_record_matrix().
+ */
+void darshan_free_record_matrix(struct darshan_record_matrix *matrix)
+{
+    free(matrix->ids);
+    free(matrix->ranks);
+    free(matrix->counters);
+    free(matrix->fcounters);
+    free(matrix->file_rec_ids);
+    memset(matrix, 0, sizeof(*matrix));
+
+    return;
+}
+
+/*
+ * darshan_log_accumulate_module
+ *
+ * Read all records of module 'mod_id' from 'fd', injecting them into an
+ * accumulator in batches of up to DARSHAN_ACCUMULATE_BATCH_SZ bytes (so
+ * that large batches are accumulated by one thread per online CPU), and
+ * emit the accumulator's derived metrics (and aggregate record, if
+ * 'aggregation_record' is not NULL). Returns 0 on success, -1 on failure
+ * or if the module does not support accumulation.
+ */
+int darshan_log_accumulate_module(darshan_fd fd, darshan_module_id mod_id,
+    struct darshan_derived_metrics *metrics, void *aggregation_record)
+{
+    struct darshan_fd_int_state *state;
+    struct darshan_job job;
+    darshan_accumulator acc;
+    char *batch_buf;
+    char *mod_buf;
+    size_t batch_used = 0;
+    int batch_count = 0;
+    long ncpus;
+    int ret;
+
+    if(!fd)
+        return(-1);
+    state = fd->state;
+
+    if(mod_id < 0 || mod_id >= DARSHAN_KNOWN_MODULE_COUNT ||
+       !mod_logutils[mod_id] || !mod_logutils[mod_id]->log_sizeof_record)
+        return(-1);
+
+    /* force the next region read to restart its stream, so the job (and
+     * then the module) are read from their start, even if either region
+     * was read from before
+     */
+    state->dz.prev_reg_id = DARSHAN_HEADER_REGION_ID;
+    ret = darshan_log_get_job(fd, &job);
+    if(ret < 0)
+        return(-1);
+
+    ret = darshan_accumulator_create(mod_id, job.nprocs, &acc);
+    if(ret < 0)
+        return(-1);
+
+    ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if(ncpus > 1)
+        darshan_accumulator_set_threads(acc, (int)ncpus);
+
+    batch_buf = malloc(DARSHAN_ACCUMULATE_BATCH_SZ);
+    if(!batch_buf)
+    {
+        darshan_accumulator_destroy(acc);
+        return(-1);
+    }
+
+    /* decode records back to back into the batch buffer, leaving room for
+     * a record of the largest size after each one, and inject the batch
+     * whenever it fills up
+     */
+    mod_buf = batch_buf;
+    while((ret = mod_logutils[mod_id]->log_get_record(fd, (void **)&mod_buf)) > 0)
+    {
+        batch_used += mod_logutils[mod_id]->log_sizeof_record(mod_buf);
+        batch_count++;
+        if(batch_used + DEF_MOD_BUF_SIZE > DARSHAN_ACCUMULATE_BATCH_SZ)
+        {
+            ret = darshan_accumulator_inject(acc, batch_buf, batch_count);
+            if(ret < 0)
+                break;
+            batch_used = 0;
+            batch_count = 0;
+        }
+        mod_buf = batch_buf + batch_used;
+    }
+    if(ret == 0 && batch_count > 0)
+        ret = darshan_accumulator_inject(acc, batch_buf, batch_count);
+    free(batch_buf);
+
+    if(ret == 0)
+        ret = darshan_accumulator_emit(acc, metrics, aggregation_record);
+    darshan_accumulator_destroy(acc);
+
+    /* likewise restart the module region for any later reads of it */
+    state->dz.prev_reg_id = DARSHAN_HEADER_REGION_ID;
+
+    return(ret < 0 ? -1 : 0);
+}
+
 /*
  * Local variables:
  *  c-indent-level: 4
@@ -169,6 +169,42 @@ struct darshan_mod_logutil_funcs
 
 extern struct darshan_mod_logutil_funcs *mod_logutils[];
 
+/* layout of module records consisting of a base record followed by
+ * integer and floating point counter arrays, for tools that handle
+ * counters generically
+ */
+struct darshan_counter_layout
+{
+    darshan_module_id mod_id;
+    int mod_ver; /* module version of the (up-converted) record layout */
+    int ncounters;
+    char **counter_names;
+    size_t counters_off;
+    int nfcounters;
+    char **fcounter_names;
+    size_t fcounters_off;
+    int unsigned_counter; /* index of a counter holding a record id, or -1 */
+};
+
+/* all records of a module, read into one row per record: 'counters' is a
+ * row-major nrecs x ncounters matrix and 'fcounters' a row-major
+ * nrecs x nfcounters matrix; 'file_rec_ids' is only set for modules whose
+ * records refer to a parent file record (H5D, PNETCDF_VAR)
+ */
+struct darshan_record_matrix
+{
+    darshan_module_id mod_id;
+    int64_t nrecs;
+    int ncounters;
+    int nfcounters;
+    darshan_record_id *ids;
+    int64_t *ranks;
+    int64_t *counters;
+    double *fcounters;
+    darshan_record_id *file_rec_ids;
+};
+
+
 #include "darshan-posix-logutils.h"
 #include "darshan-mpiio-logutils.h"
 #include "darshan-hdf5-logutils.h"
@@ -221,6 +257,11 @@ void darshan_log_get_filtered_name_records(darshan_fd fd,
     darshan_record_id *whitelist, int whitelist_count);
 int darshan_log_get_record(darshan_fd fd, int mod_idx, void **buf);
 void darshan_free(void *ptr);
+const struct darshan_counter_layout *darshan_log_get_counter_layout(
+    darshan_module_id mod_id);
+int darshan_log_get_record_matrix(darshan_fd fd, darshan_module_id mod_id,
+    struct darshan_record_matrix *matrix);
+void darshan_free_record_matrix(struct darshan_record_matrix *matrix);
 
 
 /* convenience macros for printing Darshan counters */
@@ -317,6 +358,31 @@ int darshan_accumulator_inject(darshan_accumulator accumulator,
                                void*               record_array,
                                int                 record_count);
 
+/* Set how many threads darshan_accumulator_inject() may use (default 1).
+ * The per-file metrics of large batches of records are then accumulated in
+ * parallel over contiguous ranges and merged back in record order, while
+ * the calling thread accumulates the aggregate record and the I/O time
+ * sums in record order, so the results are bit-identical to those of a
+ * single thread.
+ */
+int darshan_accumulator_set_threads(darshan_accumulator accumulator,
+                                    int                 nthreads);
+
+/* Combine the state of src into dst, as if the records injected into src
+ * had been injected into dst after its own.  Both accumulators must be for
+ * the same module and job size, and may have been fed from disjoint record
+ * ranges (e.g., by different rank streams, or logs of the same job).  src
+ * is left empty, and must still be destroyed by the caller.
+ *
+ * The derived metrics are merged exactly.  The aggregate record of src is
+ * folded into that of dst as if it were a single record, though, so its
+ * counters that are not sums, minima or maxima of the records (the common
+ * access sizes and strides, the fastest and slowest rank counters and the
+ * variances) are only approximate.
+ */
+int darshan_accumulator_merge(darshan_accumulator dst,
+                              darshan_accumulator src);
+
 struct darshan_file_category_counters {
     int64_t count;                   /* number of files in this category */
     int64_t total_read_volume_bytes; /* total read traffic volume */
@@ -388,6 +454,120 @@ int darshan_accumulator_emit(darshan_accumulator             accumulator,
 /* frees resources associated with an accumulator */
 int darshan_accumulator_destroy(darshan_accumulator accumulator);
 
+/* Stream every record of a module of an open log into a new accumulator,
+ * then emit its derived metrics and (if aggregation_record is not NULL) the
+ * combined aggregate record. The module is always read from its first
+ * record, and records are injected in batches of bounded size, which the
+ * accumulator spreads over one thread per online CPU.
+ */
+int darshan_log_accumulate_module(darshan_fd                      fd,
+                                  darshan_module_id               mod_id,
+                                  struct darshan_derived_metrics* metrics,
+                                  void*                           aggregation_record);
+
+/*****************************************************************
+ * The functions in this section make up the name table API, a compact
+ * alternative to the uthash-based darshan_name_record_ref hash for
+ * mapping record ids to names.  Ids are indexed by an open-addressing hash
+ * table and names are copied into a few large arena blocks, so building a
+ * table for millions of names takes a handful of allocations.  Name
+ * pointers returned by the table stay valid until it is destroyed.
+ */
+
+/* opaque name table reference */
+struct darshan_name_table_st;
+typedef struct darshan_name_table_st* darshan_name_table;
+
+/* create an empty name table */
+int darshan_name_table_create(darshan_name_table* new_table);
+
+/* make room for at least count names without further reallocation */
+int darshan_name_table_reserve(darshan_name_table table, int64_t count);
+
+/* Add a copy of the name of the given record id (optionally with an
+ * explicit length, for names that are not null terminated).  Returns 1 if
+ * the id was added, 0 if the table already held a name for it (which is
+ * left unchanged), and -1 on failure.
+ */
+int darshan_name_table_add(darshan_name_table table,
+                           darshan_record_id  id,
+                           const char*        name);
+int darshan_name_table_add_len(darshan_name_table table,
+                               darshan_record_id  id,
+                               const char*        name,
+                               size_t             name_len);
+
+/* returns the name of the given record id, or NULL if it is not known */
+const char *darshan_name_table_lookup(darshan_name_table table,
+                                      darshan_record_id  id);
+
+/* number of names in the table */
+int64_t darshan_name_table_count(darshan_name_table table);
+
+/* Get the id and name of the index'th name added to the table (0 <= index
+ * < darshan_name_table_count()), for iterating over all names in order.
+ */
+int darshan_name_table_get(darshan_name_table table,
+                           int64_t            index,
+                           darshan_record_id* id,
+                           const char**       name);
+
+/* frees a name table and all of its names */
+void darshan_name_table_destroy(darshan_name_table table);
+
+/* Read the name records of a log into a name table, optionally keeping
+ * only the ids in a whitelist.  Ids already in the table are skipped.  The
+ * region is always read from its start, so a log's names can be read in
+ * several passes (e.g., one whitelist at a time).
+ */
+int darshan_log_get_name_table(darshan_fd          fd,
+                               darshan_name_table  table,
+                               darshan_record_id*  whitelist,
+                               int                 whitelist_count);
+
+/* Write the names of a table to the name record region of a log; like
+ * darshan_log_put_namehash(), this must follow darshan_log_put_mounts().
+ */
+int darshan_log_put_name_table(darshan_fd fd, darshan_name_table table);
+
+/* An index over the name record region of a log, inflated once into a
+ * single buffer.  Names are null terminated and referenced in place by
+ * their offset into buf, so the names of a log cost one buffer plus one
+ * array allocation however many there are (offsets is part of the ids
+ * allocation).  Language bindings can wrap buf, ids and offsets directly.
+ */
+struct darshan_idhash;
+struct darshan_name_index
+{
+    char *buf;              /* inflated name record region */
+    int64_t buf_len;        /* bytes of buf in use */
+    int64_t count;          /* number of indexed names */
+    darshan_record_id *ids; /* record id of each name, in log order */
+    int64_t *offsets;       /* offset of each name in buf */
+
+    /* KEEP OUT -- id lookup table, built by the first lookup */
+    struct darshan_idhash *id_hash;
+};
+
+/* Inflate the name record region of a log and index the names in it,
+ * optionally keeping only the ids in a whitelist.  The region is always
+ * read from its start.  Returns 0 on success, -1 on failure.
+ */
+int darshan_log_get_name_index(darshan_fd                 fd,
+                               struct darshan_name_index* index,
+                               darshan_record_id*         whitelist,
+                               int                        whitelist_count);
+
+/* returns the name of the given record id, or NULL if it is not indexed;
+ * the first lookup builds the id lookup table, so concurrent lookups on
+ * an index need external synchronization
+ */
+const char *darshan_name_index_lookup(struct darshan_name_index* index,
+                                      darshan_record_id          id);
+
+/* frees the buffers of a name index */
+void darshan_name_index_free(struct darshan_name_index* index);
+
 /*****************************************************************/
 
 #endif
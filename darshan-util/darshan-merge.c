@@ -8,17 +8,85 @@
 #include <string.h>
 #include <getopt.h>
 #include <glob.h>
-
-#include "uthash-1.9.2/src/uthash.h"
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "darshan-logutils.h"
 
-struct darshan_shared_record_ref
+/* maximum number of input records to buffer in memory before spilling them
+ * to a temporary sorted run
+ */
+#define DARSHAN_MERGE_RUN_RECORDS (1 << 17)
+
+/* the checkpoint an input record came from: its sequence number and the
+ * identity of the process that wrote it (ranks alone are not unique
+ * without MPI, where every process is rank 0)
+ */
+struct darshan_merge_ckpt
+{
+    int seq;
+    uint64_t proc;
+};
+
+/* a single input record, along with its sort key */
+struct darshan_merge_rec
 {
     darshan_record_id id;
-    int ref_cnt;
-    char agg_rec[DEF_MOD_BUF_SIZE];
-    UT_hash_handle hlink;
+    int64_t rank;
+    int file_idx;
+    struct darshan_merge_ckpt ckpt;
+    void *rec;
+};
+
+/* a run of records sorted by (id, rank, process), spilled to a temporary
+ * log file
+ */
+struct darshan_merge_run
+{
+    char path[PATH_MAX];
+    int nrecs[DARSHAN_KNOWN_MODULE_COUNT];
+    struct darshan_merge_ckpt *ckpts[DARSHAN_KNOWN_MODULE_COUNT];
+};
+
+/* records of a single module buffered in memory */
+struct darshan_merge_buf
+{
+    struct darshan_merge_rec *recs;
+    int count;
+    int len;
+};
+
+/* state of a worker reading a contiguous range of the input logs */
+struct darshan_merge_worker
+{
+    char **infile_list;
+    int first_file;
+    int last_file;
+    int checkpoints;
+    int max_buffered;
+    struct darshan_job job;
+    char exe[DARSHAN_EXE_LEN+1];
+    struct darshan_mnt_info *mnt_array;
+    int mnt_count;
+    darshan_name_table name_table;
+    struct darshan_merge_buf bufs[DARSHAN_KNOWN_MODULE_COUNT];
+    struct darshan_merge_run *runs;
+    int nruns;
+    int ret;
+};
+
+/* a source of sorted records for the k-way merge: either a spilled run or
+ * the records still buffered in memory
+ */
+struct darshan_merge_src
+{
+    darshan_fd fd;
+    struct darshan_merge_ckpt *ckpts;
+    struct darshan_merge_rec *recs;
+    int nrecs;
+    int pos;
+    struct darshan_merge_rec cur;
 };
 
 void usage(char *exename)
@@ -30,12 +98,15 @@ void usage(char *exename)
     fprintf(stderr, "\t--output\t(REQUIRED) Full path of the output darshan log file.\n");
     fprintf(stderr, "\t--shared-redux\tReduce globally shared records into a single record.\n");
     fprintf(stderr, "\t--job-end-time\tSet the output log's job end time (requires argument of seconds since Epoch).\n");
+    fprintf(stderr, "\t--threads\tNumber of threads used to read input logs (default 1).\n");
+    fprintf(stderr, "\t--checkpoints\tInput logs are periodic checkpoints of a job; keep only the latest copy of each record.\n");
 
     exit(1);
 }
 
 void parse_args(int argc, char **argv, char ***infile_list, int *n_files,
-    char **outlog_path, int *shared_redux, int64_t *job_end_time)
+    char **outlog_path, int *shared_redux, int64_t *job_end_time,
+    int *checkpoints, int *nthreads)
 {
     int index;
     char *check;
@@ -44,12 +115,16 @@ void parse_args(int argc, char **argv, char ***infile_list, int *n_files,
         {"output", required_argument, NULL, 'o'},
         {"shared-redux", no_argument, NULL, 's'},
         {"job-end-time", required_argument, NULL, 'e'},
+        {"checkpoints", no_argument, NULL, 'c'},
+        {"threads", required_argument, NULL, 't'},
         {0, 0, 0, 0}
     };
 
     *shared_redux = 0;
     *outlog_path = NULL;
     *job_end_time = 0;
+    *checkpoints = 0;
+    *nthreads = 1;
 
     while(1)
     {
@@ -62,9 +137,20 @@ void parse_args(int argc, char **argv, char ***infile_list, int *n_files,
             case 's':
                 *shared_redux = 1;
                 break;
+            case 'c':
+                *checkpoints = 1;
+                break;
             case 'o':
                 *outlog_path = optarg;
                 break;
+            case 't':
+                *nthreads = strtol(optarg, &check, 10);
+                if(optarg == check || *nthreads < 1)
+                {
+                    fprintf(stderr, "Error: invalid number of threads.\n");
+                    exit(1);
+                }
+                break;
             case 'e':
                 *job_end_time = strtol(optarg, &check, 10);
                 if(optarg == check)
@@ -85,139 +171,464 @@ void parse_args(int argc, char **argv, char ***infile_list, int *n_files,
         usage(argv[0]);
     }
 
+    if(*checkpoints && *shared_redux)
+    {
+        fprintf(stderr, "Error: --checkpoints and --shared-redux can not be combined.\n");
+        exit(1);
+    }
+
     *infile_list = &argv[optind];
     *n_files = argc - optind;
 
     return;
 }
 
-int build_mod_shared_rec_hash(char **infile_list, int n_infiles,
-    darshan_module_id mod_id, int nprocs, char *mod_buf,
-    struct darshan_shared_record_ref **shared_rec_hash)
+static int merge_rec_cmp(const void *a, const void *b)
+{
+    const struct darshan_merge_rec *rec_a = a;
+    const struct darshan_merge_rec *rec_b = b;
+
+    if(rec_a->id != rec_b->id)
+        return((rec_a->id < rec_b->id) ? -1 : 1);
+    if(rec_a->rank != rec_b->rank)
+        return((rec_a->rank < rec_b->rank) ? -1 : 1);
+    if(rec_a->ckpt.proc != rec_b->ckpt.proc)
+        return((rec_a->ckpt.proc < rec_b->ckpt.proc) ? -1 : 1);
+    return(rec_a->file_idx - rec_b->file_idx);
+}
+
+/* order merge sources by their current record, falling back to the order
+ * of the sources (i.e., the order of the input logs) for equal records
+ */
+static int merge_src_less(struct darshan_merge_src *a, struct darshan_merge_src *b)
+{
+    if(a->cur.id != b->cur.id)
+        return(a->cur.id < b->cur.id);
+    if(a->cur.rank != b->cur.rank)
+        return(a->cur.rank < b->cur.rank);
+    if(a->cur.ckpt.proc != b->cur.ckpt.proc)
+        return(a->cur.ckpt.proc < b->cur.ckpt.proc);
+    return(a < b);
+}
+
+static void merge_heap_sift_down(struct darshan_merge_src **heap, int nheap, int i)
+{
+    struct darshan_merge_src *tmp;
+    int child;
+
+    while((child = 2 * i + 1) < nheap)
+    {
+        if(child + 1 < nheap && merge_src_less(heap[child + 1], heap[child]))
+            child++;
+        if(!merge_src_less(heap[child], heap[i]))
+            break;
+        tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+        i = child;
+    }
+
+    return;
+}
+
+static int merge_buf_add(struct darshan_merge_buf *buf, void *rec, int file_idx,
+    struct darshan_merge_ckpt *ckpt)
+{
+    struct darshan_base_record *base_rec = rec;
+    struct darshan_merge_rec *tmp_recs;
+    int new_len;
+
+    if(buf->count == buf->len)
+    {
+        new_len = buf->len ? (2 * buf->len) : 1024;
+        tmp_recs = realloc(buf->recs, new_len * sizeof(*tmp_recs));
+        if(!tmp_recs)
+            return(-1);
+        buf->recs = tmp_recs;
+        buf->len = new_len;
+    }
+
+    buf->recs[buf->count].id = base_rec->id;
+    buf->recs[buf->count].rank = base_rec->rank;
+    buf->recs[buf->count].file_idx = file_idx;
+    buf->recs[buf->count].ckpt = *ckpt;
+    buf->recs[buf->count].rec = rec;
+    buf->count++;
+
+    return(0);
+}
+
+/* sort the buffered records of each module and write them to a new
+ * temporary run log, freeing the buffered records
+ */
+static int merge_spill_run(struct darshan_merge_buf *bufs,
+    struct darshan_merge_run **runs, int *nruns)
+{
+    struct darshan_merge_run *run, *tmp_runs;
+    darshan_fd run_fd;
+    char *tmpdir;
+    int fd;
+    int ret = 0;
+    int i, j;
+
+    tmp_runs = realloc(*runs, (*nruns + 1) * sizeof(**runs));
+    if(!tmp_runs)
+        return(-1);
+    *runs = tmp_runs;
+    run = &(*runs)[*nruns];
+    memset(run, 0, sizeof(*run));
+
+    tmpdir = getenv("TMPDIR");
+    if(!tmpdir)
+        tmpdir = "/tmp";
+    snprintf(run->path, PATH_MAX, "%s/darshan-merge-XXXXXX", tmpdir);
+    fd = mkstemp(run->path);
+    if(fd < 0)
+    {
+        fprintf(stderr, "Error: unable to create temporary file in %s.\n", tmpdir);
+        return(-1);
+    }
+    close(fd);
+    (*nruns)++;
+
+    run_fd = darshan_log_create(run->path, DARSHAN_ZLIB_COMP, 0);
+    if(run_fd == NULL)
+        return(-1);
+
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT && ret == 0; i++)
+    {
+        if(bufs[i].count == 0)
+            continue;
+
+        qsort(bufs[i].recs, bufs[i].count, sizeof(*bufs[i].recs), merge_rec_cmp);
+
+        run->ckpts[i] = malloc(bufs[i].count * sizeof(*run->ckpts[i]));
+        if(!run->ckpts[i])
+        {
+            ret = -1;
+            break;
+        }
+        for(j = 0; j < bufs[i].count; j++)
+        {
+            run->ckpts[i][j] = bufs[i].recs[j].ckpt;
+            ret = mod_logutils[i]->log_put_record(run_fd, bufs[i].recs[j].rec);
+            if(ret < 0)
+            {
+                fprintf(stderr,
+                    "Error: unable to write %s module record to temporary file %s.\n",
+                    darshan_module_names[i], run->path);
+                break;
+            }
+        }
+        if(ret < 0)
+            break;
+
+        run->nrecs[i] = bufs[i].count;
+        for(j = 0; j < bufs[i].count; j++)
+            free(bufs[i].recs[j].rec);
+        bufs[i].count = 0;
+    }
+
+    darshan_log_close(run_fd);
+
+    return(ret);
+}
+
+/* advance a merge source to its next record, returning 1 if a record was
+ * read, 0 if the source is exhausted, and -1 on error
+ */
+static int merge_src_next(struct darshan_merge_src *src, darshan_module_id mod_id)
 {
-    darshan_fd in_fd;
     struct darshan_base_record *base_rec;
-    struct darshan_shared_record_ref *ref, *tmp;
-    int init_rank = -1;
+    void *rec = NULL;
     int ret;
-    int i;
 
-    /* if this module has no method for aggregating shared records, do nothing */
-    if(!(mod_logutils[mod_id]->log_agg_records))
+    if(src->pos == src->nrecs)
         return(0);
 
-    /* loop over each input log file */
-    for(i = 0; i < n_infiles; i++)
+    if(src->fd)
     {
-        in_fd = darshan_log_open(infile_list[i]);
-        if(in_fd == NULL)
+        ret = mod_logutils[mod_id]->log_get_record(src->fd, &rec);
+        if(ret != 1)
         {
             fprintf(stderr,
-                "Error: unable to open input Darshan log file %s.\n",
-                infile_list[i]);
+                "Error: unable to read %s module record from temporary file.\n",
+                darshan_module_names[mod_id]);
             return(-1);
         }
+        base_rec = rec;
+        src->cur.id = base_rec->id;
+        src->cur.rank = base_rec->rank;
+        src->cur.ckpt = src->ckpts[src->pos];
+        src->cur.rec = rec;
+    }
+    else
+    {
+        /* take ownership of the buffered record */
+        src->cur = src->recs[src->pos];
+        src->recs[src->pos].rec = NULL;
+    }
+    src->pos++;
 
-        while((ret = mod_logutils[mod_id]->log_get_record(in_fd, (void **)&mod_buf)) == 1)
-        {
-            base_rec = (struct darshan_base_record *)mod_buf;
-            if(init_rank == -1)
-                init_rank = base_rec->rank;
+    return(1);
+}
 
-            /* initialize the hash with the first rank's records */
-            if(base_rec->rank == init_rank)
+/* write all records sharing a record id to the output log, reducing them
+ * to a single record if they are shared by every process, or keeping only
+ * the latest checkpointed copy for each process
+ */
+static int merge_write_group(darshan_fd merge_fd, darshan_module_id mod_id,
+    struct darshan_merge_rec *group, int ngroup, int shared_redux,
+    int checkpoints, int nprocs, char *agg_rec)
+{
+    struct darshan_base_record *agg_base;
+    int latest;
+    int ret;
+    int i, j;
+
+    if(shared_redux && mod_logutils[mod_id]->log_agg_records &&
+       ngroup == nprocs)
+    {
+        memset(agg_rec, 0, DEF_MOD_BUF_SIZE);
+        mod_logutils[mod_id]->log_agg_records(group[0].rec, agg_rec, 1);
+        agg_base = (struct darshan_base_record *)agg_rec;
+        agg_base->id = group[0].id;
+        agg_base->rank = -1;
+        for(i = 1; i < ngroup; i++)
+            mod_logutils[mod_id]->log_agg_records(group[i].rec, agg_rec, 0);
+
+        return(mod_logutils[mod_id]->log_put_record(merge_fd, agg_rec));
+    }
+
+    for(i = 0; i < ngroup; i = j)
+    {
+        latest = i;
+        j = i + 1;
+        if(checkpoints)
+        {
+            while(j < ngroup && group[j].rank == group[i].rank &&
+                group[j].ckpt.proc == group[i].ckpt.proc)
             {
-                struct darshan_base_record *agg_base;
+                if(group[j].ckpt.seq >= group[latest].ckpt.seq)
+                    latest = j;
+                j++;
+            }
+        }
 
-                /* create a new ref and add to the hash */
-                ref = malloc(sizeof(*ref));
-                if(!ref)
-                {
-                    darshan_log_close(in_fd);
-                    return(-1);
-                }
-                memset(ref, 0, sizeof(*ref));
+        ret = mod_logutils[mod_id]->log_put_record(merge_fd, group[latest].rec);
+        if(ret < 0)
+            return(ret);
+    }
+
+    return(0);
+}
+
+/* k-way merge of a module's records across all sorted runs, writing the
+ * merged records to the output log in record id order
+ */
+static int merge_module(darshan_fd merge_fd, darshan_module_id mod_id,
+    struct darshan_merge_worker *workers, int nworkers, int shared_redux,
+    int checkpoints, int nprocs, char *agg_rec)
+{
+    struct darshan_merge_worker *w;
+    struct darshan_merge_buf *buf;
+    struct darshan_merge_src *srcs;
+    struct darshan_merge_src **heap;
+    struct darshan_merge_rec *group = NULL, *tmp_group;
+    int group_len = 0;
+    int ngroup = 0;
+    int nsrcs = 0;
+    int nheap = 0;
+    darshan_record_id id;
+    int max_srcs = 0;
+    int ret = 0;
+    int i, j;
 
-                /* initialize the aggregate record with this rank's record */
-                mod_logutils[mod_id]->log_agg_records(mod_buf, ref->agg_rec, 1);
-                agg_base = (struct darshan_base_record *)ref->agg_rec;
-                agg_base->id = base_rec->id;
-                agg_base->rank = -1;
+    for(i = 0; i < nworkers; i++)
+        max_srcs += workers[i].nruns + 1;
+    srcs = calloc(max_srcs, sizeof(*srcs));
+    heap = calloc(max_srcs, sizeof(*heap));
+    if(!srcs || !heap)
+    {
+        free(srcs);
+        free(heap);
+        return(-1);
+    }
 
-                ref->id = base_rec->id;
-                ref->ref_cnt = 1;
-                HASH_ADD(hlink, *shared_rec_hash, id, sizeof(darshan_record_id), ref);
+    /* each worker's spilled runs and buffered records are sorted partial
+     * results for its range of input logs
+     */
+    for(i = 0; i < nworkers; i++)
+    {
+        w = &workers[i];
+        for(j = 0; j < w->nruns; j++)
+        {
+            if(w->runs[j].nrecs[mod_id] == 0)
+                continue;
+            srcs[nsrcs].fd = darshan_log_open(w->runs[j].path);
+            if(srcs[nsrcs].fd == NULL)
+            {
+                ret = -1;
+                goto cleanup;
             }
-            else
-           {
-                /* search for this record in shared record hash */
-                HASH_FIND(hlink, *shared_rec_hash, &(base_rec->id),
-                    sizeof(darshan_record_id), ref);
-                if(ref)
+            srcs[nsrcs].ckpts = w->runs[j].ckpts[mod_id];
+            srcs[nsrcs].nrecs = w->runs[j].nrecs[mod_id];
+            nsrcs++;
+        }
+        buf = &w->bufs[mod_id];
+        if(buf->count > 0)
+        {
+            srcs[nsrcs].recs = buf->recs;
+            srcs[nsrcs].nrecs = buf->count;
+            nsrcs++;
+        }
+    }
+
+    for(i = 0; i < nsrcs; i++)
+    {
+        ret = merge_src_next(&srcs[i], mod_id);
+        if(ret < 0)
+            goto cleanup;
+        heap[nheap++] = &srcs[i];
+    }
+    for(i = nheap / 2 - 1; i >= 0; i--)
+        merge_heap_sift_down(heap, nheap, i);
+
+    ret = 0;
+    while(nheap > 0)
+    {
+        /* gather every record with the smallest remaining record id */
+        id = heap[0]->cur.id;
+        while(nheap > 0 && heap[0]->cur.id == id)
+        {
+            if(ngroup == group_len)
+            {
+                group_len = group_len ? (2 * group_len) : 64;
+                tmp_group = realloc(group, group_len * sizeof(*group));
+                if(!tmp_group)
                 {
-                    /* if found, aggregate this rank's record into the shared record */
-                    mod_logutils[mod_id]->log_agg_records(mod_buf, ref->agg_rec, 0);
-                    ref->ref_cnt++;
+                    ret = -1;
+                    goto cleanup;
                 }
+                group = tmp_group;
             }
+            group[ngroup++] = heap[0]->cur;
+
+            ret = merge_src_next(heap[0], mod_id);
+            if(ret < 0)
+                goto cleanup;
+            if(ret == 0)
+                heap[0] = heap[--nheap];
+            merge_heap_sift_down(heap, nheap, 0);
         }
+
+        ret = merge_write_group(merge_fd, mod_id, group, ngroup, shared_redux,
+            checkpoints, nprocs, agg_rec);
         if(ret < 0)
         {
             fprintf(stderr,
-                "Error: unable to read %s module record from input log file %s.\n",
-                darshan_module_names[mod_id], infile_list[i]);
-            darshan_log_close(in_fd);
-            return(-1);
+                "Error: unable to write %s module record to output darshan log.\n",
+                darshan_module_names[mod_id]);
+            goto cleanup;
         }
+        for(i = 0; i < ngroup; i++)
+            free(group[i].rec);
+        ngroup = 0;
+    }
 
-        darshan_log_close(in_fd);
+cleanup:
+    for(i = 0; i < ngroup; i++)
+        free(group[i].rec);
+    free(group);
+    for(i = 0; i < nsrcs; i++)
+        if(srcs[i].fd)
+            darshan_log_close(srcs[i].fd);
+    free(srcs);
+    free(heap);
+
+    return(ret);
+}
+
+static void merge_worker_cleanup(struct darshan_merge_worker *w)
+{
+    int i, j;
+
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        for(j = 0; j < w->bufs[i].count; j++)
+            free(w->bufs[i].recs[j].rec);
+        free(w->bufs[i].recs);
+    }
+    for(i = 0; i < w->nruns; i++)
+    {
+        unlink(w->runs[i].path);
+        for(j = 0; j < DARSHAN_KNOWN_MODULE_COUNT; j++)
+            free(w->runs[i].ckpts[j]);
     }
+    free(w->runs);
+    darshan_name_table_destroy(w->name_table);
+    free(w->mnt_array);
+
+    return;
+}
+
+/* copy the record id->name mappings of src that are not in dst yet over
+ * to dst, checking that the mappings both tables have agree
+ *
+ * returns 0 on success, -1 on failure
+ */
+static int merge_name_tables(darshan_name_table dst, darshan_name_table src)
+{
+    darshan_record_id id;
+    const char *name, *found;
+    int64_t i;
+    int ret = 0;
 
-    /* prune any non-shared records from the hash one last time */
-    HASH_ITER(hlink, *shared_rec_hash, ref, tmp)
+    if(darshan_name_table_reserve(dst, darshan_name_table_count(dst) +
+        darshan_name_table_count(src)) < 0)
+        return(-1);
+
+    for(i = 0; i < darshan_name_table_count(src); i++)
     {
-        if(ref->ref_cnt != nprocs)
+        darshan_name_table_get(src, i, &id, &name);
+        found = darshan_name_table_lookup(dst, id);
+        if(!found)
+        {
+            if(darshan_name_table_add(dst, id, name) < 0)
+                return(-1);
+        }
+        else if(strcmp(name, found))
         {
-            HASH_DELETE(hlink, *shared_rec_hash, ref);
-            free(ref);
+            fprintf(stderr,
+                "Error: invalid Darshan record table entry.\n");
+            ret = -1;
         }
     }
 
-    return(0);
+    return(ret);
 }
 
-int main(int argc, char *argv[])
+/* read a worker's range of input logs:
+ *      - compose job-level metadata structure (including exe & mount data)
+ *      - compose record_id->file_name mapping
+ *      - buffer all module records, spilling them to temporary runs
+ *        sorted by record id when too many are buffered
+ */
+static void *merge_read_inputs(void *arg)
 {
-    char **infile_list;
-    int n_infiles;
-    int shared_redux;
-    int64_t job_end_time = 0;
-    char *outlog_path;
-    darshan_fd in_fd, merge_fd;
-    struct darshan_job in_job, merge_job;
-    char merge_exe[DARSHAN_EXE_LEN+1] = {0};
-    struct darshan_mnt_info *merge_mnt_array;
-    int merge_mnt_count = 0;
-    struct darshan_name_record_ref *in_hash = NULL;
-    struct darshan_name_record_ref *merge_hash = NULL;
-    struct darshan_name_record_ref *ref, *tmp, *found;
-    struct darshan_shared_record_ref *shared_rec_hash = NULL;
-    struct darshan_shared_record_ref *sref, *stmp;
-    struct darshan_base_record *base_rec;
-    char *mod_buf;
+    struct darshan_merge_worker *w = arg;
+    char **infile_list = w->infile_list;
+    darshan_fd in_fd;
+    struct darshan_job in_job;
+    darshan_name_table in_table;
+    int nbuffered = 0;
+    struct darshan_merge_ckpt ckpt = {0};
+    char *meta_str;
+    void *rec;
     int i, j;
-    int ret;
+    int ret = 0;
 
-    /* grab command line arguments */
-    parse_args(argc, argv, &infile_list, &n_infiles, &outlog_path, &shared_redux, &job_end_time);
-
-    memset(&merge_job, 0, sizeof(struct darshan_job));
-
-    /* first pass at merging together logs:
-     *      - compose output job-level metadata structure (including exe & mount data)
-     *      - compose output record_id->file_name mapping 
-     */
-    for(i = 0; i < n_infiles; i++)
+    for(i = w->first_file; i < w->last_file; i++)
     {
         memset(&in_job, 0, sizeof(struct darshan_job));
 
@@ -227,7 +638,8 @@ int main(int argc, char *argv[])
             fprintf(stderr,
                 "Error: unable to open input Darshan log file %s.\n",
                 infile_list[i]);
-            return(-1);
+            ret = -1;
+            break;
         }
 
         /* read job-level metadata from the input file */
@@ -238,7 +650,23 @@ int main(int argc, char *argv[])
                 "Error: unable to read job data from input Darshan log file %s.\n",
                 infile_list[i]);
             darshan_log_close(in_fd);
-            return(-1);
+            break;
+        }
+
+        if(w->checkpoints)
+        {
+            /* the checkpoint sequence number and process identity are
+             * stored in the job metadata; fall back to the input order and
+             * the rank alone if they're missing
+             */
+            ckpt.seq = i;
+            ckpt.proc = 0;
+            meta_str = strstr(in_job.metadata, "checkpoint=");
+            if(meta_str)
+                sscanf(meta_str, "checkpoint=%d", &ckpt.seq);
+            meta_str = strstr(in_job.metadata, "checkpoint_proc=");
+            if(meta_str)
+                sscanf(meta_str, "checkpoint_proc=%" SCNu64, &ckpt.proc);
         }
 
 #if 0
@@ -258,83 +686,255 @@ int main(int argc, char *argv[])
         }
 #endif
 
-        if(i == 0)
+        if(i == w->first_file)
         {
-            /* get job data, exe, & mounts directly from the first input log */
-            memcpy(&merge_job, &in_job, sizeof(struct darshan_job));
+            memcpy(&w->job, &in_job, sizeof(struct darshan_job));
+        }
+        else
+        {
+            /* potentially update job timestamps using remaining logs */
+            if((in_job.start_time_sec < w->job.start_time_sec) ||
+               ((in_job.start_time_sec == w->job.start_time_sec) &&
+                (in_job.start_time_nsec < w->job.start_time_nsec)))
+            {
+                w->job.start_time_sec = in_job.start_time_sec;
+                w->job.start_time_nsec = in_job.start_time_nsec;
+            }
+            if((in_job.end_time_sec > w->job.end_time_sec) ||
+               ((in_job.end_time_sec == w->job.end_time_sec) &&
+                (in_job.end_time_nsec > w->job.end_time_nsec)))
+            {
+                w->job.end_time_sec = in_job.end_time_sec;
+                w->job.end_time_nsec = in_job.end_time_nsec;
+            }
+        }
 
-            ret = darshan_log_get_exe(in_fd, merge_exe);
+        if(i == 0)
+        {
+            /* get exe & mounts directly from the first input log */
+            ret = darshan_log_get_exe(in_fd, w->exe);
             if(ret < 0)
             {
                 fprintf(stderr,
                     "Error: unable to read exe string from input Darshan log file %s.\n",
                     infile_list[i]);
                 darshan_log_close(in_fd);
-                return(-1);
+                break;
             }
 
-            ret = darshan_log_get_mounts(in_fd, &merge_mnt_array, &merge_mnt_count);
+            ret = darshan_log_get_mounts(in_fd, &w->mnt_array, &w->mnt_count);
             if(ret < 0)
             {
                 fprintf(stderr,
                     "Error: unable to read mount info from input Darshan log file %s.\n",
                     infile_list[i]);
                 darshan_log_close(in_fd);
-                return(-1);
-            }
-        }
-        else
-        {
-            /* potentially update job timestamps using remaining logs */
-            if((in_job.start_time_sec < merge_job.start_time_sec) ||
-               ((in_job.start_time_sec == merge_job.start_time_sec) &&
-                (in_job.start_time_nsec < merge_job.start_time_nsec)))
-            {
-                merge_job.start_time_sec = in_job.start_time_sec;
-                merge_job.start_time_nsec = in_job.start_time_nsec;
-            }
-            if((in_job.end_time_sec > merge_job.end_time_sec) ||
-               ((in_job.end_time_sec == merge_job.end_time_sec) &&
-                (in_job.end_time_nsec > merge_job.end_time_nsec)))
-            {
-                merge_job.end_time_sec = in_job.end_time_sec;
-                merge_job.end_time_nsec = in_job.end_time_nsec;
+                break;
             }
         }
 
-        /* read the hash of ids->names for the input log */
-        ret = darshan_log_get_namehash(in_fd, &in_hash);
+        /* read the table of ids->names for the input log */
+        ret = darshan_name_table_create(&in_table);
+        if(ret == 0)
+            ret = darshan_log_get_name_table(in_fd, in_table, NULL, 0);
         if(ret < 0)
         {
             fprintf(stderr,
                 "Error: unable to read job data from input Darshan log file %s.\n",
                 infile_list[i]);
+            darshan_name_table_destroy(in_table);
             darshan_log_close(in_fd);
-            return(-1);
+            break;
         }
 
-        /* iterate the input hash, copying over record id->name mappings
-         * that have not already been copied to the output hash
+        /* copy over record id->name mappings that have not already been
+         * copied to the worker's table
          */
-        HASH_ITER(hlink, in_hash, ref, tmp)
+        ret = merge_name_tables(w->name_table, in_table);
+        darshan_name_table_destroy(in_table);
+        if(ret < 0)
+        {
+            darshan_log_close(in_fd);
+            break;
+        }
+
+        /* buffer all module records of the input log */
+        for(j = 0; j < DARSHAN_KNOWN_MODULE_COUNT; j++)
         {
-            HASH_FIND(hlink, merge_hash, &(ref->name_record->id),
-                sizeof(darshan_record_id), found);
-            if(!found)
+            if(!mod_logutils[j]) continue;
+
+            rec = NULL;
+            while((ret = mod_logutils[j]->log_get_record(in_fd, &rec)) == 1)
             {
-                HASH_ADD(hlink, merge_hash, name_record->id,
-                    sizeof(darshan_record_id), ref);
+                ret = merge_buf_add(&w->bufs[j], rec, i, &ckpt);
+                if(ret < 0)
+                {
+                    fprintf(stderr, "Error: unable to buffer input records.\n");
+                    free(rec);
+                    break;
+                }
+                rec = NULL;
+                nbuffered++;
             }
-            else if(strcmp(ref->name_record->name, found->name_record->name))
+            if(ret < 0)
             {
                 fprintf(stderr,
-                    "Error: invalid Darshan record table entry.\n");
-                darshan_log_close(in_fd);
-                return(-1);
+                    "Error: unable to read %s module record from input log file %s.\n",
+                    darshan_module_names[j], infile_list[i]);
+                break;
             }
         }
 
         darshan_log_close(in_fd);
+        if(ret < 0)
+            break;
+
+        if(nbuffered >= w->max_buffered)
+        {
+            ret = merge_spill_run(w->bufs, &w->runs, &w->nruns);
+            if(ret < 0)
+            {
+                fprintf(stderr, "Error: unable to write temporary sorted run.\n");
+                break;
+            }
+            nbuffered = 0;
+        }
+    }
+
+    /* sort the records that are still buffered */
+    if(ret == 0)
+    {
+        for(j = 0; j < DARSHAN_KNOWN_MODULE_COUNT; j++)
+            qsort(w->bufs[j].recs, w->bufs[j].count, sizeof(*w->bufs[j].recs),
+                merge_rec_cmp);
+    }
+
+    w->ret = ret;
+    return(NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    char **infile_list;
+    int n_infiles;
+    int shared_redux;
+    int checkpoints;
+    int nthreads;
+    int64_t job_end_time = 0;
+    char *outlog_path;
+    darshan_fd merge_fd = NULL;
+    struct darshan_job merge_job;
+    darshan_name_table merge_table = NULL;
+    struct darshan_merge_worker *workers, *w;
+    pthread_t *threads = NULL;
+    char *agg_rec = NULL;
+    int i;
+    int ret = -1;
+
+    /* grab command line arguments */
+    parse_args(argc, argv, &infile_list, &n_infiles, &outlog_path, &shared_redux, &job_end_time,
+        &checkpoints, &nthreads);
+
+    memset(&merge_job, 0, sizeof(struct darshan_job));
+
+    /* split the input logs into contiguous ranges, one per worker */
+    if(nthreads > n_infiles)
+        nthreads = (n_infiles > 0) ? n_infiles : 1;
+    workers = calloc(nthreads, sizeof(*workers));
+    threads = calloc(nthreads, sizeof(*threads));
+    if(!workers || !threads)
+    {
+        fprintf(stderr, "Error: unable to allocate worker state.\n");
+        free(workers);
+        free(threads);
+        return(-1);
+    }
+    for(i = 0; i < nthreads; i++)
+    {
+        w = &workers[i];
+        w->infile_list = infile_list;
+        w->first_file = (int)(((int64_t)n_infiles * i) / nthreads);
+        w->last_file = (int)(((int64_t)n_infiles * (i + 1)) / nthreads);
+        w->checkpoints = checkpoints;
+        w->max_buffered = DARSHAN_MERGE_RUN_RECORDS / nthreads;
+        if(w->max_buffered < 1024)
+            w->max_buffered = 1024;
+        if(darshan_name_table_create(&w->name_table) < 0)
+        {
+            fprintf(stderr, "Error: unable to allocate worker state.\n");
+            ret = -1;
+            goto cleanup;
+        }
+    }
+    if(darshan_name_table_create(&merge_table) < 0)
+    {
+        fprintf(stderr, "Error: unable to allocate record table.\n");
+        ret = -1;
+        goto cleanup;
+    }
+
+    /* read the input logs, in parallel if requested */
+    if(nthreads == 1)
+    {
+        merge_read_inputs(&workers[0]);
+    }
+    else
+    {
+        for(i = 0; i < nthreads; i++)
+        {
+            ret = pthread_create(&threads[i], NULL, merge_read_inputs, &workers[i]);
+            if(ret != 0)
+            {
+                /* read this worker's range in the main thread instead */
+                threads[i] = pthread_self();
+                merge_read_inputs(&workers[i]);
+            }
+        }
+        for(i = 0; i < nthreads; i++)
+        {
+            if(!pthread_equal(threads[i], pthread_self()))
+                pthread_join(threads[i], NULL);
+        }
+    }
+
+    ret = 0;
+    for(i = 0; i < nthreads; i++)
+    {
+        w = &workers[i];
+        if(w->ret < 0)
+        {
+            ret = -1;
+            goto cleanup;
+        }
+        if(w->first_file == w->last_file)
+            continue;
+
+        /* combine the job data and record names read by each worker */
+        if(i == 0)
+        {
+            memcpy(&merge_job, &w->job, sizeof(struct darshan_job));
+        }
+        else
+        {
+            if((w->job.start_time_sec < merge_job.start_time_sec) ||
+               ((w->job.start_time_sec == merge_job.start_time_sec) &&
+                (w->job.start_time_nsec < merge_job.start_time_nsec)))
+            {
+                merge_job.start_time_sec = w->job.start_time_sec;
+                merge_job.start_time_nsec = w->job.start_time_nsec;
+            }
+            if((w->job.end_time_sec > merge_job.end_time_sec) ||
+               ((w->job.end_time_sec == merge_job.end_time_sec) &&
+                (w->job.end_time_nsec > merge_job.end_time_nsec)))
+            {
+                merge_job.end_time_sec = w->job.end_time_sec;
+                merge_job.end_time_nsec = w->job.end_time_nsec;
+            }
+        }
+
+        ret = merge_name_tables(merge_table, w->name_table);
+        if(ret < 0)
+            goto cleanup;
     }
 
     /* if a job end time was passed in, apply it to the output job */
@@ -349,7 +949,8 @@ int main(int argc, char *argv[])
     if(merge_fd == NULL)
     {
         fprintf(stderr, "Error: unable to create output darshan log.\n");
-        return(-1);
+        ret = -1;
+        goto cleanup;
     }
 
     /* write the darshan job info, exe string, and mount data to output file */
@@ -357,160 +958,73 @@ int main(int argc, char *argv[])
     if(ret < 0)
     {
         fprintf(stderr, "Error: unable to write job data to output darshan log.\n");
-        darshan_log_close(merge_fd);
-        unlink(outlog_path);
-        return(-1);
+        goto cleanup;
     }
 
-    ret = darshan_log_put_exe(merge_fd, merge_exe);
+    ret = darshan_log_put_exe(merge_fd, workers[0].exe);
     if(ret < 0)
     {
         fprintf(stderr, "Error: unable to write exe string to output darshan log.\n");
-        darshan_log_close(merge_fd);
-        unlink(outlog_path);
-        return(-1);
+        goto cleanup;
     }
 
-    ret = darshan_log_put_mounts(merge_fd, merge_mnt_array, merge_mnt_count);
+    ret = darshan_log_put_mounts(merge_fd, workers[0].mnt_array,
+        workers[0].mnt_count);
     if(ret < 0)
     {
         fprintf(stderr, "Error: unable to write mount data to output darshan log.\n");
-        darshan_log_close(merge_fd);
-        unlink(outlog_path);
-        return(-1);
+        goto cleanup;
     }
 
     /* write the merged table of records to output file */
-    ret = darshan_log_put_namehash(merge_fd, merge_hash);
+    ret = darshan_log_put_name_table(merge_fd, merge_table);
     if(ret < 0)
     {
         fprintf(stderr, "Error: unable to write record table to output darshan log.\n");
-        darshan_log_close(merge_fd);
-        unlink(outlog_path);
-        return(-1);
+        goto cleanup;
     }
 
-    mod_buf = malloc(DEF_MOD_BUF_SIZE);
-    if(!mod_buf)
+    agg_rec = malloc(DEF_MOD_BUF_SIZE);
+    if(!agg_rec)
     {
-        fprintf(stderr, "Error: unable to write record table to output darshan log.\n");
-        darshan_log_close(merge_fd);
-        unlink(outlog_path);
-        return(-1);
+        fprintf(stderr, "Error: unable to allocate aggregate record buffer.\n");
+        ret = -1;
+        goto cleanup;
     }
 
-    /* iterate over active darshan modules and gather module data to write
-     * to the merged output log
+    /* merge the sorted partial results of all workers and write the merged
+     * records to the output log, one module at a time
      */
     for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
     {
         if(!mod_logutils[i]) continue;
 
-        if(shared_redux)
-        {
-            /* build the hash of records shared globally by this module */
-            ret = build_mod_shared_rec_hash(infile_list, n_infiles, i,
-                merge_job.nprocs, mod_buf, &shared_rec_hash);
-            if(ret < 0)
-            {
-                fprintf(stderr,
-                    "Error: unable to build list of %s module's shared records.\n",
-                    darshan_module_names[i]);
-                darshan_log_close(merge_fd);
-                unlink(outlog_path);
-                free(mod_buf);
-                return(-1);
-            }
-
-        }
-
-        for(j = 0; j < n_infiles; j++)
-        {
-            in_fd = darshan_log_open(infile_list[j]);
-            if(in_fd == NULL)
-            {
-                fprintf(stderr,
-                    "Error: unable to open input Darshan log file %s.\n",
-                    infile_list[j]);
-                darshan_log_close(merge_fd);
-                unlink(outlog_path);
-                free(mod_buf);
-                return(-1);
-            }
-
-            if(j == 0 && shared_rec_hash)
-            {
-                /* write out the shared records first */
-                HASH_ITER(hlink, shared_rec_hash, sref, stmp)
-                {
-                    ret = mod_logutils[i]->log_put_record(merge_fd, sref->agg_rec);
-                    if(ret < 0)
-                    {
-                        fprintf(stderr,
-                            "Error: unable to write %s module record to output darshan log.\n",
-                            darshan_module_names[i]);
-                        darshan_log_close(in_fd);
-                        darshan_log_close(merge_fd);
-                        unlink(outlog_path);
-                        free(mod_buf);
-                        return(-1);
-                    }
-                }
-            }
-
-            /* loop over module records and write them to output file */
-            while((ret = mod_logutils[i]->log_get_record(in_fd, (void **)&mod_buf)) == 1)
-            {
-                base_rec = (struct darshan_base_record *)mod_buf;
-
-                HASH_FIND(hlink, shared_rec_hash, &(base_rec->id), sizeof(darshan_record_id), sref);
-                if(sref)
-                    continue; /* skip shared records */
-
-                ret = mod_logutils[i]->log_put_record(merge_fd, mod_buf);
-                if(ret < 0)
-                {
-                    fprintf(stderr,
-                        "Error: unable to write %s module record to output log file %s.\n",
-                        darshan_module_names[i], infile_list[j]);
-                    darshan_log_close(in_fd);
-                    darshan_log_close(merge_fd);
-                    unlink(outlog_path);
-                    free(mod_buf);
-                    return(-1);
-                }
-            }
-            if(ret < 0)
-            {
-                fprintf(stderr,
-                    "Error: unable to read %s module record from input log file %s.\n",
-                    darshan_module_names[i], infile_list[j]);
-                darshan_log_close(in_fd);
-                darshan_log_close(merge_fd);
-                unlink(outlog_path);
-                free(mod_buf);
-                return(-1);
-            }
-
-            darshan_log_close(in_fd);
-        }
-
-        /* clear the shared record hash for the next module */
-        if(shared_redux)
+        ret = merge_module(merge_fd, i, workers, nthreads, shared_redux,
+            checkpoints, merge_job.nprocs, agg_rec);
+        if(ret < 0)
         {
-            HASH_ITER(hlink, shared_rec_hash, sref, stmp)
-            {
-                HASH_DELETE(hlink, shared_rec_hash, sref);
-                free(sref);
-            }
+            fprintf(stderr,
+                "Error: unable to merge %s module records.\n",
+                darshan_module_names[i]);
+            goto cleanup;
         }
     }
 
-    free(mod_buf);
-
-    darshan_log_close(merge_fd);
+cleanup:
+    if(merge_fd)
+    {
+        darshan_log_close(merge_fd);
+        if(ret < 0)
+            unlink(outlog_path);
+    }
+    free(agg_rec);
+    for(i = 0; i < nthreads; i++)
+        merge_worker_cleanup(&workers[i]);
+    free(workers);
+    free(threads);
+    darshan_name_table_destroy(merge_table);
 
-    return(0);
+    return((ret < 0) ? -1 : 0);
 }
 
 /*
@@ -0,0 +1,421 @@
+/*
+ * Copyright (C) 2023 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <getopt.h>
+#include <glob.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "uthash-1.9.2/src/uthash.h"
+
+#include "darshan-logutils.h"
+
+/* number of attempts at reading a consistent snapshot of an mmap log
+ * before skipping it for this sampling interval
+ */
+#define MMAP_LOG_SNAPSHOT_TRIES 100
+
+/* modules whose counters are aggregated by this utility */
+enum monitor_mod
+{
+    MONITOR_POSIX = 0,
+    MONITOR_MPIIO,
+    MONITOR_STDIO,
+    MONITOR_MOD_COUNT
+};
+
+static char *monitor_mod_names[MONITOR_MOD_COUNT] = {"POSIX", "MPI-IO", "STDIO"};
+
+struct monitor_counters
+{
+    int64_t bytes_read;
+    int64_t bytes_written;
+    int64_t reads;
+    int64_t writes;
+};
+
+/* per-second rates of the counters above */
+struct monitor_rates
+{
+    double bytes_read;
+    double bytes_written;
+    double reads;
+    double writes;
+};
+
+/* last sample taken from each mmap log, keyed by log file path */
+struct monitor_log_ref
+{
+    char *path;
+    int generation;
+    double sample_time; /* monotonic time at which mods was sampled */
+    struct monitor_counters mods[MONITOR_MOD_COUNT];
+    UT_hash_handle hlink;
+};
+
+void usage(char *exename)
+{
+    fprintf(stderr, "Usage: %s [options] [<mmap_log_dir>]\n", exename);
+    fprintf(stderr, "This utility periodically samples the mmap logs of running Darshan-instrumented\n");
+    fprintf(stderr, "processes on this node and prints their aggregate I/O rates.\n");
+    fprintf(stderr, "<mmap_log_dir> defaults to $DARSHAN_MMAP_LOGPATH, or /tmp if it is not set.\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "\t--interval\tSeconds between samples (default: 5).\n");
+    fprintf(stderr, "\t--count\t\tNumber of intervals to report before exiting (default: no limit).\n");
+
+    exit(1);
+}
+
+void parse_args(int argc, char **argv, char **log_dir, int *interval,
+    int *count)
+{
+    int index;
+    char *check;
+    static struct option long_opts[] =
+    {
+        {"interval", required_argument, NULL, 'i'},
+        {"count", required_argument, NULL, 'c'},
+        {0, 0, 0, 0}
+    };
+
+    *interval = 5;
+    *count = 0;
+
+    while(1)
+    {
+        int c = getopt_long(argc, argv, "", long_opts, &index);
+
+        if(c == -1) break;
+
+        switch(c)
+        {
+            case 'i':
+                *interval = strtol(optarg, &check, 10);
+                if(optarg == check || *interval < 1)
+                {
+                    fprintf(stderr, "Error: unable to parse sampling interval.\n");
+                    exit(1);
+                }
+                break;
+            case 'c':
+                *count = strtol(optarg, &check, 10);
+                if(optarg == check || *count < 1)
+                {
+                    fprintf(stderr, "Error: unable to parse interval count.\n");
+                    exit(1);
+                }
+                break;
+            case '?':
+            default:
+                usage(argv[0]);
+                break;
+        }
+    }
+
+    if(argc - optind > 1)
+        usage(argv[0]);
+    else if(argc - optind == 1)
+        *log_dir = argv[optind];
+    else if(getenv("DARSHAN_MMAP_LOGPATH"))
+        *log_dir = getenv("DARSHAN_MMAP_LOGPATH");
+    else
+        *log_dir = "/tmp";
+
+    return;
+}
+
+/* sum the counters of all initialized records of a module in a snapshot;
+ * returns -1 if the module map does not fit in the mapped log
+ */
+static int sum_mod_counters(char *log_p, size_t log_size,
+    struct darshan_header *hdr, darshan_module_id mod_id,
+    struct monitor_counters *counters)
+{
+    struct darshan_posix_file *posix_rec;
+    struct darshan_mpiio_file *mpiio_rec;
+    struct darshan_stdio_file *stdio_rec;
+    uint64_t off = hdr->mod_map[mod_id].off;
+    uint64_t len = hdr->mod_map[mod_id].len;
+    uint64_t i;
+
+    if(off + len > log_size || off + len < off)
+        return(-1);
+
+    /* records of other module versions have a different layout */
+    switch(mod_id)
+    {
+        case DARSHAN_POSIX_MOD:
+            if(hdr->mod_ver[mod_id] != DARSHAN_POSIX_VER)
+                return(0);
+            for(i = 0; i + sizeof(*posix_rec) <= len; i += sizeof(*posix_rec))
+            {
+                posix_rec = (struct darshan_posix_file *)(log_p + off + i);
+                /* records are zeroed until their module initializes them */
+                if(posix_rec->base_rec.id == 0)
+                    continue;
+                counters->bytes_read += posix_rec->counters[POSIX_BYTES_READ];
+                counters->bytes_written += posix_rec->counters[POSIX_BYTES_WRITTEN];
+                counters->reads += posix_rec->counters[POSIX_READS];
+                counters->writes += posix_rec->counters[POSIX_WRITES];
+            }
+            break;
+        case DARSHAN_MPIIO_MOD:
+            if(hdr->mod_ver[mod_id] != DARSHAN_MPIIO_VER)
+                return(0);
+            for(i = 0; i + sizeof(*mpiio_rec) <= len; i += sizeof(*mpiio_rec))
+            {
+                mpiio_rec = (struct darshan_mpiio_file *)(log_p + off + i);
+                if(mpiio_rec->base_rec.id == 0)
+                    continue;
+                counters->bytes_read += mpiio_rec->counters[MPIIO_BYTES_READ];
+                counters->bytes_written += mpiio_rec->counters[MPIIO_BYTES_WRITTEN];
+                counters->reads += mpiio_rec->counters[MPIIO_INDEP_READS] +
+                    mpiio_rec->counters[MPIIO_COLL_READS] +
+                    mpiio_rec->counters[MPIIO_SPLIT_READS] +
+                    mpiio_rec->counters[MPIIO_NB_READS];
+                counters->writes += mpiio_rec->counters[MPIIO_INDEP_WRITES] +
+                    mpiio_rec->counters[MPIIO_COLL_WRITES] +
+                    mpiio_rec->counters[MPIIO_SPLIT_WRITES] +
+                    mpiio_rec->counters[MPIIO_NB_WRITES];
+            }
+            break;
+        case DARSHAN_STDIO_MOD:
+            if(hdr->mod_ver[mod_id] != DARSHAN_STDIO_VER)
+                return(0);
+            for(i = 0; i + sizeof(*stdio_rec) <= len; i += sizeof(*stdio_rec))
+            {
+                stdio_rec = (struct darshan_stdio_file *)(log_p + off + i);
+                if(stdio_rec->base_rec.id == 0)
+                    continue;
+                counters->bytes_read += stdio_rec->counters[STDIO_BYTES_READ];
+                counters->bytes_written += stdio_rec->counters[STDIO_BYTES_WRITTEN];
+                counters->reads += stdio_rec->counters[STDIO_READS];
+                counters->writes += stdio_rec->counters[STDIO_WRITES];
+            }
+            break;
+        default:
+            break;
+    }
+
+    return(0);
+}
+
+/* take a consistent snapshot of the module counters stored in a live
+ * mmap log; returns 0 on success, -1 if the log could not be read or
+ * was being updated (or finalized) for every attempt
+ */
+static int sample_mmap_log(const char *path, struct monitor_counters *mods)
+{
+    static const darshan_module_id mod_ids[MONITOR_MOD_COUNT] =
+        {DARSHAN_POSIX_MOD, DARSHAN_MPIIO_MOD, DARSHAN_STDIO_MOD};
+    struct darshan_header hdr;
+    struct stat statbuf;
+    volatile uint64_t *seq_p;
+    uint64_t seq1, seq2;
+    char *log_p;
+    int fd;
+    int tries;
+    int i;
+    int ret = -1;
+
+    fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return(-1);
+    if(fstat(fd, &statbuf) < 0 ||
+       statbuf.st_size < (off_t)(sizeof(hdr) + DARSHAN_MMAP_LOG_SEQ_SIZE))
+    {
+        close(fd);
+        return(-1);
+    }
+    log_p = mmap(NULL, statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(log_p == MAP_FAILED)
+        return(-1);
+    seq_p = (uint64_t *)(log_p + statbuf.st_size - DARSHAN_MMAP_LOG_SEQ_SIZE);
+
+    for(tries = 0; tries < MMAP_LOG_SNAPSHOT_TRIES; tries++)
+    {
+        seq1 = __atomic_load_n(seq_p, __ATOMIC_ACQUIRE);
+        if(seq1 & 1)
+        {
+            /* the runtime is in the middle of an update */
+            usleep(1000);
+            continue;
+        }
+
+        memcpy(&hdr, log_p, sizeof(hdr));
+        if(hdr.magic_nr != DARSHAN_MAGIC_NR || hdr.comp_type != DARSHAN_NO_COMP ||
+           strcmp(hdr.version_string, DARSHAN_LOG_VERSION))
+            break;
+
+        memset(mods, 0, MONITOR_MOD_COUNT * sizeof(*mods));
+        ret = 0;
+        for(i = 0; i < MONITOR_MOD_COUNT && ret == 0; i++)
+            ret = sum_mod_counters(log_p, statbuf.st_size, &hdr, mod_ids[i],
+                &mods[i]);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq2 = __atomic_load_n(seq_p, __ATOMIC_RELAXED);
+        if(seq1 == seq2 && ret == 0)
+            break;
+        ret = -1;
+    }
+
+    munmap(log_p, statbuf.st_size);
+    return(ret);
+}
+
+/* returns the current monotonic time, in seconds */
+static double monitor_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return((double)ts.tv_sec + (double)ts.tv_nsec / 1e9);
+}
+
+int main(int argc, char **argv)
+{
+    char *log_dir;
+    char *log_glob;
+    int interval;
+    int count;
+    int generation;
+    int nprocs;
+    glob_t globbuf;
+    size_t i;
+    int j;
+    struct monitor_counters mods[MONITOR_MOD_COUNT];
+    struct monitor_rates rates[MONITOR_MOD_COUNT];
+    struct monitor_log_ref *ref, *tmp, *log_hash = NULL;
+    double sample_time;
+    double elapsed;
+    int ret;
+
+    parse_args(argc, argv, &log_dir, &interval, &count);
+
+    log_glob = malloc(strlen(log_dir) + 32);
+    if(!log_glob)
+        return(-1);
+    sprintf(log_glob, "%s/*_mmap-log-*.darshan", log_dir);
+
+    printf("# darshan-mmap-monitor: sampling %s every %d seconds\n", log_glob, interval);
+    printf("# rates are aggregated over all processes on this node that were running\n");
+    printf("# at both the start and the end of an interval\n");
+    printf("#<time>\t<module>\t<processes>\t<read MiB/s>\t<write MiB/s>\t<reads/s>\t<writes/s>\n");
+    fflush(stdout);
+
+    for(generation = 0; count == 0 || generation <= count; generation++)
+    {
+        if(generation > 0)
+            sleep(interval);
+
+        memset(rates, 0, sizeof(rates));
+        nprocs = 0;
+
+        ret = glob(log_glob, 0, NULL, &globbuf);
+        for(i = 0; ret == 0 && i < globbuf.gl_pathc; i++)
+        {
+            if(sample_mmap_log(globbuf.gl_pathv[i], mods) < 0)
+                continue;
+            sample_time = monitor_now();
+
+            HASH_FIND(hlink, log_hash, globbuf.gl_pathv[i],
+                strlen(globbuf.gl_pathv[i]), ref);
+            if(!ref)
+            {
+                /* only establish a baseline for logs we have not seen yet */
+                ref = malloc(sizeof(*ref));
+                if(!ref)
+                    continue;
+                ref->path = strdup(globbuf.gl_pathv[i]);
+                if(!ref->path)
+                {
+                    free(ref);
+                    continue;
+                }
+                HASH_ADD_KEYPTR(hlink, log_hash, ref->path, strlen(ref->path), ref);
+            }
+            else
+            {
+                /* divide by the time actually elapsed between this log's
+                 * samples, which drifts from the nominal interval with
+                 * sleep and sampling latency
+                 */
+                elapsed = sample_time - ref->sample_time;
+                for(j = 0; elapsed > 0 && j < MONITOR_MOD_COUNT; j++)
+                {
+                    rates[j].bytes_read += (mods[j].bytes_read - ref->mods[j].bytes_read) / elapsed;
+                    rates[j].bytes_written += (mods[j].bytes_written - ref->mods[j].bytes_written) / elapsed;
+                    rates[j].reads += (mods[j].reads - ref->mods[j].reads) / elapsed;
+                    rates[j].writes += (mods[j].writes - ref->mods[j].writes) / elapsed;
+                }
+                nprocs++;
+            }
+            memcpy(ref->mods, mods, sizeof(mods));
+            ref->sample_time = sample_time;
+            ref->generation = generation;
+        }
+        if(ret == 0)
+            globfree(&globbuf);
+
+        /* forget logs of processes that have exited */
+        HASH_ITER(hlink, log_hash, ref, tmp)
+        {
+            if(ref->generation != generation)
+            {
+                HASH_DELETE(hlink, log_hash, ref);
+                free(ref->path);
+                free(ref);
+            }
+        }
+
+        if(generation == 0)
+            continue;
+
+        for(j = 0; j < MONITOR_MOD_COUNT; j++)
+        {
+            printf("%ld\t%s\t%d\t%.3f\t%.3f\t%.1f\t%.1f\n", (long)time(NULL),
+                monitor_mod_names[j], nprocs,
+                rates[j].bytes_read / (1024.0 * 1024.0),
+                rates[j].bytes_written / (1024.0 * 1024.0),
+                rates[j].reads,
+                rates[j].writes);
+        }
+        fflush(stdout);
+    }
+
+    HASH_ITER(hlink, log_hash, ref, tmp)
+    {
+        HASH_DELETE(hlink, log_hash, ref);
+        free(ref->path);
+        free(ref);
+    }
+    free(log_glob);
+
+    return(0);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -31,6 +31,8 @@
 #define OPTION_TOTAL (1 << 1)  /* aggregated fields */
 #define OPTION_PERF  (1 << 2)  /* derived performance */
 #define OPTION_FILE  (1 << 3)  /* file count totals */
+#define OPTION_CSV   (1 << 4)  /* per-module CSV record tables */
+#define OPTION_BINARY (1 << 5) /* per-module fixed-width binary record tables */
 #define OPTION_SHOW_INCOMPLETE  (1 << 7)  /* show what we have, even if log is incomplete */
 #define OPTION_ALL (\
   OPTION_BASE|\
@@ -45,12 +47,39 @@
 
 #define max(a,b) (((a) > (b)) ? (a) : (b))
 
+/* stdio buffer size used when writing record tables */
+#define TABLE_BUF_SIZE (4*1024*1024)
+
+/* header of binary record tables, followed by the NUL-terminated counter
+ * names (integer counters first) padded to an 8 byte boundary, then nrows
+ * fixed-width rows starting at data_off.  Each row holds the rank (int64),
+ * the record id (uint64), the integer counters (int64) and the floating
+ * point counters (double), all in native byte order.
+ */
+#define TABLE_BIN_MAGIC "DARSHTAB"
+#define TABLE_BIN_VERSION 1
+struct table_bin_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t mod_id;
+    uint32_t mod_ver;
+    uint32_t ncounters;
+    uint32_t nfcounters;
+    uint32_t row_size;
+    uint64_t nrows;
+    uint64_t data_off;
+};
+
 /*
  * Prototypes
  */
 void posix_print_total_file(struct darshan_posix_file *pfile, int posix_ver);
 void mpiio_print_total_file(struct darshan_mpiio_file *mfile, int mpiio_ver);
 void stdio_print_total_file(struct darshan_stdio_file *pfile, int stdio_ver);
+int write_record_tables(darshan_fd fd, struct darshan_name_record_ref *name_hash,
+    struct darshan_mnt_info *mnt_data_array, int mount_count, char *prefix,
+    int mask);
 
 int usage (char *exename)
 {
@@ -61,11 +90,16 @@ int usage (char *exename)
     fprintf(stderr, "    --perf  : derived perf data\n");
     fprintf(stderr, "    --total : aggregated darshan field data\n");
     fprintf(stderr, "    --show-incomplete : display results even if log is incomplete\n");
+    fprintf(stderr, "    --csv <prefix> : write each module's records as a CSV table to\n"
+                    "                     <prefix>-<module>.csv and record names to\n"
+                    "                     <prefix>-names.csv\n");
+    fprintf(stderr, "    --binary <prefix> : like --csv, but write fixed-width binary\n"
+                    "                        tables to <prefix>-<module>.bin\n");
 
     exit(1);
 }
 
-int parse_args (int argc, char **argv, char **filename)
+int parse_args (int argc, char **argv, char **filename, char **table_prefix)
 {
     int index;
     int mask;
@@ -77,6 +111,8 @@ int parse_args (int argc, char **argv, char **filename)
         {"perf",  0, NULL, OPTION_PERF},
         {"total", 0, NULL, OPTION_TOTAL},
         {"show-incomplete", 0, NULL, OPTION_SHOW_INCOMPLETE},
+        {"csv",   1, NULL, OPTION_CSV},
+        {"binary", 1, NULL, OPTION_BINARY},
         {"help",  0, NULL, 0},
         {0, 0, 0, 0}
     };
@@ -99,6 +135,11 @@ int parse_args (int argc, char **argv, char **filename)
             case OPTION_SHOW_INCOMPLETE:
                 mask |= c;
                 break;
+            case OPTION_CSV:
+            case OPTION_BINARY:
+                mask |= c;
+                *table_prefix = optarg;
+                break;
             case 0:
             case '?':
             default:
@@ -116,6 +157,12 @@ int parse_args (int argc, char **argv, char **filename)
         usage(argv[0]);
     }
 
+    /* record tables are written in a single format, instead of text output */
+    if ((mask & OPTION_CSV) && (mask & OPTION_BINARY))
+    {
+        usage(argv[0]);
+    }
+
     /* default mask value if none specified */
     if (mask == 0 || mask == OPTION_SHOW_INCOMPLETE)
     {
@@ -131,6 +178,7 @@ int main(int argc, char **argv)
     int mask;
     int i, j;
     char *filename;
+    char *table_prefix = NULL;
     char *comp_str;
     char tmp_string[4096] = {0};
     darshan_fd fd;
@@ -150,7 +198,7 @@ int main(int argc, char **argv)
     darshan_accumulator acc = NULL;
     struct darshan_derived_metrics metrics;
 
-    mask = parse_args(argc, argv, &filename);
+    mask = parse_args(argc, argv, &filename, &table_prefix);
 
     fd = darshan_log_open(filename);
     if(!fd)
@@ -191,6 +239,23 @@ int main(int argc, char **argv)
     /* print any warnings related to this log file version */
     darshan_log_print_version_warnings(fd->version);
 
+    if(mask & (OPTION_CSV | OPTION_BINARY))
+    {
+        /* write record tables in place of the text output */
+        ret = write_record_tables(fd, name_hash, mnt_data_array, mount_count,
+            table_prefix, mask);
+        darshan_log_close(fd);
+        HASH_ITER(hlink, name_hash, ref, tmp_ref)
+        {
+            HASH_DELETE(hlink, name_hash, ref);
+            free(ref->name_record);
+            free(ref);
+        }
+        if(mount_count > 0)
+            free(mnt_data_array);
+        return(ret);
+    }
+
     if(fd->comp_type == DARSHAN_ZLIB_COMP)
         comp_str = "ZLIB";
     else if (fd->comp_type == DARSHAN_BZIP2_COMP)
@@ -637,6 +702,297 @@ void mpiio_print_total_file(struct darshan_mpiio_file *mfile, int mpiio_ver)
     return;
 }
 
+/* open a record table file named <prefix>-<suffix>, with a large stdio
+ * buffer so that rows are written out in big chunks
+ */
+static FILE *table_open(char *prefix, const char *suffix, char **buf)
+{
+    char path[4096];
+    FILE *fp;
+    int i;
+
+    snprintf(path, sizeof(path), "%s-%s", prefix, suffix);
+    /* module names such as "BG/Q" are not valid file name components */
+    for(i = strlen(prefix) + 1; path[i] != '\0'; i++)
+    {
+        if(path[i] == '/')
+            path[i] = '_';
+    }
+
+    fp = fopen(path, "w");
+    if(!fp)
+    {
+        fprintf(stderr, "Error: unable to open %s for writing.\n", path);
+        return(NULL);
+    }
+    *buf = malloc(TABLE_BUF_SIZE);
+    if(*buf)
+        setvbuf(fp, *buf, _IOFBF, TABLE_BUF_SIZE);
+
+    return(fp);
+}
+
+static int table_close(FILE *fp, char *buf)
+{
+    int ret = 0;
+
+    if(ferror(fp) || fclose(fp) != 0)
+    {
+        fprintf(stderr, "Error: failed to write record table.\n");
+        ret = -1;
+    }
+    free(buf);
+
+    return(ret);
+}
+
+/* write a CSV field, quoting it if necessary */
+static void csv_print_string(FILE *fp, const char *str)
+{
+    if(!strpbrk(str, ",\"\r\n"))
+    {
+        fputs(str, fp);
+        return;
+    }
+
+    fputc('"', fp);
+    for(; *str; str++)
+    {
+        if(*str == '"')
+            fputc('"', fp);
+        fputc(*str, fp);
+    }
+    fputc('"', fp);
+    return;
+}
+
+static int write_name_table(struct darshan_name_record_ref *name_hash,
+    struct darshan_mnt_info *mnt_data_array, int mount_count, char *prefix)
+{
+    struct darshan_name_record_ref *ref, *tmp_ref;
+    char *mnt_pt, *fs_type;
+    char *buf;
+    FILE *fp;
+    int j;
+
+    fp = table_open(prefix, "names.csv", &buf);
+    if(!fp)
+        return(-1);
+
+    fprintf(fp, "record_id,file_name,mount_pt,fs_type\n");
+    HASH_ITER(hlink, name_hash, ref, tmp_ref)
+    {
+        mnt_pt = "UNKNOWN";
+        fs_type = "UNKNOWN";
+        for(j=0; j<mount_count; j++)
+        {
+            if(strncmp(mnt_data_array[j].mnt_path, ref->name_record->name,
+                strlen(mnt_data_array[j].mnt_path)) == 0)
+            {
+                mnt_pt = mnt_data_array[j].mnt_path;
+                fs_type = mnt_data_array[j].mnt_type;
+                break;
+            }
+        }
+
+        fprintf(fp, "%" PRIu64 ",", ref->name_record->id);
+        csv_print_string(fp, ref->name_record->name);
+        fputc(',', fp);
+        csv_print_string(fp, mnt_pt);
+        fputc(',', fp);
+        csv_print_string(fp, fs_type);
+        fputc('\n', fp);
+    }
+
+    return(table_close(fp, buf));
+}
+
+static int write_module_table(darshan_fd fd, int mod_id,
+    const struct darshan_counter_layout *layout, char *prefix, int binary,
+    char *mod_buf)
+{
+    struct darshan_base_record *base_rec;
+    struct table_bin_header hdr;
+    char suffix[64];
+    char *buf;
+    char *row = NULL;
+    int64_t *counters;
+    double *fcounters;
+    size_t row_size;
+    uint64_t nrows = 0;
+    FILE *fp;
+    int i;
+    int ret;
+
+    snprintf(suffix, sizeof(suffix), "%s.%s", darshan_module_names[mod_id],
+        binary ? "bin" : "csv");
+    fp = table_open(prefix, suffix, &buf);
+    if(!fp)
+        return(-1);
+
+    row_size = (2 + layout->ncounters + layout->nfcounters) * sizeof(int64_t);
+    if(binary)
+    {
+        row = malloc(row_size);
+        if(!row)
+        {
+            table_close(fp, buf);
+            return(-1);
+        }
+
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, TABLE_BIN_MAGIC, sizeof(hdr.magic));
+        hdr.version = TABLE_BIN_VERSION;
+        hdr.mod_id = mod_id;
+        hdr.mod_ver = layout->mod_ver;
+        hdr.ncounters = layout->ncounters;
+        hdr.nfcounters = layout->nfcounters;
+        hdr.row_size = row_size;
+        hdr.data_off = sizeof(hdr);
+        for(i = 0; i < layout->ncounters; i++)
+            hdr.data_off += strlen(layout->counter_names[i]) + 1;
+        for(i = 0; i < layout->nfcounters; i++)
+            hdr.data_off += strlen(layout->fcounter_names[i]) + 1;
+        hdr.data_off = (hdr.data_off + 7) & ~((uint64_t)7);
+
+        /* nrows is filled in once all records have been written */
+        fwrite(&hdr, sizeof(hdr), 1, fp);
+        for(i = 0; i < layout->ncounters; i++)
+            fwrite(layout->counter_names[i], strlen(layout->counter_names[i]) + 1, 1, fp);
+        for(i = 0; i < layout->nfcounters; i++)
+            fwrite(layout->fcounter_names[i], strlen(layout->fcounter_names[i]) + 1, 1, fp);
+        while(ftell(fp) < (long)hdr.data_off)
+            fputc('\0', fp);
+    }
+    else
+    {
+        fprintf(fp, "rank,record_id");
+        for(i = 0; i < layout->ncounters; i++)
+            fprintf(fp, ",%s", layout->counter_names[i]);
+        for(i = 0; i < layout->nfcounters; i++)
+            fprintf(fp, ",%s", layout->fcounter_names[i]);
+        fputc('\n', fp);
+    }
+
+    while((ret = mod_logutils[mod_id]->log_get_record(fd, (void **)&mod_buf)) > 0)
+    {
+        base_rec = (struct darshan_base_record *)mod_buf;
+        counters = (int64_t *)(mod_buf + layout->counters_off);
+        fcounters = (double *)(mod_buf + layout->fcounters_off);
+
+        if(binary)
+        {
+            memcpy(row, &base_rec->rank, sizeof(int64_t));
+            memcpy(row + sizeof(int64_t), &base_rec->id, sizeof(uint64_t));
+            memcpy(row + 2 * sizeof(int64_t), counters,
+                layout->ncounters * sizeof(int64_t));
+            memcpy(row + (2 + layout->ncounters) * sizeof(int64_t), fcounters,
+                layout->nfcounters * sizeof(double));
+            fwrite(row, row_size, 1, fp);
+        }
+        else
+        {
+            fprintf(fp, "%" PRId64 ",%" PRIu64, base_rec->rank, base_rec->id);
+            for(i = 0; i < layout->ncounters; i++)
+            {
+                if(i == layout->unsigned_counter)
+                    fprintf(fp, ",%" PRIu64, (uint64_t)counters[i]);
+                else
+                    fprintf(fp, ",%" PRId64, counters[i]);
+            }
+            for(i = 0; i < layout->nfcounters; i++)
+                fprintf(fp, ",%f", fcounters[i]);
+            fputc('\n', fp);
+        }
+        nrows++;
+    }
+    if(ret < 0)
+    {
+        fprintf(stderr, "Error: failed to parse %s module record.\n",
+            darshan_module_names[mod_id]);
+    }
+
+    if(binary)
+    {
+        hdr.nrows = nrows;
+        if(fseek(fp, 0, SEEK_SET) == 0)
+            fwrite(&hdr, sizeof(hdr), 1, fp);
+        else
+            ret = -1;
+        free(row);
+    }
+
+    if(table_close(fp, buf) < 0)
+        ret = -1;
+
+    return(ret < 0 ? -1 : 0);
+}
+
+/* write a table of record names and one table of records per module, as
+ * an alternative to the text output for consumption by other tools
+ */
+int write_record_tables(darshan_fd fd, struct darshan_name_record_ref *name_hash,
+    struct darshan_mnt_info *mnt_data_array, int mount_count, char *prefix,
+    int mask)
+{
+    const struct darshan_counter_layout *layout;
+    char *mod_buf;
+    int ret;
+    int i;
+
+    ret = write_name_table(name_hash, mnt_data_array, mount_count, prefix);
+    if(ret < 0)
+        return(-1);
+
+    mod_buf = malloc(DEF_MOD_BUF_SIZE);
+    if(!mod_buf)
+        return(-1);
+
+    for(i=0; i<DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(fd->mod_map[i].len == 0 || !mod_logutils[i])
+            continue;
+        /* DXT traces have a standalone parsing utility */
+        if(i == DXT_POSIX_MOD || i == DXT_MPIIO_MOD)
+            continue;
+
+        layout = darshan_log_get_counter_layout(i);
+        if(!layout)
+        {
+            fprintf(stderr, "# Warning: %s module records can not be written "
+                "as a table, SKIPPING.\n", darshan_module_names[i]);
+            continue;
+        }
+
+        if(DARSHAN_MOD_FLAG_ISSET(fd->partial_flag, i))
+        {
+            if(!(mask & OPTION_SHOW_INCOMPLETE))
+            {
+                fprintf(stderr, "\n# *ERROR*: "
+                       "The %s module contains incomplete data!\n"
+                       "# You can write the (incomplete) data that is\n"
+                       "# present in this log using the --show-incomplete\n"
+                       "# option to darshan-parser.\n",
+                       darshan_module_names[i]);
+                ret = -1;
+                break;
+            }
+            fprintf(stderr, "# *WARNING*: "
+                   "The %s module contains incomplete data!\n",
+                   darshan_module_names[i]);
+        }
+
+        memset(mod_buf, 0, DEF_MOD_BUF_SIZE);
+        ret = write_module_table(fd, i, layout, prefix,
+            (mask & OPTION_BINARY) != 0, mod_buf);
+        if(ret < 0)
+            break;
+    }
+
+    free(mod_buf);
+    return(ret);
+}
+
 /*
  * Local variables:
  *  c-indent-level: 4
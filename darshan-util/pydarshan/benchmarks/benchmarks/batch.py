@@ -0,0 +1,63 @@
+import importlib
+import os
+import shutil
+import time
+
+example_logs = importlib.import_module("darshan.examples.example_logs")
+import darshan
+import darshan.batch
+from darshan.backend.cffi_backend import accumulate_records
+from darshan.log_utils import get_log_path
+
+
+class BatchDerivedMetrics:
+    # a directory of copies of two small logs, standing in
+    # for the logs of many jobs
+    nlogs = 1000
+    timeout = 300
+
+    params = [[1, 4]]
+    param_names = ['processes']
+
+    def setup_cache(self):
+        logdir = os.path.abspath("batch-logs")
+        if os.path.exists(logdir):
+            shutil.rmtree(logdir)
+        os.makedirs(logdir)
+        srcs = [get_log_path("sample.darshan"),
+                example_logs.example_data_files_dxt["ior_hdf5_example.darshan"]]
+        for i in range(self.nlogs):
+            src = srcs[i % len(srcs)]
+            shutil.copy(src, os.path.join(logdir, f"{i}-{os.path.basename(src)}"))
+        return logdir
+
+    def time_batch_derived_metrics(self, logdir, processes):
+        # derived metrics of all modules of all logs
+        darshan.batch.derived_metrics(logdir, processes=processes)
+
+    def track_batch_logs_per_second(self, logdir, processes):
+        start = time.perf_counter()
+        darshan.batch.derived_metrics(logdir, processes=processes)
+        return self.nlogs / (time.perf_counter() - start)
+    track_batch_logs_per_second.unit = "logs/s"
+
+    def peakmem_batch_derived_metrics(self, logdir, processes):
+        darshan.batch.derived_metrics(logdir, processes=processes)
+
+
+class ReportLoopDerivedMetrics:
+    # the same derived metrics, computed one report at a time;
+    # the baseline for BatchDerivedMetrics
+    nlogs = 100
+
+    def setup(self):
+        self.logs = [get_log_path("sample.darshan"),
+                     example_logs.example_data_files_dxt["ior_hdf5_example.darshan"]]
+
+    def time_report_loop_derived_metrics(self):
+        for i in range(self.nlogs):
+            with darshan.DarshanReport(self.logs[i % 2], read_all=True) as report:
+                for mod in darshan.batch.ACCUMULATOR_MODULES:
+                    if mod in report.records:
+                        accumulate_records(report.records[mod].to_df(), mod,
+                                           report.metadata['job']['nprocs'])
@@ -1,6 +1,7 @@
 import os
 import importlib
 
+import numpy as np
 import pandas as pd
 
 import darshan
@@ -74,3 +75,32 @@ class GetHeatMapDf:
 
     def peakmem_get_heatmap_df(self, unique_ranks, bin_count, density):
         heatmap_handling.get_heatmap_df(self.agg_df, xbins=bin_count, nprocs=unique_ranks)
+
+
+class GetHeatMapDfLarge:
+    params = [[1000, 100000], [10**5, 10**7]]
+    param_names = ['unique_ranks', 'n_segments']
+
+
+    def setup(self, unique_ranks, n_segments):
+        # randomly placed events of varying duration, some of
+        # which span many bins
+        rng = np.random.default_rng(0)
+        start_time = rng.random(n_segments) * 100
+        self.agg_data = {'length': rng.integers(1, 1 << 20, n_segments),
+                         'start_time': start_time,
+                         'end_time': start_time + rng.exponential(0.5, n_segments),
+                         'rank': rng.integers(0, unique_ranks, n_segments),
+                        }
+
+
+    def time_get_heatmap_df_large(self, unique_ranks, n_segments):
+        # benchmark binning of DXT-scale event counts
+        # directly from the event arrays
+        heatmap_handling.get_heatmap_df(self.agg_data, xbins=200,
+                                        nprocs=unique_ranks, max_time=100.0)
+
+
+    def peakmem_get_heatmap_df_large(self, unique_ranks, n_segments):
+        heatmap_handling.get_heatmap_df(self.agg_data, xbins=200,
+                                        nprocs=unique_ranks, max_time=100.0)
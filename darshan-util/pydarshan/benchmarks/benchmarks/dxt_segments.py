@@ -0,0 +1,59 @@
+import os
+import importlib
+
+import darshan.backend.cffi_backend as backend
+example_logs = importlib.import_module("darshan.examples.example_logs")
+from darshan.tests.input import test_data_files_dxt
+
+
+class DXTSegmentDecode:
+    params = [
+        ["examples/example-logs/dxt.darshan",
+         "tests/input/sample-dxt-simple.darshan",
+        ],
+        ["DXT_POSIX",
+         "DXT_MPIIO",
+        ],
+        ]
+    param_names = ['darshan_logfile', 'mod']
+
+    def setup(self, darshan_logfile, mod):
+        filename = os.path.basename(darshan_logfile)
+        if "examples" in darshan_logfile:
+            self.logfile = example_logs.example_data_files_dxt[filename]
+        else:
+            self.logfile = test_data_files_dxt[filename]
+
+    def _per_record(self, mod):
+        # the existing path: one dict per segment, per record
+        log = backend.log_open(self.logfile)
+        while backend.log_get_record(log, mod) is not None:
+            pass
+        backend.log_close(log)
+
+    def _per_record_pandas(self, mod):
+        log = backend.log_open(self.logfile)
+        while backend.log_get_dxt_record(log, mod, dtype="pandas") is not None:
+            pass
+        backend.log_close(log)
+
+    def _bulk(self, mod):
+        # all segments of the module decoded into NumPy arrays in C
+        log = backend.log_open(self.logfile)
+        backend.log_get_dxt_segments(log, mod)
+        backend.log_close(log)
+
+    def time_per_record(self, darshan_logfile, mod):
+        self._per_record(mod)
+
+    def time_per_record_pandas(self, darshan_logfile, mod):
+        self._per_record_pandas(mod)
+
+    def time_bulk(self, darshan_logfile, mod):
+        self._bulk(mod)
+
+    def peakmem_per_record(self, darshan_logfile, mod):
+        self._per_record(mod)
+
+    def peakmem_bulk(self, darshan_logfile, mod):
+        self._bulk(mod)
@@ -4,6 +4,9 @@ import os
 example_logs = importlib.import_module("darshan.examples.example_logs")
 from darshan.tests.input import test_data_files_dxt, test_data_files
 import darshan
+from darshan.backend import cffi_backend as backend
+from darshan.backend.cffi_backend import ffi, libdutil
+import numpy as np
 
 
 class ModReadAllRecords:
@@ -36,6 +39,63 @@ class ModReadAllRecords:
 
 
 
+class ModReadAllRecordsLarge:
+    # a synthetic log with one million POSIX records, built by tiling the
+    # POSIX records of an example log
+    nrecs = 1000000
+    timeout = 300
+
+    params = [['numpy', 'pandas']]
+    param_names = ['dtype']
+
+    def setup_cache(self):
+        src = backend.log_open(example_logs.example_data_files_dxt["ior_hdf5_example.darshan"])
+        modules = backend.log_get_modules(src)
+        mod_idx = modules['POSIX']['idx']
+        mod_ver = modules['POSIX']['ver']
+        job = ffi.new("struct darshan_job *")
+        libdutil.darshan_log_get_job(src['handle'], job)
+        matrix = backend.log_get_record_matrix(src, 'POSIX')
+        backend.log_close(src)
+
+        nsrc = len(matrix['id'])
+        recs = np.recarray(shape=self.nrecs,
+                           dtype=[("id", "<u8"),
+                                  ("rank", "<i8"),
+                                  ("counters", "<i8", (matrix['counters'].shape[1],)),
+                                  ("fcounters", "<f8", (matrix['fcounters'].shape[1],))])
+        recs.id = np.arange(1, self.nrecs + 1, dtype=np.uint64)
+        recs.rank = np.arange(self.nrecs) % job.nprocs
+        recs.counters = np.tile(matrix['counters'], (self.nrecs // nsrc + 1, 1))[:self.nrecs]
+        recs.fcounters = np.tile(matrix['fcounters'], (self.nrecs // nsrc + 1, 1))[:self.nrecs]
+
+        logfile = os.path.abspath("synthetic-1M.darshan")
+        if os.path.exists(logfile):
+            os.unlink(logfile)
+        log = libdutil.darshan_log_create(logfile.encode(), 0, 0)
+        libdutil.darshan_log_put_job(log, job)
+        libdutil.darshan_log_put_exe(log, b"synthetic")
+        libdutil.darshan_log_put_mounts(log, ffi.NULL, 0)
+        libdutil.darshan_log_put_namehash(log, ffi.NULL)
+        chunk = 65536
+        for i in range(0, self.nrecs, chunk):
+            buf = recs[i:i + chunk].tobytes()
+            libdutil.darshan_log_put_mod(log, mod_idx, ffi.from_buffer(buf),
+                                         len(buf), mod_ver)
+        libdutil.darshan_log_close(log)
+        return logfile
+
+    def setup(self, logfile, dtype):
+        self.report = darshan.DarshanReport(logfile, read_all=False,
+                                            lookup_name_records=False)
+
+    def time_mod_read_all_records(self, logfile, dtype):
+        self.report.mod_read_all_records(mod="POSIX", dtype=dtype)
+
+    def peakmem_mod_read_all_records(self, logfile, dtype):
+        self.report.mod_read_all_records(mod="POSIX", dtype=dtype)
+
+
 class ModReadAllDXTRecords:
 
     params = [['numpy', 'dict', 'pandas'],
@@ -58,8 +58,11 @@ typedef struct darshan_accumulator_st* darshan_accumulator;
  */
 int darshan_accumulator_create(int darshan_module_id, int64_t, darshan_accumulator*);
 int darshan_accumulator_inject(darshan_accumulator, void*, int);
+int darshan_accumulator_set_threads(darshan_accumulator, int);
+int darshan_accumulator_merge(darshan_accumulator, darshan_accumulator);
 int darshan_accumulator_emit(darshan_accumulator, struct darshan_derived_metrics*, void* aggregation_record);
 int darshan_accumulator_destroy(darshan_accumulator);
+int darshan_log_accumulate_module(void*, int, struct darshan_derived_metrics*, void*);
 
 /* from darshan-log-format.h */
 typedef uint64_t darshan_record_id;
@@ -158,6 +161,10 @@ struct darshan_heatmap_record
     struct darshan_base_record base_rec;
     double  bin_width_seconds; /* time duration of each bin */
     int64_t nbins;             /* number of bins */
+    double  start_time_seconds; /* start time of first bin */
+    int64_t nranks;            /* number of ranks in a rank matrix (0 if not a matrix) */
+    int64_t write_quantum;     /* bytes per unit of a quantized write bin */
+    int64_t read_quantum;      /* bytes per unit of a quantized read bin */
     int64_t *write_bins;       /* pointer to write bin array (trails struct in log */
     int64_t *read_bins;        /* pointer to read bin array (trails write bin array in log */
 };
@@ -179,6 +186,59 @@ typedef struct segment_info {
     double end_time;
 } segment_info;
 
+struct dxt_segment_arrays
+{
+    int64_t nrecs;
+    darshan_record_id *rec_ids;
+    int64_t count;
+    int64_t *rec_index;
+    int64_t *rank;
+    int64_t *offset;
+    int64_t *length;
+    double *start_time;
+    double *end_time;
+    int8_t *op;
+};
+
+struct darshan_name_index
+{
+    char *buf;
+    int64_t buf_len;
+    int64_t count;
+    darshan_record_id *ids;
+    int64_t *offsets;
+    void *id_hash;
+};
+
+struct darshan_record_matrix
+{
+    int mod_id;
+    int64_t nrecs;
+    int ncounters;
+    int nfcounters;
+    darshan_record_id *ids;
+    int64_t *ranks;
+    int64_t *counters;
+    double *fcounters;
+    darshan_record_id *file_rec_ids;
+};
+
+struct dxt_conflict_file
+{
+    darshan_record_id rec_id;
+    int mod_id;
+    int64_t write_count;
+    int64_t read_count;
+    int64_t write_bytes;
+    int64_t unique_write_bytes;
+    int64_t overlap_write_bytes;
+    int64_t max_write_offset;
+    double coverage;
+    int64_t overlapping_writes;
+    int64_t raw_reads;
+    int64_t raw_races;
+};
+
 /* counter names */
 extern char *bgq_counter_names[];
 extern char *bgq_f_counter_names[];
@@ -208,12 +268,24 @@ void darshan_log_get_modules(void*, struct darshan_mod_info **, int*);
 int darshan_log_get_record(void*, int, void **);
 char* darshan_log_get_lib_version(void);
 int darshan_log_get_job_runtime(void *, struct darshan_job job, double *runtime);
+void* darshan_log_create(char *, int, int);
+int darshan_log_put_job(void *, struct darshan_job *);
+int darshan_log_put_exe(void*, char *);
+int darshan_log_put_mounts(void*, struct darshan_mnt_info *, int);
+int darshan_log_put_namehash(void*, struct darshan_name_record_ref *);
+int darshan_log_put_mod(void*, int, void *, int, int);
 void darshan_free(void *);
+void free(void *);
+int darshan_log_get_record_matrix(void*, int, struct darshan_record_matrix *);
+int dxt_conflicts_analyze(void*, struct dxt_conflict_file **, int*);
+int dxt_log_get_segment_arrays(void*, int, struct dxt_segment_arrays *);
 
 int darshan_log_get_namehash(void*, struct darshan_name_record_ref **hash);
 
 void darshan_log_get_name_records(void*, struct darshan_name_record **, int*);
 void darshan_log_get_filtered_name_records(void*, struct darshan_name_record **, int*, darshan_record_id*, int);
+int darshan_log_get_name_index(void*, struct darshan_name_index *, darshan_record_id*, int);
+void darshan_name_index_free(struct darshan_name_index *);
 
 """
 
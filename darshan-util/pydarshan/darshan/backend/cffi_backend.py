@@ -50,6 +50,10 @@ ffi.cdef(API_def_c)
 libdutil = None
 libdutil = find_utils(ffi, libdutil)
 
+# the C library, which (unlike libdarshan-util) is never unloaded, even
+# while objects are still being collected at interpreter shutdown
+libc = ffi.dlopen(None)
+
 check_version(ffi, libdutil)
 
 
@@ -246,6 +250,80 @@ def log_get_modules(log):
     return modules
 
 
+def log_get_name_index(log, ids=None):
+    """
+    Returns the name records of a log, inflated in one call into a single
+    buffer that the names are referenced from in place.
+
+    Args:
+        log: handle returned by darshan.open
+        ids: record ids to keep (default: all name records)
+
+    Return:
+        dict: ``id`` holds the record id of each name, in log order, and
+        ``offset`` and ``length`` the position of the name in ``data``, a
+        uint8 array over the inflated name record region.
+    """
+
+    if ids is None:
+        whitelist = ffi.NULL
+        whitelist_cnt = 0
+    else:
+        whitelist_ids = np.fromiter(ids, dtype=np.uint64)
+        whitelist = ffi.cast("darshan_record_id *", ffi.from_buffer(whitelist_ids))
+        whitelist_cnt = len(whitelist_ids)
+
+    index = ffi.new("struct darshan_name_index *")
+    r = libdutil.darshan_log_get_name_index(log['handle'], index,
+                                            whitelist, whitelist_cnt)
+    if r != 0:
+        raise RuntimeError("A nonzero exit code was received from "
+                           "darshan_log_get_name_index() at the C level. "
+                           "It may be possible "
+                           "to retrieve additional information from the stderr "
+                           "stream.")
+
+    # the offsets follow the ids in the same allocation, so the buffer and
+    # the ids are all there is to free
+    count = index.count
+    data = _wrap_c_array(index.buf, index.buf_len, "char", np.uint8)
+    ids_offsets = _wrap_c_array(index.ids, 2 * count, "int64_t", np.int64)
+    offsets = ids_offsets[count:]
+
+    # each name ends at the first null byte at or after its offset
+    nuls = np.flatnonzero(data == 0)
+    lengths = nuls[np.searchsorted(nuls, offsets)] - offsets
+
+    return {
+        "id": ids_offsets[:count].view(np.uint64),
+        "offset": offsets,
+        "length": lengths,
+        "data": data,
+    }
+
+
+def name_index_to_dict(index):
+    """
+    Decodes the names of a name index (see ``log_get_name_index()``) into
+    a dictionary mapping record ids to names, keeping the first name of an
+    id that appears more than once.
+    """
+    data = index["data"].tobytes()
+    ids = index["id"].tolist()
+    starts = index["offset"].tolist()
+    ends = (index["offset"] + index["length"]).tolist()
+
+    name_records = {rec_id: data[start:end].decode("utf-8")
+                    for rec_id, start, end in zip(ids, starts, ends)}
+    if len(name_records) != len(ids):
+        name_records = {}
+        for rec_id, start, end in zip(ids, starts, ends):
+            if rec_id not in name_records:
+                name_records[rec_id] = data[start:end].decode("utf-8")
+
+    return name_records
+
+
 def log_get_name_records(log):
     """
     Return a dictionary resovling hash to string (typically a filepath).
@@ -262,17 +340,7 @@ def log_get_name_records(log):
     if log['name_records'] != None:
         return log['name_records']
 
-
-    name_records = {}
-
-    nrecs = ffi.new("struct darshan_name_record **")
-    cnt = ffi.new("int *")
-    libdutil.darshan_log_get_name_records(log['handle'], nrecs, cnt)
-
-    for i in range(0, cnt[0]):
-        name_records[nrecs[0][i].id] = ffi.string(nrecs[0][i].name).decode("utf-8")
-        libdutil.darshan_free(nrecs[0][i].name)
-    libdutil.darshan_free(nrecs[0])
+    name_records = name_index_to_dict(log_get_name_index(log))
 
     # add to cache
     log['name_records'] = name_records
@@ -293,22 +361,7 @@ def log_lookup_name_records(log, ids=[]):
         dict: the name records
     """
 
-    name_records = {}
-
-    #cids = ffi.new("darshan_record_id *") * len(ids)
-    whitelist = (ctypes.c_ulonglong * len(ids))(*ids)
-    whitelist_cnt = len(ids)
-
-    whitelistp = ffi.from_buffer(whitelist)
-
-    nrecs = ffi.new("struct darshan_name_record **")
-    cnt = ffi.new("int *")
-    libdutil.darshan_log_get_filtered_name_records(log['handle'], nrecs, cnt, ffi.cast("darshan_record_id *", whitelistp), whitelist_cnt)
-
-    for i in range(0, cnt[0]):
-        name_records[nrecs[0][i].id] = ffi.string(nrecs[0][i].name).decode("utf-8")
-        libdutil.darshan_free(nrecs[0][i].name)
-    libdutil.darshan_free(nrecs[0])
+    name_records = name_index_to_dict(log_get_name_index(log, ids))
 
     # add to cache
     log['name_records'] = name_records
@@ -318,7 +371,6 @@ def log_lookup_name_records(log, ids=[]):
 
 
 
-
 def log_get_record(log, mod, dtype='numpy'):
     """
     Standard entry point fetch records via mod string.
@@ -381,6 +433,53 @@ def log_get_generic_record(log, mod_name, dtype='numpy'):
 
     return rec
 
+def log_get_record_matrix(log, mod_name):
+    """
+    Returns all (remaining) records of a module, read in a single call
+    into one counter matrix and one fcounter matrix with a row per record.
+
+    Args:
+        log: Handle returned by darshan.open
+        mod_name (str): Name of the Darshan module
+
+    Return:
+        dict: ``id`` and ``rank`` hold one entry per record, ``counters``
+        and ``fcounters`` are 2-D arrays of shape (records, counters),
+        and ``file_rec_id`` is included for H5D and PNETCDF_VAR.  None is
+        returned if the module is not present in the log.
+
+    """
+    modules = log_get_modules(log)
+    if mod_name not in modules:
+        return None
+
+    matrix = ffi.new("struct darshan_record_matrix *")
+    r = libdutil.darshan_log_get_record_matrix(log['handle'],
+                                               modules[mod_name]['idx'],
+                                               matrix)
+    if r != 0:
+        raise RuntimeError("A nonzero exit code was received from "
+                           "darshan_log_get_record_matrix() at the C level. "
+                           "It may be possible "
+                           "to retrieve additional information from the stderr "
+                           "stream.")
+
+    nrecs = matrix.nrecs
+    ncols = matrix.ncounters
+    nfcols = matrix.nfcounters
+    ret = {
+        "id": _wrap_c_array(matrix.ids, nrecs, "darshan_record_id", np.uint64),
+        "rank": _wrap_c_array(matrix.ranks, nrecs, "int64_t", np.int64),
+        "counters": _wrap_c_array(matrix.counters, nrecs * ncols,
+                                  "int64_t", np.int64).reshape(nrecs, ncols),
+        "fcounters": _wrap_c_array(matrix.fcounters, nrecs * nfcols,
+                                   "double", np.float64).reshape(nrecs, nfcols),
+    }
+    if mod_name == 'H5D' or mod_name == 'PNETCDF_VAR':
+        ret["file_rec_id"] = _wrap_c_array(matrix.file_rec_ids, nrecs,
+                                           "darshan_record_id", np.uint64)
+    return ret
+
 def _make_generic_record(rbuf, mod_name, dtype='numpy'):
     """
     Returns a record dictionary for an input record buffer for a given module.
@@ -555,14 +654,103 @@ def _log_get_lustre_record(log, dtype='numpy'):
 
 
 
-def log_get_dxt_record(log, mod_name, reads=True, writes=True, dtype='dict'):
+_dxt_segment_dtype = np.dtype([("offset", np.int64),
+                               ("length", np.int64),
+                               ("start_time", np.float64),
+                               ("end_time", np.float64)])
+
+
+class LazyDXTRecord(dict):
+    """
+    A DXT record whose ``write_segments`` and ``read_segments`` are only
+    built, from a compact copy of the record's segment array, when one of
+    them is first accessed.  The other record fields are available
+    without decoding any segments.  Segments excluded by ``reads`` or
+    ``writes`` are left empty, as for non-lazy records.
+    """
+
+    def __init__(self, rec, segments, dtype, reads=True, writes=True):
+        super().__init__(rec)
+        self._segments = segments
+        self._dtype = dtype
+        self._reads = reads
+        self._writes = writes
+
+    def _materialize(self):
+        if self._segments is None:
+            return
+        segments, self._segments = self._segments, None
+        wcnt = dict.__getitem__(self, 'write_count')
+        for key, part in (('write_segments', segments[:wcnt] if self._writes else segments[:0]),
+                          ('read_segments', segments[wcnt:] if self._reads else segments[:0])):
+            segs = [dict(zip(_dxt_segment_dtype.names, seg)) for seg in part.tolist()]
+            if self._dtype == "pandas":
+                segs = pd.DataFrame(segs)
+            dict.__setitem__(self, key, segs)
+
+    def __missing__(self, key):
+        if key in ('write_segments', 'read_segments') and self._segments is not None:
+            self._materialize()
+            return dict.__getitem__(self, key)
+        raise KeyError(key)
+
+    def __contains__(self, key):
+        self._materialize()
+        return super().__contains__(key)
+
+    def __iter__(self):
+        self._materialize()
+        return super().__iter__()
+
+    def __len__(self):
+        self._materialize()
+        return super().__len__()
+
+    def __repr__(self):
+        self._materialize()
+        return super().__repr__()
+
+    def __eq__(self, other):
+        self._materialize()
+        return super().__eq__(other)
+
+    def __reduce_ex__(self, protocol):
+        # copies and pickles are plain dictionaries
+        self._materialize()
+        return (dict, (dict(self),))
+
+    def get(self, key, default=None):
+        self._materialize()
+        return super().get(key, default)
+
+    def keys(self):
+        self._materialize()
+        return super().keys()
+
+    def values(self):
+        self._materialize()
+        return super().values()
+
+    def items(self):
+        self._materialize()
+        return super().items()
+
+    def copy(self):
+        self._materialize()
+        return dict(self)
+
+
+def log_get_dxt_record(log, mod_name, reads=True, writes=True, dtype='dict', lazy=False):
     """
     Returns a dictionary holding a dxt darshan log record.
 
     Args:
         log: Handle returned by darshan.open
         mod_name (str): Name of the Darshan module
-        mod_type (str): String containing the C type
+        reads (bool): include the read segments (otherwise left empty)
+        writes (bool): include the write segments (otherwise left empty)
+        lazy (bool): return a ``LazyDXTRecord`` that only decodes its
+            segments when they are first accessed
 
     Return:
         dict: generic log record
@@ -601,16 +789,23 @@ def log_get_dxt_record(log, mod_name, reads=True, writes=True, dtype='dict'):
 
     rec['write_count'] = wcnt
     rec['read_count'] = rcnt
+
+    size_of = ffi.sizeof("struct dxt_file_record")
+    if lazy:
+        segments = np.frombuffer(ffi.buffer(buf[0] + size_of,
+                                            (wcnt + rcnt) * _dxt_segment_dtype.itemsize),
+                                 dtype=_dxt_segment_dtype).copy()
+        libdutil.darshan_free(buf[0])
+        return LazyDXTRecord(rec, segments, dtype, reads=reads, writes=writes)
  
     rec['write_segments'] = []
     rec['read_segments'] = []
 
 
-    size_of = ffi.sizeof("struct dxt_file_record")
     segments = ffi.cast("struct segment_info *", buf[0] + size_of  )
 
 
-    for i in range(wcnt):
+    for i in range(wcnt if writes else 0):
         seg = {
             "offset": segments[i].offset,
             "length": segments[i].length,
@@ -620,7 +815,7 @@ def log_get_dxt_record(log, mod_name, reads=True, writes=True, dtype='dict'):
         rec['write_segments'].append(seg)
 
 
-    for i in range(rcnt):
+    for i in range(rcnt if reads else 0):
         i = i + wcnt
         seg = {
             "offset": segments[i].offset,
@@ -639,6 +834,114 @@ def log_get_dxt_record(log, mod_name, reads=True, writes=True, dtype='dict'):
     return rec
 
 
+def _wrap_c_array(ptr, count, ctype, dtype):
+    """
+    Wraps a malloc'd C array in a NumPy array without copying it; the
+    C memory is freed once the NumPy array (and any views of it) are gone.
+    """
+    if ptr == ffi.NULL:
+        return np.empty(0, dtype=dtype)
+    # darshan_free() is a plain free(), but libdarshan-util may already be
+    # unloaded when arrays still alive at exit are collected
+    ptr = ffi.gc(ptr, libc.free)
+    return np.frombuffer(ffi.buffer(ptr, count * ffi.sizeof(ctype)),
+                         dtype=dtype)
+
+
+def log_get_dxt_segments(log, mod_name):
+    """
+    Returns all DXT segments of a module, decoded in bulk into one NumPy
+    array per field.
+
+    Args:
+        log: Handle returned by darshan.open, whose records of this
+             module have not been read yet
+        mod_name (str): Name of the Darshan module (DXT_POSIX or DXT_MPIIO)
+
+    Return:
+        dict: ``id`` holds the record id of each record, in log order.
+        ``rec_index`` (index into ``id``), ``rank``, ``offset``,
+        ``length``, ``start_time``, ``end_time`` and ``op`` (1 for
+        writes, 2 for reads) hold the fields of each segment, grouped by
+        record with writes first.  None is returned if the module is
+        not present in the log.
+    """
+    modules = log_get_modules(log)
+    if mod_name not in modules:
+        return None
+
+    arrays = ffi.new("struct dxt_segment_arrays *")
+    r = libdutil.dxt_log_get_segment_arrays(log['handle'],
+                                            modules[mod_name]['idx'],
+                                            arrays)
+    if r != 0:
+        raise RuntimeError("A nonzero exit code was received from "
+                           "dxt_log_get_segment_arrays() at the C level. "
+                           "It may be possible "
+                           "to retrieve additional information from the stderr "
+                           "stream.")
+
+    count = arrays.count
+    segs = {
+        "id": _wrap_c_array(arrays.rec_ids, arrays.nrecs,
+                            "darshan_record_id", np.uint64),
+        "rec_index": _wrap_c_array(arrays.rec_index, count, "int64_t", np.int64),
+        "rank": _wrap_c_array(arrays.rank, count, "int64_t", np.int64),
+        "offset": _wrap_c_array(arrays.offset, count, "int64_t", np.int64),
+        "length": _wrap_c_array(arrays.length, count, "int64_t", np.int64),
+        "start_time": _wrap_c_array(arrays.start_time, count, "double", np.float64),
+        "end_time": _wrap_c_array(arrays.end_time, count, "double", np.float64),
+        "op": _wrap_c_array(arrays.op, count, "int8_t", np.int8),
+    }
+    return segs
+
+
+def log_get_dxt_conflicts(log):
+    """
+    Analyzes how the DXT segments of different ranks overlap for each
+    traced file, using the DXT POSIX and MPI-IO records of a log.
+
+    Args:
+        log: Handle returned by darshan.open, whose DXT records
+             have not been read yet
+
+    Return:
+        pandas.DataFrame: one row per traced file and DXT module, with
+        write/read segment counts, bytes written (in total, at least
+        once, and by more than one rank), the furthest write offset and
+        fraction of the file up to it that was written, the number of
+        writes overlapping a write from another rank, and the number of
+        reads overlapping an earlier (``raw_reads``) or concurrent
+        (``raw_races``) write from another rank.
+    """
+    files = ffi.new("struct dxt_conflict_file **")
+    cnt = ffi.new("int *")
+    r = libdutil.dxt_conflicts_analyze(log['handle'], files, cnt)
+    if r != 0:
+        raise RuntimeError("A nonzero exit code was received from "
+                           "dxt_conflicts_analyze() at the C level. "
+                           "It may be possible "
+                           "to retrieve additional information from the stderr "
+                           "stream.")
+
+    columns = ["write_count", "read_count", "write_bytes",
+               "unique_write_bytes", "overlap_write_bytes",
+               "max_write_offset", "coverage", "overlapping_writes",
+               "raw_reads", "raw_races"]
+    rows = []
+    for i in range(cnt[0]):
+        f = files[0][i]
+        row = {"module": _mod_names[f.mod_id], "id": f.rec_id}
+        for col in columns:
+            row[col] = getattr(f, col)
+        rows.append(row)
+    libdutil.darshan_free(files[0])
+
+    df = pd.DataFrame(rows, columns=["module", "id"] + columns)
+    df["id"] = df["id"].astype(np.uint64)
+    return df
+
+
 def _log_get_heatmap_record(log):
     """
     Returns a dictionary holding a heatmap darshan log record.
@@ -674,14 +977,23 @@ def _log_get_heatmap_record(log):
     
     rec['bin_width_seconds'] = bin_width_seconds
     rec['nbins'] = nbins
+    rec['start_time_seconds'] = filerec[0].start_time_seconds
+
+    # rank matrices hold 'nranks' rows of bins for consecutive ranks
+    # starting at 'rank'; other heatmap records hold a single row
+    nranks = filerec[0].nranks
+    rec['nranks'] = nranks
+    nvals = nbins * max(nranks, 1)
 
     # write/read bins
     sizeof_64 = ffi.sizeof("int64_t")
     
-    write_bins = np.copy(np.frombuffer(ffi.buffer(filerec[0].write_bins, sizeof_64*nbins), dtype = np.int64))
+    write_bins = np.copy(np.frombuffer(ffi.buffer(filerec[0].write_bins, sizeof_64*nvals), dtype = np.int64))
+    read_bins = np.copy(np.frombuffer(ffi.buffer(filerec[0].read_bins, sizeof_64*nvals), dtype = np.int64))
+    if nranks > 0:
+        write_bins = write_bins.reshape(nranks, nbins)
+        read_bins = read_bins.reshape(nranks, nbins)
     rec['write_bins'] = write_bins
-
-    read_bins = np.copy(np.frombuffer(ffi.buffer(filerec[0].read_bins, sizeof_64*nbins), dtype = np.int64))
     rec['read_bins'] = read_bins
     libdutil.darshan_free(buf[0])
     
@@ -741,20 +1053,11 @@ def _df_to_rec(rec_dict, mod_name, rec_index_of_interest=None):
     return buf
 
 
-def accumulate_records(rec_dict, mod_name, nprocs):
+def _accumulate_buffer(record_array, num_recs, mod_name, nprocs):
     """
-    Passes a set of records (in pandas format) to the Darshan accumulator
-    interface, and returns the corresponding derived metrics struct and
-    summary record.
-
-    Parameters:
-        rec_dict: Dictionary containing the counter and fcounter dataframes.
-        mod_name: Name of the Darshan module.
-        nprocs: Number of processes participating in accumulation.
-
-    Returns:
-        namedtuple containing derived_metrics (cdata object) and
-        summary_record (dict).
+    Passes a C buffer of packed records to the Darshan accumulator
+    interface, and returns the derived metrics struct and the summary
+    record buffer.
     """
     mod_idx = mod_name_to_idx(mod_name)
     darshan_accumulator = ffi.new("darshan_accumulator *")
@@ -768,11 +1071,9 @@ def accumulate_records(rec_dict, mod_name, nprocs):
                            "to retrieve additional information from the stderr "
                            "stream.")
 
-    num_recs = rec_dict["fcounters"].shape[0]
-    record_array = _df_to_rec(rec_dict, mod_name)
-
     r_i = libdutil.darshan_accumulator_inject(darshan_accumulator[0], record_array, num_recs)
     if r_i != 0:
+        libdutil.darshan_accumulator_destroy(darshan_accumulator[0])
         raise RuntimeError("A nonzero exit code was received from "
                            "darshan_accumulator_inject() at the C level. "
                            "It may be possible "
@@ -790,9 +1091,71 @@ def accumulate_records(rec_dict, mod_name, nprocs):
                            "It may be possible "
                            "to retrieve additional information from the stderr "
                            "stream.")
+    return derived_metrics, summary_rbuf
+
+
+def accumulate_records(rec_dict, mod_name, nprocs):
+    """
+    Passes a set of records (in pandas format) to the Darshan accumulator
+    interface, and returns the corresponding derived metrics struct and
+    summary record.
+
+    Parameters:
+        rec_dict: Dictionary containing the counter and fcounter dataframes.
+        mod_name: Name of the Darshan module.
+        nprocs: Number of processes participating in accumulation.
+
+    Returns:
+        namedtuple containing derived_metrics (cdata object) and
+        summary_record (dict).
+    """
+    num_recs = rec_dict["fcounters"].shape[0]
+    record_array = _df_to_rec(rec_dict, mod_name)
+    derived_metrics, summary_rbuf = _accumulate_buffer(record_array, num_recs,
+                                                       mod_name, nprocs)
 
     summary_rec = _make_generic_record(summary_rbuf, mod_name, dtype='pandas')
 
     # create namedtuple type to hold return values
     AccumulatedRecords = namedtuple("AccumulatedRecords", ['derived_metrics', 'summary_record'])
     return AccumulatedRecords(derived_metrics, summary_rec)
+
+
+def log_accumulate_module(log, mod_name):
+    """
+    Streams all records of a module straight from the log into the Darshan
+    accumulator interface at the C level, without decoding them in Python,
+    and returns the corresponding derived metrics struct and summary record.
+
+    Parameters:
+        log: Handle returned by darshan.open
+        mod_name: Name of the Darshan module.
+
+    Returns:
+        namedtuple containing derived_metrics (cdata object) and
+        summary_record (dict), or None if the module is not present
+        in the log.
+    """
+    modules = log_get_modules(log)
+    if mod_name not in modules:
+        return None
+
+    derived_metrics = ffi.new("struct darshan_derived_metrics *")
+    summary_rbuf = ffi.new(_structdefs[mod_name].replace("**", "*"))
+    r = libdutil.darshan_log_accumulate_module(log['handle'],
+                                               modules[mod_name]['idx'],
+                                               derived_metrics,
+                                               summary_rbuf)
+    if r != 0:
+        raise RuntimeError("A nonzero exit code was received from "
+                           "darshan_log_accumulate_module() at the C level. "
+                           f"This could mean that the {mod_name} module does not "
+                           "support derived metric calculation, or that "
+                           "another kind of error occurred. It may be possible "
+                           "to retrieve additional information from the stderr "
+                           "stream.")
+
+    summary_rec = _make_generic_record(summary_rbuf, mod_name, dtype='pandas')
+
+    AccumulatedRecords = namedtuple("AccumulatedRecords", ['derived_metrics', 'summary_record'])
+    return AccumulatedRecords(derived_metrics, summary_rec)
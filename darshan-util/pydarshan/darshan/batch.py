@@ -0,0 +1,201 @@
+"""
+Module for computing derived metrics over many logs at once.
+
+Each log is opened on its own, its module records are streamed straight
+into the darshan-util C accumulator, and only the resulting per-job
+metrics are sent back, so that fleet-wide statistics can be built from
+thousands of logs using a pool of worker processes.
+"""
+
+import os
+import glob
+import logging
+import concurrent.futures
+from typing import Any, Dict, List, Optional, Sequence, Union
+
+import pandas as pd
+
+import darshan.backend.cffi_backend as backend
+
+logger = logging.getLogger(__name__)
+
+# modules supported by the darshan-util accumulator interface
+ACCUMULATOR_MODULES = ["POSIX", "MPI-IO", "STDIO"]
+
+# names of the ``darshan_file_category`` counters, in C enum order
+FILE_CATEGORIES = ["all_files", "ro_files", "wo_files", "rw_files",
+                   "uniq_files", "shared_files", "part_shared_files"]
+
+CATEGORY_COUNTERS = ["count", "total_read_volume_bytes", "total_write_volume_bytes",
+                     "max_read_volume_bytes", "max_write_volume_bytes",
+                     "total_max_offset_bytes", "max_offset_bytes", "nprocs"]
+
+DERIVED_METRICS = ["total_bytes", "unique_io_total_time_by_slowest",
+                   "unique_rw_only_time_by_slowest", "unique_md_only_time_by_slowest",
+                   "unique_io_slowest_rank", "shared_io_total_time_by_slowest",
+                   "agg_perf_by_slowest", "agg_time_by_slowest"]
+
+
+def expand_log_paths(logs: Union[str, Sequence[str]]) -> List[str]:
+    """
+    Expands a log path, directory or glob pattern (or a sequence of them)
+    into a list of log paths.
+
+    Parameters
+    ----------
+    logs: log paths, directories (whose ``*.darshan`` files are used) or
+    glob patterns.
+
+    Returns
+    -------
+    log_paths: the log paths, in input order with patterns and directories
+    expanded in sorted order, and duplicates removed.
+
+    """
+    if isinstance(logs, (str, os.PathLike)):
+        logs = [logs]
+    log_paths = []  # type: List[str]
+    for log in logs:
+        log = os.fspath(log)
+        if os.path.isdir(log):
+            log_paths += sorted(glob.glob(os.path.join(log, "*.darshan")))
+        elif glob.has_magic(log):
+            log_paths += sorted(glob.glob(log, recursive=True))
+        else:
+            log_paths.append(log)
+    return list(dict.fromkeys(log_paths))
+
+
+def _derived_metrics_dict(derived_metrics: Any) -> Dict[str, Any]:
+    """
+    Converts a ``struct darshan_derived_metrics`` into a flat dictionary.
+    """
+    metrics = {name: getattr(derived_metrics, name) for name in DERIVED_METRICS}
+    for index, category in enumerate(FILE_CATEGORIES):
+        cat_counters = derived_metrics.category_counters[index]
+        for name in CATEGORY_COUNTERS:
+            metrics[f"{category}_{name}"] = getattr(cat_counters, name)
+    return metrics
+
+
+def log_derived_metrics(log_path: str,
+                        mods: Optional[Sequence[str]] = None) -> Dict[str, Dict[str, Any]]:
+    """
+    Computes the derived metrics of each module of a single log.
+
+    Parameters
+    ----------
+    log_path: path to a darshan log file.
+
+    mods: the modules to compute metrics for (default: all modules
+    of the log in ``ACCUMULATOR_MODULES``).
+
+    Returns
+    -------
+    metrics: dictionary mapping each module to a flat dictionary of the
+    job information and the derived metrics of the module.
+
+    Raises
+    ------
+    RuntimeError: if the log can not be opened or accumulated.
+
+    """
+    log = backend.log_open(log_path)
+    if not bool(log['handle']):
+        raise RuntimeError(f"Failed to open file {log_path}.")
+    try:
+        job = backend.log_get_job(log)
+        modules = backend.log_get_modules(log)
+        job_info = {
+            "log": log_path,
+            "jobid": job["jobid"],
+            "uid": job["uid"],
+            "nprocs": job["nprocs"],
+            "start_time": job["start_time_sec"],
+            "end_time": job["end_time_sec"],
+            "run_time": job["run_time"],
+            "exe": backend.log_get_exe(log),
+        }
+        metrics = {}
+        for mod in ACCUMULATOR_MODULES:
+            if mod not in modules or (mods is not None and mod not in mods):
+                continue
+            acc = backend.log_accumulate_module(log, mod)
+            metrics[mod] = dict(job_info, **_derived_metrics_dict(acc.derived_metrics))
+    finally:
+        backend.log_close(log)
+    return metrics
+
+
+def _try_log_derived_metrics(log_path: str, mods: Optional[Sequence[str]]):
+    # worker entry point: failures are sent back rather than
+    # aborting the whole batch
+    try:
+        return log_derived_metrics(log_path, mods), None
+    except Exception as e:
+        return None, f"{type(e).__name__}: {e}"
+
+
+def derived_metrics(logs: Union[str, Sequence[str]],
+                    mods: Optional[Sequence[str]] = None,
+                    processes: Optional[int] = None,
+                    chunksize: Optional[int] = None) -> Dict[str, pd.DataFrame]:
+    """
+    Computes the derived metrics of many logs in a pool of processes.
+
+    Parameters
+    ----------
+    logs: log paths, directories or glob patterns (see ``expand_log_paths()``).
+
+    mods: the modules to compute metrics for (default: ``ACCUMULATOR_MODULES``).
+
+    processes: number of worker processes (default: ``os.cpu_count()``);
+    with a single process the logs are read in the calling process.
+
+    chunksize: number of logs handed to a worker at a time (default:
+    chosen from the number of logs and processes).
+
+    Returns
+    -------
+    metrics: dictionary mapping each module found in any of the logs to
+    a ``pd.DataFrame`` with a row per log, holding the job information
+    (log path, jobid, uid, nprocs, start/end/run time, exe) followed by
+    the derived metrics of the module.  Logs that can not be read are
+    skipped with a warning.
+
+    Examples
+    --------
+    >>> import darshan.batch
+    >>> metrics = darshan.batch.derived_metrics("/path/to/logs/*.darshan")
+    >>> metrics["POSIX"][["jobid", "nprocs", "total_bytes", "agg_perf_by_slowest"]]
+
+    """
+    log_paths = expand_log_paths(logs)
+    if processes is None:
+        processes = os.cpu_count() or 1
+    processes = max(min(processes, len(log_paths)), 1)
+    mods_arg = [mods] * len(log_paths)
+
+    if processes == 1:
+        results = map(_try_log_derived_metrics, log_paths, mods_arg)
+        return _combine_metrics(log_paths, results, mods)
+
+    if chunksize is None:
+        chunksize = max(len(log_paths) // (4 * processes), 1)
+    with concurrent.futures.ProcessPoolExecutor(max_workers=processes) as executor:
+        results = executor.map(_try_log_derived_metrics, log_paths, mods_arg,
+                               chunksize=chunksize)
+        return _combine_metrics(log_paths, results, mods)
+
+
+def _combine_metrics(log_paths, results, mods) -> Dict[str, pd.DataFrame]:
+    rows = {mod: [] for mod in ACCUMULATOR_MODULES}  # type: Dict[str, List[Dict[str, Any]]]
+    for log_path, (metrics, error) in zip(log_paths, results):
+        if error is not None:
+            logger.warning(f" Skipping log {log_path}: {error}")
+            continue
+        for mod, mod_metrics in metrics.items():
+            rows[mod].append(mod_metrics)
+    return {mod: pd.DataFrame.from_records(mod_rows)
+            for mod, mod_rows in rows.items()
+            if mod_rows or (mods is not None and mod in mods)}
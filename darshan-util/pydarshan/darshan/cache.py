@@ -0,0 +1,229 @@
+"""
+Module for an opt-in on-disk cache of decoded log data.
+
+Decoded module record matrices, name records and DXT records are stored
+as plain ``.npy`` columns, so that later opens of an unchanged log can
+load them through ``np.load(mmap_mode=...)`` instead of inflating and
+parsing the log again.
+"""
+
+import os
+import json
+import hashlib
+import logging
+import tempfile
+from typing import Any, Dict, Optional
+
+import numpy as np
+
+logger = logging.getLogger(__name__)
+
+# bump whenever the layout of the cached columns changes
+CACHE_VERSION = 2
+
+# bytes at the start of a log hashed into the cache key; this covers the
+# darshan header, including the offsets and lengths of every log region
+HEADER_HASH_BYTES = 4096
+
+
+def default_cache_dir(log_path: str) -> str:
+    """
+    Returns the cache directory of a log, which is taken from the
+    ``DARSHAN_CACHE_DIR`` environment variable if set, or is a hidden
+    directory next to the log otherwise.
+
+    Parameters
+    ----------
+    log_path: path to a darshan log file.
+
+    Returns
+    -------
+    cache_dir: the directory holding the cache entries of this log.
+
+    """
+    log_path = os.path.abspath(log_path)
+    base_dir = os.environ.get("DARSHAN_CACHE_DIR")
+    if base_dir:
+        return _log_cache_subdir(base_dir, log_path)
+    log_dir, log_name = os.path.split(log_path)
+    return os.path.join(log_dir, f".{log_name}.pydarshan-cache")
+
+
+def _log_cache_subdir(base_dir: str, log_path: str) -> str:
+    path_hash = hashlib.sha1(log_path.encode()).hexdigest()[:16]
+    return os.path.join(base_dir, f"{os.path.basename(log_path)}-{path_hash}")
+
+
+def log_cache_key(log_path: str) -> str:
+    """
+    Returns the key identifying the current contents of a log: a hash of
+    its path, size, modification time and header.
+
+    Parameters
+    ----------
+    log_path: path to a darshan log file.
+
+    Returns
+    -------
+    key: hex digest identifying the log contents.
+
+    """
+    log_path = os.path.abspath(log_path)
+    st = os.stat(log_path)
+    key = hashlib.sha256()
+    key.update(f"{CACHE_VERSION}:{log_path}:{st.st_size}:{st.st_mtime_ns}:".encode())
+    with open(log_path, "rb") as f:
+        key.update(f.read(HEADER_HASH_BYTES))
+    return key.hexdigest()
+
+
+class LogCache(object):
+    """
+    The columnar cache of a single log.
+
+    Each cache entry (e.g., the ``POSIX`` record matrix) is a set of
+    ``<entry>.<column>.npy`` files in the log's cache directory (with the
+    entry and column names hex encoded, so that any name is a valid file
+    name), listed in a ``manifest.json`` together with the key of the log
+    they were decoded from.  Entries of a log whose key has changed are discarded.  Cached
+    columns are loaded copy-on-write memory mapped, so they can be
+    modified in memory without touching the cache.
+    """
+
+    def __init__(self, log_path: str, cache_dir: Optional[str] = None):
+        """
+        Args:
+            log_path (str): path to the darshan log to cache
+            cache_dir (str): directory to keep the cache entries of all
+                logs in (optional, see ``default_cache_dir()``)
+
+        Return:
+            None
+
+        """
+        self.log_path = os.path.abspath(log_path)
+        if cache_dir:
+            self.cache_dir = _log_cache_subdir(cache_dir, self.log_path)
+        else:
+            self.cache_dir = default_cache_dir(self.log_path)
+        self.key = log_cache_key(self.log_path)
+        self.writable = True
+        self._stale_checked = False
+        self._entries = self._read_manifest()
+
+
+    def _load_manifest(self) -> Dict[str, Any]:
+        try:
+            with open(os.path.join(self.cache_dir, "manifest.json")) as f:
+                return json.load(f)
+        except (OSError, ValueError):
+            return {}
+
+
+    def _read_manifest(self) -> Dict[str, Any]:
+        manifest = self._load_manifest()
+        if manifest.get("key") != self.key:
+            return {}
+        return manifest.get("entries", {})
+
+
+    def _column_path(self, entry: str, column: str) -> str:
+        # names such as "BG/Q" are not valid file names as is
+        return os.path.join(self.cache_dir,
+                            f"{entry.encode().hex()}.{column.encode().hex()}.npy")
+
+
+    def _replace_file(self, path: str, mode: str, write):
+        # write to a temporary file first, so readers never see a partial
+        # file, and don't leave it behind if anything fails
+        fd, tmp_path = tempfile.mkstemp(dir=self.cache_dir, suffix=".tmp")
+        try:
+            with os.fdopen(fd, mode) as f:
+                write(f)
+            os.replace(tmp_path, path)
+        except BaseException:
+            try:
+                os.unlink(tmp_path)
+            except OSError:
+                pass
+            raise
+
+
+    def _write_manifest(self):
+        manifest = {"version": CACHE_VERSION, "log": self.log_path,
+                    "key": self.key, "entries": self._entries}
+        self._replace_file(os.path.join(self.cache_dir, "manifest.json"), "w",
+                           lambda f: json.dump(manifest, f))
+
+
+    def _clear_stale(self):
+        # drop the columns decoded from an earlier version of the log
+        if self._stale_checked:
+            return
+        self._stale_checked = True
+        if self._load_manifest().get("key", self.key) == self.key:
+            return
+        for name in os.listdir(self.cache_dir):
+            if name.endswith(".npy"):
+                os.unlink(os.path.join(self.cache_dir, name))
+
+
+    def __contains__(self, entry: str) -> bool:
+        return entry in self._entries
+
+
+    def get(self, entry: str) -> Optional[Dict[str, np.ndarray]]:
+        """
+        Returns the columns of a cache entry, or None if the entry is not
+        cached (or can not be loaded).
+
+        Args:
+            entry (str): name of the cache entry
+
+        Return:
+            dict: column name to memory mapped array
+
+        """
+        if entry not in self._entries:
+            return None
+        columns = {}
+        try:
+            for column in self._entries[entry]:
+                columns[column] = np.load(self._column_path(entry, column),
+                                          mmap_mode="c")
+        except (OSError, ValueError) as e:
+            logger.warning(f" Ignoring unreadable cache entry {entry} of {self.log_path}: {e}")
+            return None
+        return columns
+
+
+    def put(self, entry: str, columns: Dict[str, np.ndarray]):
+        """
+        Stores the columns of a cache entry.  Failing to write to the
+        cache only disables further writes to it.
+
+        Args:
+            entry (str): name of the cache entry
+            columns (dict): column name to array
+
+        Return:
+            None
+
+        """
+        if not self.writable:
+            return
+        try:
+            os.makedirs(self.cache_dir, exist_ok=True)
+            self._clear_stale()
+            for column, array in columns.items():
+                self._replace_file(
+                    self._column_path(entry, column), "wb",
+                    lambda f: np.save(f, np.ascontiguousarray(array),
+                                      allow_pickle=False))
+            # re-read the manifest so entries stored by other processes are kept
+            self._entries = self._read_manifest()
+            self._entries[entry] = list(columns)
+            self._write_manifest()
+        except OSError as e:
+            logger.warning(f" Not caching decoded data of {self.log_path}: {e}")
+            self.writable = False
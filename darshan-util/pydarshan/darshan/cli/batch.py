@@ -0,0 +1,82 @@
+"""The `batch` subcommand computes the derived metrics of many
+darshan logs in parallel and writes them as a single CSV table.
+"""
+import sys
+import argparse
+from typing import Any, Union
+
+import pandas as pd
+
+import darshan.batch
+
+
+def setup_parser(parser: argparse.ArgumentParser):
+    """
+    Configures the command line arguments.
+
+    Parameters
+    ----------
+    parser : command line argument parser.
+
+    """
+    parser.description = "Computes derived metrics over many Darshan logs"
+
+    parser.add_argument(
+        "log_paths",
+        type=str,
+        nargs="+",
+        help="Specify darshan logs, directories of logs or glob patterns.",
+    )
+    parser.add_argument(
+        "--module",
+        dest="modules",
+        action="append",
+        choices=darshan.batch.ACCUMULATOR_MODULES,
+        help="Module to compute metrics for (may be repeated, default: all).",
+    )
+    parser.add_argument(
+        "--processes",
+        type=int,
+        default=None,
+        help="Number of worker processes (default: number of CPUs).",
+    )
+    parser.add_argument(
+        "--output",
+        type=str,
+        help="Specify output CSV filename (default: standard output).",
+    )
+
+
+def main(args: Union[Any, None] = None):
+    """
+    Computes derived metrics over many Darshan logs.
+
+    Parameters
+    ----------
+    args: command line arguments.
+
+    """
+    if args is None:
+        parser = argparse.ArgumentParser(description="")
+        setup_parser(parser)
+        args = parser.parse_args()
+
+    metrics = darshan.batch.derived_metrics(args.log_paths,
+                                            mods=args.modules,
+                                            processes=args.processes)
+    # one row per log and module
+    df_list = [df.assign(module=mod) for mod, df in metrics.items() if not df.empty]
+    if df_list:
+        batch_df = pd.concat(df_list, ignore_index=True)
+        # keep the log and module columns up front
+        cols = ["log", "module"] + [col for col in batch_df.columns
+                                    if col not in ("log", "module")]
+        batch_df = batch_df[cols]
+    else:
+        batch_df = pd.DataFrame(columns=["log", "module"])
+
+    if args.output is None:
+        batch_df.to_csv(sys.stdout, index=False)
+    else:
+        batch_df.to_csv(args.output, index=False)
+        print(f"Metrics of {batch_df['log'].nunique()} logs written to {args.output}")
@@ -14,7 +14,7 @@ from mako.template import Template
 
 import darshan
 import darshan.cli
-from darshan.backend.cffi_backend import accumulate_records
+from darshan.backend.cffi_backend import log_accumulate_module
 from darshan.lib.accum import log_file_count_summary_table, log_module_overview_table
 from darshan.experimental.plots import (
     plot_dxt_heatmap,
@@ -144,11 +144,9 @@ class ReportData:
         self.log_path = log_path
         self.enable_dxt_heatmap = enable_dxt_heatmap
         # store the report
-        self.report = darshan.DarshanReport(log_path, read_all=False)
-        # read only generic module data and heatmap data by default
-        self.report.read_all_generic_records()
-        if "HEATMAP" in self.report.data['modules']:
-            self.report.read_all_heatmap_records()
+        # module records and heatmaps are only read once a figure or
+        # table needs them
+        self.report = darshan.DarshanReport(log_path, lazy=True)
         # if DXT heatmaps requested, additionally read-in DXT data
         if self.enable_dxt_heatmap:
             self.report.read_all_dxt_records()
@@ -392,6 +390,10 @@ class ReportData:
                 if mod in self.report.modules:
                     if mod == "HEATMAP":
                         for possible_submodule in self.report.heatmaps:
+                            # recent activity heatmaps only cover the tail
+                            # end of the run, so they are not summarized
+                            if str(possible_submodule).endswith(":recent"):
+                                continue
                             possible_submodule = possible_submodule.replace("-", "")
                             heatmap_fig = ReportFigure(
                                 section_title="I/O Summary",
@@ -507,11 +509,10 @@ class ReportData:
 
             try:
                 if mod in ["POSIX", "MPI-IO", "STDIO"]:
-                    # get the module's record dataframe and then pass to
+                    # stream the module's records from the log into the
                     # Darshan accumulator interface to generate a cumulative
                     # record and derived metrics
-                    rec_dict = self.report.records[mod].to_df()
-                    acc = accumulate_records(rec_dict, mod, self.report.metadata['job']['nprocs'])
+                    acc = log_accumulate_module(self.report.log, mod)
 
                     mod_overview_fig = ReportFigure(
                             section_title=sect_title,
@@ -14,6 +14,7 @@ class Heatmap():
         self._ranks = set()
         self._nbins = None
         self._bin_width_seconds = None
+        self._start_time_seconds = None
         
         self._num_recs = 0
         self._data = {
@@ -47,6 +48,7 @@ class Heatmap():
             
         print("Num. bins:    ", self._nbins)
         print("Bin width (s):", self._bin_width_seconds)
+        print("Start time (s):", self._start_time_seconds)
         
         print("Num. recs:    ", self._num_recs)
 
@@ -82,11 +84,25 @@ class Heatmap():
         if self._bin_width_seconds != rec['bin_width_seconds']:
             raise ValueError("Record bin_width_seconds is not consistent with current heatmap.")
 
-        # actually add data
-        self._ranks.add(rec['rank'])
-        
-        self._data['read'][rank] = rec['read_bins']
-        self._data['write'][rank] = rec['write_bins']
+        # heatmaps from older logs always start at time zero
+        start_time_seconds = rec.get('start_time_seconds', 0.0)
+        if self._start_time_seconds is None:
+            self._start_time_seconds = start_time_seconds
+        if self._start_time_seconds != start_time_seconds:
+            raise ValueError("Record start_time_seconds is not consistent with current heatmap.")
+
+        # actually add data; rank matrices contribute a row of bins for
+        # each of the consecutive ranks they cover
+        if rec.get('nranks', 0) > 0:
+            for i in range(rec['nranks']):
+                self._ranks.add(rank + i)
+                self._data['read'][rank + i] = rec['read_bins'][i]
+                self._data['write'][rank + i] = rec['write_bins'][i]
+        else:
+            self._ranks.add(rec['rank'])
+
+            self._data['read'][rank] = rec['read_bins']
+            self._data['write'][rank] = rec['write_bins']
             
         self._num_recs += 1
 
@@ -110,9 +126,12 @@ class Heatmap():
 
         nbins = self._nbins
         bin_width_seconds = self._bin_width_seconds
+        start_time_seconds = self._start_time_seconds
 
         if interval_index:
-            breaks = np.linspace(start=0, stop=nbins*bin_width_seconds, num=nbins+1)
+            breaks = np.linspace(start=start_time_seconds,
+                                 stop=start_time_seconds + nbins*bin_width_seconds,
+                                 num=nbins+1)
             columns = pd.IntervalIndex.from_breaks(breaks)
         else:
             columns = np.arange(nbins)
@@ -14,9 +14,15 @@ else:
 import pandas as pd
 import numpy as np
 
+from darshan.backend import cffi_backend as backend
+
 if TYPE_CHECKING:
     import numpy.typing as npt
 
+# maximum number of IO events (or event/bin pairs) binned at once
+# by ``get_heatmap_array()``, bounding its temporary memory use
+HEATMAP_CHUNK_SIZE = 1 << 22
+
 
 class SegDict(TypedDict):
     """
@@ -150,6 +156,86 @@ def get_rd_wr_dfs(
     return rd_wr_dfs
 
 
+def _get_record_segments(rec: Any, op_key: str) -> "npt.NDArray[Any]":
+    """
+    Returns the segments of a single operation of a DXT record
+    as a structured array, without building a ``pd.DataFrame``.
+    """
+    segments = getattr(rec, "_segments", None)
+    if segments is not None:
+        # lazily decoded records still hold their raw segment array
+        # (write segments first), so slice it instead of decoding it
+        wcnt = rec["write_count"]
+        return segments[:wcnt] if op_key == "write" else segments[wcnt:]
+
+    seg_data = rec[op_key + "_segments"]
+    seg_array = np.empty(len(seg_data), dtype=backend._dxt_segment_dtype)
+    if not len(seg_data):
+        return seg_array
+    if isinstance(seg_data, pd.DataFrame):
+        for name in seg_array.dtype.names:
+            seg_array[name] = seg_data[name].to_numpy()
+    else:
+        names = seg_array.dtype.names
+        seg_array[:] = [tuple(seg[name] for name in names) for seg in seg_data]
+    return seg_array
+
+
+def get_segment_arrays(
+    report: Any,
+    mod: str = "DXT_POSIX",
+    ops: Sequence[str] = ["read", "write"],
+) -> Dict[str, Dict[str, "npt.NDArray[Any]"]]:
+    """
+    Collects the read/write segments of all records of a DXT module
+    into flat arrays, one per segment field.
+
+    Parameters
+    ----------
+
+    report: a ``darshan.DarshanReport``.
+
+    mod: the DXT module to do analysis for (i.e. "DXT_POSIX"
+    or "DXT_MPIIO"). Default is ``"DXT_POSIX"``.
+
+    ops: a sequence of keys designating which Darshan operations to use for
+    data aggregation. Default is ``["read", "write"]``.
+
+    Returns
+    -------
+
+    seg_arrays: dictionary where each key is an operation from the input
+    ``ops`` parameter (i.e. "read", "write") and each value is a dictionary
+    mapping the column names 'length', 'start_time', 'end_time' and 'rank'
+    to arrays holding that field for every event of the operation.
+
+    Notes
+    -----
+
+    Unlike ``get_rd_wr_dfs()``, no intermediate ``pd.DataFrame`` is
+    built for each record, and the segments of records read with
+    ``DarshanReport(..., lazy=True)`` are used without decoding them.
+
+    """
+    records = report.records[mod]._records
+    seg_arrays = {}
+    for op_key in ops:
+        seg_list = [_get_record_segments(rec, op_key) for rec in records]
+        if seg_list:
+            segments = np.concatenate(seg_list)
+        else:
+            segments = np.empty(0, dtype=backend._dxt_segment_dtype)
+        ranks = np.repeat(np.array([rec["rank"] for rec in records], dtype=np.int64),
+                          [len(seg) for seg in seg_list])
+        seg_arrays[op_key] = {
+            "length": segments["length"],
+            "start_time": segments["start_time"],
+            "end_time": segments["end_time"],
+            "rank": ranks,
+        }
+    return seg_arrays
+
+
 def get_single_df_dict(
     report: Any,
     mod: str = "DXT_POSIX",
@@ -195,20 +281,62 @@ def get_single_df_dict(
     """
     # initialize an empty dictionary for storing
     # module and read/write data
-    flat_data_dict = {}  # type: Dict[str, Dict[str, pd.DataFrame]]
-    # retrieve the list of records in pd.DataFrame() form
-    dict_list = report.records[mod].to_df()
-    # retrieve the list of read/write dataframes from the list of records
-    rd_wr_dfs = get_rd_wr_dfs(dict_list=dict_list, ops=ops)
-    # create empty dictionary
-    flat_data_dict = {}
+    flat_data_dict = {}  # type: Dict[str, pd.DataFrame]
+    # retrieve the read/write segments of all records as flat arrays
+    seg_arrays = get_segment_arrays(report=report, mod=mod, ops=ops)
     for op_key in ops:
-        # add the concatenated dataframe to the flat dictionary
-        flat_data_dict[op_key] = rd_wr_dfs[op_key]
+        if seg_arrays[op_key]["rank"].size:
+            flat_data_dict[op_key] = pd.DataFrame(seg_arrays[op_key])
+        else:
+            # if there are no events assign an empty dataframe
+            flat_data_dict[op_key] = pd.DataFrame()
 
     return flat_data_dict
 
 
+def get_aggregate_arrays(
+    report: Any,
+    mod: str = "DXT_POSIX",
+    ops: Sequence[str] = ["read", "write"],
+) -> Dict[str, "npt.NDArray[Any]"]:
+    """
+    Array-based version of ``get_aggregate_data()``, which returns
+    the columns of the aggregated data as a dictionary of arrays.
+
+    Parameters
+    ----------
+
+    report: a ``darshan.DarshanReport``.
+
+    mod: the DXT module to do analysis for (i.e. "DXT_POSIX"
+    or "DXT_MPIIO"). Default is ``"DXT_POSIX"``.
+
+    ops: a sequence of keys designating which Darshan operations to use for
+    data aggregation. Default is ``["read", "write"]``.
+
+    Returns
+    -------
+
+    agg_data: dictionary mapping the column names 'length', 'start_time',
+    'end_time' and 'rank' to arrays holding the events of all selected
+    operations.
+
+    Raises
+    ------
+
+    ValueError: raised if the selected modules/operations
+    don't contain any data.
+
+    """
+    seg_arrays = get_segment_arrays(report=report, mod=mod, ops=ops)
+    if not sum(op_data["rank"].size for op_data in seg_arrays.values()):
+        raise ValueError("No data available for selected module(s) and operation(s).")
+    # read and write events are considered unique events,
+    # so if both are selected their data is simply concatenated
+    return {col: np.concatenate([op_data[col] for op_data in seg_arrays.values()])
+            for col in ["length", "start_time", "end_time", "rank"]}
+
+
 def get_aggregate_data(
     report: Any,
     mod: str = "DXT_POSIX",
@@ -255,22 +383,165 @@ def get_aggregate_data(
         1    4000    0.104217  0.104231     0
 
     """
-    # collect the concatenated dataframe data from the darshan report
-    df_dict = get_single_df_dict(report=report, mod=mod, ops=ops)
-    # iterate over each dataframe based on which operations are selected
-    df_list = []
-    for op_key, op_df in df_dict.items():
-        # if the dataframe has data, append it to the list
-        if op_df.size:
-            df_list.append(op_df)
-
-    if df_list:
-        # if there are dataframes in the list, concatenate them into 1 dataframe
-        agg_df = pd.concat(df_list, ignore_index=True)
-    else:
-        raise ValueError("No data available for selected module(s) and operation(s).")
+    return pd.DataFrame(get_aggregate_arrays(report=report, mod=mod, ops=ops))
+
+
+def _find_bins(bin_edges: "npt.NDArray[np.float64]",
+               times: "npt.NDArray[np.float64]") -> "npt.NDArray[np.int64]":
+    """
+    Returns the index of the right-closed bin containing each time,
+    which is -1 or ``xbins`` for times outside of the bins.  This equals
+    ``np.searchsorted(bin_edges, times) - 1``, but avoids a binary search
+    per time by correcting an arithmetic estimate against the bin edges.
+    """
+    xbins = len(bin_edges) - 1
+    padded_edges = np.concatenate(([-np.inf], bin_edges, [np.inf]))
+    with np.errstate(divide="ignore", invalid="ignore"):
+        estimate = np.ceil(times / (bin_edges[1] - bin_edges[0]))
+    estimate[np.isnan(estimate)] = xbins + 1
+    # index into ``padded_edges`` of the first edge >= each time
+    edge = np.clip(estimate, 0, xbins + 1).astype(np.int64) + 1
+    edge -= times <= padded_edges[edge - 1]
+    edge += times > padded_edges[edge]
+    return np.maximum(edge - 2, -1)
+
+
+def get_heatmap_array(
+    agg_data: Any,
+    bin_edges: "npt.NDArray[np.float64]",
+    nprocs: int,
+) -> "npt.NDArray[np.float64]":
+    """
+    Bins the bytes of all IO events into a rank by time bin array,
+    in a single vectorized pass over the event arrays.
 
-    return agg_df
+    Parameters
+    ----------
+
+    agg_data: the aggregated event data, either as a ``pd.DataFrame``
+    or as a dictionary of arrays (see ``get_aggregate_arrays()``).
+
+    bin_edges: the ``xbins + 1`` evenly spaced time bin edges.
+
+    nprocs: the number of MPI ranks/processes used at runtime.
+
+    Returns
+    -------
+
+    hmap_data: array of shape ``(nprocs, xbins)`` holding the data
+    read/written by each rank in each time bin.
+
+    Notes
+    -----
+
+    Bins are closed on the right, like the intervals of ``pd.cut()``.
+    An event contained in a single bin adds all of its bytes to it,
+    otherwise its bytes are shared out over the bins it spans in
+    proportion to the time spent in each. Events starting (ending)
+    outside of the bins only contribute to the bin they end (start) in.
+
+    """
+    xbins = len(bin_edges) - 1
+    bin_size = bin_edges[1] - bin_edges[0]
+    hmap_data = np.zeros(nprocs * xbins)
+
+    # (flattened bin index, bytes) pairs of the current chunk, summed
+    # with a single ``np.bincount()`` call per chunk
+    bin_list = []
+    value_list = []
+
+    def add_to_bins(flat_bins, values):
+        bin_list.append(flat_bins)
+        value_list.append(values)
+
+    def sum_bins():
+        if not bin_list:
+            return
+        sums = np.bincount(np.concatenate(bin_list), weights=np.concatenate(value_list))
+        hmap_data[:sums.size] += sums
+        bin_list.clear()
+        value_list.clear()
+
+    columns = {col: np.asarray(agg_data[col])
+               for col in ["rank", "start_time", "end_time", "length"]}
+    n_events = columns["rank"].size
+    for chunk_start in range(0, n_events, HEATMAP_CHUNK_SIZE):
+        chunk = slice(chunk_start, chunk_start + HEATMAP_CHUNK_SIZE)
+        rank = columns["rank"][chunk].astype(np.int64)
+        start_time = columns["start_time"][chunk].astype(np.float64)
+        end_time = columns["end_time"][chunk].astype(np.float64)
+        length = columns["length"][chunk].astype(np.float64)
+
+        # ranks beyond `nprocs` have no row in the heatmap
+        in_range = (rank >= 0) & (rank < nprocs)
+        if not in_range.all():
+            rank, start_time, end_time, length = (
+                rank[in_range], start_time[in_range], end_time[in_range], length[in_range])
+
+        # index of the (right-closed) bin of each start/end time,
+        # and whether it falls in any of the bins at all
+        start_bin = _find_bins(bin_edges, start_time)
+        end_bin = _find_bins(bin_edges, end_time)
+        start_binned = (start_bin >= 0) & (start_bin < xbins)
+        end_binned = (end_bin >= 0) & (end_bin < xbins)
+        np.clip(start_bin, 0, xbins - 1, out=start_bin)
+        np.clip(end_bin, 0, xbins - 1, out=end_bin)
+        row_start = rank * xbins
+
+        with np.errstate(divide="ignore", invalid="ignore"):
+            # ratio of the bin time interval over the event elapsed time
+            true_fraction = bin_size / (end_time - start_time)
+        # proportional time spent in the start/end bins
+        start_occupancy = (bin_edges[start_bin + 1] - start_time) / bin_size
+        end_occupancy = (end_time - bin_edges[end_bin]) / bin_size
+
+        # start and end are in the same bin, which gets all the bytes
+        same_bin = start_binned & end_binned & (start_bin == end_bin)
+        add_to_bins(row_start[same_bin] + start_bin[same_bin], length[same_bin])
+
+        # only one end of the event is binned, which gets its capped fraction
+        fraction = np.minimum(true_fraction, 1)
+        only_start = start_binned & ~end_binned
+        add_to_bins(row_start[only_start] + start_bin[only_start],
+                    (length * fraction * start_occupancy)[only_start])
+        only_end = ~start_binned & end_binned
+        add_to_bins(row_start[only_end] + end_bin[only_end],
+                    (length * fraction * end_occupancy)[only_end])
+
+        # events spanning several bins; start/end in adjacent bins use
+        # the true fraction, which may actually be > 1
+        spanning = start_binned & end_binned & (end_bin > start_bin)
+        fraction = np.where(end_bin == start_bin + 1, true_fraction, fraction)
+        bin_bytes = (length * fraction)[spanning]
+        row_start, start_bin, end_bin = (
+            row_start[spanning], start_bin[spanning], end_bin[spanning])
+        add_to_bins(row_start + start_bin, bin_bytes * start_occupancy[spanning])
+        add_to_bins(row_start + end_bin, bin_bytes * end_occupancy[spanning])
+
+        # each bin fully spanned by an event gets a full bin's fraction;
+        # expand these in bounded batches since long events span many bins
+        n_full = end_bin - start_bin - 1
+        has_full = np.flatnonzero(n_full)
+        full_ends = np.cumsum(n_full[has_full])
+        batch_start = 0
+        while batch_start < has_full.size:
+            done = full_ends[batch_start - 1] if batch_start else 0
+            batch_end = max(int(np.searchsorted(full_ends, done + HEATMAP_CHUNK_SIZE,
+                                                side="right")),
+                            batch_start + 1)
+            events = has_full[batch_start:batch_end]
+            counts = n_full[events]
+            event_index = np.repeat(np.arange(events.size), counts)
+            bin_offset = (np.arange(event_index.size) -
+                          np.repeat(np.cumsum(counts) - counts, counts))
+            events = events[event_index]
+            add_to_bins(row_start[events] + start_bin[events] + 1 + bin_offset,
+                        bin_bytes[events])
+            sum_bins()
+            batch_start = batch_end
+        sum_bins()
+
+    return hmap_data.reshape(nprocs, xbins)
 
 
 def get_heatmap_df(agg_df: pd.DataFrame,
@@ -287,7 +558,8 @@ def get_heatmap_df(agg_df: pd.DataFrame,
     ----------
 
     agg_df: a ``pd.DataFrame`` containing the aggregated data determined
-    by the input modules and operations.
+    by the input modules and operations, or the equivalent dictionary of
+    arrays returned by ``get_aggregate_arrays()``.
 
     xbins: the number of x-axis bins to create.
 
@@ -319,98 +591,13 @@ def get_heatmap_df(agg_df: pd.DataFrame,
     # generate the bin edges by generating an array of length n_bins+1, then
     # taking pairs of data points as the min/max bin value
     if max_time is None:
-        max_time = agg_df["end_time"].max()
+        max_time = np.max(agg_df["end_time"])
     bin_edge_data = np.linspace(0.0, max_time, xbins + 1)
-    # create dummy variables for start/end time data, where dataframe columns
-    # are the x-axis bin ranges
-    # pin dtype here because of pandas 2.0+ change--see:
-    # gh-909 and
-    # https://github.com/pandas-dev/pandas/pull/48022#issuecomment-1448755561
-    cats_start = pd.get_dummies(
-        pd.cut(agg_df["start_time"], bin_edge_data, precision=16),
-        dtype=np.uint8,
-    )
-    cats_end = pd.get_dummies(pd.cut(agg_df["end_time"], bin_edge_data, precision=16))
-    # get series for the elapsed times for each dxt segment
-    elapsed_times_dxt_segments = agg_df["end_time"] - agg_df["start_time"]
-    # calculate the time interval spanned by each bin
-    bin_size = bin_edge_data[1] - bin_edge_data[0]
-    # get the ratio of the bin time interval over the dxt segment elapsed times
-    true_fraction_of_dxt_segment_in_a_bin = bin_size / elapsed_times_dxt_segments
-    # create a version of the above series where any ratio above 1 is set to 1
-    fraction_of_dxt_segment_in_a_bin = true_fraction_of_dxt_segment_in_a_bin.copy()
-    fraction_of_dxt_segment_in_a_bin.mask(
-        fraction_of_dxt_segment_in_a_bin > 1, 1, inplace=True
-    )
-    # create a dataframe of binned dxt start events where occupied bins contain
-    # the start time and unoccupied bins are populated with NaNs
-    start_times_in_bins = cats_start.mul(agg_df["start_time"], axis=0).replace(
-        0, np.nan
-    )
-    # create a dataframe of binned dxt start events where occupied bins contain
-    # the proportional time spent in the bin
-    start_fraction_bin_occupancy = (bin_edge_data[1:] - start_times_in_bins) / bin_size
-    # create a dataframe of binned dxt end events where occupied bins contain
-    # the end time and unoccupied bins are populated with NaNs
-    end_times_in_bins = cats_end.mul(agg_df["end_time"], axis=0).replace(0, np.nan)
-    # create a dataframe of binned dxt end events where occupied bins contain
-    # the proportional time spent in the bin
-    end_fraction_bin_occupancy = (end_times_in_bins - bin_edge_data[:-1]) / bin_size
-    # combine the start/end fractional bin occupancy dataframes by multiplying
-    # them together. Fill any missing values with (1)
-    combo = start_fraction_bin_occupancy.mul(
-        end_fraction_bin_occupancy, fill_value=1, axis=0
-    )
-    # add the start/end dummy variable dataframes
-    # and replace any zeros with NaN's
-    cats = cats_start.add(cats_end, fill_value=0)
-    cats.replace(0, np.nan, inplace=True)
-    # for each row (IO event) fill in any empty (NaN) bins
-    # between filled bins because those are time spans b/w start
-    # and stop events
-    # interpolation is pointless when there is
-    # a single non-null value in a row
-    null_mask = cats.notna().sum(axis=1) > 1
-    null_mask = null_mask.loc[null_mask == True].index
-    cats_vals = cats.iloc[null_mask].values
-    nan_mask = ~np.isnan(cats_vals)
-    fill_locs = np.where(nan_mask)
-    num_rows = cats_vals.shape[0]
-    start_index = 0
-    row = 0
-
-    # TODO: this is already much faster than
-    # pandas per gh-798, but consider moving
-    # to i.e., Cython or numba?
-    while start_index < (2 * num_rows):
-        start_bound = fill_locs[1][start_index]
-        end_bound = fill_locs[1][start_index + 1]
-        cats_vals[row, start_bound:end_bound] = 1
-        start_index += 2
-        row += 1
-
-    cats.iloc[null_mask] = cats_vals
-    # each time bin containing an event has a 1 in it, otherwise NaN
-    # store mask for restoring fully occupied bins
-    mask_occ = cats == 2
-    # set the fraction of segment per occupied bin
-    cats = cats.mul(fraction_of_dxt_segment_in_a_bin, axis=0)
-    # start/end in adjacent bins require special treatment
-    adjacent_mask = (cats.count(axis=1) == 2) & (cats.sum(axis=1) == 2)
-    # multiply them by the true fractions of DXT segments, which
-    # may actually be > 1 (i.e., the non-1-capped fractions)
-    cats[adjacent_mask] = cats[adjacent_mask].mul(
-        true_fraction_of_dxt_segment_in_a_bin[adjacent_mask], axis=0
-    )
-    # adjust the fractions of the starts/ends for partial occupancy
-    # of bins
-    cats = cats.mul(combo, fill_value=1, axis=0)
-    # start and end are in bin, so restore it
-    cats = cats.mask(mask_occ, 1)
-    # each full or fractional bin event is now multiplied by
-    # the bytes data
-    cats = cats.mul(agg_df["length"], axis=0)
-    cats.index = agg_df["rank"]
-    hmap_df = cats.groupby("rank").sum()
-    hmap_df = hmap_df.reindex(index=range(nprocs), fill_value=0.0)
+    hmap_data = get_heatmap_array(agg_data=agg_df, bin_edges=bin_edge_data, nprocs=nprocs)
+    # label the columns with the same time intervals ``pd.cut()`` produces
+    intervals = pd.cut(pd.Series([], dtype=np.float64), bin_edge_data,
+                       precision=16).cat.categories
+    columns = pd.CategoricalIndex(intervals, categories=intervals, ordered=True)
+    hmap_df = pd.DataFrame(hmap_data, columns=columns,
+                           index=pd.RangeIndex(nprocs, name="rank"))
     return hmap_df
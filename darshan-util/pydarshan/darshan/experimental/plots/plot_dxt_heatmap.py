@@ -50,10 +50,10 @@ def determine_hmap_runtime(report: darshan.DarshanReport) -> Tuple[float, float]
         tmax = 0.0
         for mod in report.modules:
             if "DXT" in mod:
-                agg_df = heatmap_handling.get_aggregate_data(report=report,
-                                                             mod=mod,
-                                                             ops=["read", "write"])
-                tmax_dxt = float(agg_df["end_time"].max())
+                agg_data = heatmap_handling.get_aggregate_arrays(report=report,
+                                                                 mod=mod,
+                                                                 ops=["read", "write"])
+                tmax_dxt = float(agg_data["end_time"].max())
                 if tmax_dxt > tmax:
                     tmax = tmax_dxt
     else:
@@ -360,13 +360,13 @@ def plot_heatmap(
 
     if "DXT" in mod:
         # aggregate the data according to the selected modules and operations
-        agg_df = heatmap_handling.get_aggregate_data(report=report, mod=mod, ops=ops)
+        agg_data = heatmap_handling.get_aggregate_arrays(report=report, mod=mod, ops=ops)
         # get the heatmap data array
         # NOTE: the darshan runtime does not collect empty DXT records,
         # so we are not guaranteed to have data for all time spans
         # as a result, we force the upper time bound for the heatmap data
         # to be the wallclock time
-        hmap_df = heatmap_handling.get_heatmap_df(agg_df=agg_df,
+        hmap_df = heatmap_handling.get_heatmap_df(agg_df=agg_data,
                                                   xbins=xbins,
                                                   nprocs=nprocs,
                                                   max_time=runtime)
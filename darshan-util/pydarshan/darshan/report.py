@@ -9,6 +9,7 @@ interaction and aggregation of Darshan logs using Python.
 
 import darshan.backend.cffi_backend as backend
 
+from darshan.cache import LogCache
 from darshan.datatypes.heatmap import Heatmap
 
 import json
@@ -291,6 +292,32 @@ class DarshanRecordCollection(collections.abc.MutableSequence):
         return records
 
 
+class DarshanLazyRecords(dict):
+    """
+    Records of a lazily opened DarshanReport: a module's records are
+    only decoded from the log the first time ``records[mod]`` (or
+    ``records.get(mod)``) is used.  Membership tests and iteration only
+    cover the modules that have been read so far; use
+    ``DarshanReport.modules`` for the modules available in the log.
+    """
+
+    def __init__(self, report):
+        super().__init__()
+        self.report = report
+
+    def __missing__(self, mod):
+        self.report._read_module(mod)
+        if not dict.__contains__(self, mod):
+            raise KeyError(mod)
+        return dict.__getitem__(self, mod)
+
+    def get(self, mod, default=None):
+        try:
+            return self[mod]
+        except KeyError:
+            return default
+
+
 class DarshanReport(object):
     """
     The DarshanReport class provides a convienient wrapper to access darshan
@@ -306,7 +333,8 @@ class DarshanReport(object):
             filename=None, dtype='numpy', 
             start_time=None, end_time=None,
             automatic_summary=False,
-            read_all=True, lookup_name_records=True):
+            read_all=True, lookup_name_records=True, lazy=False,
+            cache=False):
         """
         Args:
             filename (str): filename to open (optional)
@@ -314,6 +342,12 @@ class DarshanReport(object):
             automatic_summary (bool): automatically generate summary after loading
             read_all (bool): whether to read all records for log
             lookup_name_records (bool): lookup and update name_records as records are loaded
+            lazy (bool): read each module's records (and heatmaps) only when
+                first accessed, resolving only the name records they use;
+                overrides read_all
+            cache (bool or str): keep decoded records and name records in an
+                on-disk cache, next to the log (or in DARSHAN_CACHE_DIR) if
+                True, or in the given directory
 
         Return:
             None
@@ -326,6 +360,10 @@ class DarshanReport(object):
         self.dtype = dtype                                  # default dtype to return when viewing records
         self.automatic_summary = automatic_summary
         self.lookup_name_records = lookup_name_records
+        self.lazy = lazy
+        self.cache = cache
+        self._cache = None
+        self._name_record_table = None
 
         # State dependent book-keeping
         self.converted_records = False  # true if convert_records() was called (unnumpyfy)
@@ -342,7 +380,7 @@ class DarshanReport(object):
         self._metadata = {}
         self._modules = {}
         self._counters = {}
-        self.records = {}
+        self.records = DarshanLazyRecords(self) if lazy else {}
         self._mounts = {}
         self.name_records = {}
         self._heatmaps = {}
@@ -388,6 +426,8 @@ class DarshanReport(object):
 
     @property
     def heatmaps(self):
+        if self.lazy and not self._heatmaps and "HEATMAP" in self.modules:
+            self.read_all_heatmap_records()
         return self._heatmaps
 
 #    @property
@@ -425,6 +465,13 @@ class DarshanReport(object):
             if not bool(self.log['handle']):
                 raise RuntimeError("Failed to open file.")
 
+            if self.cache:
+                cache_dir = self.cache if isinstance(self.cache, str) else None
+                self._cache = LogCache(filename, cache_dir=cache_dir)
+
+            if self.lazy:
+                read_all = False
+
             self.read_metadata(read_all=read_all)
 
             if read_all:
@@ -486,7 +533,10 @@ class DarshanReport(object):
         self._modules = self.data['modules']
 
         if read_all == True:
-            self.data["name_records"] = backend.log_get_name_records(self.log)
+            if self._cache is not None:
+                self.data["name_records"] = dict(self._get_name_record_table())
+            else:
+                self.data["name_records"] = backend.log_get_name_records(self.log)
             self.name_records = self.data['name_records']
 
 
@@ -521,7 +571,58 @@ class DarshanReport(object):
                 ids.add(rec['id'])
 
 
-        self.name_records.update(backend.log_lookup_name_records(self.log, ids))
+        self.name_records.update(self._lookup_name_records(ids))
+
+
+    def _get_name_record_table(self):
+        """
+        Returns all name records of the log, from the cache if possible.
+        """
+        if self._name_record_table is not None:
+            return self._name_record_table
+
+        cols = self._cache.get("name_records")
+        if cols is None:
+            index = backend.log_get_name_index(self.log)
+            table = backend.name_index_to_dict(index)
+            if len(table) == len(index["id"]):
+                # copy the names out of the inflated name region as is
+                offsets = np.zeros(len(table) + 1, dtype=np.int64)
+                np.cumsum(index["length"], out=offsets[1:])
+                data = np.empty(offsets[-1], dtype=np.uint8)
+                region = index["data"]
+                for start, end, src in zip(offsets[:-1].tolist(),
+                                           offsets[1:].tolist(),
+                                           index["offset"].tolist()):
+                    data[start:end] = region[src:src + end - start]
+            else:
+                names = [name.encode("utf-8") for name in table.values()]
+                offsets = np.zeros(len(names) + 1, dtype=np.int64)
+                np.cumsum([len(name) for name in names], out=offsets[1:])
+                data = np.frombuffer(b"".join(names), dtype=np.uint8)
+            self._cache.put("name_records", {
+                "id": np.fromiter(table.keys(), dtype=np.uint64, count=len(table)),
+                "offset": offsets,
+                "data": data,
+                })
+        else:
+            data = cols["data"].tobytes()
+            offsets = cols["offset"].tolist()
+            table = {rec_id: data[offsets[i]:offsets[i + 1]].decode("utf-8")
+                     for i, rec_id in enumerate(cols["id"].tolist())}
+
+        self._name_record_table = table
+        return table
+
+
+    def _lookup_name_records(self, ids):
+        """
+        Returns the name records of the given record ids.
+        """
+        if self._cache is None:
+            return backend.log_lookup_name_records(self.log, ids)
+        table = self._get_name_record_table()
+        return {rec_id: table[rec_id] for rec_id in ids if rec_id in table}
         
 
     def read_all(self, dtype=None):
@@ -549,6 +650,32 @@ class DarshanReport(object):
         return
 
 
+    def _read_module(self, mod):
+        """
+        Read all records of a single module, as requested through a lazy
+        report's records.
+
+        Args:
+            mod (str): Identifier of module to fetch all records
+
+        Return:
+            None
+        """
+        if mod not in self.modules:
+            return
+
+        if mod in ['DXT_POSIX', 'DXT_MPIIO']:
+            self.mod_read_all_dxt_records(mod, warnings=False)
+        elif mod == "LUSTRE":
+            self.mod_read_all_lustre_records(warnings=False)
+        elif mod == "APMPI":
+            self.mod_read_all_apmpi_records(warnings=False)
+        elif mod == "APXC":
+            self.mod_read_all_apxc_records(warnings=False)
+        else:
+            self.mod_read_all_records(mod, warnings=False)
+
+
     def read_all_generic_records(self, counters=True, fcounters=True, dtype=None):
         """
         Read all generic records from darshan log and return as dictionary.
@@ -605,13 +732,17 @@ class DarshanReport(object):
         _nrecs_heatmap = {  
             16592106915301738621: "heatmap:POSIX",
             3989511027826779520: "heatmap:STDIO",
-            3668870418325792824: "heatmap:MPIIO"
+            3668870418325792824: "heatmap:MPIIO",
+            462421991569340467: "heatmap:POSIX:recent",
+            14847968068921471529: "heatmap:STDIO:recent",
+            17657333421102045892: "heatmap:MPIIO:recent",
         }
 
         def heatmap_rec_to_module_name(rec, nrecs=None):
             if rec['id'] in nrecs:
                 name = nrecs[rec['id']]
-                mod = name.split(":")[1]
+                # e.g., "POSIX", or "POSIX:recent" for recent activity
+                mod = name.split(":", 1)[1]
             else:
                 mod = rec['id']
             return mod
@@ -665,52 +796,56 @@ class DarshanReport(object):
             raise ValueError(f"mod {mod} is not available in this DarshanReport object.")
 
         # update module metadata
-        self._modules[mod]['num_records'] = 0
         if mod not in self.counters:
             self.counters[mod] = {}
             self.counters[mod]['counters'] = cn 
             self.counters[mod]['fcounters'] = fcn
 
 
-        # fetch records
-        rec = backend.log_get_generic_record(self.log, mod, dtype=dtype)
-        while rec != None:
-            self.records[mod].append(rec)
-            self._modules[mod]['num_records'] += 1
-
-            # fetch next
-            rec = backend.log_get_generic_record(self.log, mod, dtype=dtype)
-
+        # fetch all records of the module in one call
+        matrix = None
+        if self._cache is not None:
+            matrix = self._cache.get(mod)
+        if matrix is None:
+            matrix = backend.log_get_record_matrix(self.log, mod)
+            if self._cache is not None:
+                self._cache.put(mod, matrix)
+        ids = matrix['id']
+        ranks = matrix['rank']
+        self._modules[mod]['num_records'] = len(ids)
 
         if self.lookup_name_records:
-            self.update_name_records(mod=mod)
+            self.name_records.update(
+                self._lookup_name_records(set(ids.tolist())))
 
-        # process/combine records if the format dtype allows for this
+        # build the DataFrames straight from the record matrices
         if dtype == 'pandas':
-            combined_c = None
-            combined_fc = None
-
-            for rec in self.records[mod]:
-                obj = rec['counters']
-                #print(type(obj))
-                #display(obj)
-                
-                if combined_c is None:
-                    combined_c = rec['counters']
-                else:
-                    combined_c = pd.concat([combined_c, rec['counters']])
-                    
-                if combined_fc is None:
-                    combined_fc = rec['fcounters']
-                else:
-                    combined_fc = pd.concat([combined_fc, rec['fcounters']])
+            df_c = pd.DataFrame(matrix['counters'], columns=cn, copy=False)
+            df_fc = pd.DataFrame(matrix['fcounters'], columns=fcn, copy=False)
+            for df in (df_c, df_fc):
+                df.insert(0, 'id', ids)
+                df.insert(1, 'rank', ranks)
 
             self.records[mod] = [{
                 'rank': -1,
                 'id': -1,
-                'counters': combined_c,
-                'fcounters': combined_fc
+                'counters': df_c,
+                'fcounters': df_fc
                 }]
+            return
+
+        for i, (rec_id, rank) in enumerate(zip(ids.tolist(), ranks.tolist())):
+            rec = {'id': rec_id, 'rank': rank}
+            if 'file_rec_id' in matrix:
+                rec['file_rec_id'] = int(matrix['file_rec_id'][i])
+
+            if dtype == 'dict':
+                rec['counters'] = dict(zip(cn, matrix['counters'][i]))
+                rec['fcounters'] = dict(zip(fcn, matrix['fcounters'][i]))
+            else:
+                rec['counters'] = matrix['counters'][i]
+                rec['fcounters'] = matrix['fcounters'][i]
+            self.records[mod].append(rec)
 
 
     def mod_read_all_apmpi_records(self, mod="APMPI", dtype=None, warnings=True):
@@ -851,14 +986,24 @@ class DarshanReport(object):
             self.counters[mod] = {}
 
 
+        if self._cache is not None:
+            for rec in self._cached_dxt_records(mod, dtype, reads=reads, writes=writes):
+                self.records[mod].append(rec)
+                self.data['modules'][mod]['num_records'] += 1
+            if self.lookup_name_records:
+                self.update_name_records(mod=mod)
+            return
+
         # fetch records
-        rec = backend.log_get_dxt_record(self.log, mod, dtype=dtype)
+        rec = backend.log_get_dxt_record(self.log, mod, reads=reads, writes=writes,
+                                         dtype=dtype, lazy=self.lazy)
         while rec != None:
             self.records[mod].append(rec)
             self.data['modules'][mod]['num_records'] += 1
 
             # fetch next
-            rec = backend.log_get_dxt_record(self.log, mod, reads=reads, writes=writes, dtype=dtype)
+            rec = backend.log_get_dxt_record(self.log, mod, reads=reads, writes=writes,
+                                             dtype=dtype, lazy=self.lazy)
 
 
         if self.lookup_name_records:
@@ -867,6 +1012,46 @@ class DarshanReport(object):
 
 
 
+    def _cached_dxt_records(self, mod, dtype, reads=True, writes=True):
+        """
+        Returns the records of a DXT module, from the cache if possible.
+        """
+        cols = self._cache.get(mod)
+        if cols is None:
+            recs = []
+            rec = backend.log_get_dxt_record(self.log, mod, dtype=dtype, lazy=True)
+            while rec is not None:
+                recs.append(rec)
+                rec = backend.log_get_dxt_record(self.log, mod, dtype=dtype, lazy=True)
+            segments = [rec._segments for rec in recs]
+            cols = {
+                "id": np.array([rec["id"] for rec in recs], dtype=np.uint64),
+                "rank": np.array([rec["rank"] for rec in recs], dtype=np.int64),
+                "hostname": np.array([rec["hostname"].encode("utf-8") for rec in recs], dtype=bytes),
+                "write_count": np.array([rec["write_count"] for rec in recs], dtype=np.int64),
+                "read_count": np.array([rec["read_count"] for rec in recs], dtype=np.int64),
+                "segments": (np.concatenate(segments) if segments else
+                             np.empty(0, dtype=backend._dxt_segment_dtype)),
+                }
+            self._cache.put(mod, cols)
+
+        seg_end = np.cumsum(cols["write_count"] + cols["read_count"]).tolist()
+        recs = []
+        seg_start = 0
+        for i, (rec_id, rank, hostname, wcnt, rcnt) in enumerate(zip(
+                cols["id"].tolist(), cols["rank"].tolist(), cols["hostname"].tolist(),
+                cols["write_count"].tolist(), cols["read_count"].tolist())):
+            rec = {'id': rec_id, 'rank': rank, 'hostname': hostname.decode("utf-8"),
+                   'write_count': wcnt, 'read_count': rcnt}
+            rec = backend.LazyDXTRecord(rec, cols["segments"][seg_start:seg_end[i]], dtype,
+                                        reads=reads, writes=writes)
+            if not self.lazy:
+                rec = dict(rec)
+            recs.append(rec)
+            seg_start = seg_end[i]
+        return recs
+
+
     def mod_read_all_lustre_records(self, mod="LUSTRE", dtype=None, warnings=True):
         """
         Reads all dxt records for provided module.
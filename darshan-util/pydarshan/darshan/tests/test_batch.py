@@ -0,0 +1,76 @@
+import os
+import shutil
+import argparse
+
+import pytest
+import pandas as pd
+
+import darshan
+import darshan.batch
+from darshan.backend.cffi_backend import accumulate_records
+from darshan.cli import batch as batch_cli
+from darshan.log_utils import get_log_path
+
+
+@pytest.fixture
+def log_dir(tmp_path):
+    for log_name in ["sample.darshan", "ior_hdf5_example.darshan", "noposix.darshan"]:
+        shutil.copy(get_log_path(log_name), tmp_path / log_name)
+    return tmp_path
+
+
+@pytest.mark.parametrize("processes", [1, 2])
+def test_derived_metrics(log_dir, processes):
+    # the batch metrics of each log and module match the derived
+    # metrics accumulated from the records of a report
+    metrics = darshan.batch.derived_metrics(str(log_dir), processes=processes)
+    assert sorted(metrics) == ["MPI-IO", "POSIX", "STDIO"]
+    for mod, df in metrics.items():
+        assert list(df["log"]) == sorted(df["log"])
+        for _, row in df.iterrows():
+            with darshan.DarshanReport(row["log"], read_all=True) as report:
+                assert row["jobid"] == report.metadata["job"]["jobid"]
+                assert row["nprocs"] == report.metadata["job"]["nprocs"]
+                acc = accumulate_records(report.records[mod].to_df(), mod,
+                                         report.metadata["job"]["nprocs"])
+            expected = darshan.batch._derived_metrics_dict(acc.derived_metrics)
+            assert row[list(expected)].to_dict() == pytest.approx(expected, nan_ok=True)
+    # noposix.darshan has no POSIX records
+    assert len(metrics["POSIX"]) == 2
+    assert len(metrics["STDIO"]) == 3
+
+
+def test_derived_metrics_bad_log(log_dir, caplog):
+    # unreadable logs are skipped, selected modules are kept
+    # even without any rows
+    bad_log = str(log_dir / "bad.darshan")
+    with open(bad_log, "w") as f:
+        f.write("not a darshan log")
+    metrics = darshan.batch.derived_metrics([str(log_dir / "noposix.darshan"), bad_log],
+                                            mods=["POSIX", "STDIO"], processes=1)
+    assert sorted(metrics) == ["POSIX", "STDIO"]
+    assert metrics["POSIX"].empty
+    assert list(metrics["STDIO"]["log"]) == [str(log_dir / "noposix.darshan")]
+    assert "Skipping log" in caplog.text
+
+
+def test_expand_log_paths(log_dir):
+    sample = str(log_dir / "sample.darshan")
+    paths = darshan.batch.expand_log_paths([sample, str(log_dir / "*.darshan")])
+    assert paths == [sample,
+                     str(log_dir / "ior_hdf5_example.darshan"),
+                     str(log_dir / "noposix.darshan")]
+    assert darshan.batch.expand_log_paths(str(log_dir)) == sorted(paths)
+
+
+def test_batch_cli(log_dir, tmp_path):
+    output = str(tmp_path / "metrics.csv")
+    parser = argparse.ArgumentParser()
+    batch_cli.setup_parser(parser)
+    args = parser.parse_args([str(log_dir / "*.darshan"), "--module", "POSIX",
+                              "--processes", "1", "--output", output])
+    batch_cli.main(args)
+    df = pd.read_csv(output)
+    assert list(df.columns[:3]) == ["log", "module", "jobid"]
+    assert list(df["module"]) == ["POSIX", "POSIX"]
+    assert os.path.basename(df["log"][1]) == "sample.darshan"
@@ -0,0 +1,104 @@
+import os
+import shutil
+
+import pytest
+import numpy as np
+from pandas.testing import assert_frame_equal
+
+import darshan
+import darshan.backend.cffi_backend as backend
+from darshan.cache import LogCache
+from darshan.log_utils import get_log_path
+
+
+@pytest.mark.parametrize("log_filename", [
+    "sample-dxt-simple.darshan",
+    "ior_hdf5_example.darshan",
+    ])
+@pytest.mark.parametrize("lazy", [True, False])
+def test_cached_report(tmp_path, monkeypatch, log_filename, lazy):
+    # a report reopened from the cache holds the same records and
+    # name records as one read from the log
+    log_path = get_log_path(log_filename)
+    with darshan.DarshanReport(log_path, read_all=True, dtype="pandas") as expected:
+        mods = [mod for mod in expected.records if mod != "LUSTRE"]
+
+        with darshan.DarshanReport(log_path, read_all=not lazy, lazy=lazy,
+                                   dtype="pandas", cache=str(tmp_path)) as report:
+            for mod in mods:
+                report.records[mod]
+
+        # the second report must not decode anything from the log
+        def fail(*args, **kwargs):
+            raise AssertionError("not served from the cache")
+        monkeypatch.setattr(backend, "log_get_record_matrix", fail)
+        monkeypatch.setattr(backend, "log_get_dxt_record", fail)
+        monkeypatch.setattr(backend, "log_get_name_records", fail)
+        monkeypatch.setattr(backend, "log_get_name_index", fail)
+
+        with darshan.DarshanReport(log_path, read_all=not lazy, lazy=lazy,
+                                   dtype="pandas", cache=str(tmp_path)) as report:
+            for mod in mods:
+                if "DXT" in mod:
+                    for rec, expected_rec in zip(report.records[mod].to_df(),
+                                                 expected.records[mod].to_df()):
+                        assert rec["id"] == expected_rec["id"]
+                        assert rec["hostname"] == expected_rec["hostname"]
+                        assert_frame_equal(rec["write_segments"], expected_rec["write_segments"])
+                        assert_frame_equal(rec["read_segments"], expected_rec["read_segments"])
+                else:
+                    for key in ["counters", "fcounters"]:
+                        assert_frame_equal(report.records[mod][0][key],
+                                           expected.records[mod][0][key])
+            for rec_id, name in report.name_records.items():
+                assert expected.name_records[rec_id] == name
+            if not lazy:
+                assert report.name_records == expected.name_records
+
+
+def test_cache_invalidation(tmp_path):
+    # replacing a log discards the cache entries of its old contents
+    log_path = str(tmp_path / "test.darshan")
+    shutil.copy(get_log_path("sample.darshan"), log_path)
+    cache = LogCache(log_path)
+    cache.put("POSIX", {"id": np.arange(3, dtype=np.uint64)})
+    assert "POSIX" in LogCache(log_path)
+    np.testing.assert_array_equal(LogCache(log_path).get("POSIX")["id"], [0, 1, 2])
+
+    shutil.copy(get_log_path("sample-dxt-simple.darshan"), log_path)
+    cache = LogCache(log_path)
+    assert "POSIX" not in cache
+    assert cache.get("POSIX") is None
+    cache.put("STDIO", {"id": np.arange(2, dtype=np.uint64)})
+    assert not os.path.exists(cache._column_path("POSIX", "id"))
+    assert "STDIO" in LogCache(log_path)
+
+
+def test_cache_entry_names(tmp_path):
+    # entry and column names need not be valid file names
+    log_path = str(tmp_path / "test.darshan")
+    shutil.copy(get_log_path("sample.darshan"), log_path)
+    cache = LogCache(log_path)
+    cache.put("BG/Q", {"id/rank": np.arange(3, dtype=np.int64)})
+    cache.put("..", {".": np.arange(2, dtype=np.int64)})
+    assert cache.writable
+    cache = LogCache(log_path)
+    np.testing.assert_array_equal(cache.get("BG/Q")["id/rank"], [0, 1, 2])
+    np.testing.assert_array_equal(cache.get("..")["."], [0, 1])
+
+
+def test_cache_failed_put(tmp_path, monkeypatch):
+    # a failed write disables the cache without leaving temporary files
+    log_path = str(tmp_path / "test.darshan")
+    shutil.copy(get_log_path("sample.darshan"), log_path)
+    cache = LogCache(log_path)
+    cache.put("POSIX", {"id": np.arange(3, dtype=np.uint64)})
+
+    def fail(*args, **kwargs):
+        raise OSError("disk full")
+    monkeypatch.setattr(np, "save", fail)
+    cache.put("STDIO", {"id": np.arange(2, dtype=np.uint64)})
+    assert not cache.writable
+    assert "STDIO" not in LogCache(log_path)
+    assert not [name for name in os.listdir(cache.cache_dir)
+                if name.endswith(".tmp")]
@@ -162,6 +162,121 @@ def test_log_get_generic_record(dtype):
         assert actual_fcounter_names == expected_fcounter_names
 
 
+@pytest.mark.parametrize("log_name, module", [
+    ("sample.darshan", "POSIX"),
+    ("ior_hdf5_example.darshan", "MPI-IO"),
+    ("ior_hdf5_example.darshan", "STDIO"),
+    ("ior_hdf5_example.darshan", "H5D"),
+    ])
+def test_log_get_record_matrix(log_name, module):
+    # the whole-module matrix should hold the same records, in the
+    # same order, as reading them one at a time
+    log_path = get_log_path(log_name)
+    log = backend.log_open(log_path)
+    matrix = backend.log_get_record_matrix(log, module)
+    backend.log_close(log)
+
+    log = backend.log_open(log_path)
+    recs = []
+    rec = backend.log_get_generic_record(log, module)
+    while rec is not None:
+        recs.append(rec)
+        rec = backend.log_get_generic_record(log, module)
+    backend.log_close(log)
+
+    assert matrix["id"].dtype == np.uint64
+    assert matrix["counters"].shape == (len(recs), len(backend.counter_names(module)))
+    assert matrix["fcounters"].shape == (len(recs), len(backend.fcounter_names(module)))
+    assert_array_equal(matrix["id"], [rec["id"] for rec in recs])
+    assert_array_equal(matrix["rank"], [rec["rank"] for rec in recs])
+    assert_array_equal(matrix["counters"], [rec["counters"] for rec in recs])
+    assert_array_equal(matrix["fcounters"], [rec["fcounters"] for rec in recs])
+    if module == "H5D":
+        assert_array_equal(matrix["file_rec_id"],
+                           [rec["file_rec_id"] for rec in recs])
+
+    # and mod_read_all_records() should build its DataFrames from it
+    with darshan.DarshanReport(log_path, read_all=False) as report:
+        report.mod_read_all_records(module, dtype="pandas")
+        df = report.records[module][0]["counters"]
+    assert list(df.columns) == ["id", "rank"] + backend.counter_names(module)
+    assert_array_equal(df.iloc[:, 2:].to_numpy(), matrix["counters"])
+
+
+@pytest.mark.parametrize("log_name, module", [
+    ("sample.darshan", "POSIX"),
+    ("ior_hdf5_example.darshan", "POSIX"),
+    ("ior_hdf5_example.darshan", "MPI-IO"),
+    ("ior_hdf5_example.darshan", "STDIO"),
+    ])
+def test_log_accumulate_module(log_name, module):
+    # streaming a module into the accumulator at the C level gives the
+    # same derived metrics and summary record as accumulating its records
+    # from DataFrames, whether or not the module was read before
+    with darshan.DarshanReport(get_log_path(log_name), lazy=True) as report:
+        expected = backend.accumulate_records(report.records[module].to_df(), module,
+                                              report.metadata["job"]["nprocs"])
+        actual = backend.log_accumulate_module(report.log, module)
+        # the module can be read again afterwards
+        num_recs = len(backend.log_get_record_matrix(report.log, module)["id"])
+
+    assert num_recs == len(report.records[module])
+    for name in ["total_bytes", "agg_perf_by_slowest", "agg_time_by_slowest",
+                 "unique_io_slowest_rank", "shared_io_total_time_by_slowest"]:
+        assert getattr(actual.derived_metrics, name) == getattr(expected.derived_metrics, name)
+    for index in range(7):
+        assert (ffi.buffer(ffi.addressof(actual.derived_metrics.category_counters[index]))[:] ==
+                ffi.buffer(ffi.addressof(expected.derived_metrics.category_counters[index]))[:])
+    for key in ["counters", "fcounters"]:
+        assert actual.summary_record[key].equals(expected.summary_record[key])
+
+
+def test_log_accumulate_module_unsupported():
+    # DXT records can not be accumulated, absent modules are skipped
+    log = backend.log_open(get_log_path("sample-dxt-simple.darshan"))
+    try:
+        with pytest.raises(RuntimeError, match="darshan_log_accumulate_module"):
+            backend.log_accumulate_module(log, "DXT_POSIX")
+        assert backend.log_accumulate_module(log, "STDIO") is None
+    finally:
+        backend.log_close(log)
+
+
+@pytest.mark.parametrize("log_name", [
+    "sample.darshan",
+    "sample-dxt-simple.darshan",
+    "noposix.darshan",
+    ])
+def test_log_get_name_index(log_name):
+    # the names indexed in place in the inflated name region should match
+    # those copied out one at a time, with or without a whitelist
+    log = backend.log_open(get_log_path(log_name))
+    try:
+        nrecs = ffi.new("struct darshan_name_record **")
+        cnt = ffi.new("int *")
+        libdutil.darshan_log_get_name_records(log['handle'], nrecs, cnt)
+        expected = {}
+        for i in range(cnt[0]):
+            expected[nrecs[0][i].id] = ffi.string(nrecs[0][i].name).decode("utf-8")
+            libdutil.darshan_free(nrecs[0][i].name)
+        libdutil.darshan_free(nrecs[0])
+
+        index = backend.log_get_name_index(log)
+        assert index["id"].dtype == np.uint64
+        # ids repeated in the region stay in the index; the first name wins
+        assert_array_equal(np.unique(index["id"]),
+                           np.unique(np.array(list(expected.keys()), dtype=np.uint64)))
+        assert backend.name_index_to_dict(index) == expected
+
+        ids = list(expected.keys())[::2] + [12345]
+        index = backend.log_get_name_index(log, ids)
+        assert backend.name_index_to_dict(index) == {
+            rec_id: expected[rec_id] for rec_id in ids if rec_id in expected}
+        assert backend.name_index_to_dict(backend.log_get_name_index(log, [])) == {}
+    finally:
+        backend.log_close(log)
+
+
 @pytest.mark.parametrize("log_name", [
     "imbalanced-io.darshan",
     "e3sm_io_heatmap_only.darshan",
@@ -602,3 +602,36 @@ def test_get_heatmap_df(
             assert actual_hmap_data.values.sum() == 4202504
         elif ops[0] == "write":
             assert actual_hmap_data.values.sum() == 4195800
+
+
+@pytest.mark.parametrize("lazy", [False, True])
+@pytest.mark.parametrize("ops", [["read"], ["write"], ["read", "write"]])
+def test_get_heatmap_df_arrays(lazy, ops):
+    # the heatmap built from the event arrays (and from the segments of
+    # lazily read records) matches the one built from the aggregate dataframe
+    filepath = get_log_path("ior_hdf5_example.darshan")
+    with darshan.DarshanReport(filepath) as report:
+        agg_df = heatmap_handling.get_aggregate_data(report=report, ops=ops)
+        expected = heatmap_handling.get_heatmap_df(agg_df=agg_df, xbins=50, nprocs=4)
+    with darshan.DarshanReport(filepath, lazy=lazy) as report:
+        agg_data = heatmap_handling.get_aggregate_arrays(report=report, ops=ops)
+        actual = heatmap_handling.get_heatmap_df(agg_df=agg_data, xbins=50, nprocs=4)
+    pd.testing.assert_frame_equal(actual, expected)
+
+
+def test_get_heatmap_df_bin_edges():
+    # events starting/ending exactly on bin edges are binned like
+    # ``pd.cut()`` intervals, spanning events are shared out over
+    # bins in proportion to the time spent in each, and events ending
+    # after the last bin only contribute to the bin they start in
+    agg_df = pd.DataFrame({"length": [10, 20, 30, 40, 50],
+                           "start_time": [0.0, 1.0, 1.5, 0.5, 3.5],
+                           "end_time": [1.0, 2.0, 2.5, 3.5, 5.0],
+                           "rank": [0, 0, 1, 1, 2]})
+    actual = heatmap_handling.get_heatmap_df(agg_df=agg_df, xbins=4, nprocs=3, max_time=4.0)
+    expected = np.array([[10 / 1, 20, 0, 0],
+                         [40 / 6, 15 + 40 / 3, 15 + 40 / 3, 40 / 6],
+                         [0, 0, 0, 50 * (1 / 1.5) * 0.5]])
+    assert_allclose(actual.values, expected)
+    assert actual.columns[0] == pd.Interval(0.0, 1.0)
+    assert actual.index.name == "rank"
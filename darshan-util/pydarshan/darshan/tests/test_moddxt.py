@@ -37,3 +37,135 @@ def test_dxt_records(logfile, mod, expected_dict):
     log = backend.log_open(logfile)
     rec = backend.log_get_record(log, mod)
     assert rec == expected_dict
+
+
+@pytest.mark.parametrize("logfile", [
+    "dxt.darshan",
+    "sample-dxt-simple.darshan",
+    ])
+def test_dxt_conflicts(logfile):
+    # compare the C conflict analysis against a direct
+    # computation from the DXT records
+    logfile = get_log_path(logfile)
+    log = backend.log_open(logfile)
+    actual = backend.log_get_dxt_conflicts(log)
+    backend.log_close(log)
+
+    log = backend.log_open(logfile)
+    segs = {}
+    for mod in ["DXT_POSIX", "DXT_MPIIO"]:
+        while True:
+            rec = backend.log_get_record(log, mod)
+            if rec is None:
+                break
+            for op in ["write", "read"]:
+                for seg in rec[f"{op}_segments"]:
+                    if seg["offset"] < 0 or seg["length"] <= 0:
+                        continue
+                    segs.setdefault((mod, rec["id"]), []).append(
+                        (op, rec["rank"], seg["offset"],
+                         seg["offset"] + seg["length"],
+                         seg["start_time"], seg["end_time"]))
+    backend.log_close(log)
+
+    assert len(actual) == len(segs)
+    for row in actual.itertuples():
+        file_segs = segs[(row.module, row.id)]
+        writes = [s for s in file_segs if s[0] == "write"]
+        reads = [s for s in file_segs if s[0] == "read"]
+        assert row.write_count == len(writes)
+        assert row.read_count == len(reads)
+        assert row.write_bytes == sum(w[3] - w[2] for w in writes)
+
+        unique = 0
+        end = -1
+        for w in sorted(writes, key=lambda w: w[2]):
+            if w[3] > end:
+                unique += w[3] - max(w[2], end)
+                end = w[3]
+        assert row.unique_write_bytes == unique
+        if writes:
+            assert row.max_write_offset == end
+            assert row.coverage == pytest.approx(unique / end)
+
+        def overlaps(a, b):
+            return a[1] != b[1] and a[2] < b[3] and b[2] < a[3]
+        assert row.overlapping_writes == sum(
+            any(overlaps(w, o) for o in writes) for w in writes)
+        assert row.raw_reads == sum(
+            any(overlaps(r, w) and w[4] < r[5] for w in writes) for r in reads)
+        assert row.raw_races == sum(
+            any(overlaps(r, w) and w[4] < r[5] and w[5] > r[4] for w in writes)
+            for r in reads)
+
+
+@pytest.mark.parametrize("logfile", [
+    "dxt.darshan",
+    "sample-dxt-simple.darshan",
+    ])
+@pytest.mark.parametrize("mod", ["DXT_POSIX", "DXT_MPIIO"])
+def test_dxt_segments(logfile, mod):
+    # the bulk segment decoder should match the per-record path
+    logfile = get_log_path(logfile)
+    log = backend.log_open(logfile)
+    segs = backend.log_get_dxt_segments(log, mod)
+    backend.log_close(log)
+
+    log = backend.log_open(logfile)
+    if mod not in backend.log_get_modules(log):
+        assert segs is None
+        return
+    expected = {k: [] for k in segs}
+    while True:
+        rec = backend.log_get_record(log, mod)
+        if rec is None:
+            break
+        for op, code in [("write", 1), ("read", 2)]:
+            for seg in rec[f"{op}_segments"]:
+                expected["rec_index"].append(len(expected["id"]))
+                expected["rank"].append(rec["rank"])
+                expected["op"].append(code)
+                for field in ["offset", "length", "start_time", "end_time"]:
+                    expected[field].append(seg[field])
+        expected["id"].append(rec["id"])
+    backend.log_close(log)
+
+    for field, values in expected.items():
+        assert segs[field].tolist() == values
+
+
+@pytest.mark.parametrize("lazy", [False, True])
+@pytest.mark.parametrize("reads, writes", [
+    (True, True),
+    (True, False),
+    (False, True),
+    (False, False),
+    ])
+def test_dxt_record_filters(lazy, reads, writes):
+    # excluded segments are left empty, whether or not records are lazy
+    log = backend.log_open(get_log_path("dxt.darshan"))
+    try:
+        while True:
+            expected = backend.log_get_dxt_record(log, "DXT_POSIX")
+            if expected is None:
+                break
+            if expected["write_count"] and expected["read_count"]:
+                break
+    finally:
+        backend.log_close(log)
+    assert expected is not None
+
+    log = backend.log_open(get_log_path("dxt.darshan"))
+    try:
+        while True:
+            rec = backend.log_get_dxt_record(log, "DXT_POSIX", reads=reads,
+                                             writes=writes, lazy=lazy)
+            if rec["id"] == expected["id"] and rec["rank"] == expected["rank"]:
+                break
+    finally:
+        backend.log_close(log)
+
+    assert rec["write_count"] == expected["write_count"]
+    assert rec["read_count"] == expected["read_count"]
+    assert rec["write_segments"] == (expected["write_segments"] if writes else [])
+    assert rec["read_segments"] == (expected["read_segments"] if reads else [])
@@ -74,6 +74,38 @@ def test_load_records():
         assert 1 == len(report.data['records']['POSIX'])
 
 
+def test_lazy_load_records():
+    # a lazy report reads a module's records on first access, and ends
+    # up with the same records as an eagerly read report
+    log_path = get_log_path("sample-dxt-simple.darshan")
+    with darshan.DarshanReport(log_path, read_all=True) as eager_report, \
+         darshan.DarshanReport(log_path, lazy=True) as report:
+        assert len(report.records) == 0
+        assert len(report.name_records) == 0
+
+        assert_frame_equal(report.records["POSIX"].to_df()["counters"],
+                           eager_report.records["POSIX"].to_df()["counters"])
+        assert list(report.records) == ["POSIX"]
+        posix_ids = set(report.records["POSIX"].to_df()["counters"]["id"])
+        assert set(report.name_records) == posix_ids
+        for rec_id, name in report.name_records.items():
+            assert eager_report.name_records[rec_id] == name
+
+        # DXT segments are only decoded once a record's segments are used
+        dxt_records = report.records["DXT_POSIX"]._records
+        assert not any(dict.__contains__(rec, "read_segments") for rec in dxt_records)
+        assert dxt_records[0]["id"] == eager_report.records["DXT_POSIX"]._records[0]["id"]
+        assert not dict.__contains__(dxt_records[0], "read_segments")
+        for rec, eager_rec in zip(report.records["DXT_POSIX"].to_df(),
+                                  eager_report.records["DXT_POSIX"].to_df()):
+            assert rec.keys() == eager_rec.keys()
+            for key in ["write_segments", "read_segments"]:
+                assert_frame_equal(rec[key], eager_rec[key])
+
+        with pytest.raises(KeyError):
+            report.records["H5D"]
+        assert report.records.get("H5D") is None
+
 @pytest.mark.parametrize("unsupported_record",
         ["DXT_POSIX", "DXT_MPIIO", "LUSTRE", "APMPI", "APXC"]
         )
@@ -413,6 +445,37 @@ def test_runtime_heatmap_retrieval(capsys, logname, hmap_types, nbins, bin_width
                 assert element in captured.out
 
 
+def test_heatmap_rank_matrix_records():
+    # rank matrix records cover a block of consecutive ranks and should
+    # be split into per-rank rows just like ordinary heatmap records
+    from darshan.datatypes.heatmap import Heatmap
+    heatmap = Heatmap("POSIX")
+    write_bins = np.arange(12, dtype=np.int64).reshape(3, 4)
+    read_bins = 2 * write_bins
+    heatmap.add_record({"id": 16592106915301738621,
+                        "rank": 4,
+                        "bin_width_seconds": 0.1,
+                        "nbins": 4,
+                        "start_time_seconds": 0.0,
+                        "nranks": 3,
+                        "write_bins": write_bins,
+                        "read_bins": read_bins})
+    heatmap.add_record({"id": 16592106915301738621,
+                        "rank": 0,
+                        "bin_width_seconds": 0.1,
+                        "nbins": 4,
+                        "start_time_seconds": 0.0,
+                        "nranks": 0,
+                        "write_bins": np.ones(4, dtype=np.int64),
+                        "read_bins": np.zeros(4, dtype=np.int64)})
+    assert heatmap._ranks == {0, 4, 5, 6}
+    write_df = heatmap.to_df(["write"], interval_index=False).sort_index()
+    assert list(write_df.index) == [0, 4, 5, 6]
+    assert_allclose(write_df.loc[5].values, [4, 5, 6, 7])
+    assert_allclose(heatmap.to_df(["read", "write"]).loc[6].values,
+                    [24, 27, 30, 33])
+
+
 def test_runtime_dxt_heatmap_similarity():
     # this log file should have a similar "diagonal"
     # data structure in both DXT and runtime HEATMAP forms;
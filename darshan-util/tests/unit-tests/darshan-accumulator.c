@@ -11,6 +11,8 @@
 
 static MunitResult inject_shared_file_records(const MunitParameter params[], void* data);
 static MunitResult inject_unique_file_records(const MunitParameter params[], void* data);
+static MunitResult merge_accumulators(const MunitParameter params[], void* data);
+static MunitResult inject_parallel_records(const MunitParameter params[], void* data);
 static void* test_context_setup(const MunitParameter params[], void* user_data);
 static void test_context_tear_down(void *data);
 
@@ -20,6 +22,7 @@ static void stdio_set_dummy_record(void* buffer);
 static void stdio_validate_double_dummy_record(void* buffer, struct darshan_derived_metrics* metrics, int shared_file_flag);
 static void mpiio_set_dummy_record(void* buffer);
 static void mpiio_validate_double_dummy_record(void* buffer, struct darshan_derived_metrics* metrics, int shared_file_flag);
+static void vary_dummy_record(darshan_module_id mod_id, void* buffer, int i);
 
 
 /* test definition */
@@ -35,6 +38,12 @@ static MunitTest tests[]
        {"/inject-unique-file-records", inject_unique_file_records,
         test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
         test_params},
+       {"/merge-accumulators", merge_accumulators,
+        test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
+        test_params},
+       {"/inject-parallel-records", inject_parallel_records,
+        test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
+        test_params},
        {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
 
 static const MunitSuite test_suite = {
@@ -237,12 +246,272 @@ static MunitResult inject_unique_file_records(const MunitParameter params[], voi
     return MUNIT_OK;
 }
 
+/* test combining accumulators that were each fed one of the records, for
+ * both shared and unique files
+ */
+static MunitResult merge_accumulators(const MunitParameter params[], void* data)
+{
+    struct test_context* ctx = (struct test_context*)data;
+    int ret;
+    int shared_file_flag;
+    darshan_accumulator acc1, acc2, acc_other;
+    struct darshan_derived_metrics metrics;
+    void* record1;
+    void* record2;
+    void* record_agg;
+    struct darshan_base_record* base_rec;
+
+    record1 = malloc(DEF_MOD_BUF_SIZE);
+    munit_assert_not_null(record1);
+    record2 = malloc(DEF_MOD_BUF_SIZE);
+    munit_assert_not_null(record2);
+    record_agg = malloc(DEF_MOD_BUF_SIZE);
+    munit_assert_not_null(record_agg);
+
+    munit_assert_not_null(set_dummy_fn[ctx->mod_id]);
+
+    for(shared_file_flag = 1; shared_file_flag >= 0; shared_file_flag--) {
+        set_dummy_fn[ctx->mod_id](record1);
+        set_dummy_fn[ctx->mod_id](record2);
+        base_rec = record2;
+        base_rec->rank++;
+        if(!shared_file_flag)
+            base_rec->id++;
+
+        ret = darshan_accumulator_create(ctx->mod_id, 4, &acc1);
+        munit_assert_int(ret, ==, 0);
+        ret = darshan_accumulator_create(ctx->mod_id, 4, &acc2);
+        munit_assert_int(ret, ==, 0);
+
+        /* inject one example record into each accumulator */
+        ret = darshan_accumulator_inject(acc1, record1, 1);
+        munit_assert_int(ret, ==, 0);
+        ret = darshan_accumulator_inject(acc2, record2, 1);
+        munit_assert_int(ret, ==, 0);
+
+        /* accumulators of a different job size can't be merged */
+        ret = darshan_accumulator_create(ctx->mod_id, 8, &acc_other);
+        munit_assert_int(ret, ==, 0);
+        ret = darshan_accumulator_merge(acc1, acc_other);
+        munit_assert_int(ret, ==, -1);
+        ret = darshan_accumulator_destroy(acc_other);
+        munit_assert_int(ret, ==, 0);
+
+        ret = darshan_accumulator_merge(acc1, acc2);
+        munit_assert_int(ret, ==, 0);
+
+        /* the merged accumulator looks like it was fed both records */
+        ret = darshan_accumulator_emit(acc1, &metrics, record_agg);
+        munit_assert_int(ret, ==, 0);
+        validate_double_dummy_fn[ctx->mod_id](record_agg, &metrics, shared_file_flag);
+
+        /* the merged-from accumulator is left empty */
+        ret = darshan_accumulator_emit(acc2, &metrics, record_agg);
+        munit_assert_int(ret, ==, 0);
+        munit_assert_int64(metrics.total_bytes, ==, 0);
+        munit_assert_int64(metrics.category_counters[DARSHAN_ALL_FILES].count, ==, 0);
+
+        ret = darshan_accumulator_destroy(acc1);
+        munit_assert_int(ret, ==, 0);
+        ret = darshan_accumulator_destroy(acc2);
+        munit_assert_int(ret, ==, 0);
+    }
+
+    free(record1);
+    free(record2);
+    free(record_agg);
+
+    return MUNIT_OK;
+}
+
+/* test that multi-threaded injects match a single-threaded one exactly;
+ * thread counts are set explicitly, so the worker threads run however many
+ * CPUs the test machine has
+ */
+static MunitResult inject_parallel_records(const MunitParameter params[], void* data)
+{
+    struct test_context* ctx = (struct test_context*)data;
+    int ret;
+    int i, j;
+    int record_size;
+    int record_count = 20000;
+    int nprocs = 16;
+    /* 20000 records are split over at most 4 threads (4096 or more each) */
+    int nthreads[] = {2, 3, 4, 16};
+    int t;
+    darshan_accumulator acc_serial, acc_parallel;
+    struct darshan_derived_metrics metrics_serial, metrics_parallel;
+    struct darshan_file_category_counters *cat_serial, *cat_parallel;
+    const struct darshan_counter_layout *layout;
+    int64_t *counters_serial, *counters_parallel;
+    double *fcounters_serial, *fcounters_parallel;
+    char* record_array;
+    void* record_agg_serial;
+    void* record_agg_parallel;
+    struct darshan_base_record* base_rec;
+
+    record_agg_serial = malloc(DEF_MOD_BUF_SIZE);
+    munit_assert_not_null(record_agg_serial);
+    record_agg_parallel = malloc(DEF_MOD_BUF_SIZE);
+    munit_assert_not_null(record_agg_parallel);
+
+    munit_assert_not_null(set_dummy_fn[ctx->mod_id]);
+
+    /* pack many records for a handful of files, each opened by a few ranks
+     * or shared by all of them, with more distinct access sizes than the
+     * aggregate record's common values can hold and times that vary by rank
+     */
+    set_dummy_fn[ctx->mod_id](record_agg_serial);
+    record_size = ctx->mod_fns->log_sizeof_record(record_agg_serial);
+    record_array = malloc((size_t)record_count * record_size);
+    munit_assert_not_null(record_array);
+    for(i = 0; i < record_count; i++) {
+        memcpy(&record_array[(size_t)i * record_size], record_agg_serial, record_size);
+        base_rec = (struct darshan_base_record*)&record_array[(size_t)i * record_size];
+        base_rec->id += i % 97;
+        if(i % 97 == 0)
+            base_rec->rank = -1;
+        else
+            base_rec->rank = (i / 97) % nprocs;
+        vary_dummy_record(ctx->mod_id, base_rec, i);
+    }
+
+    ret = darshan_accumulator_create(ctx->mod_id, nprocs, &acc_serial);
+    munit_assert_int(ret, ==, 0);
+    ret = darshan_accumulator_inject(acc_serial, record_array, record_count);
+    munit_assert_int(ret, ==, 0);
+    ret = darshan_accumulator_emit(acc_serial, &metrics_serial, record_agg_serial);
+    munit_assert_int(ret, ==, 0);
+
+    ret = darshan_accumulator_set_threads(acc_serial, 0);
+    munit_assert_int(ret, ==, -1);
+
+    for(t = 0; t < (int)(sizeof(nthreads) / sizeof(nthreads[0])); t++) {
+        ret = darshan_accumulator_create(ctx->mod_id, nprocs, &acc_parallel);
+        munit_assert_int(ret, ==, 0);
+        ret = darshan_accumulator_set_threads(acc_parallel, nthreads[t]);
+        munit_assert_int(ret, ==, 0);
+        ret = darshan_accumulator_inject(acc_parallel, record_array, record_count);
+        munit_assert_int(ret, ==, 0);
+        ret = darshan_accumulator_emit(acc_parallel, &metrics_parallel, record_agg_parallel);
+        munit_assert_int(ret, ==, 0);
+
+        /* derived metrics should match exactly, time sums included */
+        munit_assert_int64(metrics_parallel.total_bytes, ==, metrics_serial.total_bytes);
+        munit_assert_int(metrics_parallel.unique_io_slowest_rank, ==, metrics_serial.unique_io_slowest_rank);
+        munit_assert_double(metrics_parallel.unique_io_total_time_by_slowest, ==, metrics_serial.unique_io_total_time_by_slowest);
+        munit_assert_double(metrics_parallel.shared_io_total_time_by_slowest, ==, metrics_serial.shared_io_total_time_by_slowest);
+        munit_assert_double(metrics_parallel.agg_perf_by_slowest, ==, metrics_serial.agg_perf_by_slowest);
+        for(j = 0; j < DARSHAN_FILE_CATEGORY_MAX; j++) {
+            cat_serial = &metrics_serial.category_counters[j];
+            cat_parallel = &metrics_parallel.category_counters[j];
+            munit_assert_int64(cat_parallel->count, ==, cat_serial->count);
+            munit_assert_int64(cat_parallel->total_read_volume_bytes, ==, cat_serial->total_read_volume_bytes);
+            munit_assert_int64(cat_parallel->total_write_volume_bytes, ==, cat_serial->total_write_volume_bytes);
+            munit_assert_int64(cat_parallel->max_offset_bytes, ==, cat_serial->max_offset_bytes);
+            munit_assert_int64(cat_parallel->nprocs, ==, cat_serial->nprocs);
+        }
+
+        /* and the aggregate record should be identical, down to the common
+         * access sizes and the fastest and slowest ranks
+         */
+        munit_assert_int64(((struct darshan_base_record*)record_agg_parallel)->id, ==,
+            ((struct darshan_base_record*)record_agg_serial)->id);
+        munit_assert_int64(((struct darshan_base_record*)record_agg_parallel)->rank, ==,
+            ((struct darshan_base_record*)record_agg_serial)->rank);
+        layout = darshan_log_get_counter_layout(ctx->mod_id);
+        munit_assert_not_null(layout);
+        counters_serial = (int64_t*)((char*)record_agg_serial + layout->counters_off);
+        counters_parallel = (int64_t*)((char*)record_agg_parallel + layout->counters_off);
+        for(j = 0; j < layout->ncounters; j++) {
+            if(counters_parallel[j] != counters_serial[j])
+                munit_errorf("%s: %" PRId64 " != %" PRId64, layout->counter_names[j],
+                    counters_parallel[j], counters_serial[j]);
+        }
+        fcounters_serial = (double*)((char*)record_agg_serial + layout->fcounters_off);
+        fcounters_parallel = (double*)((char*)record_agg_parallel + layout->fcounters_off);
+        for(j = 0; j < layout->nfcounters; j++) {
+            if(fcounters_parallel[j] != fcounters_serial[j])
+                munit_errorf("%s: %f != %f", layout->fcounter_names[j],
+                    fcounters_parallel[j], fcounters_serial[j]);
+        }
+
+        ret = darshan_accumulator_destroy(acc_parallel);
+        munit_assert_int(ret, ==, 0);
+    }
+
+    ret = darshan_accumulator_destroy(acc_serial);
+    munit_assert_int(ret, ==, 0);
+
+    free(record_array);
+    free(record_agg_serial);
+    free(record_agg_parallel);
+
+    return MUNIT_OK;
+}
 
 int main(int argc, char **argv)
 {
     return munit_suite_main(&test_suite, NULL, argc, argv);
 }
 
+/* Perturb the i'th copy of a dummy record: spread its accesses over 12
+ * distinct sizes and vary its I/O times, so that the common access counters
+ * and the fastest/slowest rank counters of an aggregate record depend on
+ * all of the records.
+ */
+static void vary_dummy_record(darshan_module_id mod_id, void* buffer, int i)
+{
+    int64_t *access = NULL, *count = NULL;
+    double *read_time, *write_time, *meta_time;
+    int k;
+
+    switch(mod_id) {
+        case DARSHAN_POSIX_MOD:
+        {
+            struct darshan_posix_file *rec = buffer;
+            access = &rec->counters[POSIX_ACCESS1_ACCESS];
+            count = &rec->counters[POSIX_ACCESS1_COUNT];
+            read_time = &rec->fcounters[POSIX_F_READ_TIME];
+            write_time = &rec->fcounters[POSIX_F_WRITE_TIME];
+            meta_time = &rec->fcounters[POSIX_F_META_TIME];
+            break;
+        }
+        case DARSHAN_MPIIO_MOD:
+        {
+            struct darshan_mpiio_file *rec = buffer;
+            access = &rec->counters[MPIIO_ACCESS1_ACCESS];
+            count = &rec->counters[MPIIO_ACCESS1_COUNT];
+            read_time = &rec->fcounters[MPIIO_F_READ_TIME];
+            write_time = &rec->fcounters[MPIIO_F_WRITE_TIME];
+            meta_time = &rec->fcounters[MPIIO_F_META_TIME];
+            break;
+        }
+        case DARSHAN_STDIO_MOD:
+        {
+            struct darshan_stdio_file *rec = buffer;
+            read_time = &rec->fcounters[STDIO_F_READ_TIME];
+            write_time = &rec->fcounters[STDIO_F_WRITE_TIME];
+            meta_time = &rec->fcounters[STDIO_F_META_TIME];
+            break;
+        }
+        default:
+            munit_error("no way to vary records of this module");
+    }
+
+    if(access) {
+        for(k = 0; k < 4; k++) {
+            access[k] = 1024 * (1 + (i + 3 * k) % 12);
+            count[k] = 1 + (i * 7 + k) % 5;
+        }
+    }
+    *read_time = 0.001 * (1 + (i * 13) % 31);
+    *write_time = 0.001 * (1 + (i * 13 + 1) % 31);
+    *meta_time = 0.001 * (1 + (i * 13 + 2) % 31);
+
+    return;
+}
+
 /* Set example values for record of type posix.  As elsewhere in the
  * logutils API, the size of the buffer is implied.
  */
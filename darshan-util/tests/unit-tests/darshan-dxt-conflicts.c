@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2022 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "munit/munit.h"
+
+#include <darshan-logutils.h>
+
+static MunitResult analyze_known_conflicts(const MunitParameter params[], void* data);
+
+/* test definition */
+static MunitTest tests[]
+    = {{"/analyze-known-conflicts", analyze_known_conflicts,
+        NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+       {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+static const MunitSuite test_suite = {
+    "/darshan-dxt-conflicts", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE
+};
+
+#define TEST_POSIX_ID 101
+#define TEST_MPIIO_ID 202
+
+/* a segment of a synthetic DXT record */
+struct test_seg
+{
+    int64_t rank;
+    int write;
+    int64_t offset;
+    int64_t length;
+    double start_time;
+    double end_time;
+};
+
+/* POSIX segments of a single file, accessed by 3 ranks:
+ *  - rank 2's write of [50, 60) overlaps rank 0's write of [0, 100)
+ *  - rank 1's write of [150, 250) overlaps rank 0's write of [100, 200),
+ *    and rank 2's write of [180, 190) overlaps both
+ *  - rank 1 rewrites [400, 450) itself, which is not a conflict
+ *  - rank 1 reads [0, 50) long after rank 0 wrote it (a read after write)
+ *  - rank 0 reads [160, 170) while rank 1 is writing it (a race)
+ *  - rank 0 reads [400, 410) before rank 1 writes it, rank 1 reads its
+ *    own writes and rank 2 reads bytes nobody wrote, none of which count
+ */
+static const struct test_seg posix_segs[] =
+{
+    {0, 1, 0, 100, 1.0, 1.1},
+    {0, 1, 100, 100, 1.2, 1.3},
+    {0, 0, 160, 10, 2.05, 2.06},
+    {0, 0, 400, 10, 0.5, 0.6},
+    {1, 1, 150, 100, 2.0, 2.1},
+    {1, 1, 400, 100, 2.2, 2.3},
+    {1, 1, 400, 50, 2.4, 2.5},
+    {1, 0, 0, 50, 5.0, 5.1},
+    {1, 0, 420, 10, 9.0, 9.1},
+    {2, 1, 50, 10, 3.0, 3.1},
+    {2, 1, 180, 10, 3.2, 3.3},
+    {2, 0, 300, 50, 9.0, 9.1},
+};
+
+/* MPI-IO segments of another file: disjoint writes by 2 ranks, one of
+ * them without a valid offset, and a read of the other rank's write
+ */
+static const struct test_seg mpiio_segs[] =
+{
+    {0, 1, 0, 10, 1.0, 2.0},
+    {0, 0, 10, 10, 3.0, 4.0},
+    {1, 1, 10, 10, 1.0, 2.0},
+    {1, 1, -1, 10, 1.5, 2.5},
+};
+
+/* build the DXT record of a rank from a segment list (writes first) */
+static struct dxt_file_record *make_dxt_record(darshan_record_id id,
+    int64_t rank, const struct test_seg *segs, int nsegs)
+{
+    struct dxt_file_record *rec;
+    segment_info *info;
+    int64_t n = 0;
+    int write;
+    int i;
+
+    rec = calloc(1, sizeof(*rec) + nsegs * sizeof(segment_info));
+    munit_assert_not_null(rec);
+    rec->base_rec.id = id;
+    rec->base_rec.rank = rank;
+    info = (segment_info *)((char *)rec + sizeof(*rec));
+    for(write = 1; write >= 0; write--)
+    {
+        for(i = 0; i < nsegs; i++)
+        {
+            if(segs[i].rank != rank || segs[i].write != write)
+                continue;
+            info[n].offset = segs[i].offset;
+            info[n].length = segs[i].length;
+            info[n].start_time = segs[i].start_time;
+            info[n].end_time = segs[i].end_time;
+            n++;
+            if(write)
+                rec->write_count++;
+            else
+                rec->read_count++;
+        }
+    }
+
+    return(rec);
+}
+
+static void put_dxt_records(darshan_fd fd, darshan_module_id mod_id,
+    darshan_record_id id, const struct test_seg *segs, int nsegs, int nranks)
+{
+    struct dxt_file_record *rec;
+    int64_t rank;
+
+    for(rank = 0; rank < nranks; rank++)
+    {
+        rec = make_dxt_record(id, rank, segs, nsegs);
+        munit_assert_int(mod_logutils[mod_id]->log_put_record(fd, rec), ==, 0);
+        free(rec);
+    }
+
+    return;
+}
+
+/* analyze a log with known overlapping writes and reads after writes
+ * across ranks, and check every reported value
+ */
+static MunitResult analyze_known_conflicts(const MunitParameter params[], void* data)
+{
+    struct dxt_conflict_file *files;
+    char log_path[] = "/tmp/darshan-dxt-conflicts-test.XXXXXX";
+    struct darshan_job job = {0};
+    darshan_name_table names;
+    darshan_fd fd;
+    int count;
+    int tmp_fd;
+
+    tmp_fd = mkstemp(log_path);
+    munit_assert_int(tmp_fd, >=, 0);
+    close(tmp_fd);
+
+    fd = darshan_log_create(log_path, DARSHAN_ZLIB_COMP, 0);
+    munit_assert_not_null(fd);
+    job.nprocs = 3;
+    munit_assert_int(darshan_log_put_job(fd, &job), ==, 0);
+    munit_assert_int(darshan_log_put_exe(fd, "dxt-conflicts-test"), ==, 0);
+    munit_assert_int(darshan_log_put_mounts(fd, NULL, 0), ==, 0);
+    munit_assert_int(darshan_name_table_create(&names), ==, 0);
+    munit_assert_int(darshan_name_table_add(names, TEST_POSIX_ID, "/tmp/posix-file"), ==, 1);
+    munit_assert_int(darshan_name_table_add(names, TEST_MPIIO_ID, "/tmp/mpiio-file"), ==, 1);
+    munit_assert_int(darshan_log_put_name_table(fd, names), ==, 0);
+    darshan_name_table_destroy(names);
+    put_dxt_records(fd, DXT_POSIX_MOD, TEST_POSIX_ID, posix_segs,
+        sizeof(posix_segs) / sizeof(posix_segs[0]), 3);
+    put_dxt_records(fd, DXT_MPIIO_MOD, TEST_MPIIO_ID, mpiio_segs,
+        sizeof(mpiio_segs) / sizeof(mpiio_segs[0]), 2);
+    darshan_log_close(fd);
+
+    fd = darshan_log_open(log_path);
+    munit_assert_not_null(fd);
+    munit_assert_int(dxt_conflicts_analyze(fd, &files, &count), ==, 0);
+    darshan_log_close(fd);
+    unlink(log_path);
+
+    munit_assert_int(count, ==, 2);
+
+    munit_assert_uint64(files[0].rec_id, ==, TEST_POSIX_ID);
+    munit_assert_int(files[0].mod_id, ==, DXT_POSIX_MOD);
+    munit_assert_int64(files[0].write_count, ==, 7);
+    munit_assert_int64(files[0].read_count, ==, 5);
+    munit_assert_int64(files[0].write_bytes, ==, 470);
+    /* [0, 250) and [400, 500) */
+    munit_assert_int64(files[0].unique_write_bytes, ==, 350);
+    /* [50, 60) and [150, 200) */
+    munit_assert_int64(files[0].overlap_write_bytes, ==, 60);
+    munit_assert_int64(files[0].max_write_offset, ==, 500);
+    munit_assert_double_equal(files[0].coverage, 0.7, 9);
+    munit_assert_int64(files[0].overlapping_writes, ==, 5);
+    munit_assert_int64(files[0].raw_reads, ==, 2);
+    munit_assert_int64(files[0].raw_races, ==, 1);
+
+    munit_assert_uint64(files[1].rec_id, ==, TEST_MPIIO_ID);
+    munit_assert_int(files[1].mod_id, ==, DXT_MPIIO_MOD);
+    munit_assert_int64(files[1].write_count, ==, 2);
+    munit_assert_int64(files[1].read_count, ==, 1);
+    munit_assert_int64(files[1].write_bytes, ==, 20);
+    munit_assert_int64(files[1].unique_write_bytes, ==, 20);
+    munit_assert_int64(files[1].overlap_write_bytes, ==, 0);
+    munit_assert_int64(files[1].max_write_offset, ==, 20);
+    munit_assert_double_equal(files[1].coverage, 1.0, 9);
+    munit_assert_int64(files[1].overlapping_writes, ==, 0);
+    munit_assert_int64(files[1].raw_reads, ==, 1);
+    munit_assert_int64(files[1].raw_races, ==, 0);
+
+    free(files);
+
+    return MUNIT_OK;
+}
+
+int main(int argc, char **argv)
+{
+    return munit_suite_main(&test_suite, NULL, argc, argv);
+}
@@ -0,0 +1,364 @@
+/*
+ * Copyright (C) 2022 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "munit/munit.h"
+
+#include <darshan-logutils.h>
+
+static MunitResult query_random_windows(const MunitParameter params[], void* data);
+static MunitResult reuse_index_cache(const MunitParameter params[], void* data);
+
+/* test definition */
+static MunitTest tests[]
+    = {{"/query-random-windows", query_random_windows,
+        NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+       {"/reuse-index-cache", reuse_index_cache,
+        NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+       {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+static const MunitSuite test_suite = {
+    "/darshan-dxt-index", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE
+};
+
+#define TEST_NFILES 4
+#define TEST_NRANKS 4
+#define TEST_MAX_SEGS 300
+#define TEST_NQUERIES 2000
+
+/* a synthetic DXT log: one record per (module, file, rank) */
+struct test_log
+{
+    char path[64];
+    int nrecs;
+    struct dxt_file_record *recs[2 * TEST_NFILES * TEST_NRANKS];
+    int rec_mods[2 * TEST_NFILES * TEST_NRANKS];
+};
+
+static darshan_record_id test_rec_id(int file)
+{
+    return(1000 + 17 * file);
+}
+
+/* generate random segments for a record, including the occasional long
+ * segment that overlaps most of the others
+ */
+static struct dxt_file_record *random_dxt_record(darshan_record_id id,
+    int64_t rank)
+{
+    struct dxt_file_record *rec;
+    segment_info *segs;
+    int64_t nsegs;
+    int64_t i;
+    double start;
+
+    nsegs = munit_rand_int_range(0, TEST_MAX_SEGS);
+    rec = calloc(1, sizeof(*rec) + nsegs * sizeof(segment_info));
+    munit_assert_not_null(rec);
+    rec->base_rec.id = id;
+    rec->base_rec.rank = rank;
+    rec->write_count = nsegs ? munit_rand_int_range(0, nsegs) : 0;
+    rec->read_count = nsegs - rec->write_count;
+
+    segs = (segment_info *)((char *)rec + sizeof(*rec));
+    for(i = 0; i < nsegs; i++)
+    {
+        start = munit_rand_double() * 100.0;
+        /* duplicate start times must keep segment order */
+        if(i > 0 && munit_rand_int_range(0, 10) == 0)
+            start = segs[i - 1].start_time;
+        segs[i].offset = munit_rand_int_range(0, 1 << 20);
+        segs[i].length = munit_rand_int_range(1, 1 << 16);
+        segs[i].start_time = start;
+        if(munit_rand_int_range(0, 50) == 0)
+            segs[i].end_time = start + munit_rand_double() * 100.0;
+        else
+            segs[i].end_time = start + munit_rand_double() * 0.5;
+    }
+
+    return(rec);
+}
+
+static void write_test_log(struct test_log *log)
+{
+    int mods[2] = {DXT_POSIX_MOD, DXT_MPIIO_MOD};
+    struct darshan_job job = {0};
+    darshan_name_table names;
+    darshan_fd fd;
+    char name[32];
+    int tmp_fd;
+    int m, f, r;
+
+    strcpy(log->path, "/tmp/darshan-dxt-index-test.XXXXXX");
+    tmp_fd = mkstemp(log->path);
+    munit_assert_int(tmp_fd, >=, 0);
+    close(tmp_fd);
+
+    log->nrecs = 0;
+    for(m = 0; m < 2; m++)
+        for(f = 0; f < TEST_NFILES; f++)
+            for(r = 0; r < TEST_NRANKS; r++)
+            {
+                log->recs[log->nrecs] = random_dxt_record(test_rec_id(f), r);
+                log->rec_mods[log->nrecs] = mods[m];
+                log->nrecs++;
+            }
+
+    fd = darshan_log_create(log->path, DARSHAN_ZLIB_COMP, 0);
+    munit_assert_not_null(fd);
+    job.nprocs = TEST_NRANKS;
+    munit_assert_int(darshan_log_put_job(fd, &job), ==, 0);
+    munit_assert_int(darshan_log_put_exe(fd, "dxt-index-test"), ==, 0);
+    munit_assert_int(darshan_log_put_mounts(fd, NULL, 0), ==, 0);
+    munit_assert_int(darshan_name_table_create(&names), ==, 0);
+    for(f = 0; f < TEST_NFILES; f++)
+    {
+        snprintf(name, sizeof(name), "/tmp/file%d", f);
+        munit_assert_int(darshan_name_table_add(names, test_rec_id(f), name), ==, 1);
+    }
+    munit_assert_int(darshan_log_put_name_table(fd, names), ==, 0);
+    darshan_name_table_destroy(names);
+    for(r = 0; r < log->nrecs; r++)
+        munit_assert_int(
+            mod_logutils[log->rec_mods[r]]->log_put_record(fd, log->recs[r]), ==, 0);
+    darshan_log_close(fd);
+
+    return;
+}
+
+static void free_test_log(struct test_log *log)
+{
+    char cache_path[128];
+    int i;
+
+    snprintf(cache_path, sizeof(cache_path), "%s.dxtidx", log->path);
+    unlink(cache_path);
+    unlink(log->path);
+    for(i = 0; i < log->nrecs; i++)
+        free(log->recs[i]);
+
+    return;
+}
+
+/* order segments the way dxt_index_query() returns them */
+static int query_segment_cmp(const void *a, const void *b)
+{
+    const struct dxt_query_segment *s_a = a;
+    const struct dxt_query_segment *s_b = b;
+
+    if(s_a->rec_id != s_b->rec_id)
+        return((s_a->rec_id < s_b->rec_id) ? -1 : 1);
+    if(s_a->rank != s_b->rank)
+        return((s_a->rank < s_b->rank) ? -1 : 1);
+    if(s_a->op != s_b->op)
+        return((s_a->op < s_b->op) ? -1 : 1);
+    if(s_a->info.start_time != s_b->info.start_time)
+        return((s_a->info.start_time < s_b->info.start_time) ? -1 : 1);
+    return(s_a->segment - s_b->segment);
+}
+
+/* answer a query by scanning every segment of the log */
+static void brute_force_query(struct test_log *log, struct dxt_query *query,
+    struct dxt_query_segment **segs, int64_t *count)
+{
+    struct dxt_file_record *rec;
+    segment_info *info;
+    int64_t len = 0;
+    int64_t i;
+    int op;
+    int r;
+
+    *segs = NULL;
+    *count = 0;
+    for(r = 0; r < log->nrecs; r++)
+    {
+        rec = log->recs[r];
+        if(log->rec_mods[r] != query->mod_id ||
+            (query->rec_id && rec->base_rec.id != query->rec_id) ||
+            rec->base_rec.rank < query->rank_min ||
+            rec->base_rec.rank > query->rank_max)
+            continue;
+
+        info = (segment_info *)((char *)rec + sizeof(*rec));
+        for(i = 0; i < rec->write_count + rec->read_count; i++)
+        {
+            op = (i < rec->write_count) ? DXT_QUERY_WRITE : DXT_QUERY_READ;
+            if(!(op & query->ops) || info[i].start_time > query->end_time ||
+                info[i].end_time < query->start_time)
+                continue;
+
+            if(*count == len)
+            {
+                len = len ? (2 * len) : 64;
+                *segs = realloc(*segs, len * sizeof(**segs));
+                munit_assert_not_null(*segs);
+            }
+            (*segs)[*count].rec_id = rec->base_rec.id;
+            (*segs)[*count].rank = rec->base_rec.rank;
+            (*segs)[*count].op = op;
+            (*segs)[*count].segment =
+                (op == DXT_QUERY_WRITE) ? i : i - rec->write_count;
+            (*segs)[*count].info = info[i];
+            (*count)++;
+        }
+    }
+    qsort(*segs, *count, sizeof(**segs), query_segment_cmp);
+
+    return;
+}
+
+static void random_query(struct dxt_query *query)
+{
+    int mods[2] = {DXT_POSIX_MOD, DXT_MPIIO_MOD};
+    double a, b;
+
+    memset(query, 0, sizeof(*query));
+    query->mod_id = mods[munit_rand_int_range(0, 1)];
+    if(munit_rand_int_range(0, 2) == 0)
+        query->rec_id = 0;
+    else
+        query->rec_id = test_rec_id(munit_rand_int_range(0, TEST_NFILES));
+    query->rank_min = munit_rand_int_range(-1, TEST_NRANKS);
+    query->rank_max = query->rank_min + munit_rand_int_range(0, TEST_NRANKS);
+    a = munit_rand_double() * 220.0 - 10.0;
+    b = a + munit_rand_double() * ((munit_rand_int_range(0, 3) == 0) ? 100.0 : 2.0);
+    query->start_time = a;
+    query->end_time = b;
+    query->ops = munit_rand_int_range(1, 3);
+
+    return;
+}
+
+static void check_query(struct dxt_index *index, struct test_log *log,
+    struct dxt_query *query)
+{
+    struct dxt_query_segment *segs, *expected;
+    int64_t count, expected_count;
+    int64_t i;
+
+    munit_assert_int(dxt_index_query(index, query, &segs, &count), ==, 0);
+    brute_force_query(log, query, &expected, &expected_count);
+    munit_assert_int64(count, ==, expected_count);
+    for(i = 0; i < count; i++)
+    {
+        munit_assert_uint64(segs[i].rec_id, ==, expected[i].rec_id);
+        munit_assert_int64(segs[i].rank, ==, expected[i].rank);
+        munit_assert_int(segs[i].op, ==, expected[i].op);
+        munit_assert_int(segs[i].segment, ==, expected[i].segment);
+        munit_assert_memory_equal(sizeof(segment_info), &segs[i].info,
+            &expected[i].info);
+    }
+    free(segs);
+    free(expected);
+
+    return;
+}
+
+/* every query must return exactly the segments a full scan finds, in
+ * record, rank, operation and start time order
+ */
+static MunitResult query_random_windows(const MunitParameter params[], void* data)
+{
+    struct test_log log;
+    struct dxt_index *index;
+    struct dxt_query query;
+    int i;
+
+    write_test_log(&log);
+    munit_assert_int(dxt_index_open(log.path, 0, &index), ==, 0);
+
+    for(i = 0; i < TEST_NQUERIES; i++)
+    {
+        random_query(&query);
+        check_query(index, &log, &query);
+    }
+
+    /* a window covering everything returns every segment of the module */
+    memset(&query, 0, sizeof(query));
+    query.mod_id = DXT_MPIIO_MOD;
+    query.rank_min = 0;
+    query.rank_max = TEST_NRANKS;
+    query.start_time = -1.0;
+    query.end_time = 1000.0;
+    query.ops = DXT_QUERY_WRITE | DXT_QUERY_READ;
+    check_query(index, &log, &query);
+
+    dxt_index_close(index);
+    free_test_log(&log);
+
+    return MUNIT_OK;
+}
+
+static int64_t cached_mtime_nsec(struct test_log *log)
+{
+    char cache_path[128];
+    int64_t hdr[7];
+    FILE *fp;
+
+    snprintf(cache_path, sizeof(cache_path), "%s.dxtidx", log->path);
+    fp = fopen(cache_path, "r");
+    munit_assert_not_null(fp);
+    munit_assert_size(fread(hdr, sizeof(hdr), 1, fp), ==, 1);
+    fclose(fp);
+
+    /* magic, version and pad, log size, log mtime, log mtime nsec, ... */
+    return(hdr[4]);
+}
+
+/* a cached index answers queries like a freshly built one, and is rebuilt
+ * when the log's modification time changes, even within the same second
+ */
+static MunitResult reuse_index_cache(const MunitParameter params[], void* data)
+{
+    struct test_log log;
+    struct dxt_index *index;
+    struct dxt_query query;
+    struct timespec times[2];
+    struct stat st;
+    int i;
+
+    write_test_log(&log);
+    munit_assert_int(dxt_index_open(log.path, 1, &index), ==, 0);
+    dxt_index_close(index);
+
+    /* the second open maps the cache written by the first */
+    munit_assert_int(dxt_index_open(log.path, 1, &index), ==, 0);
+    for(i = 0; i < TEST_NQUERIES / 10; i++)
+    {
+        random_query(&query);
+        check_query(index, &log, &query);
+    }
+    dxt_index_close(index);
+
+    munit_assert_int(stat(log.path, &st), ==, 0);
+    munit_assert_int64(cached_mtime_nsec(&log), ==, st.st_mtim.tv_nsec);
+    times[0] = st.st_atim;
+    times[1] = st.st_mtim;
+    times[1].tv_nsec = (st.st_mtim.tv_nsec + 1) % 1000000000;
+    munit_assert_int(utimensat(AT_FDCWD, log.path, times, 0), ==, 0);
+    munit_assert_int(stat(log.path, &st), ==, 0);
+
+    munit_assert_int(dxt_index_open(log.path, 1, &index), ==, 0);
+    munit_assert_int64(cached_mtime_nsec(&log), ==, st.st_mtim.tv_nsec);
+    random_query(&query);
+    check_query(index, &log, &query);
+    dxt_index_close(index);
+
+    free_test_log(&log);
+
+    return MUNIT_OK;
+}
+
+int main(int argc, char **argv)
+{
+    return munit_suite_main(&test_suite, NULL, argc, argv);
+}
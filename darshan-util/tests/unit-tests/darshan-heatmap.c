@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2022 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "munit/munit.h"
+
+#include <darshan-logutils.h>
+
+static MunitResult roundtrip_heatmap_records(const MunitParameter params[], void* data);
+
+/* test definition */
+static MunitTest tests[]
+    = {{"/roundtrip-heatmap-records", roundtrip_heatmap_records,
+        NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+       {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+static const MunitSuite test_suite = {
+    "/darshan-heatmap", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE
+};
+
+#define TEST_NBINS 4
+#define TEST_NRANKS 3
+
+/* allocate a heatmap record with room for nranks rows (or a single row for
+ * a per-process record, nranks == 0) of nbins read and write bins
+ */
+static struct darshan_heatmap_record *alloc_heatmap_record(int64_t nranks,
+    int64_t nbins)
+{
+    struct darshan_heatmap_record *rec;
+    int64_t nvals = (nranks > 0 ? nranks : 1) * nbins;
+
+    rec = calloc(1, sizeof(*rec) + nvals*2*sizeof(int64_t));
+    munit_assert_not_null(rec);
+    rec->nbins = nbins;
+    rec->nranks = nranks;
+    rec->bin_width_seconds = 0.5;
+    rec->write_bins = (int64_t*)((uintptr_t)rec + sizeof(*rec));
+    rec->read_bins = &rec->write_bins[nvals];
+
+    return(rec);
+}
+
+static void assert_heatmap_records_equal(struct darshan_heatmap_record *a,
+    struct darshan_heatmap_record *b)
+{
+    int64_t nvals = (a->nranks > 0 ? a->nranks : 1) * a->nbins;
+
+    munit_assert_uint64(a->base_rec.id, ==, b->base_rec.id);
+    munit_assert_int64(a->base_rec.rank, ==, b->base_rec.rank);
+    munit_assert_double(a->bin_width_seconds, ==, b->bin_width_seconds);
+    munit_assert_double(a->start_time_seconds, ==, b->start_time_seconds);
+    munit_assert_int64(a->nbins, ==, b->nbins);
+    munit_assert_int64(a->nranks, ==, b->nranks);
+    munit_assert_int64(a->write_quantum, ==, b->write_quantum);
+    munit_assert_int64(a->read_quantum, ==, b->read_quantum);
+    munit_assert_memory_equal(nvals*sizeof(int64_t), a->write_bins, b->write_bins);
+    munit_assert_memory_equal(nvals*sizeof(int64_t), a->read_bins, b->read_bins);
+}
+
+/* write a per-process heatmap and a quantized rank x time matrix to a log,
+ * then read them back: the per-process bins must be unchanged, and the
+ * matrix bins (multiples of their quantum) must expand back exactly
+ */
+static MunitResult roundtrip_heatmap_records(const MunitParameter params[], void* data)
+{
+    struct darshan_heatmap_record *recs[2];
+    void *read_rec;
+    char log_path[] = "/tmp/darshan-heatmap-test.XXXXXX";
+    struct darshan_job job = {0};
+    darshan_name_table names;
+    darshan_fd fd;
+    int tmp_fd;
+    int64_t i;
+    int ret;
+
+    tmp_fd = mkstemp(log_path);
+    munit_assert_int(tmp_fd, >=, 0);
+    close(tmp_fd);
+
+    recs[0] = alloc_heatmap_record(0, TEST_NBINS);
+    recs[0]->base_rec.id = 1;
+    recs[0]->base_rec.rank = 2;
+    recs[0]->start_time_seconds = 1.5;
+    for(i = 0; i < TEST_NBINS; i++)
+    {
+        recs[0]->write_bins[i] = (i + 1) * 1000000007LL;
+        recs[0]->read_bins[i] = i * 3;
+    }
+
+    recs[1] = alloc_heatmap_record(TEST_NRANKS, TEST_NBINS);
+    recs[1]->base_rec.id = 1;
+    recs[1]->base_rec.rank = 0;
+    recs[1]->write_quantum = 4096;
+    recs[1]->read_quantum = 7;
+    for(i = 0; i < TEST_NRANKS*TEST_NBINS; i++)
+    {
+        recs[1]->write_bins[i] = (i * 37 % 256) * recs[1]->write_quantum;
+        recs[1]->read_bins[i] = (255 - i) * recs[1]->read_quantum;
+    }
+
+    /* write the log */
+    fd = darshan_log_create(log_path, DARSHAN_ZLIB_COMP, 0);
+    munit_assert_not_null(fd);
+    job.nprocs = TEST_NRANKS;
+    munit_assert_int(darshan_log_put_job(fd, &job), ==, 0);
+    munit_assert_int(darshan_log_put_exe(fd, "heatmap-test"), ==, 0);
+    munit_assert_int(darshan_log_put_mounts(fd, NULL, 0), ==, 0);
+    munit_assert_int(darshan_name_table_create(&names), ==, 0);
+    munit_assert_int(darshan_name_table_add(names, 1, "heatmap:POSIX"), ==, 1);
+    munit_assert_int(darshan_log_put_name_table(fd, names), ==, 0);
+    darshan_name_table_destroy(names);
+    for(i = 0; i < 2; i++)
+    {
+        ret = mod_logutils[DARSHAN_HEATMAP_MOD]->log_put_record(fd, recs[i]);
+        munit_assert_int(ret, ==, 0);
+    }
+    darshan_log_close(fd);
+
+    /* read it back */
+    fd = darshan_log_open(log_path);
+    munit_assert_not_null(fd);
+    munit_assert_int(fd->mod_ver[DARSHAN_HEATMAP_MOD], ==, DARSHAN_HEATMAP_VER);
+    for(i = 0; i < 2; i++)
+    {
+        read_rec = NULL;
+        ret = mod_logutils[DARSHAN_HEATMAP_MOD]->log_get_record(fd, &read_rec);
+        munit_assert_int(ret, ==, 1);
+        assert_heatmap_records_equal(recs[i], read_rec);
+        free(read_rec);
+    }
+    read_rec = NULL;
+    ret = mod_logutils[DARSHAN_HEATMAP_MOD]->log_get_record(fd, &read_rec);
+    munit_assert_int(ret, ==, 0);
+    darshan_log_close(fd);
+
+    unlink(log_path);
+    free(recs[0]);
+    free(recs[1]);
+
+    return MUNIT_OK;
+}
+
+int main(int argc, char **argv)
+{
+    return munit_suite_main(&test_suite, NULL, argc, argv);
+}
@@ -7,17 +7,30 @@
 #define __DARSHAN_HEATMAP_LOG_FORMAT_H
 
 /* current HEATMAP log format version */
-#define DARSHAN_HEATMAP_VER 1
+#define DARSHAN_HEATMAP_VER 3
 
 /* record structure for a Darshan heatmap.  These should be one per
  * API/category that registers heatmap data.  Each is variable size
- * according to the nbins field.
+ * according to the nbins field.  Heatmaps covering only the most recent
+ * activity of a process (rather than its entire execution) report the
+ * time of their first bin in start_time_seconds.
+ *
+ * A heatmap may also be stored as a rank x time matrix gathered from a
+ * block of 'nranks' consecutive ranks starting at base_rec.rank.  In the
+ * log, each bin of a rank matrix is quantized to a single byte that
+ * counts multiples of write_quantum or read_quantum bytes, stored as
+ * nranks rows of write bins followed by nranks rows of read bins.
+ * darshan-util expands these into int64_t bins when reading the log.
  */
 struct darshan_heatmap_record
 {
     struct darshan_base_record base_rec;
     double  bin_width_seconds; /* time duration of each bin */
     int64_t nbins;             /* number of bins */
+    double  start_time_seconds; /* start time of first bin */
+    int64_t nranks;            /* number of ranks in a rank matrix (0 if not a matrix) */
+    int64_t write_quantum;     /* bytes per unit of a quantized write bin */
+    int64_t read_quantum;      /* bytes per unit of a quantized read bin */
     int64_t *write_bins;       /* pointer to write bin array (trails struct in log */
     int64_t *read_bins;        /* pointer to read bin array (trails write bin array in log */
 };
@@ -64,6 +64,14 @@ struct darshan_log_map
     uint64_t len;
 };
 
+/* mmap logs (see the --enable-mmap-logs option of darshan-runtime) end
+ * with a 64-bit sequence counter. The runtime increments it before and
+ * after updating the log header, name records, or module maps, so it is
+ * odd while an update is in progress; readers sampling a live mmap log
+ * retry until they observe the same even value before and after a read.
+ */
+#define DARSHAN_MMAP_LOG_SEQ_SIZE sizeof(uint64_t)
+
 /* the darshan header stores critical metadata needed for correctly
  * reading the contents of the corresponding Darshan log
  */